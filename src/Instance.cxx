@@ -24,6 +24,9 @@
 #include "Stats.hxx"
 #include "client/List.hxx"
 #include "input/cache/Manager.hxx"
+#include "decoder/cache/Manager.hxx"
+#include "event/LatencyProbe.hxx"
+#include "metrics/Listener.hxx"
 
 #ifdef ENABLE_CURL
 #include "RemoteTagCache.hxx"
@@ -55,6 +55,9 @@ class StateFile;
 class RemoteTagCache;
 class StickerDatabase;
 class InputCacheManager;
+class DecoderCacheManager;
+class LatencyProbe;
+class MetricsListener;
 
 /**
  * A utility class which, when used as the first base class, ensures
@@ -95,12 +98,21 @@ struct Instance final
 	 */
 	EventThread rtio_thread;
 
+	/**
+	 * Optional wakeup latency probes for #io_thread and
+	 * #rtio_thread, enabled with "latency_probe" in a "thread"
+	 * block.
+	 */
+	std::unique_ptr<LatencyProbe> io_latency_probe, rtio_latency_probe;
+
 #ifdef ENABLE_SYSTEMD_DAEMON
 	Systemd::Watchdog systemd_watchdog;
 #endif
 
 	std::unique_ptr<InputCacheManager> input_cache;
 
+	std::unique_ptr<DecoderCacheManager> decoder_cache;
+
 	MaskMonitor idle_monitor;
 
 #ifdef ENABLE_NEIGHBOR_PLUGINS
@@ -125,6 +137,11 @@ struct Instance final
 
 	std::unique_ptr<ClientList> client_list;
 
+	/**
+	 * The HTTP listener for the "metrics" block.
+	 */
+	std::unique_ptr<MetricsListener> metrics_listener;
+
 	std::list<Partition> partitions;
 
 	StateFile *state_file = nullptr;
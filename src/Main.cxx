@@ -28,6 +28,7 @@
 #include "Permission.hxx"
 #include "Listen.hxx"
 #include "client/Listener.hxx"
+#include "metrics/Listener.hxx"
 #include "client/Config.hxx"
 #include "client/List.hxx"
 #include "command/AllCommands.hxx"
@@ -40,9 +41,14 @@
 #include "input/Init.hxx"
 #include "input/cache/Config.hxx"
 #include "input/cache/Manager.hxx"
+#include "decoder/cache/Config.hxx"
+#include "decoder/cache/Manager.hxx"
 #include "event/Loop.hxx"
+#include "event/Call.hxx"
+#include "event/LatencyProbe.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "fs/Config.hxx"
+#include "trace/PipelineTrace.hxx"
 #include "playlist/PlaylistRegistry.hxx"
 #include "zeroconf/ZeroconfGlue.hxx"
 #include "decoder/DecoderList.hxx"
@@ -60,6 +66,7 @@
 #include "config/Option.hxx"
 #include "config/Domain.hxx"
 #include "config/Parser.hxx"
+#include "config/ThreadConfig.hxx"
 #include "util/RuntimeError.hxx"
 #include "util/ScopeExit.hxx"
 
@@ -245,13 +252,14 @@ InitDatabaseAndStorage(Instance &instance, const ConfigData &config)
  * Configure and initialize the sticker subsystem.
  */
 static std::unique_ptr<StickerDatabase>
-LoadStickerDatabase(const ConfigData &config)
+LoadStickerDatabase(EventLoop &event_loop, const ConfigData &config)
 {
 	auto sticker_file = config.GetPath(ConfigOption::STICKER_FILE);
 	if (sticker_file.IsNull())
 		return nullptr;
 
-	return std::make_unique<StickerDatabase>(std::move(sticker_file));
+	return std::make_unique<StickerDatabase>(event_loop,
+						 std::move(sticker_file));
 }
 
 #endif
@@ -269,6 +277,34 @@ glue_state_file_init(Instance &instance, const ConfigData &raw_config)
 	instance.state_file->Read();
 }
 
+/**
+ * Apply the "thread" block to an #EventThread and start its
+ * #LatencyProbe if one was configured.
+ */
+static void
+StartEventThreadConfig(EventLoop &loop, ThreadKind kind,
+		       std::unique_ptr<LatencyProbe> &probe)
+{
+	const bool latency_probe = GetThreadConfig(kind).latency_probe;
+	if (latency_probe)
+		probe = std::make_unique<LatencyProbe>(loop);
+
+	BlockingCall(loop, [kind, &probe](){
+		ApplyThreadConfig(kind);
+		if (probe)
+			probe->Start();
+	});
+}
+
+static void
+StopLatencyProbe(std::unique_ptr<LatencyProbe> &probe) noexcept
+{
+	if (probe)
+		BlockingCall(probe->GetEventLoop(), [&probe](){
+			probe.reset();
+		});
+}
+
 /**
  * Initialize the decoder and player core, including the music pipe.
  */
@@ -322,7 +358,9 @@ initialize_decoder_and_player(Instance &instance,
 					 max_length,
 					 buffered_chunks,
 					 configured_audio_format,
-					 replay_gain_config);
+					 replay_gain_config,
+					 config.GetBool(ConfigOption::PREDECODE_NEXT_SONG,
+							false));
 	auto &partition = instance.partitions.back();
 
 	partition.replay_gain_mode = config.With(ConfigOption::REPLAYGAIN, [](const char *s){
@@ -422,11 +460,26 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 		instance.input_cache = std::make_unique<InputCacheManager>(c);
 	}
 
+	const auto *decoder_cache_config = raw_config.GetBlock(ConfigBlockOption::DECODER_CACHE);
+	if (decoder_cache_config != nullptr) {
+		const DecoderCacheConfig c(*decoder_cache_config);
+		instance.decoder_cache = std::make_unique<DecoderCacheManager>(c);
+	}
+
 	initialize_decoder_and_player(instance,
 				      raw_config, config.replay_gain);
 
 	listen_global_init(raw_config, *instance.partitions.front().listener);
 
+	const auto *metrics_config = raw_config.GetBlock(ConfigBlockOption::METRICS);
+	if (metrics_config != nullptr) {
+		instance.metrics_listener =
+			std::make_unique<MetricsListener>(instance.event_loop,
+							  instance,
+							  *metrics_config);
+		instance.metrics_listener->Open();
+	}
+
 #ifdef ENABLE_DAEMON
 	daemonize_set_user();
 	daemonize_begin(options.daemon);
@@ -453,10 +506,19 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 #endif
 
 #ifdef ENABLE_SQLITE
-	instance.sticker_database = LoadStickerDatabase(raw_config);
+	instance.sticker_database = LoadStickerDatabase(instance.event_loop,
+						       raw_config);
 #endif
 
-	command_init();
+	const std::chrono::steady_clock::duration latency_log_threshold =
+		std::chrono::milliseconds(raw_config.GetUnsigned(ConfigOption::LATENCY_LOG_THRESHOLD, 0));
+	command_init(latency_log_threshold);
+	instance.event_loop.SetLagThreshold(latency_log_threshold);
+
+	PipelineTrace::SetDumpPath(raw_config.GetPath(ConfigOption::PIPELINE_TRACE_FILE));
+	PipelineTrace::SetEnabled(raw_config.GetBool(ConfigOption::PIPELINE_TRACE,
+						     false));
+	AtScopeExit() { PipelineTrace::Deinit(); };
 
 	for (auto &partition : instance.partitions) {
 		partition.outputs.Configure(instance.rtio_thread.GetEventLoop(),
@@ -482,9 +544,21 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 	const ScopeSignalHandlersInit signal_handlers_init(instance.event_loop);
 #endif
 
+	InitThreadConfig(raw_config);
+
 	instance.io_thread.Start();
 	instance.rtio_thread.Start();
 
+	StartEventThreadConfig(instance.io_thread.GetEventLoop(),
+			       ThreadKind::IO, instance.io_latency_probe);
+	StartEventThreadConfig(instance.rtio_thread.GetEventLoop(),
+			       ThreadKind::RTIO, instance.rtio_latency_probe);
+
+	AtScopeExit(&instance) {
+		StopLatencyProbe(instance.io_latency_probe);
+		StopLatencyProbe(instance.rtio_latency_probe);
+	};
+
 #ifdef ENABLE_NEIGHBOR_PLUGINS
 	if (instance.neighbors != nullptr)
 		instance.neighbors->Open();
@@ -561,6 +635,8 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 
 	ZeroconfDeinit();
 
+	instance.metrics_listener.reset();
+
 	instance.BeginShutdownPartitions();
 }
 
@@ -68,6 +68,15 @@ public:
 		return buffer.GetCapacity();
 	}
 
+	/**
+	 * Returns the number of chunks currently allocated.
+	 */
+	gcc_pure
+	unsigned GetAllocated() const noexcept {
+		const std::lock_guard<Mutex> protect(mutex);
+		return buffer.GetAllocated();
+	}
+
 	/**
 	 * Allocates a chunk from the buffer.  When it is not used anymore,
 	 * call Return().
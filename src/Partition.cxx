@@ -35,7 +35,8 @@ Partition::Partition(Instance &_instance,
 		     unsigned max_length,
 		     unsigned buffer_chunks,
 		     AudioFormat configured_audio_format,
-		     const ReplayGainConfig &replay_gain_config) noexcept
+		     const ReplayGainConfig &replay_gain_config,
+		     bool predecode) noexcept
 	:instance(_instance),
 	 name(_name),
 	 listener(new ClientListener(instance.event_loop, *this)),
@@ -44,8 +45,10 @@ Partition::Partition(Instance &_instance,
 	 outputs(*this),
 	 pc(*this, outputs,
 	    instance.input_cache.get(),
+	    instance.decoder_cache.get(),
 	    buffer_chunks,
-	    configured_audio_format, replay_gain_config)
+	    configured_audio_format, replay_gain_config,
+	    predecode)
 {
 	UpdateEffectiveReplayGainMode();
 }
@@ -70,7 +70,8 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 		  unsigned max_length,
 		  unsigned buffer_chunks,
 		  AudioFormat configured_audio_format,
-		  const ReplayGainConfig &replay_gain_config) noexcept;
+		  const ReplayGainConfig &replay_gain_config,
+		  bool predecode) noexcept;
 
 	~Partition() noexcept;
 
@@ -21,6 +21,7 @@
 #include "PlaylistFile.hxx"
 #include "PlaylistSave.hxx"
 #include "PlaylistError.hxx"
+#include "playlist/SplSongCache.hxx"
 #include "db/PlaylistInfo.hxx"
 #include "db/PlaylistVector.hxx"
 #include "song/DetachedSong.hxx"
@@ -41,12 +42,19 @@
 #include "fs/DirectoryReader.hxx"
 #include "util/StringCompare.hxx"
 #include "util/UriUtil.hxx"
+#include "util/LruCache.hxx"
 
 #include <assert.h>
 #include <string.h>
 
 static const char PLAYLIST_COMMENT = '#';
 
+/**
+ * The maximum number of stored playlists in the
+ * #playlist_file_cache.
+ */
+static constexpr std::size_t PLAYLIST_FILE_CACHE_SIZE = 16;
+
 static unsigned playlist_max_length;
 bool playlist_saveAbsolutePaths = DEFAULT_PLAYLIST_SAVE_ABSOLUTE_PATHS;
 
@@ -172,8 +180,71 @@ ListPlaylistFiles()
 	return list;
 }
 
+/**
+ * A parsed stored playlist file.  It is considered up to date as
+ * long as the file's attributes are unchanged.
+ */
+struct PlaylistFileCacheItem {
+	std::chrono::system_clock::time_point mtime;
+	uint64_t size;
+#ifndef _WIN32
+	ino_t inode;
+#endif
+
+	PlaylistFileContents contents;
+
+	void Set(const FileInfo &fi) noexcept {
+		mtime = fi.GetModificationTime();
+		size = fi.GetSize();
+#ifndef _WIN32
+		inode = fi.GetInode();
+#endif
+	}
+
+	gcc_pure
+	bool IsValid(const FileInfo &fi) const noexcept {
+		return fi.GetModificationTime() == mtime &&
+			fi.GetSize() == size
+#ifndef _WIN32
+			&& fi.GetInode() == inode
+#endif
+			;
+	}
+};
+
+/**
+ * Recently used stored playlists, indexed by their name.  This
+ * avoids parsing big files again and again while they are being
+ * edited or listed.  When the cache is full, the least recently
+ * used playlist is evicted.  Stored playlists are only accessed by
+ * the main thread, therefore no locking is necessary.
+ */
+static LruCache<std::string, PlaylistFileCacheItem,
+		PLAYLIST_FILE_CACHE_SIZE> playlist_file_cache;
+
+static void
+PlaylistFileCacheStore(const char *utf8path, const FileInfo &fi,
+		       PlaylistFileContents &&contents)
+{
+	PlaylistFileCacheItem item;
+	item.Set(fi);
+	item.contents = std::move(contents);
+	playlist_file_cache.Put(utf8path, std::move(item));
+}
+
+/**
+ * Discard all cached data about the stored playlist after it has
+ * been modified or deleted.
+ */
 static void
-SavePlaylistFile(const PlaylistFileContents &contents, const char *utf8path)
+PlaylistFileCacheErase(const char *utf8path) noexcept
+{
+	playlist_file_cache.Remove(utf8path);
+	spl_song_cache_erase(utf8path);
+}
+
+static void
+SavePlaylistFile(PlaylistFileContents &&contents, const char *utf8path)
 {
 	assert(utf8path != nullptr);
 
@@ -189,61 +260,91 @@ SavePlaylistFile(const PlaylistFileContents &contents, const char *utf8path)
 	bos.Flush();
 
 	fos.Commit();
-}
 
-PlaylistFileContents
-LoadPlaylistFile(const char *utf8path)
-try {
-	PlaylistFileContents contents;
-
-	const auto path_fs = spl_map_to_fs(utf8path);
-	assert(!path_fs.IsNull());
+	spl_song_cache_erase(utf8path);
 
-	TextFile file(path_fs);
+	FileInfo fi;
+	if (GetFileInfo(path_fs, fi))
+		PlaylistFileCacheStore(utf8path, fi, std::move(contents));
+	else
+		PlaylistFileCacheErase(utf8path);
+}
 
-	char *s;
-	while ((s = file.ReadLine()) != nullptr) {
-		if (*s == 0 || *s == PLAYLIST_COMMENT)
-			continue;
+/**
+ * Convert one line of a stored playlist file to a song URI.
+ *
+ * @return the URI or an empty string if the line shall be skipped
+ */
+static std::string
+ParsePlaylistLine(const char *s)
+{
+	if (*s == 0 || *s == PLAYLIST_COMMENT)
+		return std::string();
 
 #ifdef _UNICODE
-		/* on Windows, playlists always contain UTF-8, because
-		   its "narrow" charset (i.e. CP_ACP) is incapable of
-		   storing all Unicode paths */
-		const auto path = AllocatedPath::FromUTF8(s);
-		if (path.IsNull())
-			continue;
+	/* on Windows, playlists always contain UTF-8, because its
+	   "narrow" charset (i.e. CP_ACP) is incapable of storing all
+	   Unicode paths */
+	const auto path = AllocatedPath::FromUTF8(s);
+	if (path.IsNull())
+		return std::string();
 #else
-		const Path path = Path::FromFS(s);
+	const Path path = Path::FromFS(s);
 #endif
 
-		std::string uri_utf8;
-
-		if (!uri_has_scheme(s)) {
+	if (!uri_has_scheme(s)) {
 #ifdef ENABLE_DATABASE
-			uri_utf8 = map_fs_to_utf8(path);
-			if (uri_utf8.empty()) {
-				if (path.IsAbsolute()) {
-					uri_utf8 = path.ToUTF8();
-					if (uri_utf8.empty())
-						continue;
-				} else
-					continue;
-			}
+		auto uri_utf8 = map_fs_to_utf8(path);
+		if (uri_utf8.empty() && path.IsAbsolute())
+			uri_utf8 = path.ToUTF8();
+
+		return uri_utf8;
 #else
-			continue;
+		return std::string();
 #endif
-		} else {
-			uri_utf8 = path.ToUTF8();
-			if (uri_utf8.empty())
-				continue;
-		}
+	} else
+		return path.ToUTF8();
+}
+
+static PlaylistFileContents
+ParsePlaylistFile(Path path_fs)
+{
+	PlaylistFileContents contents;
+
+	TextFile file(path_fs);
+
+	char *s;
+	while ((s = file.ReadLine()) != nullptr) {
+		auto uri_utf8 = ParsePlaylistLine(s);
+		if (uri_utf8.empty())
+			continue;
 
 		contents.emplace_back(std::move(uri_utf8));
 		if (contents.size() >= playlist_max_length)
 			break;
 	}
 
+	return contents;
+}
+
+PlaylistFileContents
+LoadPlaylistFile(const char *utf8path)
+try {
+	const auto path_fs = spl_map_to_fs(utf8path);
+	assert(!path_fs.IsNull());
+
+	const FileInfo fi(path_fs);
+
+	const auto *item = playlist_file_cache.Get(utf8path);
+	if (item != nullptr && item->IsValid(fi))
+		return item->contents;
+
+	auto contents = ParsePlaylistFile(path_fs);
+
+	/* the attributes were obtained before the file was parsed;
+	   if it was modified meanwhile, the cache item will be
+	   discarded next time */
+	PlaylistFileCacheStore(utf8path, fi, PlaylistFileContents(contents));
 	return contents;
 } catch (const std::system_error &e) {
 	if (IsFileNotFound(e))
@@ -271,7 +372,7 @@ spl_move_index(const char *utf8path, unsigned src, unsigned dest)
 	const auto dest_i = std::next(contents.begin(), dest);
 	contents.insert(dest_i, std::move(value));
 
-	SavePlaylistFile(contents, utf8path);
+	SavePlaylistFile(std::move(contents), utf8path);
 
 	idle_add(IDLE_STORED_PLAYLIST);
 }
@@ -292,6 +393,8 @@ spl_clear(const char *utf8path)
 			throw;
 	}
 
+	PlaylistFileCacheErase(utf8path);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 }
 
@@ -311,6 +414,8 @@ spl_delete(const char *name_utf8)
 			throw;
 	}
 
+	PlaylistFileCacheErase(name_utf8);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 }
 
@@ -324,16 +429,74 @@ spl_remove_index(const char *utf8path, unsigned pos)
 
 	contents.erase(std::next(contents.begin(), pos));
 
-	SavePlaylistFile(contents, utf8path);
+	SavePlaylistFile(std::move(contents), utf8path);
 	idle_add(IDLE_STORED_PLAYLIST);
 }
 
+/**
+ * Determine the URI which LoadPlaylistFile() will return for the
+ * line written by playlist_print_song().
+ *
+ * @return the URI or an empty string if the song is not written or
+ * will be skipped when loading
+ */
+static std::string
+GetPlaylistFileURI(const DetachedSong &song)
+try {
+	const char *uri_utf8 = playlist_saveAbsolutePaths
+		? song.GetRealURI()
+		: song.GetURI();
+
+	const auto uri_fs = AllocatedPath::FromUTF8Throw(uri_utf8);
+
+#ifdef _UNICODE
+	return ParsePlaylistLine(uri_fs.ToUTF8Throw().c_str());
+#else
+	return ParsePlaylistLine(uri_fs.c_str());
+#endif
+} catch (...) {
+	return std::string();
+}
+
+/**
+ * Update the cache item (if any) after a song has been appended to
+ * the file, to avoid parsing the whole file again.
+ *
+ * @param old_fi the file's attributes before the song was appended
+ */
+static void
+PlaylistFileCacheAppend(const char *utf8path, Path path_fs,
+			const FileInfo &old_fi, const DetachedSong &song)
+{
+	spl_song_cache_erase(utf8path);
+
+	auto *item = playlist_file_cache.Get(utf8path);
+	if (item == nullptr)
+		return;
+
+	FileInfo fi;
+	if (!item->IsValid(old_fi) || !GetFileInfo(path_fs, fi)) {
+		playlist_file_cache.Remove(utf8path);
+		return;
+	}
+
+	auto uri = GetPlaylistFileURI(song);
+	if (!uri.empty() && item->contents.size() < playlist_max_length)
+		item->contents.emplace_back(std::move(uri));
+
+	item->Set(fi);
+}
+
 void
 spl_append_song(const char *utf8path, const DetachedSong &song)
 try {
 	const auto path_fs = spl_map_to_fs(utf8path);
 	assert(!path_fs.IsNull());
 
+	FileInfo old_fi;
+	if (!GetFileInfo(path_fs, old_fi))
+		PlaylistFileCacheErase(utf8path);
+
 	FileOutputStream fos(path_fs, FileOutputStream::Mode::APPEND_OR_CREATE);
 
 	if (fos.Tell() / (MPD_PATH_MAX + 1) >= playlist_max_length)
@@ -347,6 +510,8 @@ try {
 	bos.Flush();
 	fos.Commit();
 
+	PlaylistFileCacheAppend(utf8path, path_fs, old_fi, song);
+
 	idle_add(IDLE_STORED_PLAYLIST);
 } catch (const std::system_error &e) {
 	if (IsFileNotFound(e))
@@ -391,4 +556,7 @@ spl_rename(const char *utf8from, const char *utf8to)
 	assert(!to_path_fs.IsNull());
 
 	spl_rename_internal(from_path_fs, to_path_fs);
+
+	PlaylistFileCacheErase(utf8from);
+	PlaylistFileCacheErase(utf8to);
 }
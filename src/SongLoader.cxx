@@ -86,6 +86,31 @@ SongLoader::LoadSong(const LocatedUri &located_uri) const
 	gcc_unreachable();
 }
 
+bool
+SongLoader::IsLocalFile(const char *uri_utf8) const noexcept
+try {
+	const auto located_uri = LocateUri(UriPluginKind::INPUT,
+					   uri_utf8, client
+#ifdef ENABLE_DATABASE
+					   , storage
+#endif
+					   );
+	if (located_uri.type != LocatedUri::Type::PATH)
+		return false;
+
+#ifdef ENABLE_DATABASE
+	if (storage != nullptr &&
+	    storage->MapToRelativeUTF8(located_uri.canonical_uri) != nullptr)
+		/* LoadFile() will look it up in the database */
+		return false;
+#endif
+
+	return true;
+} catch (...) {
+	/* LoadSong() will fail quickly */
+	return false;
+}
+
 DetachedSong
 SongLoader::LoadSong(const char *uri_utf8) const
 {
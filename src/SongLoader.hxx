@@ -75,6 +75,15 @@ public:
 	gcc_nonnull_all
 	DetachedSong LoadSong(const char *uri_utf8) const;
 
+	/**
+	 * Would LoadSong() read the song's tags from a local file
+	 * (instead of using the database or just the URI)?  Such
+	 * songs may be loaded in a worker thread, because this does
+	 * not access the database.
+	 */
+	gcc_pure gcc_nonnull_all
+	bool IsLocalFile(const char *uri_utf8) const noexcept;
+
 private:
 	gcc_nonnull_all
 	DetachedSong LoadFromDatabase(const char *uri) const;
@@ -23,6 +23,8 @@
 #include "client/Response.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
+#include "decoder/cache/Manager.hxx"
+#include "event/LatencyProbe.hxx"
 #include "db/Selection.hxx"
 #include "db/Interface.hxx"
 #include "db/Stats.hxx"
@@ -88,6 +90,14 @@ stats_update(const Database &db)
 	}
 }
 
+const DatabaseStats *
+stats_get_database(const Database &db) noexcept
+{
+	return stats_update(db)
+		? &stats
+		: nullptr;
+}
+
 static void
 db_stats_print(Response &r, const Database &db)
 {
@@ -114,6 +124,18 @@ db_stats_print(Response &r, const Database &db)
 
 #endif
 
+static void
+latency_probe_print(Response &r, const char *name, const LatencyProbe &probe)
+{
+	const auto probe_stats = probe.GetStats();
+	r.Format("%s_jitter_avg: %lu\n"
+		 "%s_jitter_max: %lu\n",
+		 name,
+		 (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(probe_stats.average).count(),
+		 name,
+		 (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(probe_stats.max).count());
+}
+
 void
 stats_print(Response &r, const Partition &partition)
 {
@@ -133,4 +155,22 @@ stats_print(Response &r, const Partition &partition)
 	if (db != nullptr)
 		db_stats_print(r, *db);
 #endif
+
+	const auto *decoder_cache = partition.instance.decoder_cache.get();
+	if (decoder_cache != nullptr) {
+		const auto cache_stats = decoder_cache->GetStats();
+		r.Format("decoder_cache_songs: %lu\n"
+			 "decoder_cache_size: %lu\n"
+			 "decoder_cache_hits: %u\n"
+			 "decoder_cache_misses: %u\n",
+			 (unsigned long)cache_stats.n_items,
+			 (unsigned long)cache_stats.total_size,
+			 cache_stats.hits, cache_stats.misses);
+	}
+
+	const auto &instance = partition.instance;
+	if (instance.io_latency_probe)
+		latency_probe_print(r, "io", *instance.io_latency_probe);
+	if (instance.rtio_latency_probe)
+		latency_probe_print(r, "rtio", *instance.rtio_latency_probe);
 }
@@ -22,10 +22,21 @@
 
 class Response;
 struct Partition;
+class Database;
+struct DatabaseStats;
 
 void
 stats_invalidate();
 
+/**
+ * Returns the statistics of the given #Database.  They are cached
+ * until stats_invalidate() is called.
+ *
+ * @return nullptr on error
+ */
+const DatabaseStats *
+stats_get_database(const Database &db) noexcept;
+
 void
 stats_print(Response &r, const Partition &partition);
 
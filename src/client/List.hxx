@@ -47,6 +47,10 @@ public:
 		return list.end();
 	}
 
+	unsigned GetSize() const noexcept {
+		return list.size();
+	}
+
 	bool IsFull() const noexcept {
 		return list.size() >= max_size;
 	}
@@ -22,6 +22,8 @@
 #include "util/FormatString.hxx"
 #include "util/AllocatedString.hxx"
 
+#include <string.h>
+
 TagMask
 Response::GetTagMask() const noexcept
 {
@@ -31,13 +33,14 @@ Response::GetTagMask() const noexcept
 bool
 Response::Write(const void *data, size_t length) noexcept
 {
+	bytes_written += length;
 	return client.Write(data, length);
 }
 
 bool
 Response::Write(const char *data) noexcept
 {
-	return client.Write(data);
+	return Write(data, strlen(data));
 }
 
 bool
@@ -43,6 +43,11 @@ class Response {
 	 */
 	const char *command = "";
 
+	/**
+	 * The number of bytes passed to Write() so far.
+	 */
+	size_t bytes_written = 0;
+
 public:
 	Response(Client &_client, unsigned _list_index) noexcept
 		:client(_client), list_index(_list_index) {}
@@ -71,6 +76,10 @@ public:
 		command = _command;
 	}
 
+	size_t GetBytesWritten() const noexcept {
+		return bytes_written;
+	}
+
 	bool Write(const void *data, size_t length) noexcept;
 	bool Write(const char *data) noexcept;
 	bool FormatV(const char *fmt, va_list args) noexcept;
@@ -41,13 +41,18 @@
 #include "Instance.hxx"
 #include "client/Client.hxx"
 #include "client/Response.hxx"
+#include "event/Loop.hxx"
 #include "util/Tokenizer.hxx"
 #include "util/StringAPI.hxx"
+#include "util/LatencyHistogram.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
 
 #ifdef ENABLE_SQLITE
 #include "StickerCommands.hxx"
 #endif
 
+#include <chrono>
 #include <iterator>
 
 #include <assert.h>
@@ -77,6 +82,9 @@ handle_commands(Client &client, Request request, Response &response);
 static CommandResult
 handle_not_commands(Client &client, Request request, Response &response);
 
+static CommandResult
+handle_latencystats(Client &client, Request request, Response &response);
+
 /**
  * The command registry.
  *
@@ -114,6 +122,7 @@ static constexpr struct command commands[] = {
 #endif
 	{ "idle", PERMISSION_READ, 0, -1, handle_idle },
 	{ "kill", PERMISSION_ADMIN, -1, -1, handle_kill },
+	{ "latencystats", PERMISSION_READ, 0, 0, handle_latencystats },
 #ifdef ENABLE_DATABASE
 	{ "list", PERMISSION_READ, 1, -1, handle_list },
 	{ "listall", PERMISSION_READ, 0, 1, handle_listall },
@@ -148,6 +157,7 @@ static constexpr struct command commands[] = {
 	{ "password", PERMISSION_NONE, 1, 1, handle_password },
 	{ "pause", PERMISSION_CONTROL, 0, 1, handle_pause },
 	{ "ping", PERMISSION_NONE, 0, 0, handle_ping },
+	{ "pipelinetrace", PERMISSION_ADMIN, 1, 1, handle_pipelinetrace },
 	{ "play", PERMISSION_CONTROL, 0, 1, handle_play },
 	{ "playid", PERMISSION_CONTROL, 0, 1, handle_playid },
 	{ "playlist", PERMISSION_READ, 0, 0, handle_playlist },
@@ -211,6 +221,29 @@ static constexpr struct command commands[] = {
 
 static constexpr unsigned num_commands = std::size(commands);
 
+static constexpr Domain command_domain("command");
+
+/**
+ * Execution statistics for one command.
+ */
+struct CommandStats {
+	LatencyHistogram duration;
+
+	uint64_t bytes_written = 0;
+};
+
+/**
+ * Execution statistics, indexed like #commands.  These are only
+ * accessed from the main thread.
+ */
+static CommandStats command_stats[num_commands];
+
+/**
+ * Commands taking longer than this are logged; zero disables
+ * logging.
+ */
+static std::chrono::steady_clock::duration slow_command_threshold;
+
 static bool
 command_available(gcc_unused const Partition &partition,
 		  gcc_unused const struct command *cmd)
@@ -280,9 +313,61 @@ handle_not_commands(Client &client, gcc_unused Request request, Response &r)
 	return PrintUnavailableCommands(r, client.GetPermission());
 }
 
+static unsigned long
+ToMicroseconds(std::chrono::steady_clock::duration d) noexcept
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+static void
+PrintLatencyHistogram(Response &r, const char *prefix,
+		      const LatencyHistogram &h) noexcept
+{
+	r.Format("%scount: %lu\n"
+		 "%sp50: %lu\n"
+		 "%sp99: %lu\n"
+		 "%smax: %lu\n",
+		 prefix, (unsigned long)h.GetCount(),
+		 prefix, ToMicroseconds(h.GetPercentile(50)),
+		 prefix, ToMicroseconds(h.GetPercentile(99)),
+		 prefix, ToMicroseconds(h.GetMax()));
+}
+
 void
-command_init()
+command_visit_stats(const std::function<void(const char *name,
+					     const LatencyHistogram &duration,
+					     uint64_t bytes_written)> &f)
+{
+	for (unsigned i = 0; i < num_commands; ++i) {
+		const auto &stats = command_stats[i];
+		if (stats.duration.GetCount() > 0)
+			f(commands[i].cmd, stats.duration,
+			  stats.bytes_written);
+	}
+}
+
+static CommandResult
+handle_latencystats(Client &client, gcc_unused Request request, Response &r)
 {
+	PrintLatencyHistogram(r, "loop_lag_",
+			      client.GetEventLoop().GetTimerLag());
+
+	command_visit_stats([&r](const char *name,
+				 const LatencyHistogram &duration,
+				 uint64_t bytes_written){
+		r.Format("command: %s\n", name);
+		PrintLatencyHistogram(r, "", duration);
+		r.Format("bytes: %lu\n", (unsigned long)bytes_written);
+	});
+
+	return CommandResult::OK;
+}
+
+void
+command_init(std::chrono::steady_clock::duration _slow_command_threshold)
+{
+	slow_command_threshold = _slow_command_threshold;
+
 #ifndef NDEBUG
 	/* ensure that the command list is sorted */
 	for (unsigned i = 0; i < num_commands - 1; ++i)
@@ -415,9 +500,24 @@ try {
 		command_checked_lookup(r, client.GetPermission(),
 				       cmd_name, args);
 
-	CommandResult ret = cmd
-		? cmd->handler(client, args, r)
-		: CommandResult::ERROR;
+	if (cmd == nullptr)
+		return CommandResult::ERROR;
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	CommandResult ret = cmd->handler(client, args, r);
+
+	const auto duration = std::chrono::steady_clock::now() - start_time;
+	auto &stats = command_stats[cmd - commands];
+	stats.duration.Add(duration);
+	stats.bytes_written += r.GetBytesWritten();
+
+	if (slow_command_threshold > slow_command_threshold.zero() &&
+	    duration > slow_command_threshold)
+		FormatWarning(command_domain,
+			      "Command \"%s\" took %lu ms",
+			      cmd->cmd,
+			      (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
 
 	return ret;
 } catch (const std::exception &e) {
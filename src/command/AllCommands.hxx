@@ -22,10 +22,20 @@
 
 #include "CommandResult.hxx"
 
+#include <chrono>
+#include <functional>
+
+#include <stdint.h>
+
 class Client;
+class LatencyHistogram;
 
+/**
+ * @param _slow_command_threshold log commands which take longer
+ * than this; zero disables logging
+ */
 void
-command_init();
+command_init(std::chrono::steady_clock::duration _slow_command_threshold);
 
 void
 command_finish();
@@ -33,4 +43,14 @@ command_finish();
 CommandResult
 command_process(Client &client, unsigned num, char *line);
 
+/**
+ * Invoke the given function for each command which has been
+ * executed at least once, passing its execution time histogram and
+ * the total size of its responses.
+ */
+void
+command_visit_stats(const std::function<void(const char *name,
+					     const LatencyHistogram &duration,
+					     uint64_t bytes_written)> &f);
+
 #endif
@@ -17,6 +17,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "config.h"
 #include "DatabaseCommands.hxx"
 #include "Request.hxx"
 #include "db/DatabaseQueue.hxx"
@@ -34,6 +35,10 @@
 #include "util/ASCII.hxx"
 #include "song/Filter.hxx"
 
+#ifdef ENABLE_SQLITE
+#include "StickerCommands.hxx"
+#endif
+
 #include <memory>
 #include <vector>
 
@@ -68,13 +73,25 @@ ParseSortTag(const char *s)
 	return tag;
 }
 
+/**
+ * Load the sticker values referenced by the filter.
+ */
+static void
+LoadStickers(gcc_unused Client &client, gcc_unused const SongFilter &filter)
+{
+#ifdef ENABLE_SQLITE
+	LoadFilterStickers(client, filter);
+#endif
+}
+
 /**
  * Convert all remaining arguments to a #DatabaseSelection.
  *
  * @param filter a buffer to be used for DatabaseSelection::filter
  */
 static DatabaseSelection
-ParseDatabaseSelection(Request args, bool fold_case, SongFilter &filter)
+ParseDatabaseSelection(Client &client, Request args, bool fold_case,
+		       SongFilter &filter)
 {
 	RangeArg window = RangeArg::All();
 	if (args.size >= 2 && StringIsEqual(args[args.size - 2], "window")) {
@@ -106,6 +123,7 @@ ParseDatabaseSelection(Request args, bool fold_case, SongFilter &filter)
 				    GetFullMessage(std::current_exception()).c_str());
 	}
 	filter.Optimize();
+	LoadStickers(client, filter);
 
 	DatabaseSelection selection("", true, &filter);
 	selection.window = window;
@@ -118,7 +136,7 @@ static CommandResult
 handle_match(Client &client, Request args, Response &r, bool fold_case)
 {
 	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, fold_case, filter);
+	const auto selection = ParseDatabaseSelection(client, args, fold_case, filter);
 
 	db_selection_print(r, client.GetPartition(),
 			   selection, true, false);
@@ -141,7 +159,7 @@ static CommandResult
 handle_match_add(Client &client, Request args, bool fold_case)
 {
 	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, fold_case, filter);
+	const auto selection = ParseDatabaseSelection(client, args, fold_case, filter);
 
 	auto &partition = client.GetPartition();
 	AddFromDatabase(partition, selection);
@@ -166,7 +184,7 @@ handle_searchaddpl(Client &client, Request args, Response &)
 	const char *playlist = args.shift();
 
 	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, true, filter);
+	const auto selection = ParseDatabaseSelection(client, args, true, filter);
 
 	const Database &db = client.GetDatabaseOrThrow();
 
@@ -203,6 +221,7 @@ handle_count(Client &client, Request args, Response &r)
 		}
 
 		filter.Optimize();
+		LoadStickers(client, filter);
 	}
 
 	PrintSongCount(r, client.GetPartition(), "", &filter, group);
@@ -236,6 +255,7 @@ handle_list_file(Client &client, Request args, Response &r)
 			return CommandResult::ERROR;
 		}
 		filter->Optimize();
+		LoadStickers(client, *filter);
 	}
 
 	PrintSongUris(r, client.GetPartition(), filter.get());
@@ -311,6 +331,7 @@ handle_list(Client &client, Request args, Response &r)
 			return CommandResult::ERROR;
 		}
 		filter->Optimize();
+		LoadStickers(client, *filter);
 	}
 
 	PrintUniqueTags(r, client.GetPartition(),
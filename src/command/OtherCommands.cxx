@@ -40,6 +40,7 @@
 #include "util/StringView.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "Stats.hxx"
+#include "trace/PipelineTrace.hxx"
 #include "PlaylistFile.hxx"
 #include "db/PlaylistVector.hxx"
 #include "client/Client.hxx"
@@ -386,6 +387,26 @@ handle_config(Client &client, gcc_unused Request args, Response &r)
 	return CommandResult::OK;
 }
 
+CommandResult
+handle_pipelinetrace(gcc_unused Client &client, Request args, Response &r)
+{
+	const char *action = args.front();
+
+	if (StringIsEqual(action, "on"))
+		PipelineTrace::SetEnabled(true);
+	else if (StringIsEqual(action, "off"))
+		PipelineTrace::SetEnabled(false);
+	else if (StringIsEqual(action, "dump"))
+		PipelineTrace::DumpDefault();
+	else {
+		r.FormatError(ACK_ERROR_ARG, "Unrecognized action: %s",
+			      action);
+		return CommandResult::ERROR;
+	}
+
+	return CommandResult::OK;
+}
+
 CommandResult
 handle_idle(Client &client, Request args, Response &r)
 {
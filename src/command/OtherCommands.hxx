@@ -59,6 +59,9 @@ handle_stats(Client &client, Request request, Response &response);
 CommandResult
 handle_config(Client &client, Request request, Response &response);
 
+CommandResult
+handle_pipelinetrace(Client &client, Request request, Response &response);
+
 CommandResult
 handle_idle(Client &client, Request request, Response &response);
 
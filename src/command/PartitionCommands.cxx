@@ -102,7 +102,8 @@ handle_newpartition(Client &client, Request request, Response &response)
 					 16384,
 					 1024,
 					 AudioFormat::Undefined(),
-					 ReplayGainConfig());
+					 ReplayGainConfig(),
+					 false);
 	auto &partition = instance.partitions.back();
 	partition.outputs.AddNullOutput(instance.io_thread.GetEventLoop(),
 					ReplayGainConfig(),
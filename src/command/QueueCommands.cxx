@@ -33,12 +33,15 @@
 #include "client/Response.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
-#include "BulkEdit.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/Exception.hxx"
 #include "util/StringAPI.hxx"
 #include "util/NumberParser.hxx"
 
+#ifdef ENABLE_SQLITE
+#include "StickerCommands.hxx"
+#endif
+
 #include <limits>
 
 static void
@@ -54,11 +57,8 @@ AddDatabaseSelection(Client &client, const char *uri,
 		     gcc_unused Response &r)
 {
 #ifdef ENABLE_DATABASE
-	auto &partition = client.GetPartition();
-	const ScopeBulkEdit bulk_edit(partition);
-
 	const DatabaseSelection selection(uri, true);
-	AddFromDatabase(partition, selection);
+	AddFromDatabase(client.GetPartition(), selection);
 	return CommandResult::OK;
 #else
 	(void)client;
@@ -274,6 +274,10 @@ handle_playlist_match(Client &client, Request args, Response &r,
 	}
 	filter.Optimize();
 
+#ifdef ENABLE_SQLITE
+	LoadFilterStickers(client, filter);
+#endif
+
 	playlist_print_find(r, client.GetPlaylist(), filter);
 	return CommandResult::OK;
 }
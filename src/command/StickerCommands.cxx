@@ -26,6 +26,8 @@
 #include "sticker/Print.hxx"
 #include "client/Client.hxx"
 #include "client/Response.hxx"
+#include "protocol/Ack.hxx"
+#include "song/Filter.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "util/StringAPI.hxx"
@@ -176,3 +178,17 @@ handle_sticker(Client &client, Request args, Response &r)
 		return CommandResult::ERROR;
 	}
 }
+
+void
+LoadFilterStickers(Client &client, const SongFilter &filter)
+{
+	if (filter.GetStickerPredicates().empty())
+		return;
+
+	auto &instance = client.GetInstance();
+	if (!instance.HasStickerDatabase())
+		throw ProtocolError(ACK_ERROR_UNKNOWN,
+				    "sticker database is disabled");
+
+	sticker_song_load_filter(*instance.sticker_database, filter);
+}
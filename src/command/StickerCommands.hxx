@@ -25,8 +25,18 @@
 class Client;
 class Request;
 class Response;
+class SongFilter;
 
 CommandResult
 handle_sticker(Client &client, Request request, Response &response);
 
+/**
+ * Load the sticker values referenced by the filter (if any).
+ *
+ * Throws #ProtocolError if the filter contains sticker predicates,
+ * but the sticker database is disabled.
+ */
+void
+LoadFilterStickers(Client &client, const SongFilter &filter);
+
 #endif
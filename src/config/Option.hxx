@@ -79,6 +79,11 @@ enum class ConfigOption {
 	DESPOTIFY_USER,
 	DESPOTIFY_PASSWORD,
 	DESPOTIFY_HIGH_BITRATE,
+	PREDECODE_NEXT_SONG,
+	MLOCKALL,
+	LATENCY_LOG_THRESHOLD,
+	PIPELINE_TRACE,
+	PIPELINE_TRACE_FILE,
 	MAX
 };
 
@@ -87,6 +92,9 @@ enum class ConfigBlockOption {
 	DECODER,
 	INPUT,
 	INPUT_CACHE,
+	DECODER_CACHE,
+	THREAD,
+	METRICS,
 	PLAYLIST_PLUGIN,
 	RESAMPLER,
 	AUDIO_FILTER,
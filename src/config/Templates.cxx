@@ -75,6 +75,11 @@ const ConfigTemplate config_param_templates[] = {
 	{ "despotify_user", false, true },
 	{ "despotify_password", false, true },
 	{ "despotify_high_bitrate", false, true },
+	{ "predecode_next_song" },
+	{ "mlockall" },
+	{ "latency_log_threshold" },
+	{ "pipeline_trace" },
+	{ "pipeline_trace_file" },
 };
 
 static constexpr unsigned n_config_param_templates =
@@ -88,6 +93,9 @@ const ConfigTemplate config_block_templates[] = {
 	{ "decoder", true },
 	{ "input", true },
 	{ "input_cache" },
+	{ "decoder_cache" },
+	{ "thread", true },
+	{ "metrics" },
 	{ "playlist_plugin", true },
 	{ "resampler" },
 	{ "filter", true },
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ThreadConfig.hxx"
+#include "Data.hxx"
+#include "Block.hxx"
+#include "Domain.hxx"
+#include "util/RuntimeError.hxx"
+#include "util/StringAPI.hxx"
+#include "Log.hxx"
+
+#include <array>
+
+#include <stdlib.h>
+
+#ifdef HAVE_MLOCKALL
+#include <sys/mman.h>
+#endif
+
+static constexpr const char *thread_kind_names[] = {
+	"decoder",
+	"player",
+	"output",
+	"update",
+	"io",
+	"rtio",
+};
+
+static_assert(std::size(thread_kind_names) == size_t(ThreadKind::MAX),
+	      "Wrong number of thread_kind_names");
+
+static std::array<ThreadConfig, size_t(ThreadKind::MAX)> thread_configs;
+
+static ThreadKind
+ParseThreadKind(const char *s)
+{
+	for (size_t i = 0; i < size_t(ThreadKind::MAX); ++i)
+		if (StringIsEqual(s, thread_kind_names[i]))
+			return ThreadKind(i);
+
+	throw FormatRuntimeError("Unknown thread name: %s", s);
+}
+
+static ThreadScheduler
+ParseThreadScheduler(const char *s)
+{
+	if (StringIsEqual(s, "other"))
+		return ThreadScheduler::OTHER;
+	else if (StringIsEqual(s, "batch"))
+		return ThreadScheduler::BATCH;
+	else if (StringIsEqual(s, "idle"))
+		return ThreadScheduler::IDLE;
+	else if (StringIsEqual(s, "fifo"))
+		return ThreadScheduler::FIFO;
+	else if (StringIsEqual(s, "rr"))
+		return ThreadScheduler::RR;
+	else
+		throw FormatRuntimeError("Unknown scheduler: %s", s);
+}
+
+static unsigned
+ParseCpuNumber(const char *s, char **endptr)
+{
+	const unsigned long n = strtoul(s, endptr, 10);
+	if (*endptr == s)
+		throw std::runtime_error("CPU number expected");
+
+	if (n >= 64)
+		throw FormatRuntimeError("CPU number too large: %lu", n);
+
+	return n;
+}
+
+/**
+ * Parse a list of CPU numbers and ranges, e.g. "0,2-3".
+ */
+static uint64_t
+ParseCpuList(const char *s)
+{
+	uint64_t mask = 0;
+
+	while (true) {
+		char *endptr;
+		unsigned first = ParseCpuNumber(s, &endptr), last = first;
+		if (*endptr == '-')
+			last = ParseCpuNumber(endptr + 1, &endptr);
+
+		if (last < first)
+			throw std::runtime_error("Invalid CPU range");
+
+		for (unsigned i = first; i <= last; ++i)
+			mask |= uint64_t(1) << i;
+
+		if (*endptr == 0)
+			break;
+
+		if (*endptr != ',')
+			throw std::runtime_error("Malformed CPU list");
+
+		s = endptr + 1;
+	}
+
+	return mask;
+}
+
+static ThreadConfig
+LoadThreadConfig(ThreadKind kind, const ConfigBlock &block)
+{
+	ThreadConfig c;
+
+	const auto *scheduler = block.GetBlockParam("scheduler");
+	if (scheduler != nullptr) {
+		c.has_scheduler = true;
+		c.scheduler = scheduler->With(ParseThreadScheduler);
+	}
+
+	c.priority = block.GetBlockValue("priority", 0);
+	if (c.scheduler == ThreadScheduler::FIFO ||
+	    c.scheduler == ThreadScheduler::RR) {
+		if (c.priority < 1 || c.priority > 99)
+			throw std::runtime_error("Real-time priority must be between 1 and 99");
+	} else if (c.priority < -20 || c.priority > 19)
+		throw std::runtime_error("Nice value must be between -20 and 19");
+
+	const auto *cpu_affinity = block.GetBlockParam("cpu_affinity");
+	if (cpu_affinity != nullptr)
+		c.cpu_mask = cpu_affinity->With(ParseCpuList);
+
+	c.latency_probe = block.GetBlockValue("latency_probe", false);
+	if (c.latency_probe && kind != ThreadKind::IO &&
+	    kind != ThreadKind::RTIO)
+		throw std::runtime_error("latency_probe is only supported by the \"io\" and \"rtio\" threads");
+
+	return c;
+}
+
+void
+InitThreadConfig(const ConfigData &config)
+{
+	std::array<bool, size_t(ThreadKind::MAX)> seen{};
+
+	for (const auto &block : config.GetBlockList(ConfigBlockOption::THREAD)) {
+		block.SetUsed();
+
+		const auto *name = block.GetBlockParam("name");
+		if (name == nullptr)
+			throw FormatRuntimeError("Missing \"name\" in thread block on line %i",
+						 block.line);
+
+		const auto kind = name->With(ParseThreadKind);
+		if (seen[size_t(kind)])
+			throw FormatRuntimeError("Duplicate thread block \"%s\" on line %i",
+						 name->value.c_str(), block.line);
+		seen[size_t(kind)] = true;
+
+		try {
+			thread_configs[size_t(kind)] =
+				LoadThreadConfig(kind, block);
+		} catch (...) {
+			std::throw_with_nested(FormatRuntimeError("Error in thread block on line %i",
+								  block.line));
+		}
+	}
+
+	if (config.GetBool(ConfigOption::MLOCKALL, false)) {
+#ifdef HAVE_MLOCKALL
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+			LogErrno(config_domain, "mlockall() failed");
+#else
+		LogWarning(config_domain,
+			   "mlockall is not supported on this platform");
+#endif
+	}
+}
+
+const ThreadConfig &
+GetThreadConfig(ThreadKind kind) noexcept
+{
+	return thread_configs[size_t(kind)];
+}
+
+bool
+ApplyThreadConfig(ThreadKind kind) noexcept
+{
+	const auto &c = GetThreadConfig(kind);
+	const char *name = thread_kind_names[size_t(kind)];
+
+	if (c.has_scheduler) {
+		try {
+			SetThreadScheduler(c.scheduler, c.priority);
+		} catch (...) {
+			FormatError(std::current_exception(),
+				    "Failed to set the scheduler of the %s thread",
+				    name);
+		}
+	}
+
+	if (c.cpu_mask != 0) {
+		try {
+			SetThreadAffinity(c.cpu_mask);
+		} catch (...) {
+			FormatError(std::current_exception(),
+				    "Failed to set the CPU affinity of the %s thread",
+				    name);
+		}
+	}
+
+	return c.has_scheduler;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_CONFIG_THREAD_HXX
+#define MPD_CONFIG_THREAD_HXX
+
+#include "thread/Util.hxx"
+
+#include <stdint.h>
+
+struct ConfigData;
+
+/**
+ * The kinds of threads which can be configured with a "thread"
+ * block.
+ */
+enum class ThreadKind : uint8_t {
+	DECODER,
+	PLAYER,
+	OUTPUT,
+	UPDATE,
+	IO,
+	RTIO,
+	MAX
+};
+
+/**
+ * The settings of one "thread" block.
+ */
+struct ThreadConfig {
+	/**
+	 * Was a "scheduler" configured?  If not, the thread keeps
+	 * its built-in default.
+	 */
+	bool has_scheduler = false;
+
+	ThreadScheduler scheduler = ThreadScheduler::OTHER;
+
+	int priority = 0;
+
+	/**
+	 * The CPUs this thread may run on; 0 means no restriction.
+	 */
+	uint64_t cpu_mask = 0;
+
+	/**
+	 * Measure the wakeup latency of this thread's #EventLoop?
+	 * Only supported by the "io" and "rtio" threads.
+	 */
+	bool latency_probe = false;
+};
+
+/**
+ * Load all "thread" blocks and apply the "mlockall" setting.  This
+ * must be called after daemonizing, because memory locks are not
+ * inherited by fork(), and before the configured threads are
+ * started.
+ *
+ * Throws on error.
+ */
+void
+InitThreadConfig(const ConfigData &config);
+
+/**
+ * Returns the settings for the given kind of thread.
+ */
+const ThreadConfig &
+GetThreadConfig(ThreadKind kind) noexcept;
+
+/**
+ * Apply the configured settings to the current thread.  Errors are
+ * logged.
+ *
+ * @return true if a scheduling policy was configured, i.e. the
+ * caller shall not apply its own default policy
+ */
+bool
+ApplyThreadConfig(ThreadKind kind) noexcept;
+
+#endif
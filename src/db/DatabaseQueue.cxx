@@ -22,25 +22,53 @@
 #include "Interface.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
+#include "BulkEdit.hxx"
 #include "song/DetachedSong.hxx"
 
-#include <functional>
+#include <vector>
 
-static void
-AddToQueue(Partition &partition, const LightSong &song)
-{
-	const auto *storage = partition.instance.storage;
-	partition.playlist.AppendSong(partition.pc,
-				      DatabaseDetachSong(storage,
-							 song));
-}
+/**
+ * The number of songs which are collected before they are appended
+ * to the queue in one batch.
+ */
+static constexpr std::size_t ADD_BATCH_SIZE = 1024;
 
 void
 AddFromDatabase(Partition &partition, const DatabaseSelection &selection)
 {
 	const Database &db = partition.instance.GetDatabaseOrThrow();
+	const auto *storage = partition.instance.storage;
+
+	/* postpone the "playlist" idle event and the queued song
+	   update until all batches have been appended */
+	const ScopeBulkEdit bulk_edit(partition);
+
+	std::vector<DetachedSong> batch;
+	batch.reserve(ADD_BATCH_SIZE);
+
+	auto flush = [&partition, &batch](){
+		partition.playlist.AppendSongs(partition.pc, batch);
+		batch.clear();
+	};
+
+	try {
+		db.Visit(selection, [storage, &batch, &flush](const LightSong &song){
+				batch.emplace_back(DatabaseDetachSong(storage, song));
+				if (batch.size() >= ADD_BATCH_SIZE)
+					flush();
+			});
+	} catch (...) {
+		/* append the songs which were visited before the
+		   error */
+		try {
+			flush();
+		} catch (...) {
+			/* the queue is full; report the original
+			   error */
+		}
+
+		throw;
+	}
 
-	using namespace std::placeholders;
-	const auto f = std::bind(AddToQueue, std::ref(partition), _1);
-	db.Visit(selection, f);
+	flush();
 }
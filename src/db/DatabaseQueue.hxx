@@ -23,6 +23,13 @@
 struct Partition;
 struct DatabaseSelection;
 
+/**
+ * Append all songs matching the selection to the queue.  Listeners
+ * are notified only once, after all songs have been appended.
+ *
+ * Throws on error.  Songs which were found before the error are
+ * appended nonetheless.
+ */
 void
 AddFromDatabase(Partition &partition, const DatabaseSelection &selection);
 
@@ -31,6 +31,7 @@
 #include "thread/Thread.hxx"
 #include "thread/Name.hxx"
 #include "thread/Util.hxx"
+#include "config/ThreadConfig.hxx"
 
 #ifndef NDEBUG
 #include "event/Loop.hxx"
@@ -118,7 +119,8 @@ UpdateService::Task() noexcept
 	else
 		LogDebug(update_domain, "starting");
 
-	SetThreadIdlePriority();
+	if (!ApplyThreadConfig(ThreadKind::UPDATE))
+		SetThreadIdlePriority();
 
 	modified = walk->Walk(next.db->GetRoot(), next.path_utf8.c_str(),
 			      next.discard);
@@ -149,6 +151,7 @@ UpdateService::StartThread(UpdateQueueItem &&i)
 	modified = false;
 
 	next = std::move(i);
+	start_time = std::chrono::steady_clock::now();
 	walk = std::make_unique<UpdateWalk>(config, GetEventLoop(), listener,
 					    *next.storage);
 
@@ -251,6 +254,11 @@ UpdateService::RunDeferred() noexcept
 
 	next.Clear();
 
+	const auto duration = std::chrono::steady_clock::now() - start_time;
+	++stats.n_jobs;
+	stats.last_duration = duration;
+	stats.total_duration += duration;
+
 	idle_add(IDLE_UPDATE);
 
 	if (modified)
@@ -26,6 +26,7 @@
 #include "thread/Thread.hxx"
 #include "util/Compiler.h"
 
+#include <chrono>
 #include <memory>
 
 class SimpleDatabase;
@@ -60,6 +61,25 @@ class UpdateService final {
 
 	std::unique_ptr<UpdateWalk> walk;
 
+public:
+	struct Stats {
+		/**
+		 * The number of finished update jobs.
+		 */
+		unsigned n_jobs = 0;
+
+		std::chrono::steady_clock::duration last_duration{};
+		std::chrono::steady_clock::duration total_duration{};
+	};
+
+private:
+	/**
+	 * When was the current job started?
+	 */
+	std::chrono::steady_clock::time_point start_time;
+
+	Stats stats;
+
 public:
 	UpdateService(const ConfigData &_config,
 		      EventLoop &_loop, SimpleDatabase &_db,
@@ -80,6 +100,10 @@ public:
 		return next.id;
 	}
 
+	const Stats &GetStats() const noexcept {
+		return stats;
+	}
+
 	/**
 	 * Add this path to the database update queue.
 	 *
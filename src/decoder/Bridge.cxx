@@ -32,7 +32,10 @@
 #include "input/LocalOpen.hxx"
 #include "input/cache/Manager.hxx"
 #include "input/cache/Stream.hxx"
+#include "cache/Manager.hxx"
+#include "cache/Item.hxx"
 #include "fs/Path.hxx"
+#include "trace/PipelineTrace.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/StringBuffer.hxx"
 
@@ -117,6 +120,9 @@ DecoderBridge::GetChunk() noexcept
 		return current_chunk.get();
 
 	do {
+		if (dc.LockWaitPipeLimit() != DecoderCommand::NONE)
+			return nullptr;
+
 		current_chunk = dc.buffer->Allocate();
 		if (current_chunk != nullptr) {
 			current_chunk->replay_gain_serial = replay_gain_serial;
@@ -132,6 +138,64 @@ DecoderBridge::GetChunk() noexcept
 	return nullptr;
 }
 
+void
+DecoderBridge::StartCacheRecording(const DecoderCacheManager &cache,
+				   const char *uri,
+				   std::chrono::system_clock::time_point mtime) noexcept
+{
+	cache_item = std::make_unique<DecoderCacheItem>(uri, mtime);
+	cache_max_size = cache.GetMaxItemSize();
+}
+
+void
+DecoderBridge::CommitCacheRecording(DecoderCacheManager &cache) noexcept
+{
+	if (cache_item == nullptr || !dc.in_audio_format.IsDefined())
+		return;
+
+	if (!dc.total_time.IsNegative()) {
+		/* the decoder plugin may have given up early because
+		   of a decoding error which it did not report; accept
+		   only songs which are (almost) as long as
+		   announced */
+		const auto recorded = dc.in_audio_format
+			.SizeToTime<SongTime>(cache_item->data.size());
+		if (uint64_t(recorded.ToMS()) * 50 <
+		    uint64_t(dc.total_time.ToMS()) * 49) {
+			cache_item.reset();
+			return;
+		}
+	}
+
+	cache_item->audio_format = dc.in_audio_format;
+	cache_item->duration = dc.total_time;
+	if (replay_gain_serial != 0)
+		cache_item->replay_gain = replay_gain_info;
+	cache_item->mix_ramp = dc.GetMixRamp();
+	if (decoder_tag != nullptr)
+		cache_item->tag = std::make_unique<Tag>(*decoder_tag);
+
+	cache.Put(std::move(cache_item));
+}
+
+void
+DecoderBridge::RecordCacheData(const void *data, size_t length,
+			       uint16_t kbit_rate) noexcept
+{
+	assert(cache_item != nullptr);
+
+	auto &buffer = cache_item->data;
+	if (length > cache_max_size - buffer.size()) {
+		/* too large for the cache */
+		cache_item.reset();
+		return;
+	}
+
+	const auto *p = (const uint8_t *)data;
+	buffer.insert(buffer.end(), p, p + length);
+	cache_item->kbit_rate = kbit_rate;
+}
+
 void
 DecoderBridge::FlushChunk() noexcept
 {
@@ -141,10 +205,17 @@ DecoderBridge::FlushChunk() noexcept
 	assert(current_chunk != nullptr);
 
 	auto chunk = std::move(current_chunk);
-	if (!chunk->IsEmpty())
+	const size_t nbytes = chunk->length;
+	if (!chunk->IsEmpty()) {
 		dc.pipe->Push(std::move(chunk));
 
+		if (PipelineTrace::IsEnabled())
+			PipelineTrace::Record(PipelineTraceEvent::CHUNK_PRODUCED,
+					      nullptr, dc.pipe->GetSize());
+	}
+
 	const std::lock_guard<Mutex> protect(dc.mutex);
+	dc.decoded_time += dc.out_audio_format.SizeToTime<FloatDuration>(nbytes);
 	if (dc.client_is_waiting)
 		dc.client_cond.notify_one();
 }
@@ -282,6 +353,18 @@ DecoderBridge::Ready(const AudioFormat audio_format,
 			error = std::current_exception();
 		}
 	}
+
+	if (cache_item != nullptr && !duration.IsNegative()) {
+		/* allocate the whole song at once */
+		const size_t expected =
+			audio_format.TimeToSize(SongTime(duration));
+		try {
+			cache_item->data.reserve(std::min(expected,
+							  cache_max_size));
+		} catch (const std::bad_alloc &) {
+			cache_item.reset();
+		}
+	}
 }
 
 DecoderCommand
@@ -315,6 +398,9 @@ DecoderBridge::CommandFinished() noexcept
 	if (seeking) {
 		seeking = false;
 
+		/* the recorded data is not contiguous anymore */
+		cache_item.reset();
+
 		/* delete frames from the old song position */
 
 		current_chunk.reset();
@@ -367,6 +453,8 @@ DecoderBridge::SeekError() noexcept
 
 	assert(dc.command == DecoderCommand::SEEK);
 
+	cache_item.reset();
+
 	dc.seek_error = true;
 	seeking = false;
 
@@ -428,6 +516,7 @@ try {
 	return nbytes;
 } catch (...) {
 	error = std::current_exception();
+	cache_item.reset();
 	return 0;
 }
 
@@ -496,6 +585,9 @@ DecoderBridge::SubmitData(InputStream *is,
 		}
 	}
 
+	if (cache_item != nullptr)
+		RecordCacheData(data, length, kbit_rate);
+
 	if (convert != nullptr) {
 		assert(dc.in_audio_format != dc.out_audio_format);
 
@@ -24,10 +24,13 @@
 #include "ReplayGainInfo.hxx"
 #include "MusicChunkPtr.hxx"
 
+#include <chrono>
 #include <exception>
 #include <memory>
 
 class PcmConvert;
+class DecoderCacheManager;
+struct DecoderCacheItem;
 struct MusicChunk;
 class DecoderControl;
 class Path;
@@ -110,6 +113,19 @@ private:
 	 */
 	std::exception_ptr error;
 
+	/**
+	 * The decoded PCM data is being collected in this object, to
+	 * be added to the #DecoderCacheManager after the song has
+	 * been decoded completely.  nullptr if the song is not being
+	 * recorded (or if recording was aborted, e.g. by seeking).
+	 */
+	std::unique_ptr<DecoderCacheItem> cache_item;
+
+	/**
+	 * Abort the recording if #cache_item grows beyond this size.
+	 */
+	size_t cache_max_size;
+
 public:
 	DecoderBridge(DecoderControl &_dc, bool _initial_seek_pending,
 		      std::unique_ptr<Tag> _tag) noexcept;
@@ -154,6 +170,22 @@ public:
 			std::rethrow_exception(error);
 	}
 
+	/**
+	 * Begin collecting the decoded PCM data for the
+	 * #DecoderCacheManager.
+	 */
+	void StartCacheRecording(const DecoderCacheManager &cache,
+				 const char *uri,
+				 std::chrono::system_clock::time_point mtime) noexcept;
+
+	/**
+	 * The song has been decoded completely: add the recorded
+	 * data to the #DecoderCacheManager.  Nothing is added if the
+	 * recording was aborted (by seeking or by an error) or if
+	 * the data is shorter than the announced duration.
+	 */
+	void CommitCacheRecording(DecoderCacheManager &cache) noexcept;
+
 	/**
 	 * Open a local file.
 	 */
@@ -199,6 +231,12 @@ private:
 	 */
 	DecoderCommand DoSendTag(const Tag &tag) noexcept;
 
+	/**
+	 * Append raw PCM data (before conversion) to #cache_item.
+	 */
+	void RecordCacheData(const void *data, size_t length,
+			     uint16_t kbit_rate) noexcept;
+
 	bool UpdateStreamTag(InputStream *is) noexcept;
 };
 
@@ -27,10 +27,11 @@
 
 DecoderControl::DecoderControl(Mutex &_mutex, Cond &_client_cond,
 			       InputCacheManager *_input_cache,
+			       DecoderCacheManager *_decoder_cache,
 			       const AudioFormat _configured_audio_format,
 			       const ReplayGainConfig &_replay_gain_config) noexcept
 	:thread(BIND_THIS_METHOD(RunThread)),
-	 input_cache(_input_cache),
+	 input_cache(_input_cache), decoder_cache(_decoder_cache),
 	 mutex(_mutex), client_cond(_client_cond),
 	 configured_audio_format(_configured_audio_format),
 	 replay_gain_config(_replay_gain_config) {}
@@ -89,6 +90,22 @@ DecoderControl::IsCurrentSong(const DetachedSong &_song) const noexcept
 	gcc_unreachable();
 }
 
+bool
+DecoderControl::IsPipeLimitReached() const noexcept
+{
+	return pipe_limit > 0 && pipe->GetSize() >= pipe_limit;
+}
+
+DecoderCommand
+DecoderControl::LockWaitPipeLimit() noexcept
+{
+	std::unique_lock<Mutex> lock(mutex);
+	while (command == DecoderCommand::NONE && IsPipeLimitReached())
+		Wait(lock);
+
+	return command;
+}
+
 void
 DecoderControl::Start(std::unique_lock<Mutex> &lock,
 		      std::unique_ptr<DetachedSong> _song,
@@ -47,6 +47,7 @@ class DetachedSong;
 class MusicBuffer;
 class MusicPipe;
 class InputCacheManager;
+class DecoderCacheManager;
 
 enum class DecoderState : uint8_t {
 	STOP = 0,
@@ -71,6 +72,8 @@ class DecoderControl final : public InputStreamHandler {
 public:
 	InputCacheManager *const input_cache;
 
+	DecoderCacheManager *const decoder_cache;
+
 	/**
 	 * This lock protects #state and #command.
 	 *
@@ -169,6 +172,26 @@ public:
 	 */
 	std::shared_ptr<MusicPipe> pipe;
 
+	/**
+	 * If non-zero, then the decoder pauses as soon as #pipe
+	 * contains this number of chunks, until the client resets
+	 * this attribute and calls Signal().  This is used to
+	 * pre-decode only the beginning of the next song in a second
+	 * decoder, without taking too much of the #MusicBuffer from
+	 * the current song.
+	 *
+	 * Protected by #mutex.
+	 */
+	unsigned pipe_limit = 0;
+
+	/**
+	 * The total duration of the audio this decoder has submitted
+	 * to its pipes.  This is used for throughput statistics.
+	 *
+	 * Protected by #mutex.
+	 */
+	FloatDuration decoded_time = FloatDuration::zero();
+
 	const ReplayGainConfig replay_gain_config;
 	ReplayGainMode replay_gain_mode = ReplayGainMode::OFF;
 
@@ -185,6 +208,7 @@ public:
 	 */
 	DecoderControl(Mutex &_mutex, Cond &_client_cond,
 		       InputCacheManager *_input_cache,
+		       DecoderCacheManager *_decoder_cache,
 		       const AudioFormat _configured_audio_format,
 		       const ReplayGainConfig &_replay_gain_config) noexcept;
 	~DecoderControl() noexcept;
@@ -310,6 +334,25 @@ public:
 	gcc_pure
 	bool IsCurrentSong(const DetachedSong &_song) const noexcept;
 
+	/**
+	 * Has #pipe reached #pipe_limit?
+	 *
+	 * Caller must lock the object.
+	 */
+	gcc_pure
+	bool IsPipeLimitReached() const noexcept;
+
+	/**
+	 * If #pipe has reached #pipe_limit, wait until the player
+	 * lifts the limit (or sends a command).  This function is
+	 * only valid in the decoder thread.
+	 *
+	 * Caller must not lock the object.
+	 *
+	 * @return the pending command or DecoderCommand::NONE
+	 */
+	DecoderCommand LockWaitPipeLimit() noexcept;
+
 	gcc_pure
 	bool IsUnseekableCurrentSong(const DetachedSong &_song) const noexcept {
 		return !seekable && IsCurrentSong(_song);
@@ -412,6 +455,10 @@ public:
 
 	void Quit() noexcept;
 
+	const MixRampInfo &GetMixRamp() const noexcept {
+		return mix_ramp;
+	}
+
 	const char *GetMixRampStart() const noexcept {
 		return mix_ramp.GetStart();
 	}
@@ -434,6 +481,20 @@ public:
 	 */
 	void CycleMixRamp() noexcept;
 
+	/**
+	 * Copy the MixRamp and ReplayGain information of the song
+	 * decoded by another #DecoderControl, as if this object had
+	 * decoded it before the current song.  This is used when the
+	 * player switches to a decoder which has pre-decoded the next
+	 * song in parallel.
+	 *
+	 * Caller must lock the object.
+	 */
+	void TakePrevious(const DecoderControl &other) noexcept {
+		previous_mix_ramp = other.mix_ramp;
+		replay_gain_prev_db = other.replay_gain_db;
+	}
+
 private:
 	void RunThread() noexcept;
 
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SeekIndexCache.hxx"
+#include "Domain.hxx"
+#include "fs/io/FileReader.hxx"
+#include "fs/io/BufferedReader.hxx"
+#include "fs/io/FileOutputStream.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/Traits.hxx"
+#include "system/Error.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
+#include "Log.hxx"
+
+#include <stdexcept>
+
+#include <stdio.h>
+#include <string.h>
+
+static constexpr char SEEK_INDEX_MAGIC[8] = {
+	'M', 'P', 'D', 'S', 'E', 'E', 'K', '2',
+};
+
+/**
+ * Refuse to load indexes larger than this; the MAD decoder plugin
+ * doesn't support more frames anyway.
+ */
+static constexpr uint64_t MAX_SEEK_POINTS = 8 * 1024 * 1024;
+
+/**
+ * The header of a seek index file.  It is followed by the URI (not
+ * null-terminated) and the #SeekPoint array.  All values are in
+ * host byte order, because the file is only a local cache.
+ */
+struct SeekIndexHeader {
+	char magic[sizeof(SEEK_INDEX_MAGIC)];
+
+	uint64_t file_size;
+
+	/**
+	 * The modification time of the file in nanoseconds since
+	 * the epoch.
+	 */
+	int64_t file_mtime;
+
+	uint32_t uri_length;
+
+	uint32_t reserved;
+
+	uint64_t n_points;
+};
+
+gcc_const
+static int64_t
+ExportTime(std::chrono::system_clock::time_point t) noexcept
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(t.time_since_epoch()).count();
+}
+
+/**
+ * The 64 bit FNV-1a hash of the given string.
+ */
+gcc_pure
+static uint64_t
+HashURI(const char *uri) noexcept
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char *p = uri; *p != 0; ++p) {
+		hash ^= (unsigned char)*p;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+AllocatedPath
+SeekIndexCache::MakePath(const char *uri) const noexcept
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.seek",
+		 (unsigned long long)HashURI(uri));
+
+	return AllocatedPath::Build(directory, AllocatedPath::FromUTF8(name));
+}
+
+bool
+SeekIndexCache::GetModificationTime(const char *uri,
+				    std::chrono::system_clock::time_point &mtime) noexcept
+{
+	/* the URI of a local file's input stream is its absolute
+	   path */
+	if (!PathTraitsUTF8::IsAbsolute(uri))
+		return false;
+
+	const auto path = AllocatedPath::FromUTF8(uri);
+	FileInfo fi;
+	if (path.IsNull() || !GetFileInfo(path, fi))
+		return false;
+
+	mtime = fi.GetModificationTime();
+	return true;
+}
+
+std::vector<SeekPoint>
+SeekIndexCache::Load(const char *uri, uint64_t size,
+		     std::chrono::system_clock::time_point mtime) const noexcept
+try {
+	FileReader file(MakePath(uri));
+	BufferedReader reader(file);
+
+	SeekIndexHeader header;
+	reader.ReadFull({&header, sizeof(header)});
+
+	const size_t uri_length = strlen(uri);
+	if (memcmp(header.magic, SEEK_INDEX_MAGIC,
+		   sizeof(header.magic)) != 0 ||
+	    header.file_size != size ||
+	    header.file_mtime != ExportTime(mtime) ||
+	    header.uri_length != uri_length ||
+	    header.n_points > MAX_SEEK_POINTS)
+		/* stale or foreign file */
+		return {};
+
+	std::vector<char> stored_uri(uri_length);
+	reader.ReadFull({stored_uri.data(), uri_length});
+	if (memcmp(stored_uri.data(), uri, uri_length) != 0)
+		/* hash collision */
+		return {};
+
+	std::vector<SeekPoint> points(header.n_points);
+	reader.ReadFull({points.data(), points.size() * sizeof(points[0])});
+
+	FormatDebug(decoder_domain, "Loaded %zu seek points for %s",
+		    points.size(), uri);
+	return points;
+} catch (const std::system_error &e) {
+	if (!IsFileNotFound(e))
+		LogError(e);
+	return {};
+} catch (...) {
+	LogError(std::current_exception());
+	return {};
+}
+
+void
+SeekIndexCache::Save(const char *uri, uint64_t size,
+		     std::chrono::system_clock::time_point mtime,
+		     ConstBuffer<SeekPoint> points) const
+{
+	SeekIndexHeader header;
+	memcpy(header.magic, SEEK_INDEX_MAGIC, sizeof(header.magic));
+	header.file_size = size;
+	header.file_mtime = ExportTime(mtime);
+	header.uri_length = strlen(uri);
+	header.reserved = 0;
+	header.n_points = points.size;
+
+	FileOutputStream file(MakePath(uri));
+	file.Write(&header, sizeof(header));
+	file.Write(uri, header.uri_length);
+	file.Write(points.data, points.size * sizeof(points.front()));
+	file.Commit();
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DECODER_SEEK_INDEX_CACHE_HXX
+#define MPD_DECODER_SEEK_INDEX_CACHE_HXX
+
+#include "fs/AllocatedPath.hxx"
+#include "util/Compiler.h"
+
+#include <chrono>
+#include <vector>
+
+#include <stdint.h>
+
+template<typename T> struct ConstBuffer;
+
+/**
+ * One entry of a seek index: the byte offset of a frame within the
+ * file and its time stamp.  The unit of #time is defined by the
+ * decoder plugin which created the index.
+ */
+struct SeekPoint {
+	uint64_t offset;
+	uint64_t time;
+};
+
+/**
+ * A persistent cache of seek indexes for files which cannot be
+ * seeked efficiently without one (e.g. VBR MP3 without a Xing
+ * table).  The index built by a decoder plugin during playback is
+ * stored in a file in the configured directory, and is loaded when
+ * the file gets played the next time, to allow seeking to any
+ * position right away.
+ *
+ * Each cache file is identified by a hash of the URI; the full URI
+ * and the size and modification time of the file are stored inside,
+ * and a mismatch invalidates the cached index.  Only local files
+ * are supported, because remote streams have no reliable
+ * modification time.
+ */
+class SeekIndexCache {
+	const AllocatedPath directory;
+
+public:
+	explicit SeekIndexCache(AllocatedPath &&_directory) noexcept
+		:directory(std::move(_directory)) {}
+
+	/**
+	 * Determine the modification time of the file with the
+	 * given (input stream) URI.
+	 *
+	 * @return false if the modification time is not known, e.g.
+	 * because this is not a local file; the file must not be
+	 * cached then
+	 */
+	static bool GetModificationTime(const char *uri,
+					std::chrono::system_clock::time_point &mtime) noexcept;
+
+	/**
+	 * Load the seek index of the given file.
+	 *
+	 * @param size the size of the file in bytes
+	 * @param mtime the modification time of the file
+	 * @return the index, or an empty vector if there is no
+	 * (valid) index for this file
+	 */
+	std::vector<SeekPoint> Load(const char *uri, uint64_t size,
+				    std::chrono::system_clock::time_point mtime) const noexcept;
+
+	/**
+	 * Store the seek index of the given file, replacing an
+	 * existing one.
+	 *
+	 * Throws on error.
+	 *
+	 * @param size the size of the file in bytes
+	 * @param mtime the modification time of the file before it
+	 * was decoded
+	 */
+	void Save(const char *uri, uint64_t size,
+		  std::chrono::system_clock::time_point mtime,
+		  ConstBuffer<SeekPoint> points) const;
+
+private:
+	gcc_pure
+	AllocatedPath MakePath(const char *uri) const noexcept;
+};
+
+#endif
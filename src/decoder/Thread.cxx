@@ -25,10 +25,13 @@
 #include "MusicPipe.hxx"
 #include "fs/Traits.hxx"
 #include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
 #include "DecoderAPI.hxx"
 #include "input/InputStream.hxx"
 #include "input/Registry.hxx"
 #include "DecoderList.hxx"
+#include "cache/Manager.hxx"
+#include "cache/Item.hxx"
 #include "system/Error.hxx"
 #include "util/MimeType.hxx"
 #include "util/UriUtil.hxx"
@@ -36,6 +39,7 @@
 #include "util/Domain.hxx"
 #include "util/ScopeExit.hxx"
 #include "thread/Name.hxx"
+#include "config/ThreadConfig.hxx"
 #include "tag/ApeReplayGain.hxx"
 #include "Log.hxx"
 
@@ -408,6 +412,46 @@ SongHasVolatileTags(const DetachedSong &song) noexcept
 	return !song.IsFile() && !HasRemoteTagScanner(song.GetRealURI());
 }
 
+/**
+ * Determine the modification time of the local file which is about
+ * to be decoded, to validate #DecoderCacheManager items.  The file is
+ * stat'ed, because it may have been modified after the last database
+ * update.
+ *
+ * Caller holds DecoderControl::mutex.
+ *
+ * @return false if this is not a local file or if it cannot be
+ * stat'ed
+ */
+static bool
+GetDecoderCacheModificationTime(DecoderControl &dc, Path path_fs,
+				std::chrono::system_clock::time_point &mtime) noexcept
+{
+	if (path_fs.IsNull())
+		return false;
+
+	FileInfo fi;
+	{
+		const ScopeUnlock unlock(dc.mutex);
+		if (!GetFileInfo(path_fs, fi))
+			return false;
+	}
+
+	mtime = fi.GetModificationTime();
+	return true;
+}
+
+/**
+ * Can the given song be stored in the #DecoderCacheManager?  Only
+ * complete songs are eligible.
+ */
+gcc_pure
+static bool
+IsDecoderCacheable(const DecoderControl &dc) noexcept
+{
+	return !dc.start_time.IsPositive() && !dc.end_time.IsPositive();
+}
+
 /**
  * Decode a song addressed by a #DetachedSong.
  *
@@ -425,6 +469,16 @@ decoder_run_song(DecoderControl &dc,
 				played it*/
 			     !SongHasVolatileTags(song) ? std::make_unique<Tag>(song.GetTag()) : nullptr);
 
+	std::shared_ptr<const DecoderCacheItem> cached;
+	std::chrono::system_clock::time_point mtime;
+	if (dc.decoder_cache != nullptr &&
+	    GetDecoderCacheModificationTime(dc, path_fs, mtime)) {
+		cached = dc.decoder_cache->Get(uri, mtime);
+		if (cached == nullptr && IsDecoderCacheable(dc))
+			bridge.StartCacheRecording(*dc.decoder_cache, uri,
+						   mtime);
+	}
+
 	dc.state = DecoderState::START;
 	dc.CommandFinishedLocked();
 
@@ -437,12 +491,23 @@ decoder_run_song(DecoderControl &dc,
 			bridge.CheckFlushChunk();
 		};
 
-		success = DecoderUnlockedRunUri(bridge, uri, path_fs);
+		if (cached != nullptr) {
+			/* serve the decoded PCM data from the cache
+			   instead of running the decoder plugin */
+			cached->Replay(bridge);
+			success = true;
+		} else
+			success = DecoderUnlockedRunUri(bridge, uri, path_fs);
 
 	}
 
 	bridge.CheckRethrowError();
 
+	if (success && dc.command == DecoderCommand::NONE &&
+	    dc.decoder_cache != nullptr)
+		/* the song was decoded completely */
+		bridge.CommitCacheRecording(*dc.decoder_cache);
+
 	if (success)
 		dc.state = DecoderState::STOP;
 	else {
@@ -490,6 +555,7 @@ void
 DecoderControl::RunThread() noexcept
 {
 	SetThreadName("decoder");
+	ApplyThreadConfig(ThreadKind::DECODER);
 
 	std::unique_lock<Mutex> lock(mutex);
 
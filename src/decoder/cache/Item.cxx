@@ -0,0 +1,74 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Item.hxx"
+#include "decoder/Client.hxx"
+#include "decoder/Command.hxx"
+
+#include <algorithm>
+
+/**
+ * Submit the PCM data in portions of (at most) this size.
+ */
+static constexpr size_t REPLAY_BLOCK_SIZE = 16384;
+
+void
+DecoderCacheItem::Replay(DecoderClient &client) const noexcept
+{
+	client.Ready(audio_format, true, duration);
+
+	if (replay_gain.IsDefined())
+		client.SubmitReplayGain(&replay_gain);
+
+	if (mix_ramp.IsDefined())
+		client.SubmitMixRamp(MixRampInfo(mix_ramp));
+
+	if (tag != nullptr)
+		client.SubmitTag(nullptr, Tag(*tag));
+
+	const size_t frame_size = audio_format.GetFrameSize();
+	const size_t block_size =
+		std::max(REPLAY_BLOCK_SIZE / frame_size, size_t(1)) * frame_size;
+
+	size_t position = 0;
+	auto cmd = client.GetCommand();
+	while (cmd != DecoderCommand::STOP) {
+		if (cmd == DecoderCommand::SEEK) {
+			const uint64_t frame = client.GetSeekFrame();
+			if (frame > data.size() / frame_size) {
+				client.SeekError();
+			} else {
+				position = frame * frame_size;
+				client.CommandFinished();
+			}
+
+			cmd = client.GetCommand();
+			continue;
+		}
+
+		if (position >= data.size())
+			break;
+
+		const size_t nbytes = std::min(data.size() - position,
+					       block_size);
+		cmd = client.SubmitData(nullptr, data.data() + position,
+					nbytes, kbit_rate);
+		position += nbytes;
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DECODER_CACHE_ITEM_HXX
+#define MPD_DECODER_CACHE_ITEM_HXX
+
+#include "AudioFormat.hxx"
+#include "Chrono.hxx"
+#include "ReplayGainInfo.hxx"
+#include "MixRampInfo.hxx"
+#include "tag/Tag.hxx"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+class DecoderClient;
+
+/**
+ * The decoded PCM data of one song in the #DecoderCacheManager,
+ * together with the other information submitted by the decoder
+ * plugin, which allows Replay() to stand in for the plugin.
+ */
+struct DecoderCacheItem {
+	const std::string uri;
+
+	/**
+	 * The modification time of the file when it was decoded.
+	 */
+	const std::chrono::system_clock::time_point mtime;
+
+	/**
+	 * The format of #data, i.e. the format announced by the
+	 * decoder plugin (before conversion to the configured
+	 * "audio_output_format").
+	 */
+	AudioFormat audio_format = AudioFormat::Undefined();
+
+	SignedSongTime duration = SignedSongTime::Negative();
+
+	ReplayGainInfo replay_gain;
+
+	MixRampInfo mix_ramp;
+
+	/**
+	 * The last tag submitted by the decoder plugin.
+	 */
+	std::unique_ptr<Tag> tag;
+
+	uint16_t kbit_rate = 0;
+
+	std::vector<uint8_t> data;
+
+	DecoderCacheItem(const char *_uri,
+			 std::chrono::system_clock::time_point _mtime) noexcept
+		:uri(_uri), mtime(_mtime) {
+		replay_gain.Clear();
+	}
+
+	size_t GetSize() const noexcept {
+		return data.size();
+	}
+
+	/**
+	 * Submit the cached song to the #DecoderClient, like the
+	 * decoder plugin would have done, including seeking.
+	 */
+	void Replay(DecoderClient &client) const noexcept;
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Manager.hxx"
+#include "Config.hxx"
+#include "Item.hxx"
+
+#include <algorithm>
+
+#include <assert.h>
+
+DecoderCacheManager::DecoderCacheManager(const DecoderCacheConfig &config) noexcept
+	:max_total_size(config.size)
+{
+}
+
+DecoderCacheManager::~DecoderCacheManager() noexcept = default;
+
+DecoderCacheManager::ItemList::iterator
+DecoderCacheManager::Find(const char *uri) noexcept
+{
+	return std::find_if(items.begin(), items.end(),
+			    [uri](const auto &item){
+				    return item->uri == uri;
+			    });
+}
+
+void
+DecoderCacheManager::Remove(ItemList::iterator i) noexcept
+{
+	assert(total_size >= (*i)->GetSize());
+
+	total_size -= (*i)->GetSize();
+	items.erase(i);
+}
+
+std::shared_ptr<const DecoderCacheItem>
+DecoderCacheManager::Get(const char *uri,
+			 std::chrono::system_clock::time_point mtime) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	auto i = Find(uri);
+	if (i == items.end()) {
+		++misses;
+		return nullptr;
+	}
+
+	if ((*i)->mtime != mtime) {
+		/* the file has been modified */
+		Remove(i);
+		++misses;
+		return nullptr;
+	}
+
+	/* refresh */
+	items.splice(items.end(), items, i);
+
+	++hits;
+	return items.back();
+}
+
+void
+DecoderCacheManager::Put(std::unique_ptr<DecoderCacheItem> item) noexcept
+{
+	const size_t size = item->GetSize();
+	if (size > GetMaxItemSize())
+		return;
+
+	const std::lock_guard<Mutex> lock(mutex);
+
+	auto i = Find(item->uri.c_str());
+	if (i != items.end())
+		Remove(i);
+
+	total_size += size;
+
+	/* items which are still being replayed are kept alive by
+	   their std::shared_ptr */
+	while (total_size > max_total_size && !items.empty())
+		Remove(items.begin());
+
+	items.emplace_back(std::move(item));
+}
+
+DecoderCacheManager::Stats
+DecoderCacheManager::GetStats() const noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	return {items.size(), total_size, hits, misses};
+}
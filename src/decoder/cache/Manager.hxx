@@ -0,0 +1,99 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DECODER_CACHE_MANAGER_HXX
+#define MPD_DECODER_CACHE_MANAGER_HXX
+
+#include "thread/Mutex.hxx"
+#include "util/Compiler.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+
+struct DecoderCacheConfig;
+struct DecoderCacheItem;
+
+/**
+ * A class which caches the decoded PCM data of recently played songs
+ * in RAM, so playing them again does not need to run the decoder
+ * plugin.
+ */
+class DecoderCacheManager {
+	const size_t max_total_size;
+
+	mutable Mutex mutex;
+
+	size_t total_size = 0;
+
+	/**
+	 * All items, the least recently used first.  A linear search
+	 * is good enough, because the number of songs which fit into
+	 * the cache is small.
+	 */
+	std::list<std::shared_ptr<const DecoderCacheItem>> items;
+
+	unsigned hits = 0, misses = 0;
+
+public:
+	struct Stats {
+		size_t n_items, total_size;
+		unsigned hits, misses;
+	};
+
+	explicit DecoderCacheManager(const DecoderCacheConfig &config) noexcept;
+	~DecoderCacheManager() noexcept;
+
+	/**
+	 * The largest #DecoderCacheItem which will be accepted by
+	 * Put().
+	 */
+	size_t GetMaxItemSize() const noexcept {
+		return max_total_size / 2;
+	}
+
+	/**
+	 * Look up the decoded song with the given URI.  The item is
+	 * only returned if its modification time matches.
+	 *
+	 * @return the item or nullptr on cache miss
+	 */
+	std::shared_ptr<const DecoderCacheItem> Get(const char *uri,
+						    std::chrono::system_clock::time_point mtime) noexcept;
+
+	/**
+	 * Add a new item, replacing an existing one with the same
+	 * URI and evicting the least recently used ones if the cache
+	 * is full.
+	 */
+	void Put(std::unique_ptr<DecoderCacheItem> item) noexcept;
+
+	gcc_pure
+	Stats GetStats() const noexcept;
+
+private:
+	using ItemList = std::list<std::shared_ptr<const DecoderCacheItem>>;
+
+	gcc_pure
+	ItemList::iterator Find(const char *uri) noexcept;
+
+	void Remove(ItemList::iterator i) noexcept;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "MadDecoderPlugin.hxx"
 #include "../DecoderAPI.hxx"
+#include "../SeekIndexCache.hxx"
 #include "input/InputStream.hxx"
 #include "tag/Id3Scan.hxx"
 #include "tag/Id3ReplayGain.hxx"
@@ -27,13 +28,19 @@
 #include "tag/ReplayGain.hxx"
 #include "tag/MixRamp.hxx"
 #include "CheckAudioFormat.hxx"
+#include "config/Block.hxx"
 #include "util/Clamp.hxx"
+#include "util/ConstBuffer.hxx"
 #include "util/StringCompare.hxx"
 #include "util/Domain.hxx"
 #include "Log.hxx"
 
 #include <mad.h>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #ifdef ENABLE_ID3TAG
 #include "tag/Id3Unique.hxx"
 #include <id3tag.h>
@@ -68,6 +75,11 @@ static constexpr Domain mad_domain("mad");
 
 static bool gapless_playback;
 
+/**
+ * The "seek_index_cache" setting; nullptr if disabled.
+ */
+static std::unique_ptr<SeekIndexCache> seek_index_cache;
+
 gcc_const
 static SongTime
 ToSongTime(mad_timer_t t) noexcept
@@ -103,9 +115,36 @@ mad_plugin_init(const ConfigBlock &block)
 {
 	gapless_playback = block.GetBlockValue("gapless",
 					       DEFAULT_GAPLESS_MP3_PLAYBACK);
+
+	auto cache_path = block.GetPath("seek_index_cache");
+	if (!cache_path.IsNull())
+		seek_index_cache =
+			std::make_unique<SeekIndexCache>(std::move(cache_path));
+
 	return true;
 }
 
+static void
+mad_plugin_finish() noexcept
+{
+	seek_index_cache.reset();
+}
+
+static constexpr uint64_t
+FromMadTimer(mad_timer_t t) noexcept
+{
+	return uint64_t(t.seconds) * MAD_TIMER_RESOLUTION + t.fraction;
+}
+
+static mad_timer_t
+ToMadTimer(uint64_t t) noexcept
+{
+	mad_timer_t result;
+	result.seconds = t / MAD_TIMER_RESOLUTION;
+	result.fraction = t % MAD_TIMER_RESOLUTION;
+	return result;
+}
+
 class MadDecoder {
 	static constexpr size_t READ_BUFFER_SIZE = 40960;
 
@@ -123,6 +162,19 @@ class MadDecoder {
 	mad_timer_t *times = nullptr;
 	size_t highest_frame = 0;
 	size_t max_frames = 0;
+
+	/**
+	 * The number of #frame_offsets / #times entries which were
+	 * loaded from the #seek_index_cache.
+	 */
+	size_t cached_frames = 0;
+
+	/**
+	 * The modification time of the file, which validates the
+	 * #seek_index_cache entry.
+	 */
+	std::chrono::system_clock::time_point file_mtime;
+
 	size_t current_frame = 0;
 	unsigned int drop_start_frames;
 	unsigned int drop_end_frames;
@@ -178,6 +230,19 @@ private:
 		times = new mad_timer_t[max_frames];
 	}
 
+	/**
+	 * Fill #frame_offsets and #times from the #seek_index_cache,
+	 * allowing fast seeks to positions which have not been
+	 * decoded yet.
+	 */
+	void LoadSeekIndex() noexcept;
+
+	/**
+	 * Store #frame_offsets and #times in the #seek_index_cache if
+	 * we have learned more frames than were loaded.
+	 */
+	void SaveSeekIndex() noexcept;
+
 	gcc_pure
 	size_t TimeToFrame(SongTime t) const noexcept;
 
@@ -783,6 +848,43 @@ MadDecoder::~MadDecoder() noexcept
 	delete[] times;
 }
 
+inline void
+MadDecoder::LoadSeekIndex() noexcept
+{
+	const auto points = seek_index_cache->Load(input_stream.GetURI(),
+						   input_stream.GetSize(),
+						   file_mtime);
+	const size_t n = std::min(points.size(), max_frames);
+
+	for (size_t i = 0; i < n; ++i) {
+		frame_offsets[i] = points[i].offset;
+		times[i] = ToMadTimer(points[i].time);
+	}
+
+	highest_frame = cached_frames = n;
+}
+
+inline void
+MadDecoder::SaveSeekIndex() noexcept
+{
+	if (highest_frame <= cached_frames)
+		return;
+
+	std::vector<SeekPoint> points;
+	points.reserve(highest_frame);
+	for (size_t i = 0; i < highest_frame; ++i)
+		points.push_back({uint64_t(frame_offsets[i]),
+				  FromMadTimer(times[i])});
+
+	try {
+		seek_index_cache->Save(input_stream.GetURI(),
+				       input_stream.GetSize(), file_mtime,
+				       {points.data(), points.size()});
+	} catch (...) {
+		LogError(std::current_exception());
+	}
+}
+
 size_t
 MadDecoder::TimeToFrame(SongTime t) const noexcept
 {
@@ -978,6 +1080,13 @@ MadDecoder::RunDecoder() noexcept
 
 	AllocateBuffers();
 
+	const bool use_seek_index_cache = seek_index_cache != nullptr &&
+		input_stream.IsSeekable() && input_stream.KnownSize() &&
+		SeekIndexCache::GetModificationTime(input_stream.GetURI(),
+						    file_mtime);
+	if (use_seek_index_cache)
+		LoadSeekIndex();
+
 	client->Ready(CheckAudioFormat(frame.header.samplerate,
 				       SampleFormat::S24_P32,
 				       MAD_NCHANNELS(&frame.header)),
@@ -988,6 +1097,9 @@ MadDecoder::RunDecoder() noexcept
 		client->SubmitTag(input_stream, std::move(tag));
 
 	while (Read()) {}
+
+	if (use_seek_index_cache)
+		SaveSeekIndex();
 }
 
 static void
@@ -1028,6 +1140,6 @@ static const char *const mad_mime_types[] = { "audio/mpeg", nullptr };
 
 constexpr DecoderPlugin mad_decoder_plugin =
 	DecoderPlugin("mad", mad_decode, mad_decoder_scan_stream)
-	.WithInit(mad_plugin_init)
+	.WithInit(mad_plugin_init, mad_plugin_finish)
 	.WithSuffixes(mad_suffixes)
 	.WithMimeTypes(mad_mime_types);
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "LatencyProbe.hxx"
+
+static constexpr std::chrono::steady_clock::duration latency_probe_interval =
+	std::chrono::milliseconds(100);
+
+void
+LatencyProbe::Start() noexcept
+{
+	due = std::chrono::steady_clock::now() + latency_probe_interval;
+	timer.Schedule(latency_probe_interval);
+}
+
+LatencyProbe::Stats
+LatencyProbe::GetStats() const noexcept
+{
+	const std::lock_guard<Mutex> protect(mutex);
+
+	Stats stats;
+	stats.average = n > 0
+		? sum / n
+		: std::chrono::steady_clock::duration::zero();
+	stats.max = max;
+	return stats;
+}
+
+void
+LatencyProbe::OnTimer() noexcept
+{
+	const auto now = std::chrono::steady_clock::now();
+	const auto delay = now > due
+		? now - due
+		: std::chrono::steady_clock::duration::zero();
+
+	{
+		const std::lock_guard<Mutex> protect(mutex);
+		++n;
+		sum += delay;
+		if (delay > max)
+			max = delay;
+	}
+
+	Start();
+}
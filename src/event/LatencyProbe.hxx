@@ -0,0 +1,66 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_EVENT_LATENCY_PROBE_HXX
+#define MPD_EVENT_LATENCY_PROBE_HXX
+
+#include "TimerEvent.hxx"
+#include "thread/Mutex.hxx"
+
+#include <chrono>
+
+/**
+ * Periodically wakes up the #EventLoop and measures how late the
+ * wakeup was.  This reveals scheduling jitter caused by other
+ * processes or by the thread's own workload.
+ *
+ * Start() must be called from the thread that runs the #EventLoop;
+ * GetStats() is thread-safe.
+ */
+class LatencyProbe final {
+	TimerEvent timer;
+
+	std::chrono::steady_clock::time_point due;
+
+	mutable Mutex mutex;
+
+	unsigned n = 0;
+	std::chrono::steady_clock::duration sum{}, max{};
+
+public:
+	struct Stats {
+		std::chrono::steady_clock::duration average, max;
+	};
+
+	explicit LatencyProbe(EventLoop &loop) noexcept
+		:timer(loop, BIND_THIS_METHOD(OnTimer)) {}
+
+	auto &GetEventLoop() const noexcept {
+		return timer.GetEventLoop();
+	}
+
+	void Start() noexcept;
+
+	Stats GetStats() const noexcept;
+
+private:
+	void OnTimer() noexcept;
+};
+
+#endif
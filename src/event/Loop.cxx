@@ -22,6 +22,10 @@
 #include "IdleMonitor.hxx"
 #include "DeferEvent.hxx"
 #include "util/ScopeExit.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
+
+static constexpr Domain event_loop_domain("event_loop");
 
 EventLoop::EventLoop(ThreadId _thread)
 	:SocketMonitor(*this),
@@ -122,6 +126,13 @@ EventLoop::HandleTimers() noexcept
 
 		timers.erase(i);
 
+		const auto lag = -timeout;
+		timer_lag.Add(lag);
+		if (lag_threshold > lag_threshold.zero() && lag > lag_threshold)
+			FormatWarning(event_loop_domain,
+				      "Timer ran %lu ms late",
+				      (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(lag).count());
+
 		t.Run();
 	}
 
@@ -22,6 +22,7 @@
 
 #include "thread/Id.hxx"
 #include "util/Compiler.h"
+#include "util/LatencyHistogram.hxx"
 
 #include "PollGroup.hxx"
 #include "thread/Mutex.hxx"
@@ -117,6 +118,18 @@ class EventLoop final : SocketMonitor
 	 */
 	ThreadId thread = ThreadId::Null();
 
+	/**
+	 * How late did the #TimerEvent callbacks run?
+	 */
+	LatencyHistogram timer_lag;
+
+	/**
+	 * If positive, log a warning for each #TimerEvent which runs
+	 * later than this.
+	 */
+	std::chrono::steady_clock::duration lag_threshold =
+		std::chrono::steady_clock::duration::zero();
+
 public:
 	/**
 	 * Throws on error.
@@ -186,6 +199,22 @@ public:
 	 */
 	void RemoveDeferred(DeferEvent &d) noexcept;
 
+	/**
+	 * Returns statistics about how late #TimerEvent callbacks
+	 * were invoked.  This reveals callbacks which block the loop
+	 * for too long.
+	 *
+	 * This method must be called from the thread which runs
+	 * this #EventLoop (or after it has finished).
+	 */
+	const LatencyHistogram &GetTimerLag() const noexcept {
+		return timer_lag;
+	}
+
+	void SetLagThreshold(std::chrono::steady_clock::duration _threshold) noexcept {
+		lag_threshold = _threshold;
+	}
+
 	/**
 	 * The main function of this class.  It will loop until
 	 * Break() gets called.  Can be called only once.
@@ -51,6 +51,16 @@ public:
 	virtual void Reset() noexcept {
 	}
 
+	/**
+	 * Would FilterPCM() currently return its input unmodified?
+	 * This allows the caller to skip the filter.  The return
+	 * value may change at any time, e.g. when the volume is
+	 * changed.
+	 */
+	virtual bool IsPassthrough() const noexcept {
+		return false;
+	}
+
 	/**
 	 * Filters a block of PCM data.
 	 *
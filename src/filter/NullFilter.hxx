@@ -27,6 +27,10 @@ class NullFilter final : public Filter {
 public:
 	explicit NullFilter(const AudioFormat &af):Filter(af) {}
 
+	bool IsPassthrough() const noexcept override {
+		return true;
+	}
+
 	virtual ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override {
 		return src;
 	}
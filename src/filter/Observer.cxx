@@ -75,6 +75,10 @@ public:
 		filter->Reset();
 	}
 
+	bool IsPassthrough() const noexcept override {
+		return filter->IsPassthrough();
+	}
+
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override {
 		return filter->FilterPCM(src);
 	}
@@ -53,6 +53,10 @@ public:
 			convert->Reset();
 	}
 
+	bool IsPassthrough() const noexcept override {
+		return !convert && filter->IsPassthrough();
+	}
+
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
 	ConstBuffer<void> Flush() override;
 };
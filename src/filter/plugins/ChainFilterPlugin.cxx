@@ -64,6 +64,7 @@ public:
 
 	/* virtual methods from class Filter */
 	void Reset() noexcept override;
+	bool IsPassthrough() const noexcept override;
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
 	ConstBuffer<void> Flush() override;
 
@@ -137,6 +138,16 @@ ChainFilter::Reset() noexcept
 		child.filter->Reset();
 }
 
+bool
+ChainFilter::IsPassthrough() const noexcept
+{
+	for (const auto &child : children)
+		if (!child.filter->IsPassthrough())
+			return false;
+
+	return true;
+}
+
 template<typename I>
 static ConstBuffer<void>
 ApplyFilterChain(I begin, I end, ConstBuffer<void> src)
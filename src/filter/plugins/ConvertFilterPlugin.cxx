@@ -51,6 +51,10 @@ public:
 			state->Reset();
 	}
 
+	bool IsPassthrough() const noexcept override {
+		return !state;
+	}
+
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
 
 	ConstBuffer<void> Flush() override {
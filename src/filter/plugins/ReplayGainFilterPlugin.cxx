@@ -29,6 +29,7 @@
 #include "util/Domain.hxx"
 #include "Log.hxx"
 
+#include <atomic>
 #include <exception>
 
 #include <assert.h>
@@ -50,10 +51,28 @@ class ReplayGainFilter final : public Filter {
 	 */
 	const unsigned base;
 
+	/**
+	 * The software volume set by the #SoftwareMixer (owned by
+	 * the #PreparedReplayGainFilter).  It is multiplied with the
+	 * replay gain scale, so both are applied in one pass.
+	 */
+	const std::atomic_uint &software_volume;
+
 	ReplayGainMode mode = ReplayGainMode::OFF;
 
 	ReplayGainInfo info;
 
+	/**
+	 * The volume calculated from #mode and #info by Update().
+	 */
+	unsigned replay_gain_volume = PCM_VOLUME_1;
+
+	/**
+	 * The #software_volume value which was last multiplied into
+	 * #pv.
+	 */
+	unsigned applied_software_volume = PCM_VOLUME_1;
+
 	/**
 	 * About the current volume: it is between 0 and a value that
 	 * may or may not exceed #PCM_VOLUME_1.
@@ -71,10 +90,12 @@ class ReplayGainFilter final : public Filter {
 public:
 	ReplayGainFilter(const ReplayGainConfig &_config, bool allow_convert,
 			 const AudioFormat &audio_format,
-			 Mixer *_mixer, unsigned _base)
+			 Mixer *_mixer, unsigned _base,
+			 const std::atomic_uint &_software_volume)
 		:Filter(audio_format),
 		 config(_config),
-		 mixer(_mixer), base(_base) {
+		 mixer(_mixer), base(_base),
+		 software_volume(_software_volume) {
 		info.Clear();
 
 		out_audio_format.format = pv.Open(out_audio_format.format,
@@ -108,7 +129,20 @@ public:
 	 */
 	void Update();
 
+	/**
+	 * Pass the product of #replay_gain_volume and
+	 * #software_volume to #pv.
+	 */
+	void ApplySoftwareVolume() noexcept;
+
 	/* virtual methods from class Filter */
+	bool IsPassthrough() const noexcept override {
+		return mixer != nullptr ||
+			(pv.IsPassthrough() &&
+			 software_volume.load(std::memory_order_relaxed) ==
+			 applied_software_volume);
+	}
+
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
 };
 
@@ -133,11 +167,22 @@ class PreparedReplayGainFilter final : public PreparedFilter {
 	 */
 	unsigned base;
 
+	/**
+	 * The software volume which is applied together with replay
+	 * gain; see replay_gain_filter_set_volume().  It is written
+	 * by the main thread and read by the output thread.
+	 */
+	std::atomic_uint software_volume{PCM_VOLUME_1};
+
 public:
 	explicit PreparedReplayGainFilter(const ReplayGainConfig _config,
 					  bool _allow_convert)
 		:config(_config), allow_convert(_allow_convert) {}
 
+	void SetVolume(unsigned volume) noexcept {
+		software_volume.store(volume, std::memory_order_relaxed);
+	}
+
 	void SetMixer(Mixer *_mixer, unsigned _base) {
 		assert(_mixer == nullptr || (_base > 0 && _base <= 100));
 
@@ -162,6 +207,8 @@ ReplayGainFilter::Update()
 		volume = pcm_float_to_volume(scale);
 	}
 
+	replay_gain_volume = volume;
+
 	if (mixer != nullptr) {
 		/* update the hardware mixer volume */
 
@@ -176,7 +223,17 @@ ReplayGainFilter::Update()
 				 "Failed to update hardware mixer");
 		}
 	} else
-		pv.SetVolume(volume);
+		ApplySoftwareVolume();
+}
+
+void
+ReplayGainFilter::ApplySoftwareVolume() noexcept
+{
+	applied_software_volume =
+		software_volume.load(std::memory_order_relaxed);
+
+	pv.SetVolume((uint_least64_t)replay_gain_volume *
+		     applied_software_volume / PCM_VOLUME_1);
 }
 
 std::unique_ptr<PreparedFilter>
@@ -191,15 +248,23 @@ std::unique_ptr<Filter>
 PreparedReplayGainFilter::Open(AudioFormat &af)
 {
 	return std::make_unique<ReplayGainFilter>(config, allow_convert,
-						  af, mixer, base);
+						  af, mixer, base,
+						  software_volume);
 }
 
 ConstBuffer<void>
 ReplayGainFilter::FilterPCM(ConstBuffer<void> src)
 {
-	return mixer != nullptr
-		? src
-		: pv.Apply(src);
+	if (mixer != nullptr)
+		return src;
+
+	/* pick up software volume changes lazily, so the gain is
+	   recalculated only when one of its factors has changed */
+	if (software_volume.load(std::memory_order_relaxed) !=
+	    applied_software_volume)
+		ApplySoftwareVolume();
+
+	return pv.Apply(src);
 }
 
 void
@@ -211,6 +276,15 @@ replay_gain_filter_set_mixer(PreparedFilter &_filter, Mixer *mixer,
 	filter.SetMixer(mixer, base);
 }
 
+void
+replay_gain_filter_set_volume(PreparedFilter &_filter,
+			      unsigned volume) noexcept
+{
+	auto &filter = (PreparedReplayGainFilter &)_filter;
+
+	filter.SetVolume(volume);
+}
+
 void
 replay_gain_filter_set_info(Filter &_filter, const ReplayGainInfo *info)
 {
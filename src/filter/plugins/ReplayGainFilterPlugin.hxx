@@ -50,6 +50,17 @@ void
 replay_gain_filter_set_mixer(PreparedFilter &_filter, Mixer *mixer,
 			     unsigned base);
 
+/**
+ * Sets the software volume which is multiplied with the replay gain
+ * scale, so the #SoftwareMixer volume does not need a separate
+ * #VolumeFilter pass.  Takes effect at the next chunk.
+ *
+ * @param volume the volume, see #PCM_VOLUME_1
+ */
+void
+replay_gain_filter_set_volume(PreparedFilter &filter,
+			      unsigned volume) noexcept;
+
 /**
  * Sets a new #ReplayGainInfo at the beginning of a new song.
  *
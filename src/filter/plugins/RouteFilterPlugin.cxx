@@ -37,6 +37,12 @@
  *
  * If multiple sources are copied to the same destination channel, only
  * one of them takes effect.
+ *
+ * A route may have a gain factor, formatted as source>dest*gain.  If
+ * at least one route has a gain factor, the filter mixes instead of
+ * copying: all sources for a destination channel are added, e.g.: \\
+ * routes "0>0, 1>1, 2>0*0.707, 2>1*0.707, 4>0*0.707, 5>1*0.707"\\
+ * downmixes 5.1 surround to stereo.
  */
 
 #include "RouteFilterPlugin.hxx"
@@ -46,16 +52,19 @@
 #include "filter/Filter.hxx"
 #include "filter/Prepared.hxx"
 #include "pcm/Buffer.hxx"
+#include "pcm/ChannelMatrix.hxx"
 #include "pcm/Silence.hxx"
+#include "util/NumberParser.hxx"
 #include "util/StringStrip.hxx"
 #include "util/RuntimeError.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/WritableBuffer.hxx"
 
+#include <algorithm>
 #include <array>
 #include <stdexcept>
 
-#include <string.h>
+#include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -68,6 +77,13 @@ class RouteFilter final : public Filter {
 	 */
 	const std::array<int8_t, MAX_CHANNELS> sources;
 
+	/**
+	 * If this is set, then the filter mixes the input channels
+	 * with this matrix instead of copying according to
+	 * #sources.
+	 */
+	const std::unique_ptr<PcmChannelMatrix> matrix;
+
 	/**
 	 * The actual input format of our signal, once opened
 	 */
@@ -92,10 +108,15 @@ class RouteFilter final : public Filter {
 
 public:
 	RouteFilter(const AudioFormat &audio_format, unsigned out_channels,
-		    const std::array<int8_t, MAX_CHANNELS> &_sources);
+		    const std::array<int8_t, MAX_CHANNELS> &_sources,
+		    std::unique_ptr<PcmChannelMatrix> &&_matrix);
 
 	/* virtual methods from class Filter */
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
+
+private:
+	template<typename T>
+	void Copy(T *dest, const T *src, size_t n_frames) const noexcept;
 };
 
 class PreparedRouteFilter final : public PreparedFilter {
@@ -121,12 +142,25 @@ class PreparedRouteFilter final : public PreparedFilter {
 	 */
 	std::array<int8_t, MAX_CHANNELS> sources;
 
+	/**
+	 * The gain of each route, indexed by destination and then
+	 * source channel.  Only used if #mix is set.
+	 */
+	float gains[MAX_CHANNELS][MAX_CHANNELS];
+
+	/**
+	 * Did at least one route specify a gain factor?  Then the
+	 * channels get mixed according to #gains.
+	 */
+	bool mix = false;
+
 public:
 	/**
 	 * Parse the "routes" section, a string on the form
-	 *  a>b, c>d, e>f, ...
+	 *  a>b, c>d, e>f*g, ...
 	 * where a... are non-unique, non-negative integers
-	 * and input channel a gets copied to output channel b, etc.
+	 * and input channel a gets copied to output channel b, etc.;
+	 * the optional g is a gain factor.
 	 * @param block the configuration block to read
 	 * @param filter a route_filter whose min_channels and sources[] to set
 	 */
@@ -145,6 +179,7 @@ PreparedRouteFilter::PreparedRouteFilter(const ConfigBlock &block)
 	 */
 
 	sources.fill(-1);
+	std::fill_n(&gains[0][0], MAX_CHANNELS * MAX_CHANNELS, 0.f);
 
 	min_input_channels = 0;
 	min_output_channels = 0;
@@ -181,7 +216,19 @@ PreparedRouteFilter::PreparedRouteFilter(const ConfigBlock &block)
 		if (dest >= min_output_channels)
 			min_output_channels = dest + 1;
 
+		float gain = 1;
+		if (*endptr == '*') {
+			routes = StripLeft(endptr + 1);
+			gain = ParseFloat(routes, &endptr);
+			if (endptr == routes)
+				throw std::runtime_error("Malformed 'routes' specification");
+
+			endptr = StripLeft(endptr);
+			mix = true;
+		}
+
 		sources[dest] = source;
+		gains[dest][source] += gain;
 
 		routes = endptr;
 
@@ -203,8 +250,10 @@ route_filter_init(const ConfigBlock &block)
 
 RouteFilter::RouteFilter(const AudioFormat &audio_format,
 			 unsigned out_channels,
-			 const std::array<int8_t, MAX_CHANNELS> &_sources)
-	:Filter(audio_format), sources(_sources), input_format(audio_format),
+			 const std::array<int8_t, MAX_CHANNELS> &_sources,
+			 std::unique_ptr<PcmChannelMatrix> &&_matrix)
+	:Filter(audio_format), sources(_sources), matrix(std::move(_matrix)),
+	 input_format(audio_format),
 	 input_frame_size(input_format.GetFrameSize())
 {
 	// Decide on an output format which has enough channels,
@@ -218,54 +267,92 @@ RouteFilter::RouteFilter(const AudioFormat &audio_format,
 std::unique_ptr<Filter>
 PreparedRouteFilter::Open(AudioFormat &audio_format)
 {
+	std::unique_ptr<PcmChannelMatrix> matrix;
+
+	if (mix) {
+		switch (audio_format.format) {
+		case SampleFormat::S16:
+		case SampleFormat::S24_P32:
+		case SampleFormat::S32:
+		case SampleFormat::FLOAT:
+			break;
+
+		default:
+			throw FormatRuntimeError("Mixing channels is not implemented for %s",
+						 sample_format_to_string(audio_format.format));
+		}
+
+		matrix = std::make_unique<PcmChannelMatrix>(audio_format.channels,
+							    min_output_channels);
+
+		/* undefined sources are silent */
+		for (unsigned d = 0; d < min_output_channels; ++d)
+			for (unsigned s = 0; s < audio_format.channels; ++s)
+				matrix->Set(d, s, gains[d][s]);
+	}
+
 	return std::make_unique<RouteFilter>(audio_format, min_output_channels,
-					     sources);
+					     sources, std::move(matrix));
+}
+
+template<typename T>
+inline void
+RouteFilter::Copy(T *dest, const T *src, size_t n_frames) const noexcept
+{
+	const unsigned in_channels = input_format.channels;
+	const unsigned out_channels = out_audio_format.channels;
+
+	T silence;
+	PcmSilence({&silence, sizeof(silence)}, input_format.format);
+
+	/* translate the table into source offsets; -1 means
+	   silence */
+	std::array<int8_t, MAX_CHANNELS> offsets;
+	for (unsigned c = 0; c < out_channels; ++c)
+		offsets[c] = sources[c] >= 0 &&
+			(unsigned)sources[c] < in_channels
+			? sources[c]
+			: -1;
+
+	for (size_t i = 0; i < n_frames; ++i, src += in_channels)
+		for (unsigned c = 0; c < out_channels; ++c)
+			*dest++ = offsets[c] >= 0 ? src[offsets[c]] : silence;
 }
 
 ConstBuffer<void>
 RouteFilter::FilterPCM(ConstBuffer<void> src)
 {
-	size_t number_of_frames = src.size / input_frame_size;
+	if (matrix)
+		return pcm_channel_matrix(output_buffer, *matrix,
+					  input_format.format, src);
 
-	const size_t bytes_per_frame_per_channel = input_format.GetSampleSize();
-
-	// A moving pointer that always refers to channel 0 in the input, at the currently handled frame
-	const uint8_t *base_source = (const uint8_t *)src.data;
+	size_t number_of_frames = src.size / input_frame_size;
 
-	// Grow our reusable buffer, if needed, and set the moving pointer
+	// Grow our reusable buffer, if needed
 	const size_t result_size = number_of_frames * output_frame_size;
 	void *const result = output_buffer.Get(result_size);
 
-	// A moving pointer that always refers to the currently filled channel of the currently handled frame, in the output
-	uint8_t *chan_destination = (uint8_t *)result;
-
-	// Perform our copy operations, with N input channels and M output channels
-	for (unsigned int s=0; s<number_of_frames; ++s) {
-
-		// Need to perform one copy per output channel
-		for (unsigned c = 0; c < out_audio_format.channels; ++c) {
-			if (sources[c] == -1 ||
-			    (unsigned)sources[c] >= input_format.channels) {
-				// No source for this destination output,
-				// give it zeroes as input
-				PcmSilence({chan_destination, bytes_per_frame_per_channel},
-					   input_format.format);
-			} else {
-				// Get the data from channel sources[c]
-				// and copy it to the output
-				const uint8_t *data = base_source +
-					(sources[c] * bytes_per_frame_per_channel);
-				memcpy(chan_destination,
-					  data,
-					  bytes_per_frame_per_channel);
-			}
-			// Move on to the next output channel
-			chan_destination += bytes_per_frame_per_channel;
-		}
-
-
-		// Go on to the next N input samples
-		base_source += input_frame_size;
+	// Perform our copy operations, with N input channels and M
+	// output channels, one sample size at a time
+	switch (input_format.GetSampleSize()) {
+	case 1:
+		Copy((uint8_t *)result, (const uint8_t *)src.data,
+		     number_of_frames);
+		break;
+
+	case 2:
+		Copy((uint16_t *)result, (const uint16_t *)src.data,
+		     number_of_frames);
+		break;
+
+	case 4:
+		Copy((uint32_t *)result, (const uint32_t *)src.data,
+		     number_of_frames);
+		break;
+
+	default:
+		assert(false);
+		gcc_unreachable();
 	}
 
 	// Here it is, ladies and gentlemen! Rerouted data!
@@ -43,6 +43,10 @@ public:
 	}
 
 	/* virtual methods from class Filter */
+	bool IsPassthrough() const noexcept override {
+		return pv.IsPassthrough();
+	}
+
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
 };
 
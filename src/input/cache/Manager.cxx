@@ -94,12 +94,17 @@ InputCacheManager::Get(const char *uri, bool create)
 		// TODO revalidate the cache item using the file's mtime?
 		// TODO if cache item contains error, retry now?
 
+		if (create)
+			++hits;
+
 		return InputCacheLease(item);
 	}
 
 	if (!create)
 		return {};
 
+	++misses;
+
 	// TODO: wait for "ready" without blocking here
 	auto is = InputStream::OpenReady(uri, mutex);
 
@@ -26,6 +26,8 @@
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
 
+#include <atomic>
+
 class InputStream;
 class InputCacheItem;
 class InputCacheLease;
@@ -42,6 +44,12 @@ class InputCacheManager {
 
 	size_t total_size = 0;
 
+	/**
+	 * Statistics: how often did Get() with create=true find an
+	 * existing item, and how often did it have to open the file?
+	 */
+	std::atomic_uint hits{0}, misses{0};
+
 	struct ItemCompare {
 		gcc_pure
 		bool operator()(const InputCacheItem &a,
@@ -91,6 +99,14 @@ public:
 	 */
 	void Prefetch(const char *uri);
 
+	unsigned GetHits() const noexcept {
+		return hits;
+	}
+
+	unsigned GetMisses() const noexcept {
+		return misses;
+	}
+
 private:
 	/**
 	 * Check whether the given #InputStream can be stored in this
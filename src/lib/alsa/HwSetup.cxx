@@ -173,7 +173,7 @@ SetupSampleFormat(snd_pcm_t *pcm, snd_pcm_hw_params_t *hwparams,
 
 HwResult
 SetupHw(snd_pcm_t *pcm,
-	unsigned buffer_time, unsigned period_time,
+	unsigned buffer_time, unsigned period_time, bool mmap,
 	AudioFormat &audio_format, PcmExport::Params &params)
 {
 	snd_pcm_hw_params_t *hwparams;
@@ -188,8 +188,20 @@ SetupHw(snd_pcm_t *pcm,
 		throw FormatRuntimeError("snd_pcm_hw_params_any() failed: %s",
 					 snd_strerror(-err));
 
-	err = snd_pcm_hw_params_set_access(pcm, hwparams,
-					   SND_PCM_ACCESS_RW_INTERLEAVED);
+	if (mmap) {
+		err = snd_pcm_hw_params_set_access(pcm, hwparams,
+						   SND_PCM_ACCESS_MMAP_INTERLEAVED);
+		if (err < 0) {
+			FormatDebug(alsa_output_domain,
+				    "mmap access not supported, falling back to writei: %s",
+				    snd_strerror(-err));
+			mmap = false;
+		}
+	}
+
+	if (!mmap)
+		err = snd_pcm_hw_params_set_access(pcm, hwparams,
+						   SND_PCM_ACCESS_RW_INTERLEAVED);
 	if (err < 0)
 		throw FormatRuntimeError("snd_pcm_hw_params_set_access() failed: %s",
 					 snd_strerror(-err));
@@ -285,6 +297,7 @@ SetupHw(snd_pcm_t *pcm,
 					 snd_strerror(-err));
 
 	HwResult result;
+	result.mmap = mmap;
 
 	err = snd_pcm_hw_params_get_format(hwparams, &result.format);
 	if (err < 0)
@@ -31,6 +31,12 @@ namespace Alsa {
 struct HwResult {
 	snd_pcm_format_t format;
 	snd_pcm_uframes_t buffer_size, period_size;
+
+	/**
+	 * Was SND_PCM_ACCESS_MMAP_INTERLEAVED configured?  If not,
+	 * the PCM must be accessed with snd_pcm_writei().
+	 */
+	bool mmap;
 };
 
 /**
@@ -38,13 +44,16 @@ struct HwResult {
  *
  * @param buffer_time the configured buffer time, or 0 if not configured
  * @param period_time the configured period time, or 0 if not configured
+ * @param mmap attempt to configure SND_PCM_ACCESS_MMAP_INTERLEAVED,
+ * falling back to SND_PCM_ACCESS_RW_INTERLEAVED if the device does
+ * not support it
  * @param audio_format an #AudioFormat to be configured (or modified)
  * by this function
  * @param params to be modified by this function
  */
 HwResult
 SetupHw(snd_pcm_t *pcm,
-	unsigned buffer_time, unsigned period_time,
+	unsigned buffer_time, unsigned period_time, bool mmap,
 	AudioFormat &audio_format, PcmExport::Params &params);
 
 } // namespace Alsa
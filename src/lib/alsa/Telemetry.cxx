@@ -0,0 +1,59 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Telemetry.hxx"
+
+namespace Alsa {
+
+static std::string
+ToMicroseconds(Telemetry::Duration d) noexcept
+{
+	const auto us = std::chrono::duration_cast<std::chrono::microseconds>(d);
+	return std::to_string(us.count());
+}
+
+std::string
+Telemetry::FormatWriteLatencyAverage() const noexcept
+{
+	const auto n = n_writes.load(std::memory_order_relaxed);
+	const auto sum = write_duration_sum.load(std::memory_order_relaxed);
+	return ToMicroseconds(Duration(n > 0 ? sum / Duration::rep(n) : 0));
+}
+
+std::string
+Telemetry::FormatWriteLatencyMax() const noexcept
+{
+	return ToMicroseconds(Duration(write_duration_max.load(std::memory_order_relaxed)));
+}
+
+std::string
+Telemetry::FormatFillHistogram() const noexcept
+{
+	std::string result;
+
+	for (const auto &i : fill) {
+		if (!result.empty())
+			result.push_back(' ');
+		result += std::to_string(i.load(std::memory_order_relaxed));
+	}
+
+	return result;
+}
+
+} // namespace Alsa
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_ALSA_TELEMETRY_HXX
+#define MPD_ALSA_TELEMETRY_HXX
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <stdint.h>
+
+namespace Alsa {
+
+/**
+ * Statistics about the I/O of one ALSA PCM: xruns, the duration of
+ * each write and how full the ALSA-PCM buffer was before it.  They
+ * are collected by #AlsaOutput and reported as output attributes.
+ *
+ * The counters are only modified by the output thread, but may be
+ * read by any thread at any time.  They are atomic (with relaxed
+ * memory ordering), so the real-time output thread never needs to
+ * wait for a reader.  A reader may see a snapshot where the counters
+ * are not perfectly consistent with each other, which is good enough
+ * for statistics.
+ */
+struct Telemetry {
+	typedef std::chrono::steady_clock::duration Duration;
+
+	/**
+	 * The number of fill level histogram buckets; each covers
+	 * 1/FILL_BUCKETS of the ALSA-PCM buffer.
+	 */
+	static constexpr unsigned FILL_BUCKETS = 8;
+
+	/**
+	 * The number of xruns (buffer underruns).
+	 */
+	std::atomic<unsigned> xruns{0};
+
+	std::atomic<uint64_t> n_writes{0};
+
+	std::atomic<Duration::rep> write_duration_sum{0};
+	std::atomic<Duration::rep> write_duration_max{0};
+
+	std::array<std::atomic<uint64_t>, FILL_BUCKETS> fill{};
+
+	unsigned GetXruns() const noexcept {
+		return xruns.load(std::memory_order_relaxed);
+	}
+
+	void AddXrun() noexcept {
+		Increment(xruns);
+	}
+
+	void AddWrite(Duration d) noexcept {
+		Increment(n_writes);
+
+		const auto rep = d.count();
+		write_duration_sum.store(write_duration_sum.load(std::memory_order_relaxed) + rep,
+					 std::memory_order_relaxed);
+		if (rep > write_duration_max.load(std::memory_order_relaxed))
+			write_duration_max.store(rep,
+						 std::memory_order_relaxed);
+	}
+
+	/**
+	 * @param filled the number of frames in the ALSA-PCM buffer
+	 * @param buffer_size the size of the ALSA-PCM buffer in frames
+	 */
+	void AddFill(uint64_t filled, uint64_t buffer_size) noexcept {
+		if (buffer_size == 0)
+			return;
+
+		uint64_t i = filled * FILL_BUCKETS / buffer_size;
+		if (i >= FILL_BUCKETS)
+			i = FILL_BUCKETS - 1;
+
+		Increment(fill[i]);
+	}
+
+	/**
+	 * @return the average write duration in microseconds
+	 */
+	std::string FormatWriteLatencyAverage() const noexcept;
+
+	/**
+	 * @return the maximum write duration in microseconds
+	 */
+	std::string FormatWriteLatencyMax() const noexcept;
+
+	/**
+	 * @return the fill level histogram as a space separated list
+	 * of counters, starting with the emptiest bucket
+	 */
+	std::string FormatFillHistogram() const noexcept;
+
+private:
+	/**
+	 * Increment a counter.  This is not an atomic
+	 * read-modify-write operation, because there is only one
+	 * writer thread.
+	 */
+	template<typename T>
+	static void Increment(std::atomic<T> &a) noexcept {
+		a.store(a.load(std::memory_order_relaxed) + 1,
+			std::memory_order_relaxed);
+	}
+};
+
+} // namespace Alsa
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Connection.hxx"
+#include "Listener.hxx"
+#include "Export.hxx"
+#include "net/SocketError.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "util/Domain.hxx"
+#include "util/StringFormat.hxx"
+#include "Log.hxx"
+
+#include <assert.h>
+#include <string.h>
+
+static constexpr Domain metrics_domain("metrics");
+
+MetricsConnection::MetricsConnection(MetricsListener &_listener,
+				     UniqueSocketDescriptor fd,
+				     EventLoop &_loop) noexcept
+	:BufferedSocket(fd.Release(), _loop),
+	 listener(_listener),
+	 timeout_event(_loop, BIND_THIS_METHOD(OnTimeout))
+{
+	timeout_event.Schedule(listener.GetTimeout());
+}
+
+MetricsConnection::~MetricsConnection() noexcept
+{
+	if (IsDefined())
+		BufferedSocket::Close();
+}
+
+void
+MetricsConnection::Close() noexcept
+{
+	delete this;
+}
+
+bool
+MetricsConnection::HandleLine(const char *line) noexcept
+{
+	assert(state != State::RESPONSE);
+
+	if (state == State::REQUEST) {
+		if (strncmp(line, "HEAD /", 6) == 0) {
+			line += 6;
+			head_method = true;
+		} else if (strncmp(line, "GET /", 5) == 0) {
+			line += 5;
+		} else {
+			/* only GET is supported */
+			LogWarning(metrics_domain,
+				   "malformed request line from client");
+			return false;
+		}
+
+		not_found = !((strncmp(line, "metrics", 7) == 0 &&
+			       (line[7] == '\0' || line[7] == ' ' ||
+				line[7] == '?')) ||
+			      line[0] == '\0' || line[0] == ' ');
+
+		line = strchr(line, ' ');
+		if (line == nullptr || strncmp(line + 1, "HTTP/", 5) != 0) {
+			/* HTTP/0.9 without request headers */
+			BeginResponse();
+			return true;
+		}
+
+		/* after the request line, request headers follow */
+		state = State::HEADERS;
+		return true;
+	} else {
+		if (*line == 0)
+			/* empty line: request is finished */
+			BeginResponse();
+
+		/* ignore all request headers */
+		return true;
+	}
+}
+
+void
+MetricsConnection::BeginResponse() noexcept
+{
+	assert(state != State::RESPONSE);
+
+	state = State::RESPONSE;
+
+	if (not_found) {
+		response = "HTTP/1.1 404 Not Found\r\n"
+			"Content-Type: text/plain\r\n"
+			"Connection: close\r\n"
+			"\r\n";
+		if (!head_method)
+			response += "404 Not Found\n";
+		return;
+	}
+
+	const auto body = ExportMetrics(listener.GetInstance());
+
+	response = StringFormat<256>("HTTP/1.1 200 OK\r\n"
+				     "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+				     "Content-Length: %lu\r\n"
+				     "Connection: close\r\n"
+				     "Cache-Control: no-cache, no-store\r\n"
+				     "\r\n",
+				     (unsigned long)body.length()).c_str();
+	if (!head_method)
+		response += body;
+}
+
+bool
+MetricsConnection::TryWrite() noexcept
+{
+	assert(state == State::RESPONSE);
+	assert(position < response.length());
+
+	const ssize_t nbytes =
+		GetSocket().Write(response.data() + position,
+				  response.length() - position);
+	if (nbytes < 0) {
+		const auto e = GetSocketError();
+		if (IsSocketErrorAgain(e))
+			return true;
+
+		if (!IsSocketErrorClosed(e)) {
+			SocketErrorMessage msg(e);
+			FormatWarning(metrics_domain,
+				      "failed to write to client: %s",
+				      (const char *)msg);
+		}
+
+		Close();
+		return false;
+	}
+
+	position += nbytes;
+	if (position >= response.length()) {
+		/* the response is complete */
+		Close();
+		return false;
+	}
+
+	/* the client is making progress */
+	timeout_event.Schedule(listener.GetTimeout());
+	return true;
+}
+
+void
+MetricsConnection::OnTimeout() noexcept
+{
+	Close();
+}
+
+bool
+MetricsConnection::OnSocketReady(unsigned flags) noexcept
+{
+	if (flags & WRITE)
+		return TryWrite();
+
+	return BufferedSocket::OnSocketReady(flags);
+}
+
+BufferedSocket::InputResult
+MetricsConnection::OnSocketInput(void *data, size_t length) noexcept
+{
+	if (state == State::RESPONSE) {
+		/* ignore pipelined requests */
+		ConsumeInput(length);
+		return InputResult::MORE;
+	}
+
+	char *line = (char *)data;
+	char *newline = (char *)memchr(line, '\n', length);
+	if (newline == nullptr)
+		return InputResult::MORE;
+
+	ConsumeInput(newline + 1 - line);
+
+	if (newline > line && newline[-1] == '\r')
+		--newline;
+
+	/* terminate the string at the end of the line */
+	*newline = 0;
+
+	if (!HandleLine(line)) {
+		Close();
+		return InputResult::CLOSED;
+	}
+
+	if (state == State::RESPONSE) {
+		/* usually, the whole response fits into the socket
+		   buffer; if not, the rest is sent by
+		   OnSocketReady() */
+		if (!TryWrite())
+			return InputResult::CLOSED;
+
+		ScheduleWrite();
+		return InputResult::MORE;
+	}
+
+	return InputResult::AGAIN;
+}
+
+void
+MetricsConnection::OnSocketError(std::exception_ptr ep) noexcept
+{
+	LogError(ep);
+	Close();
+}
+
+void
+MetricsConnection::OnSocketClosed() noexcept
+{
+	Close();
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_METRICS_CONNECTION_HXX
+#define MPD_METRICS_CONNECTION_HXX
+
+#include "event/BufferedSocket.hxx"
+#include "event/TimerEvent.hxx"
+
+#include <boost/intrusive/list_hook.hpp>
+
+#include <string>
+
+class UniqueSocketDescriptor;
+class MetricsListener;
+
+/**
+ * One HTTP connection to the #MetricsListener.  It reads one
+ * request, sends the response and closes the connection.
+ */
+class MetricsConnection final
+	: BufferedSocket,
+	  public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>> {
+	MetricsListener &listener;
+
+	/**
+	 * Closes the connection if the client does not send the
+	 * request or does not accept the response in time.
+	 */
+	TimerEvent timeout_event;
+
+	enum class State {
+		/**
+		 * Waiting for the request line.
+		 */
+		REQUEST,
+
+		/**
+		 * Waiting for the end of the request headers.
+		 */
+		HEADERS,
+
+		/**
+		 * Sending #response.
+		 */
+		RESPONSE,
+	} state = State::REQUEST;
+
+	/**
+	 * Was the request method "HEAD"?
+	 */
+	bool head_method = false;
+
+	/**
+	 * Was a path other than "/metrics" requested?
+	 */
+	bool not_found = false;
+
+	/**
+	 * The response (headers and body) being sent.
+	 */
+	std::string response;
+
+	/**
+	 * The number of bytes of #response which have already been
+	 * sent.
+	 */
+	size_t position = 0;
+
+public:
+	MetricsConnection(MetricsListener &_listener,
+			  UniqueSocketDescriptor fd, EventLoop &_loop) noexcept;
+	~MetricsConnection() noexcept;
+
+	/**
+	 * Close the socket and delete this object.
+	 */
+	void Close() noexcept;
+
+private:
+	/**
+	 * @return false if the request was malformed
+	 */
+	bool HandleLine(const char *line) noexcept;
+
+	void BeginResponse() noexcept;
+
+	/**
+	 * @return false if the connection has been closed
+	 */
+	bool TryWrite() noexcept;
+
+	/* callback for TimerEvent */
+	void OnTimeout() noexcept;
+
+	/* virtual methods from class BufferedSocket */
+	InputResult OnSocketInput(void *data, size_t length) noexcept override;
+	void OnSocketError(std::exception_ptr ep) noexcept override;
+	void OnSocketClosed() noexcept override;
+
+	/* virtual methods from class SocketMonitor */
+	bool OnSocketReady(unsigned flags) noexcept override;
+};
+
+#endif
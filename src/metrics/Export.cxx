@@ -0,0 +1,336 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "Export.hxx"
+#include "Writer.hxx"
+#include "Instance.hxx"
+#include "Partition.hxx"
+#include "client/List.hxx"
+#include "command/AllCommands.hxx"
+#include "player/Control.hxx"
+#include "output/MultipleOutputs.hxx"
+#include "output/Control.hxx"
+#include "input/cache/Manager.hxx"
+#include "decoder/cache/Manager.hxx"
+#include "event/LatencyProbe.hxx"
+#include "util/LatencyHistogram.hxx"
+
+#ifdef ENABLE_DATABASE
+#include "Stats.hxx"
+#include "db/Stats.hxx"
+#include "db/update/Service.hxx"
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+/**
+ * Parse an output attribute value as a number.
+ *
+ * @return false if the value is not a number
+ */
+static bool
+ParseNumericAttribute(const std::string &value, double &result) noexcept
+{
+	if (value.empty())
+		return false;
+
+	char *endptr;
+	result = strtod(value.c_str(), &endptr);
+	return *endptr == 0;
+}
+
+static void
+ExportCommands(MetricsWriter &w, Instance &instance) noexcept
+{
+	w.Family("mpd_clients", "gauge",
+		 "Number of connected clients");
+	w.Sample("mpd_clients", {},
+		 uint64_t(instance.client_list->GetSize()));
+
+	w.Family("mpd_commands", "counter",
+		 "Number of executed protocol commands");
+	command_visit_stats([&w](const char *name,
+				 const LatencyHistogram &duration,
+				 uint64_t){
+		w.Sample("mpd_commands_total", {{"command", name}},
+			 duration.GetCount());
+	});
+
+	w.Family("mpd_command_duration_seconds", "summary",
+		 "Execution time of protocol commands");
+	command_visit_stats([&w](const char *name,
+				 const LatencyHistogram &duration,
+				 uint64_t){
+		w.Summary("mpd_command_duration_seconds",
+			  {{"command", name}}, duration);
+	});
+
+	w.Family("mpd_command_response_bytes", "counter",
+		 "Total size of the responses to protocol commands");
+	command_visit_stats([&w](const char *name,
+				 const LatencyHistogram &,
+				 uint64_t bytes_written){
+		w.Sample("mpd_command_response_bytes_total",
+			 {{"command", name}}, bytes_written);
+	});
+}
+
+static void
+ExportEventLoops(MetricsWriter &w, Instance &instance) noexcept
+{
+	w.Family("mpd_event_loop_lag_seconds", "summary",
+		 "How late timers in the main event loop fired");
+	w.Summary("mpd_event_loop_lag_seconds", {},
+		  instance.event_loop.GetTimerLag());
+
+	if (!instance.io_latency_probe && !instance.rtio_latency_probe)
+		return;
+
+	const std::pair<const char *, const LatencyProbe *> probes[] = {
+		{"io", instance.io_latency_probe.get()},
+		{"rtio", instance.rtio_latency_probe.get()},
+	};
+
+	w.Family("mpd_event_thread_jitter_seconds", "gauge",
+		 "Wakeup latency of the I/O threads");
+	for (const auto &i : probes) {
+		if (i.second == nullptr)
+			continue;
+
+		const auto stats = i.second->GetStats();
+		w.Sample("mpd_event_thread_jitter_seconds",
+			 {{"thread", i.first}, {"stat", "avg"}},
+			 stats.average);
+		w.Sample("mpd_event_thread_jitter_seconds",
+			 {{"thread", i.first}, {"stat", "max"}},
+			 stats.max);
+	}
+}
+
+static void
+ExportPlayers(MetricsWriter &w, Instance &instance) noexcept
+{
+	/* take one consistent snapshot of each player; this locks
+	   each PlayerControl only once */
+	std::vector<std::pair<const Partition *, PlayerMetrics>> players;
+	for (const auto &partition : instance.partitions)
+		players.emplace_back(&partition,
+				     partition.pc.LockGetMetrics());
+
+	w.Family("mpd_decoded_seconds", "counter",
+		 "Duration of the audio decoded so far");
+	for (const auto &i : players)
+		w.Sample("mpd_decoded_seconds_total",
+			 {{"partition", i.first->name.c_str()}},
+			 i.second.decoded_time);
+
+	w.Family("mpd_played_seconds", "counter",
+		 "Duration of the audio played so far");
+	for (const auto &i : players)
+		w.Sample("mpd_played_seconds_total",
+			 {{"partition", i.first->name.c_str()}},
+			 i.first->pc.GetTotalPlayTime());
+
+	w.Family("mpd_music_buffer_chunks", "gauge",
+		 "Number of chunks allocated in the music buffer");
+	for (const auto &i : players)
+		w.Sample("mpd_music_buffer_chunks",
+			 {{"partition", i.first->name.c_str()}},
+			 uint64_t(i.second.buffer_chunks_used));
+
+	w.Family("mpd_music_buffer_capacity_chunks", "gauge",
+		 "Size of the music buffer");
+	for (const auto &i : players)
+		w.Sample("mpd_music_buffer_capacity_chunks",
+			 {{"partition", i.first->name.c_str()}},
+			 uint64_t(i.second.buffer_chunks_total));
+}
+
+/**
+ * A snapshot of one audio output's state.
+ */
+struct OutputMetrics {
+	const Partition &partition;
+	const AudioOutputControl &ao;
+	std::map<std::string, std::string> attributes;
+
+	OutputMetrics(const Partition &_partition,
+		      const AudioOutputControl &_ao) noexcept
+		:partition(_partition), ao(_ao),
+		 attributes(ao.GetAttributes()) {}
+};
+
+static void
+ExportOutputs(MetricsWriter &w, Instance &instance) noexcept
+{
+	/* query the attributes of each output only once */
+	std::vector<OutputMetrics> outputs;
+	for (const auto &partition : instance.partitions)
+		for (unsigned i = 0; i < partition.outputs.Size(); ++i)
+			outputs.emplace_back(partition,
+					     partition.outputs.Get(i));
+
+	w.Family("mpd_output_enabled", "gauge",
+		 "Whether the audio output is enabled");
+	for (const auto &i : outputs)
+		w.Sample("mpd_output_enabled",
+			 {{"partition", i.partition.name.c_str()},
+			  {"output", i.ao.GetName()},
+			  {"plugin", i.ao.GetPluginName()}},
+			 uint64_t(i.ao.IsEnabled()));
+
+	w.Family("mpd_output_underruns", "counter",
+		 "Number of buffer underruns of the audio output");
+	for (const auto &i : outputs) {
+		const auto xruns = i.attributes.find("xruns");
+		double value;
+		if (xruns != i.attributes.end() &&
+		    ParseNumericAttribute(xruns->second, value))
+			w.Sample("mpd_output_underruns_total",
+				 {{"partition", i.partition.name.c_str()},
+				  {"output", i.ao.GetName()}},
+				 value);
+	}
+
+	w.Family("mpd_output_attribute", "gauge",
+		 "Numeric runtime attributes reported by the output plugin");
+	for (const auto &i : outputs) {
+		for (const auto &a : i.attributes) {
+			if (a.first == "xruns")
+				/* already exported as
+				   mpd_output_underruns_total */
+				continue;
+
+			double value;
+			if (ParseNumericAttribute(a.second, value))
+				w.Sample("mpd_output_attribute",
+					 {{"partition", i.partition.name.c_str()},
+					  {"output", i.ao.GetName()},
+					  {"name", a.first.c_str()}},
+					 value);
+		}
+	}
+}
+
+#ifdef ENABLE_DATABASE
+
+static void
+ExportDatabase(MetricsWriter &w, Instance &instance) noexcept
+{
+	const Database *db = instance.GetDatabase();
+	if (db != nullptr) {
+		const auto *stats = stats_get_database(*db);
+		if (stats != nullptr) {
+			w.Family("mpd_database_songs", "gauge",
+				 "Number of songs in the database");
+			w.Sample("mpd_database_songs", {},
+				 uint64_t(stats->song_count));
+
+			w.Family("mpd_database_artists", "gauge",
+				 "Number of artists in the database");
+			w.Sample("mpd_database_artists", {},
+				 uint64_t(stats->artist_count));
+
+			w.Family("mpd_database_albums", "gauge",
+				 "Number of albums in the database");
+			w.Sample("mpd_database_albums", {},
+				 uint64_t(stats->album_count));
+
+			w.Family("mpd_database_playtime_seconds", "gauge",
+				 "Total duration of all songs in the database");
+			w.Sample("mpd_database_playtime_seconds", {},
+				 stats->total_duration);
+		}
+	}
+
+	if (instance.update != nullptr) {
+		const auto &stats = instance.update->GetStats();
+
+		w.Family("mpd_database_update_duration_seconds", "summary",
+			 "Duration of database updates");
+		w.Sample("mpd_database_update_duration_seconds_sum", {},
+			 stats.total_duration);
+		w.Sample("mpd_database_update_duration_seconds_count", {},
+			 uint64_t(stats.n_jobs));
+
+		w.Family("mpd_database_last_update_duration_seconds", "gauge",
+			 "Duration of the most recent database update");
+		w.Sample("mpd_database_last_update_duration_seconds", {},
+			 stats.last_duration);
+	}
+}
+
+#endif
+
+static void
+ExportCaches(MetricsWriter &w, Instance &instance) noexcept
+{
+	if (instance.input_cache) {
+		w.Family("mpd_input_cache_hits", "counter",
+			 "Number of files found in the input cache");
+		w.Sample("mpd_input_cache_hits_total", {},
+			 uint64_t(instance.input_cache->GetHits()));
+
+		w.Family("mpd_input_cache_misses", "counter",
+			 "Number of files not found in the input cache");
+		w.Sample("mpd_input_cache_misses_total", {},
+			 uint64_t(instance.input_cache->GetMisses()));
+	}
+
+	if (instance.decoder_cache) {
+		const auto stats = instance.decoder_cache->GetStats();
+
+		w.Family("mpd_decoder_cache_hits", "counter",
+			 "Number of songs played from the decoder cache");
+		w.Sample("mpd_decoder_cache_hits_total", {},
+			 uint64_t(stats.hits));
+
+		w.Family("mpd_decoder_cache_misses", "counter",
+			 "Number of songs not found in the decoder cache");
+		w.Sample("mpd_decoder_cache_misses_total", {},
+			 uint64_t(stats.misses));
+
+		w.Family("mpd_decoder_cache_bytes", "gauge",
+			 "Size of the decoded PCM data in the decoder cache");
+		w.Sample("mpd_decoder_cache_bytes", {},
+			 uint64_t(stats.total_size));
+	}
+}
+
+std::string
+ExportMetrics(Instance &instance) noexcept
+{
+	MetricsWriter w;
+
+	ExportCommands(w, instance);
+	ExportEventLoops(w, instance);
+	ExportPlayers(w, instance);
+	ExportOutputs(w, instance);
+#ifdef ENABLE_DATABASE
+	ExportDatabase(w, instance);
+#endif
+	ExportCaches(w, instance);
+
+	return w.Finish();
+}
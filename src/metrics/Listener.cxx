@@ -0,0 +1,65 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Listener.hxx"
+#include "config/Block.hxx"
+#include "config/Net.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "net/SocketAddress.hxx"
+#include "util/DeleteDisposer.hxx"
+#include "util/Domain.hxx"
+#include "Log.hxx"
+
+static constexpr Domain metrics_domain("metrics");
+
+static constexpr unsigned DEFAULT_METRICS_PORT = 9101;
+static constexpr unsigned DEFAULT_METRICS_TIMEOUT = 10;
+static constexpr unsigned DEFAULT_METRICS_MAX_CONNECTIONS = 8;
+
+MetricsListener::MetricsListener(EventLoop &_loop, Instance &_instance,
+				 const ConfigBlock &block)
+	:ServerSocket(_loop), instance(_instance),
+	 timeout(std::chrono::seconds(block.GetPositiveValue("connection_timeout",
+							     DEFAULT_METRICS_TIMEOUT))),
+	 max_connections(block.GetPositiveValue("max_connections",
+						DEFAULT_METRICS_MAX_CONNECTIONS))
+{
+	ServerSocketAddGeneric(*this, block.GetBlockValue("bind_to_address"),
+			       block.GetPositiveValue("port",
+						      DEFAULT_METRICS_PORT));
+}
+
+MetricsListener::~MetricsListener() noexcept
+{
+	connections.clear_and_dispose(DeleteDisposer());
+}
+
+void
+MetricsListener::OnAccept(UniqueSocketDescriptor fd,
+			  SocketAddress, int) noexcept
+{
+	if (connections.size() >= max_connections) {
+		LogWarning(metrics_domain, "Max connections reached");
+		return;
+	}
+
+	auto *c = new MetricsConnection(*this, std::move(fd),
+					GetEventLoop());
+	connections.push_back(*c);
+}
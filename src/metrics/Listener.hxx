@@ -0,0 +1,77 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_METRICS_LISTENER_HXX
+#define MPD_METRICS_LISTENER_HXX
+
+#include "event/ServerSocket.hxx"
+#include "Connection.hxx"
+
+#include <boost/intrusive/list.hpp>
+
+#include <chrono>
+
+struct Instance;
+struct ConfigBlock;
+
+/**
+ * A small HTTP server which exports statistics in the OpenMetrics
+ * format (configured with the "metrics" block).
+ */
+class MetricsListener final : public ServerSocket {
+	Instance &instance;
+
+	boost::intrusive::list<MetricsConnection,
+			       boost::intrusive::base_hook<boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>>,
+			       boost::intrusive::constant_time_size<false>> connections;
+
+	/**
+	 * Connections which are idle for this duration are closed.
+	 */
+	const std::chrono::steady_clock::duration timeout;
+
+	/**
+	 * The maximum number of simultaneous connections.  More are
+	 * rejected.
+	 */
+	const unsigned max_connections;
+
+public:
+	/**
+	 * Throws on error.
+	 */
+	MetricsListener(EventLoop &_loop, Instance &_instance,
+			const ConfigBlock &block);
+
+	~MetricsListener() noexcept;
+
+	Instance &GetInstance() noexcept {
+		return instance;
+	}
+
+	std::chrono::steady_clock::duration GetTimeout() const noexcept {
+		return timeout;
+	}
+
+private:
+	void OnAccept(UniqueSocketDescriptor fd,
+		      SocketAddress address, int uid) noexcept override;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Writer.hxx"
+#include "util/LatencyHistogram.hxx"
+
+#include <stdio.h>
+
+void
+MetricsWriter::Family(const char *name, const char *type,
+		      const char *help) noexcept
+{
+	buffer += "# TYPE ";
+	buffer += name;
+	buffer += ' ';
+	buffer += type;
+	buffer += "\n# HELP ";
+	buffer += name;
+	buffer += ' ';
+	buffer += help;
+	buffer += '\n';
+}
+
+void
+MetricsWriter::Sample(const char *name, std::initializer_list<Label> labels,
+		      uint64_t value) noexcept
+{
+	char s[32];
+	snprintf(s, sizeof(s), "%llu", (unsigned long long)value);
+	Sample(name, labels, s);
+}
+
+void
+MetricsWriter::Sample(const char *name, std::initializer_list<Label> labels,
+		      double value) noexcept
+{
+	char s[32];
+	snprintf(s, sizeof(s), "%.9g", value);
+	Sample(name, labels, s);
+}
+
+void
+MetricsWriter::Summary(const char *name, std::initializer_list<Label> labels,
+		       const LatencyHistogram &h) noexcept
+{
+	static constexpr std::pair<double, const char *> quantiles[] = {
+		{50, "0.5"},
+		{99, "0.99"},
+	};
+
+	for (const auto &q : quantiles) {
+		buffer += name;
+		buffer += '{';
+		for (const auto &i : labels) {
+			buffer += i.first;
+			buffer += "=\"";
+			AppendEscaped(i.second);
+			buffer += "\",";
+		}
+
+		buffer += "quantile=\"";
+		buffer += q.second;
+		buffer += "\"} ";
+
+		char s[32];
+		snprintf(s, sizeof(s), "%.9g",
+			 std::chrono::duration_cast<std::chrono::duration<double>>(h.GetPercentile(q.first)).count());
+		buffer += s;
+		buffer += '\n';
+	}
+
+	Sample((std::string(name) + "_sum").c_str(), labels, h.GetSum());
+	Sample((std::string(name) + "_count").c_str(), labels,
+	       h.GetCount());
+}
+
+void
+MetricsWriter::Sample(const char *name, std::initializer_list<Label> labels,
+		      const char *value) noexcept
+{
+	buffer += name;
+
+	if (labels.size() > 0) {
+		char separator = '{';
+		for (const auto &i : labels) {
+			buffer += separator;
+			separator = ',';
+			buffer += i.first;
+			buffer += "=\"";
+			AppendEscaped(i.second);
+			buffer += '"';
+		}
+
+		buffer += '}';
+	}
+
+	buffer += ' ';
+	buffer += value;
+	buffer += '\n';
+}
+
+void
+MetricsWriter::AppendEscaped(const char *s) noexcept
+{
+	for (; *s != 0; ++s) {
+		switch (*s) {
+		case '\\':
+			buffer += "\\\\";
+			break;
+
+		case '"':
+			buffer += "\\\"";
+			break;
+
+		case '\n':
+			buffer += "\\n";
+			break;
+
+		default:
+			buffer += *s;
+		}
+	}
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_METRICS_WRITER_HXX
+#define MPD_METRICS_WRITER_HXX
+
+#include <chrono>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+#include <stdint.h>
+
+class LatencyHistogram;
+
+/**
+ * Helper class which renders metric families in the OpenMetrics
+ * text format.
+ */
+class MetricsWriter {
+	std::string buffer;
+
+public:
+	using Label = std::pair<const char *, const char *>;
+
+	void Family(const char *name, const char *type,
+		    const char *help) noexcept;
+
+	void Sample(const char *name, std::initializer_list<Label> labels,
+		    uint64_t value) noexcept;
+
+	void Sample(const char *name, std::initializer_list<Label> labels,
+		    double value) noexcept;
+
+	template<typename Rep, typename Period>
+	void Sample(const char *name, std::initializer_list<Label> labels,
+		    std::chrono::duration<Rep, Period> value) noexcept {
+		Sample(name, labels,
+		       std::chrono::duration_cast<std::chrono::duration<double>>(value).count());
+	}
+
+	/**
+	 * Render a #LatencyHistogram as a "summary" family (the
+	 * family header must have been written already).
+	 */
+	void Summary(const char *name, std::initializer_list<Label> labels,
+		     const LatencyHistogram &h) noexcept;
+
+	std::string Finish() noexcept {
+		buffer += "# EOF\n";
+		return std::move(buffer);
+	}
+
+private:
+	void Sample(const char *name, std::initializer_list<Label> labels,
+		    const char *value) noexcept;
+
+	void AppendEscaped(const char *s) noexcept;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include "SoftwareMixerPlugin.hxx"
 #include "mixer/MixerInternal.hxx"
 #include "filter/plugins/VolumeFilterPlugin.hxx"
+#include "filter/plugins/ReplayGainFilterPlugin.hxx"
 #include "pcm/Volume.hxx"
 
 #include <assert.h>
@@ -28,6 +29,14 @@
 class SoftwareMixer final : public Mixer {
 	Filter *filter = nullptr;
 
+	/**
+	 * If set, then the volume is applied by these
+	 * #ReplayGainFilter instances together with the replay gain
+	 * scale, instead of by a #VolumeFilter.
+	 */
+	PreparedFilter *replay_gain_filter = nullptr;
+	PreparedFilter *other_replay_gain_filter = nullptr;
+
 	/**
 	 * The current volume in percent (0..100).
 	 */
@@ -41,6 +50,14 @@ public:
 
 	void SetFilter(Filter *_filter) noexcept;
 
+	void SetReplayGainFilters(PreparedFilter *_replay_gain_filter,
+				  PreparedFilter *_other_replay_gain_filter) noexcept;
+
+private:
+	void ApplyVolume() noexcept;
+
+public:
+
 	/* virtual methods from class Mixer */
 	void Open() override {
 	}
@@ -85,9 +102,7 @@ SoftwareMixer::SetVolume(unsigned new_volume)
 	assert(new_volume <= 100);
 
 	volume = new_volume;
-
-	if (filter != nullptr)
-		volume_filter_set(filter, PercentVolumeToSoftwareVolume(new_volume));
+	ApplyVolume();
 }
 
 const MixerPlugin software_mixer_plugin = {
@@ -95,14 +110,35 @@ const MixerPlugin software_mixer_plugin = {
 	true,
 };
 
+void
+SoftwareMixer::ApplyVolume() noexcept
+{
+	const unsigned v = PercentVolumeToSoftwareVolume(volume);
+
+	if (filter != nullptr)
+		volume_filter_set(filter, v);
+
+	if (replay_gain_filter != nullptr)
+		replay_gain_filter_set_volume(*replay_gain_filter, v);
+
+	if (other_replay_gain_filter != nullptr)
+		replay_gain_filter_set_volume(*other_replay_gain_filter, v);
+}
+
 inline void
 SoftwareMixer::SetFilter(Filter *_filter) noexcept
 {
 	filter = _filter;
+	ApplyVolume();
+}
 
-	if (filter != nullptr)
-		volume_filter_set(filter,
-				  PercentVolumeToSoftwareVolume(volume));
+inline void
+SoftwareMixer::SetReplayGainFilters(PreparedFilter *_replay_gain_filter,
+				    PreparedFilter *_other_replay_gain_filter) noexcept
+{
+	replay_gain_filter = _replay_gain_filter;
+	other_replay_gain_filter = _other_replay_gain_filter;
+	ApplyVolume();
 }
 
 void
@@ -111,3 +147,12 @@ software_mixer_set_filter(Mixer &mixer, Filter *filter) noexcept
 	SoftwareMixer &sm = (SoftwareMixer &)mixer;
 	sm.SetFilter(filter);
 }
+
+void
+software_mixer_set_replay_gain_filters(Mixer &mixer,
+				       PreparedFilter *replay_gain_filter,
+				       PreparedFilter *other_replay_gain_filter) noexcept
+{
+	SoftwareMixer &sm = (SoftwareMixer &)mixer;
+	sm.SetReplayGainFilters(replay_gain_filter, other_replay_gain_filter);
+}
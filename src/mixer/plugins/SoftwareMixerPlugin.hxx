@@ -22,6 +22,7 @@
 
 class Mixer;
 class Filter;
+class PreparedFilter;
 
 /**
  * Attach a #VolumeFilter to this mixer.  The #VolumeFilter is the
@@ -32,4 +33,16 @@ class Filter;
 void
 software_mixer_set_filter(Mixer &mixer, Filter *filter) noexcept;
 
+/**
+ * Let the given replay_gain_filter_plugin instances apply the volume
+ * together with the replay gain scale (see
+ * replay_gain_filter_set_volume()).  This is used instead of
+ * software_mixer_set_filter() if there is nothing but a linear gain
+ * between the two stages, saving one pass over the PCM data.
+ */
+void
+software_mixer_set_replay_gain_filters(Mixer &mixer,
+				       PreparedFilter *replay_gain_filter,
+				       PreparedFilter *other_replay_gain_filter) noexcept;
+
 #endif
@@ -79,7 +79,14 @@ AudioOutputControl::GetMixer() const noexcept
 const std::map<std::string, std::string>
 AudioOutputControl::GetAttributes() const noexcept
 {
-	return output->GetAttributes();
+	auto attributes = output->GetAttributes();
+
+	const std::lock_guard<Mutex> protect(mutex);
+	attributes.emplace("passthrough_bytes",
+			   std::to_string(source.GetPassthroughBytes()));
+	attributes.emplace("filtered_bytes",
+			   std::to_string(source.GetFilteredBytes()));
+	return attributes;
 }
 
 void
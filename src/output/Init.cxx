@@ -26,6 +26,7 @@
 #include "mixer/MixerList.hxx"
 #include "mixer/MixerType.hxx"
 #include "mixer/MixerControl.hxx"
+#include "mixer/plugins/SoftwareMixerPlugin.hxx"
 #include "filter/LoadChain.hxx"
 #include "filter/Prepared.hxx"
 #include "filter/plugins/AutoConvertFilterPlugin.hxx"
@@ -108,6 +109,7 @@ audio_output_load_mixer(EventLoop &event_loop, FilteredAudioOutput &ao,
 			const MixerType mixer_type,
 			const MixerPlugin *plugin,
 			PreparedFilter &filter_chain,
+			bool volume_filter,
 			MixerListener &listener)
 {
 	Mixer *mixer;
@@ -135,8 +137,9 @@ audio_output_load_mixer(EventLoop &event_loop, FilteredAudioOutput &ao,
 				  ConfigBlock());
 		assert(mixer != nullptr);
 
-		filter_chain_append(filter_chain, "software_mixer",
-				    ao.volume_filter.Set(volume_filter_prepare()));
+		if (volume_filter)
+			filter_chain_append(filter_chain, "software_mixer",
+					    ao.volume_filter.Set(volume_filter_prepare()));
 		return mixer;
 	}
 
@@ -212,11 +215,23 @@ FilteredAudioOutput::Setup(EventLoop &event_loop,
 	const char *replay_gain_handler =
 		block.GetBlockValue("replay_gain_handler", "software");
 
+	/* if nothing but the software volume follows the replay gain
+	   filter (no normalization, no user filters), then both
+	   gains are fused into one PcmVolume pass inside the
+	   ReplayGainFilter; this is not possible if a non-linear
+	   filter sits between them */
+	const bool fuse_software_volume =
+		mixer_type == MixerType::SOFTWARE &&
+		strcmp(replay_gain_handler, "software") == 0 &&
+		!defaults.normalize &&
+		*block.GetBlockValue(AUDIO_FILTERS, "") == 0;
+
 	if (strcmp(replay_gain_handler, "none") != 0) {
 		/* when using software volume, we lose quality by
-		   invoking PcmVolume::Apply() twice; to avoid losing
-		   too much precision, we allow the ReplayGainFilter
-		   to convert 16 bit to 24 bit */
+		   invoking PcmVolume::Apply() twice (or by applying
+		   the fused gain at 16 bit); to avoid losing too much
+		   precision, we allow the ReplayGainFilter to convert
+		   16 bit to 24 bit */
 		const bool allow_convert = mixer_type == MixerType::SOFTWARE;
 
 		prepared_replay_gain_filter =
@@ -235,6 +250,7 @@ FilteredAudioOutput::Setup(EventLoop &event_loop,
 						mixer_type,
 						mixer_plugin,
 						*prepared_filter,
+						!fuse_software_volume,
 						mixer_listener);
 	} catch (...) {
 		FormatError(std::current_exception(),
@@ -242,6 +258,11 @@ FilteredAudioOutput::Setup(EventLoop &event_loop,
 			    name);
 	}
 
+	if (fuse_software_volume && mixer != nullptr)
+		software_mixer_set_replay_gain_filters(*mixer,
+						       prepared_replay_gain_filter.get(),
+						       prepared_other_replay_gain_filter.get());
+
 	/* use the hardware mixer for replay gain? */
 
 	if (strcmp(replay_gain_handler, "mixer") == 0) {
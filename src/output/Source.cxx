@@ -130,6 +130,23 @@ AudioOutputSource::CloseFilter() noexcept
 	filter.reset();
 }
 
+void
+AudioOutputSource::UpdateReplayGain(const MusicChunk &chunk,
+				    Filter &current_replay_gain_filter,
+				    unsigned *replay_gain_serial_p) noexcept
+{
+	replay_gain_filter_set_mode(current_replay_gain_filter,
+				    replay_gain_mode);
+
+	if (chunk.replay_gain_serial != *replay_gain_serial_p) {
+		replay_gain_filter_set_info(current_replay_gain_filter,
+					    chunk.replay_gain_serial != 0
+					    ? &chunk.replay_gain_info
+					    : nullptr);
+		*replay_gain_serial_p = chunk.replay_gain_serial;
+	}
+}
+
 ConstBuffer<void>
 AudioOutputSource::GetChunkData(const MusicChunk &chunk,
 				Filter *current_replay_gain_filter,
@@ -143,16 +160,9 @@ AudioOutputSource::GetChunkData(const MusicChunk &chunk,
 	assert(data.size % in_audio_format.GetFrameSize() == 0);
 
 	if (!data.empty() && current_replay_gain_filter != nullptr) {
-		replay_gain_filter_set_mode(*current_replay_gain_filter,
-					    replay_gain_mode);
-
-		if (chunk.replay_gain_serial != *replay_gain_serial_p) {
-			replay_gain_filter_set_info(*current_replay_gain_filter,
-						    chunk.replay_gain_serial != 0
-						    ? &chunk.replay_gain_info
-						    : nullptr);
-			*replay_gain_serial_p = chunk.replay_gain_serial;
-		}
+		if (replay_gain_serial_p != nullptr)
+			UpdateReplayGain(chunk, *current_replay_gain_filter,
+					 replay_gain_serial_p);
 
 		data = current_replay_gain_filter->FilterPCM(data);
 	}
@@ -160,11 +170,36 @@ AudioOutputSource::GetChunkData(const MusicChunk &chunk,
 	return data;
 }
 
+bool
+AudioOutputSource::IsPassthrough(const MusicChunk &chunk) const noexcept
+{
+	if (chunk.other != nullptr)
+		/* cross-fading */
+		return false;
+
+	if (replay_gain_filter && !replay_gain_filter->IsPassthrough())
+		return false;
+
+	return filter->IsPassthrough();
+}
+
 ConstBuffer<void>
-AudioOutputSource::FilterChunk(const MusicChunk &chunk)
+AudioOutputSource::FilterChunk(const MusicChunk &chunk, bool &passthrough_r)
 {
-	auto data = GetChunkData(chunk, replay_gain_filter.get(),
+	/* this needs to be done before asking the filters whether
+	   they can be skipped, because the ReplayGain info may have
+	   changed; GetChunkData() is told not to do it again */
+	if (replay_gain_filter && chunk.length > 0)
+		UpdateReplayGain(chunk, *replay_gain_filter,
 				 &replay_gain_serial);
+
+	passthrough_r = IsPassthrough(chunk);
+	if (passthrough_r)
+		/* optimized special case: hand the chunk to the
+		   output as-is */
+		return {chunk.data, chunk.length};
+
+	auto data = GetChunkData(chunk, replay_gain_filter.get(), nullptr);
 	if (data.empty())
 		return data;
 
@@ -227,17 +262,25 @@ AudioOutputSource::Fill(Mutex &mutex)
 
 	pending_tag = current_chunk->tag.get();
 
+	bool passthrough;
+
 	try {
 		/* release the mutex while the filter runs, because
-		   that may take a while */
+		   that may take a while; this also keeps
+		   AudioOutputControl::GetAttributes() (which reads
+		   the byte counters below) from blocking */
 		const ScopeUnlock unlock(mutex);
 
-		pending_data = pending_data.FromVoid(FilterChunk(*current_chunk));
+		pending_data = pending_data.FromVoid(FilterChunk(*current_chunk,
+								 passthrough));
 	} catch (...) {
 		current_chunk = nullptr;
 		throw;
 	}
 
+	(passthrough ? passthrough_bytes : filtered_bytes)
+		+= current_chunk->length;
+
 	return true;
 }
 
@@ -117,6 +117,23 @@ class AudioOutputSource {
 	 */
 	ConstBuffer<uint8_t> pending_data;
 
+	/**
+	 * The number of #MusicChunk bytes which were passed to the
+	 * #AudioOutput as-is, because no filter, ReplayGain or
+	 * cross-fading was active.
+	 *
+	 * Protected by the mutex passed to Fill().
+	 */
+	uint64_t passthrough_bytes = 0;
+
+	/**
+	 * The number of #MusicChunk bytes which went through the
+	 * filters.
+	 *
+	 * Protected by the mutex passed to Fill().
+	 */
+	uint64_t filtered_bytes = 0;
+
 public:
 	AudioOutputSource() noexcept;
 	~AudioOutputSource() noexcept;
@@ -135,6 +152,14 @@ public:
 		return in_audio_format;
 	}
 
+	uint64_t GetPassthroughBytes() const noexcept {
+		return passthrough_bytes;
+	}
+
+	uint64_t GetFilteredBytes() const noexcept {
+		return filtered_bytes;
+	}
+
 	AudioFormat Open(AudioFormat audio_format, const MusicPipe &_pipe,
 			 PreparedFilter *prepared_replay_gain_filter,
 			 PreparedFilter *prepared_other_replay_gain_filter,
@@ -206,11 +231,34 @@ private:
 
 	void CloseFilter() noexcept;
 
+	void UpdateReplayGain(const MusicChunk &chunk,
+			      Filter &replay_gain_filter,
+			      unsigned *replay_gain_serial_p) noexcept;
+
+	/**
+	 * @param replay_gain_serial_p if not nullptr, then
+	 * UpdateReplayGain() is called before the ReplayGain filter
+	 * is applied; nullptr means the caller has already done that
+	 */
 	ConstBuffer<void> GetChunkData(const MusicChunk &chunk,
 				       Filter *replay_gain_filter,
 				       unsigned *replay_gain_serial_p);
 
-	ConstBuffer<void> FilterChunk(const MusicChunk &chunk);
+	/**
+	 * Can the given #MusicChunk be passed to the #AudioOutput
+	 * as-is, without invoking any filter?
+	 *
+	 * UpdateReplayGain() must have been called for this chunk
+	 * already.
+	 */
+	bool IsPassthrough(const MusicChunk &chunk) const noexcept;
+
+	/**
+	 * @param passthrough_r set to true if the chunk was not
+	 * filtered (see IsPassthrough())
+	 */
+	ConstBuffer<void> FilterChunk(const MusicChunk &chunk,
+				      bool &passthrough_r);
 };
 
 #endif
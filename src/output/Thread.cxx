@@ -24,6 +24,8 @@
 #include "thread/Util.hxx"
 #include "thread/Slack.hxx"
 #include "thread/Name.hxx"
+#include "config/ThreadConfig.hxx"
+#include "trace/PipelineTrace.hxx"
 #include "util/StringBuffer.hxx"
 #include "util/ScopeExit.hxx"
 #include "util/RuntimeError.hxx"
@@ -402,11 +404,13 @@ AudioOutputControl::Task() noexcept
 {
 	FormatThreadName("output:%s", GetName());
 
-	try {
-		SetThreadRealtime();
-	} catch (...) {
-		Log(LogLevel::INFO, std::current_exception(),
-		    "OutputThread could not get realtime scheduling, continuing anyway");
+	if (!ApplyThreadConfig(ThreadKind::OUTPUT)) {
+		try {
+			SetThreadRealtime();
+		} catch (...) {
+			Log(LogLevel::INFO, std::current_exception(),
+			    "OutputThread could not get realtime scheduling, continuing anyway");
+		}
 	}
 
 	SetThreadTimerSlack(std::chrono::microseconds(100));
@@ -515,7 +519,12 @@ AudioOutputControl::Task() noexcept
 
 		if (command == Command::NONE) {
 			woken_for_play = false;
+
+			if (open)
+				PipelineTrace::Emit(PipelineTraceEvent::OUTPUT_WAIT_BEGIN);
 			wake_cond.wait(lock);
+			if (open)
+				PipelineTrace::Emit(PipelineTraceEvent::OUTPUT_WAIT_END);
 		}
 	}
 }
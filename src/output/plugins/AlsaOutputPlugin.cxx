@@ -23,6 +23,7 @@
 #include "lib/alsa/HwSetup.hxx"
 #include "lib/alsa/NonBlock.hxx"
 #include "lib/alsa/PeriodBuffer.hxx"
+#include "lib/alsa/Telemetry.hxx"
 #include "lib/alsa/Version.hxx"
 #include "../OutputAPI.hxx"
 #include "mixer/MixerList.hxx"
@@ -39,18 +40,35 @@
 #include "event/DeferEvent.hxx"
 #include "event/Call.hxx"
 #include "Log.hxx"
+#include "trace/PipelineTrace.hxx"
 
 #include <alsa/asoundlib.h>
 
 #include <boost/lockfree/spsc_queue.hpp>
 
+#include <algorithm>
 #include <string>
 #include <forward_list>
 
+#include <string.h>
+
 static const char default_device[] = "default";
 
 static constexpr unsigned MPD_ALSA_BUFFER_TIME_US = 500000;
 
+/**
+ * The default bounds for the "adaptive_buffer" mode.
+ */
+static constexpr unsigned MPD_ALSA_MIN_BUFFER_TIME_US = 100000;
+static constexpr unsigned MPD_ALSA_MAX_BUFFER_TIME_US = 2000000;
+
+/**
+ * In "adaptive_buffer" mode, the buffer is shrunk only after it
+ * was played this long without an xrun.
+ */
+static constexpr std::chrono::steady_clock::duration MPD_ALSA_ADAPTIVE_STABLE_TIME =
+	std::chrono::minutes(1);
+
 class AlsaOutput final
 	: AudioOutput, MultiSocketMonitor {
 
@@ -90,13 +108,57 @@ class AlsaOutput final
 	/** libasound's period_time setting (in microseconds) */
 	const unsigned period_time;
 
+	/**
+	 * The bounds (in microseconds) for #adaptive_buffer_time.
+	 */
+	const unsigned min_buffer_time, max_buffer_time;
+
+	/**
+	 * The buffer_time and period_time which were passed to
+	 * Alsa::SetupHw() by the current Open() call.
+	 */
+	unsigned current_buffer_time, current_period_time;
+
 	/** the mode flags passed to snd_pcm_open */
 	int mode = 0;
 
+	/**
+	 * Attempt to use SND_PCM_ACCESS_MMAP_INTERLEAVED?
+	 */
+	const bool mmap_setting;
+
 	std::forward_list<Alsa::AllowedFormat> allowed_formats;
 
 	/**
-	 * Protects #dop_setting and #allowed_formats.
+	 * Grow or shrink the buffer (between #min_buffer_time and
+	 * #max_buffer_time) depending on the xruns observed during
+	 * the previous Open()/Close() session?
+	 */
+	bool adaptive_buffer;
+
+	/**
+	 * The buffer_time for the next Open() call in
+	 * #adaptive_buffer mode.
+	 */
+	unsigned adaptive_buffer_time;
+
+	/**
+	 * Modified only by the output thread without locking; see
+	 * #Alsa::Telemetry.
+	 */
+	Alsa::Telemetry telemetry;
+
+	/**
+	 * The value of Alsa::Telemetry::xruns at the time Open() was
+	 * called.
+	 */
+	unsigned open_xruns;
+
+	std::chrono::steady_clock::time_point open_time;
+
+	/**
+	 * Protects #dop_setting, #allowed_formats, #adaptive_buffer,
+	 * #adaptive_buffer_time and #open_xruns.
 	 */
 	mutable Mutex attributes_mutex;
 
@@ -118,6 +180,11 @@ class AlsaOutput final
 	 */
 	snd_pcm_uframes_t period_frames;
 
+	/**
+	 * The size of the ALSA-PCM buffer, in number of frames.
+	 */
+	snd_pcm_uframes_t buffer_frames;
+
 	std::chrono::steady_clock::duration effective_period_duration;
 
 	/**
@@ -138,6 +205,14 @@ class AlsaOutput final
 	 */
 	bool work_around_drain_bug;
 
+	/**
+	 * Is the PCM accessed with snd_pcm_mmap_begin() and
+	 * snd_pcm_mmap_commit()?  In this mode, data is copied from
+	 * the #ring_buffer directly into the ALSA-PCM buffer, and
+	 * #period_buffer is not used.
+	 */
+	bool mmap;
+
 	/**
 	 * After Open() or Cancel(), has this output been activated by
 	 * a Play() command?
@@ -308,6 +383,29 @@ private:
 
 	int Recover(int err) noexcept;
 
+	/**
+	 * Update #telemetry after a write to the ALSA-PCM.  This is
+	 * called by the output thread for each period and does not
+	 * lock any mutex.
+	 *
+	 * @param avail the snd_pcm_avail_update() return value
+	 * before the write
+	 * @param duration the time it took to write
+	 */
+	void RecordWrite(snd_pcm_sframes_t avail,
+			 Alsa::Telemetry::Duration duration) noexcept {
+		telemetry.AddWrite(duration);
+		if (avail >= 0 && (snd_pcm_uframes_t)avail <= buffer_frames)
+			telemetry.AddFill(buffer_frames - avail,
+					  buffer_frames);
+	}
+
+	/**
+	 * Calculate a new #adaptive_buffer_time after the session
+	 * which is being closed.
+	 */
+	void AdaptBufferTime() noexcept;
+
 	/**
 	 * Drain all buffers.  To be run in #EventLoop's thread.
 	 *
@@ -346,6 +444,17 @@ private:
 		return true;
 	}
 
+	/**
+	 * Copy data from the #ring_buffer directly into the mmapped
+	 * ALSA-PCM buffer.  Only used in #mmap mode.
+	 *
+	 * @param silence_frames the maximum number of silence frames
+	 * to be inserted if the #ring_buffer runs empty
+	 * @return the number of frames committed (may be 0) or a
+	 * negative error code
+	 */
+	snd_pcm_sframes_t CopyRingToMmap(snd_pcm_uframes_t silence_frames) noexcept;
+
 	snd_pcm_sframes_t WriteFromPeriodBuffer() noexcept {
 		assert(period_buffer.IsFull());
 		assert(period_buffer.GetFrames(out_frame_size) > 0);
@@ -371,6 +480,43 @@ private:
 		cond.notify_one();
 	}
 
+	/**
+	 * There is no data in the #ring_buffer, but also no pressure
+	 * to fill the ALSA-PCM buffer.  Set the #waiting flag, so
+	 * Play() reactivates this object as soon as more data
+	 * arrives.
+	 */
+	void BeginWaiting() noexcept {
+		const std::lock_guard<Mutex> lock(mutex);
+		waiting = true;
+		cond.notify_one();
+	}
+
+	/**
+	 * Stop monitoring the ALSA file descriptor until Play()
+	 * calls Activate() again.
+	 */
+	void StopMonitoring() noexcept {
+		MultiSocketMonitor::Reset();
+		defer_invalidate_sockets.Cancel();
+
+		/* just in case Play() doesn't get called soon
+		   enough, schedule a timer which generates silence
+		   before the xrun occurs */
+		/* the timer fires in half of a period; this short
+		   duration may produce a few more wakeups than
+		   necessary, but should be small enough to avoid the
+		   xrun */
+		silence_timer.Schedule(effective_period_duration / 2);
+	}
+
+	/**
+	 * The #mmap mode part of DispatchSockets().
+	 *
+	 * Throws on error.
+	 */
+	void DispatchMmap();
+
 	/**
 	 * Callback for @silence_timer
 	 */
@@ -404,8 +550,21 @@ AlsaOutput::AlsaOutput(EventLoop &_loop, const ConfigBlock &block)
 #endif
 	 buffer_time(block.GetPositiveValue("buffer_time",
 					    MPD_ALSA_BUFFER_TIME_US)),
-	 period_time(block.GetPositiveValue("period_time", 0u))
+	 period_time(block.GetPositiveValue("period_time", 0u)),
+	 min_buffer_time(block.GetPositiveValue("min_buffer_time",
+						std::min(buffer_time,
+							 MPD_ALSA_MIN_BUFFER_TIME_US))),
+	 max_buffer_time(block.GetPositiveValue("max_buffer_time",
+						std::max(buffer_time,
+							 MPD_ALSA_MAX_BUFFER_TIME_US))),
+	 mmap_setting(block.GetBlockValue("mmap", false)),
+	 adaptive_buffer(block.GetBlockValue("adaptive_buffer", false)),
+	 adaptive_buffer_time(std::clamp(buffer_time,
+					 min_buffer_time, max_buffer_time))
 {
+	if (min_buffer_time > max_buffer_time)
+		throw std::runtime_error("min_buffer_time must not be larger than max_buffer_time");
+
 #ifdef SND_PCM_NO_AUTO_RESAMPLE
 	if (!block.GetBlockValue("auto_resample", true))
 		mode |= SND_PCM_NO_AUTO_RESAMPLE;
@@ -438,6 +597,18 @@ AlsaOutput::GetAttributes() const noexcept
 #ifdef ENABLE_DSD
 		std::make_pair("dop", dop_setting ? "1" : "0"),
 #endif
+		std::make_pair("adaptive_buffer", adaptive_buffer ? "1" : "0"),
+		std::make_pair("buffer_time",
+			       std::to_string(adaptive_buffer
+					      ? adaptive_buffer_time
+					      : buffer_time)),
+		std::make_pair("xruns", std::to_string(telemetry.GetXruns())),
+		std::make_pair("write_latency_avg",
+			       telemetry.FormatWriteLatencyAverage()),
+		std::make_pair("write_latency_max",
+			       telemetry.FormatWriteLatencyMax()),
+		std::make_pair("fill_histogram",
+			       telemetry.FormatFillHistogram()),
 	};
 }
 
@@ -457,6 +628,14 @@ AlsaOutput::SetAttribute(std::string &&name, std::string &&value)
 		else
 			throw std::invalid_argument("Bad 'dop' value");
 #endif
+	} else if (name == "adaptive_buffer") {
+		const std::lock_guard<Mutex> lock(attributes_mutex);
+		if (value == "0")
+			adaptive_buffer = false;
+		else if (value == "1")
+			adaptive_buffer = true;
+		else
+			throw std::invalid_argument("Bad 'adaptive_buffer' value");
 	} else
 		AudioOutput::SetAttribute(std::move(name), std::move(value));
 }
@@ -528,16 +707,20 @@ AlsaOutput::Setup(AudioFormat &audio_format,
 		  PcmExport::Params &params)
 {
 	const auto hw_result = Alsa::SetupHw(pcm,
-					     buffer_time, period_time,
+					     current_buffer_time,
+					     current_period_time,
+					     mmap_setting,
 					     audio_format, params);
+	mmap = hw_result.mmap;
 
 	FormatDebug(alsa_output_domain, "format=%s (%s)",
 		    snd_pcm_format_name(hw_result.format),
 		    snd_pcm_format_description(hw_result.format));
 
-	FormatDebug(alsa_output_domain, "buffer_size=%u period_size=%u",
+	FormatDebug(alsa_output_domain, "buffer_size=%u period_size=%u mmap=%d",
 		    (unsigned)hw_result.buffer_size,
-		    (unsigned)hw_result.period_size);
+		    (unsigned)hw_result.period_size,
+		    mmap);
 
 	AlsaSetupSw(pcm, hw_result.buffer_size - hw_result.period_size,
 		    hw_result.period_size);
@@ -552,6 +735,7 @@ AlsaOutput::Setup(AudioFormat &audio_format,
 		alsa_period_size = 1;
 
 	period_frames = alsa_period_size;
+	buffer_frames = hw_result.buffer_size;
 	effective_period_duration = audio_format.FramesToTime<decltype(effective_period_duration)>(period_frames);
 
 	/* generate silence if there's less than one period of data
@@ -675,6 +859,19 @@ AlsaOutput::Open(AudioFormat &audio_format)
 		dop = dop_setting;
 #endif
 
+		if (adaptive_buffer) {
+			/* let Alsa::SetupHw() derive the period
+			   from the adaptive buffer time */
+			current_buffer_time = adaptive_buffer_time;
+			current_period_time = 0;
+		} else {
+			current_buffer_time = buffer_time;
+			current_period_time = period_time;
+		}
+
+		open_xruns = telemetry.GetXruns();
+		open_time = std::chrono::steady_clock::now();
+
 		if (!allowed_formats.empty()) {
 			const auto &a = BestMatch(allowed_formats,
 						  audio_format);
@@ -748,6 +945,10 @@ AlsaOutput::Recover(int err) noexcept
 		FormatDebug(alsa_output_domain,
 			    "Underrun on ALSA device \"%s\"",
 			    GetDevice());
+
+		PipelineTrace::Emit(PipelineTraceEvent::XRUN, GetDevice());
+
+		telemetry.AddXrun();
 	} else if (err == -ESTRPIPE) {
 		FormatDebug(alsa_output_domain,
 			    "ALSA device \"%s\" was suspended",
@@ -798,32 +999,51 @@ AlsaOutput::Recover(int err) noexcept
 inline bool
 AlsaOutput::DrainInternal()
 {
-	/* drain ring_buffer */
-	CopyRingToPeriodBuffer();
+	if (mmap) {
+		/* drain ring_buffer directly into the ALSA-PCM
+		   buffer; a partial period does not need to be
+		   padded with silence in this mode */
+		auto frames_written = CopyRingToMmap(0);
+		if (frames_written < 0) {
+			if (frames_written == -EAGAIN)
+				return false;
+
+			throw FormatRuntimeError("snd_pcm_mmap_commit() failed: %s",
+						 snd_strerror(-frames_written));
+		}
 
-	/* drain period_buffer */
-	if (!period_buffer.IsCleared()) {
-		if (!period_buffer.IsFull())
-			/* generate some silence to finish the partial
-			   period */
-			period_buffer.FillWithSilence(silence, out_frame_size);
+		if (ring_buffer->read_available() > 0)
+			/* the ALSA-PCM buffer is full; try again
+			   in the next iteration */
+			return false;
+	} else {
+		/* drain ring_buffer */
+		CopyRingToPeriodBuffer();
 
 		/* drain period_buffer */
-		if (!period_buffer.IsDrained()) {
-			auto frames_written = WriteFromPeriodBuffer();
-			if (frames_written < 0) {
-				if (frames_written == -EAGAIN)
-					return false;
-
-				throw FormatRuntimeError("snd_pcm_writei() failed: %s",
-							 snd_strerror(-frames_written));
+		if (!period_buffer.IsCleared()) {
+			if (!period_buffer.IsFull())
+				/* generate some silence to finish the partial
+				   period */
+				period_buffer.FillWithSilence(silence, out_frame_size);
+
+			/* drain period_buffer */
+			if (!period_buffer.IsDrained()) {
+				auto frames_written = WriteFromPeriodBuffer();
+				if (frames_written < 0) {
+					if (frames_written == -EAGAIN)
+						return false;
+
+					throw FormatRuntimeError("snd_pcm_writei() failed: %s",
+								 snd_strerror(-frames_written));
+				}
+
+				/* need to call CopyRingToPeriodBuffer() and
+				   WriteFromPeriodBuffer() again in the next
+				   iteration, so don't finish the drain just
+				   yet */
+				return false;
 			}
-
-			/* need to call CopyRingToPeriodBuffer() and
-			   WriteFromPeriodBuffer() again in the next
-			   iteration, so don't finish the drain just
-			   yet */
-			return false;
 		}
 	}
 
@@ -942,6 +1162,40 @@ AlsaOutput::Close() noexcept
 	delete ring_buffer;
 	snd_pcm_close(pcm);
 	delete[] silence;
+
+	AdaptBufferTime();
+}
+
+inline void
+AlsaOutput::AdaptBufferTime() noexcept
+{
+	const std::lock_guard<Mutex> lock(attributes_mutex);
+
+	if (!adaptive_buffer)
+		return;
+
+	/* the new value takes effect at the next Open() call,
+	   because the hardware parameters cannot be changed while
+	   the PCM is running */
+
+	unsigned t = std::clamp(current_buffer_time,
+				min_buffer_time, max_buffer_time);
+	if (telemetry.GetXruns() != open_xruns)
+		/* there were xruns: grow the buffer */
+		t = std::min(t + t / 2, max_buffer_time);
+	else if (std::chrono::steady_clock::now() - open_time >= MPD_ALSA_ADAPTIVE_STABLE_TIME)
+		/* no xruns for a while: try a smaller buffer to
+		   reduce latency */
+		t = std::max(t - t / 4, min_buffer_time);
+	else
+		return;
+
+	if (t != adaptive_buffer_time) {
+		adaptive_buffer_time = t;
+		FormatDebug(alsa_output_domain,
+			    "adaptive buffer_time=%u on ALSA device \"%s\"",
+			    t, GetDevice());
+	}
 }
 
 size_t
@@ -1057,6 +1311,11 @@ try {
 		}
 	}
 
+	if (mmap) {
+		DispatchMmap();
+		return;
+	}
+
 	CopyRingToPeriodBuffer();
 
 	if (!period_buffer.IsFull()) {
@@ -1077,31 +1336,14 @@ try {
 			   start of playback, when our ring_buffer is
 			   smaller than the ALSA-PCM buffer */
 
-			{
-				const std::lock_guard<Mutex> lock(mutex);
-				waiting = true;
-				cond.notify_one();
-			}
+			BeginWaiting();
 
 			/* avoid race condition: see if data has
 			   arrived meanwhile before disabling the
 			   event (but after setting the "waiting"
 			   flag) */
-			if (!CopyRingToPeriodBuffer()) {
-				MultiSocketMonitor::Reset();
-				defer_invalidate_sockets.Cancel();
-
-				/* just in case Play() doesn't get
-				   called soon enough, schedule a
-				   timer which generates silence
-				   before the xrun occurs */
-				/* the timer fires in half of a
-				   period; this short duration may
-				   produce a few more wakeups than
-				   necessary, but should be small
-				   enough to avoid the xrun */
-				silence_timer.Schedule(effective_period_duration / 2);
-			}
+			if (!CopyRingToPeriodBuffer())
+				StopMonitoring();
 
 			return;
 		}
@@ -1114,7 +1356,13 @@ try {
 		period_buffer.FillWithSilence(silence, out_frame_size);
 	}
 
+	const auto avail = snd_pcm_avail_update(pcm);
+	const auto write_start = std::chrono::steady_clock::now();
 	auto frames_written = WriteFromPeriodBuffer();
+	if (frames_written >= 0)
+		RecordWrite(avail,
+			    std::chrono::steady_clock::now() - write_start);
+
 	if (frames_written < 0) {
 		if (frames_written == -EAGAIN || frames_written == -EINTR)
 			/* try again in the next DispatchSockets()
@@ -1134,6 +1382,125 @@ try {
 	LockCaughtError();
 }
 
+snd_pcm_sframes_t
+AlsaOutput::CopyRingToMmap(snd_pcm_uframes_t silence_frames) noexcept
+{
+	snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+	if (avail < 0)
+		return avail;
+
+	snd_pcm_sframes_t total = 0;
+	while (avail > 0) {
+		const snd_pcm_channel_area_t *areas;
+		snd_pcm_uframes_t offset, frames = avail;
+		int err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+		if (err < 0)
+			return err;
+
+		/* with SND_PCM_ACCESS_MMAP_INTERLEAVED, all channels
+		   share one area, and one step is one frame */
+		assert(areas[0].step == out_frame_size * 8);
+		uint8_t *dest = (uint8_t *)areas[0].addr
+			+ areas[0].first / 8 + offset * out_frame_size;
+
+		size_t nbytes = ring_buffer->pop(dest,
+						 frames * out_frame_size);
+		snd_pcm_uframes_t n = nbytes / out_frame_size;
+
+		while (n < frames && silence_frames > 0) {
+			const snd_pcm_uframes_t s =
+				std::min({frames - n, silence_frames,
+					  period_frames});
+			memcpy(dest + n * out_frame_size, silence,
+			       s * out_frame_size);
+			n += s;
+			silence_frames -= s;
+		}
+
+		auto committed = snd_pcm_mmap_commit(pcm, offset, n);
+		if (committed < 0)
+			return committed;
+
+		if ((snd_pcm_uframes_t)committed != n)
+			return -EPIPE;
+
+		total += n;
+		avail -= n;
+
+		if (n < frames)
+			/* the ring_buffer has run empty */
+			break;
+	}
+
+	if (total > 0) {
+		written = true;
+
+		/* unlike snd_pcm_writei(), snd_pcm_mmap_commit()
+		   does not start the PCM automatically when the
+		   start threshold (buffer_size - period_size, see
+		   AlsaSetupSw()) is reached */
+		if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED &&
+		    avail <= (snd_pcm_sframes_t)period_frames) {
+			int err = snd_pcm_start(pcm);
+			if (err < 0)
+				return err;
+		}
+
+		const std::lock_guard<Mutex> lock(mutex);
+		/* notify the OutputThread that there is now
+		   room in ring_buffer */
+		cond.notify_one();
+	}
+
+	return total;
+}
+
+inline void
+AlsaOutput::DispatchMmap()
+{
+	const auto avail = snd_pcm_avail_update(pcm);
+	const auto write_start = std::chrono::steady_clock::now();
+	auto frames_written = CopyRingToMmap(0);
+	if (frames_written > 0)
+		RecordWrite(avail,
+			    std::chrono::steady_clock::now() - write_start);
+
+	if (frames_written >= 0 &&
+	    snd_pcm_avail_update(pcm) >= (snd_pcm_sframes_t)period_frames) {
+		/* the ring_buffer has run empty before the ALSA-PCM
+		   buffer could be filled; see DispatchSockets() for
+		   the same decision in writei mode */
+		if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED ||
+		    snd_pcm_avail(pcm) <= max_avail_frames) {
+			BeginWaiting();
+
+			/* avoid race condition: see if data has
+			   arrived meanwhile */
+			if (ring_buffer->read_available() == 0)
+				StopMonitoring();
+
+			return;
+		}
+
+		if (throttle_silence_log.CheckUpdate(std::chrono::seconds(5)))
+			FormatWarning(alsa_output_domain, "Decoder is too slow; playing silence to avoid xrun");
+
+		/* insert one period of silence to avoid ALSA xrun */
+		frames_written = CopyRingToMmap(period_frames);
+	}
+
+	if (frames_written < 0) {
+		if (frames_written == -EAGAIN || frames_written == -EINTR)
+			/* try again in the next DispatchSockets()
+			   call which is still scheduled */
+			return;
+
+		if (Recover(frames_written) < 0)
+			throw FormatRuntimeError("snd_pcm_mmap_commit() failed: %s",
+						 snd_strerror(-frames_written));
+	}
+}
+
 const struct AudioOutputPlugin alsa_output_plugin = {
 	"alsa",
 	alsa_test_default_device,
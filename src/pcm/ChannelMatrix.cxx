@@ -0,0 +1,451 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ChannelMatrix.hxx"
+#include "Buffer.hxx"
+#include "Traits.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include <assert.h>
+
+namespace {
+
+enum class ChannelPosition : uint8_t {
+	FRONT_LEFT,
+	FRONT_RIGHT,
+	FRONT_CENTER,
+	LFE,
+	BACK_LEFT,
+	BACK_RIGHT,
+	BACK_CENTER,
+	SIDE_LEFT,
+	SIDE_RIGHT,
+};
+
+}
+
+/**
+ * MPD's channel layouts (the same as FLAC and WAVE_FORMAT_EXTENSIBLE)
+ * indexed by the number of channels minus one.
+ */
+static constexpr ChannelPosition channel_layouts[MAX_CHANNELS][MAX_CHANNELS] = {
+	{ ChannelPosition::FRONT_CENTER },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT,
+	  ChannelPosition::FRONT_CENTER },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT,
+	  ChannelPosition::BACK_LEFT, ChannelPosition::BACK_RIGHT },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT,
+	  ChannelPosition::FRONT_CENTER,
+	  ChannelPosition::BACK_LEFT, ChannelPosition::BACK_RIGHT },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT,
+	  ChannelPosition::FRONT_CENTER, ChannelPosition::LFE,
+	  ChannelPosition::BACK_LEFT, ChannelPosition::BACK_RIGHT },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT,
+	  ChannelPosition::FRONT_CENTER, ChannelPosition::LFE,
+	  ChannelPosition::BACK_CENTER,
+	  ChannelPosition::SIDE_LEFT, ChannelPosition::SIDE_RIGHT },
+	{ ChannelPosition::FRONT_LEFT, ChannelPosition::FRONT_RIGHT,
+	  ChannelPosition::FRONT_CENTER, ChannelPosition::LFE,
+	  ChannelPosition::BACK_LEFT, ChannelPosition::BACK_RIGHT,
+	  ChannelPosition::SIDE_LEFT, ChannelPosition::SIDE_RIGHT },
+};
+
+/**
+ * -3 dB
+ */
+static constexpr float SQRT1_2 = 0.70710678f;
+
+static int
+FindChannel(unsigned channels, ChannelPosition position) noexcept
+{
+	const auto *layout = channel_layouts[channels - 1];
+	for (unsigned i = 0; i < channels; ++i)
+		if (layout[i] == position)
+			return i;
+
+	return -1;
+}
+
+PcmChannelMatrix::PcmChannelMatrix(unsigned _src_channels,
+				   unsigned _dest_channels) noexcept
+	:src_channels(_src_channels), dest_channels(_dest_channels)
+{
+	assert(audio_valid_channel_count(src_channels));
+	assert(audio_valid_channel_count(dest_channels));
+
+	std::fill_n(&coefficients[0][0], MAX_CHANNELS * MAX_CHANNELS, 0.f);
+}
+
+/**
+ * Add the given source channel to the destination channel with the
+ * given position, if it exists in the destination layout.
+ *
+ * @return true if the destination channel exists
+ */
+static bool
+AddToPosition(PcmChannelMatrix &m, unsigned src, ChannelPosition position,
+	      float gain) noexcept
+{
+	int dest = FindChannel(m.GetDestChannels(), position);
+	if (dest < 0)
+		return false;
+
+	m.Set(dest, src, m.Get(dest, src) + gain);
+	return true;
+}
+
+/**
+ * Add the given source channel to a pair of destination channels.
+ */
+static bool
+AddToPair(PcmChannelMatrix &m, unsigned src,
+	  ChannelPosition left, ChannelPosition right,
+	  float gain) noexcept
+{
+	if (FindChannel(m.GetDestChannels(), left) < 0 ||
+	    FindChannel(m.GetDestChannels(), right) < 0)
+		return false;
+
+	AddToPosition(m, src, left, gain);
+	AddToPosition(m, src, right, gain);
+	return true;
+}
+
+/**
+ * Map one source channel into a destination layout which may lack the
+ * channel's position, folding it into the nearest existing
+ * channel(s).
+ */
+static void
+FoldChannel(PcmChannelMatrix &m, unsigned src,
+	    ChannelPosition position) noexcept
+{
+	if (AddToPosition(m, src, position, 1))
+		return;
+
+	switch (position) {
+	case ChannelPosition::FRONT_LEFT:
+	case ChannelPosition::FRONT_RIGHT:
+		/* all layouts with more than one channel have
+		   front left and right */
+		break;
+
+	case ChannelPosition::FRONT_CENTER:
+		AddToPair(m, src, ChannelPosition::FRONT_LEFT,
+			  ChannelPosition::FRONT_RIGHT, SQRT1_2);
+		break;
+
+	case ChannelPosition::LFE:
+		/* ITU-R BS.775 drops the LFE channel */
+		break;
+
+	case ChannelPosition::BACK_LEFT:
+		AddToPosition(m, src, ChannelPosition::SIDE_LEFT, 1) ||
+			AddToPosition(m, src, ChannelPosition::FRONT_LEFT,
+				      SQRT1_2);
+		break;
+
+	case ChannelPosition::BACK_RIGHT:
+		AddToPosition(m, src, ChannelPosition::SIDE_RIGHT, 1) ||
+			AddToPosition(m, src, ChannelPosition::FRONT_RIGHT,
+				      SQRT1_2);
+		break;
+
+	case ChannelPosition::SIDE_LEFT:
+		AddToPosition(m, src, ChannelPosition::BACK_LEFT, 1) ||
+			AddToPosition(m, src, ChannelPosition::FRONT_LEFT,
+				      SQRT1_2);
+		break;
+
+	case ChannelPosition::SIDE_RIGHT:
+		AddToPosition(m, src, ChannelPosition::BACK_RIGHT, 1) ||
+			AddToPosition(m, src, ChannelPosition::FRONT_RIGHT,
+				      SQRT1_2);
+		break;
+
+	case ChannelPosition::BACK_CENTER:
+		AddToPair(m, src, ChannelPosition::BACK_LEFT,
+			  ChannelPosition::BACK_RIGHT, SQRT1_2) ||
+			AddToPair(m, src, ChannelPosition::SIDE_LEFT,
+				  ChannelPosition::SIDE_RIGHT, SQRT1_2) ||
+			AddToPair(m, src, ChannelPosition::FRONT_LEFT,
+				  ChannelPosition::FRONT_RIGHT, SQRT1_2);
+		break;
+	}
+}
+
+PcmChannelMatrix
+PcmChannelMatrix::Default(unsigned src_channels,
+			  unsigned dest_channels) noexcept
+{
+	PcmChannelMatrix m(src_channels, dest_channels);
+
+	if (src_channels == dest_channels) {
+		for (unsigned i = 0; i < src_channels; ++i)
+			m.Set(i, i, 1);
+	} else if (dest_channels == 1) {
+		/* average of all channels */
+		for (unsigned i = 0; i < src_channels; ++i)
+			m.Set(0, i, 1.f / src_channels);
+	} else if (src_channels == 1) {
+		/* copy mono to all channels */
+		for (unsigned i = 0; i < dest_channels; ++i)
+			m.Set(i, 0, 1);
+	} else if (src_channels == 2) {
+		/* left/right to front-left/front-right, all other
+		   channels are silent */
+		m.Set(0, 0, 1);
+		m.Set(1, 1, 1);
+	} else {
+		const auto *layout = channel_layouts[src_channels - 1];
+		for (unsigned i = 0; i < src_channels; ++i)
+			FoldChannel(m, i, layout[i]);
+
+		m.Normalize();
+	}
+
+	return m;
+}
+
+void
+PcmChannelMatrix::Normalize() noexcept
+{
+	for (unsigned d = 0; d < dest_channels; ++d) {
+		float sum = 0;
+		for (unsigned s = 0; s < src_channels; ++s)
+			sum += std::abs(coefficients[d][s]);
+
+		if (sum > 1)
+			for (unsigned s = 0; s < src_channels; ++s)
+				coefficients[d][s] /= sum;
+	}
+}
+
+/**
+ * The type used for the calculations; "float" has enough precision
+ * for 24 bit samples, but 32 bit samples need "double".
+ */
+template<SampleFormat F>
+using MatrixFloat = std::conditional_t<F == SampleFormat::S32,
+				       double, float>;
+
+/**
+ * Convert a sum back to the sample type, clamping it to the valid
+ * range and rounding it to the nearest integer (halfway cases away
+ * from zero).
+ */
+template<SampleFormat F, class Traits=SampleTraits<F>>
+static inline typename Traits::value_type
+FromMatrixFloat(MatrixFloat<F> x) noexcept
+{
+	using A = MatrixFloat<F>;
+
+	if constexpr (F == SampleFormat::FLOAT)
+		return x;
+	else {
+		/* the conversion truncates toward zero; moving the
+		   value away from zero by one half makes it round */
+		x = x < 0 ? x - A(0.5) : x + A(0.5);
+
+		return typename Traits::value_type(std::clamp<A>(x,
+								 Traits::MIN,
+								 Traits::MAX));
+	}
+}
+
+/**
+ * Apply the matrix with channel counts known at compile time.  This
+ * allows the compiler to unroll the inner loops and vectorise the
+ * frame loop.
+ */
+template<SampleFormat F, unsigned SC, unsigned DC,
+	 class Traits=SampleTraits<F>>
+static void
+ApplyMatrix(typename Traits::pointer_type gcc_restrict dest,
+	    typename Traits::const_pointer_type gcc_restrict src,
+	    size_t n_frames, const PcmChannelMatrix &matrix) noexcept
+{
+	using A = MatrixFloat<F>;
+
+	/* a local copy which the compiler knows cannot alias the
+	   destination buffer */
+	A c[DC][SC];
+	for (unsigned d = 0; d < DC; ++d)
+		for (unsigned s = 0; s < SC; ++s)
+			c[d][s] = matrix.Get(d, s);
+
+	for (size_t i = 0; i < n_frames; ++i, src += SC, dest += DC) {
+		for (unsigned d = 0; d < DC; ++d) {
+			A sum = 0;
+			for (unsigned s = 0; s < SC; ++s)
+				sum += c[d][s] * A(src[s]);
+			dest[d] = FromMatrixFloat<F>(sum);
+		}
+	}
+}
+
+/**
+ * Generic implementation for channel counts which have no
+ * specialization.
+ */
+template<SampleFormat F, class Traits=SampleTraits<F>>
+static void
+ApplyMatrixGeneric(typename Traits::pointer_type dest,
+		   typename Traits::const_pointer_type src,
+		   size_t n_frames, const PcmChannelMatrix &matrix) noexcept
+{
+	using A = MatrixFloat<F>;
+
+	const unsigned src_channels = matrix.GetSourceChannels();
+	const unsigned dest_channels = matrix.GetDestChannels();
+
+	for (size_t i = 0; i < n_frames; ++i, src += src_channels) {
+		for (unsigned d = 0; d < dest_channels; ++d) {
+			A sum = 0;
+			for (unsigned s = 0; s < src_channels; ++s)
+				sum += A(matrix.Get(d, s)) * A(src[s]);
+			*dest++ = FromMatrixFloat<F>(sum);
+		}
+	}
+}
+
+template<SampleFormat F, class Traits=SampleTraits<F>>
+using MatrixFunction = void (*)(typename Traits::pointer_type dest,
+				typename Traits::const_pointer_type src,
+				size_t n_frames,
+				const PcmChannelMatrix &matrix) noexcept;
+
+template<SampleFormat F, unsigned DC, unsigned... SC>
+static MatrixFunction<F>
+SelectMatrixFunction(unsigned src_channels,
+		     std::integer_sequence<unsigned, SC...>) noexcept
+{
+	static constexpr MatrixFunction<F> table[] = {
+		ApplyMatrix<F, SC + 1, DC>...
+	};
+
+	return table[src_channels - 1];
+}
+
+/**
+ * Choose a specialized implementation.  Only downmixing to mono and
+ * stereo is specialized, because that is the common case; everything
+ * else uses the generic implementation.
+ */
+template<SampleFormat F>
+static MatrixFunction<F>
+SelectMatrixFunction(unsigned src_channels, unsigned dest_channels) noexcept
+{
+	using Sequence = std::make_integer_sequence<unsigned, MAX_CHANNELS>;
+
+	switch (dest_channels) {
+	case 1:
+		return SelectMatrixFunction<F, 1>(src_channels, Sequence());
+
+	case 2:
+		return SelectMatrixFunction<F, 2>(src_channels, Sequence());
+
+	default:
+		return ApplyMatrixGeneric<F>;
+	}
+}
+
+template<SampleFormat F, class Traits=SampleTraits<F>>
+static ConstBuffer<typename Traits::value_type>
+ApplyMatrix(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+	    ConstBuffer<typename Traits::value_type> src) noexcept
+{
+	const unsigned src_channels = matrix.GetSourceChannels();
+	const unsigned dest_channels = matrix.GetDestChannels();
+
+	assert(src.size % src_channels == 0);
+
+	const size_t n_frames = src.size / src_channels;
+	const size_t dest_size = n_frames * dest_channels;
+	auto dest = buffer.GetT<typename Traits::value_type>(dest_size);
+
+	SelectMatrixFunction<F>(src_channels, dest_channels)(dest, src.data,
+							     n_frames, matrix);
+	return { dest, dest_size };
+}
+
+ConstBuffer<int16_t>
+pcm_channel_matrix_16(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		      ConstBuffer<int16_t> src) noexcept
+{
+	return ApplyMatrix<SampleFormat::S16>(buffer, matrix, src);
+}
+
+ConstBuffer<int32_t>
+pcm_channel_matrix_24(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		      ConstBuffer<int32_t> src) noexcept
+{
+	return ApplyMatrix<SampleFormat::S24_P32>(buffer, matrix, src);
+}
+
+ConstBuffer<int32_t>
+pcm_channel_matrix_32(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		      ConstBuffer<int32_t> src) noexcept
+{
+	return ApplyMatrix<SampleFormat::S32>(buffer, matrix, src);
+}
+
+ConstBuffer<float>
+pcm_channel_matrix_float(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+			 ConstBuffer<float> src) noexcept
+{
+	return ApplyMatrix<SampleFormat::FLOAT>(buffer, matrix, src);
+}
+
+ConstBuffer<void>
+pcm_channel_matrix(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		   SampleFormat format, ConstBuffer<void> src) noexcept
+{
+	switch (format) {
+	case SampleFormat::UNDEFINED:
+	case SampleFormat::S8:
+	case SampleFormat::DSD:
+		return nullptr;
+
+	case SampleFormat::S16:
+		return pcm_channel_matrix_16(buffer, matrix,
+					     ConstBuffer<int16_t>::FromVoid(src)).ToVoid();
+
+	case SampleFormat::S24_P32:
+		return pcm_channel_matrix_24(buffer, matrix,
+					     ConstBuffer<int32_t>::FromVoid(src)).ToVoid();
+
+	case SampleFormat::S32:
+		return pcm_channel_matrix_32(buffer, matrix,
+					     ConstBuffer<int32_t>::FromVoid(src)).ToVoid();
+
+	case SampleFormat::FLOAT:
+		return pcm_channel_matrix_float(buffer, matrix,
+						ConstBuffer<float>::FromVoid(src)).ToVoid();
+	}
+
+	assert(false);
+	gcc_unreachable();
+}
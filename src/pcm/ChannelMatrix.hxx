@@ -0,0 +1,148 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_CHANNEL_MATRIX_HXX
+#define MPD_PCM_CHANNEL_MATRIX_HXX
+
+#include "ChannelDefs.hxx"
+#include "util/Compiler.h"
+
+#include <stdint.h>
+
+class PcmBuffer;
+template<typename T> struct ConstBuffer;
+enum class SampleFormat : uint8_t;
+
+/**
+ * A mixing matrix which describes how to convert PCM data from one
+ * channel layout to another: each output channel is the weighted sum
+ * of all input channels.
+ */
+class PcmChannelMatrix {
+	unsigned src_channels, dest_channels;
+
+	/**
+	 * The coefficients, indexed by destination channel and then
+	 * source channel.
+	 */
+	float coefficients[MAX_CHANNELS][MAX_CHANNELS];
+
+public:
+	/**
+	 * Construct a matrix with all coefficients set to zero,
+	 * i.e. silence on all output channels.
+	 */
+	PcmChannelMatrix(unsigned _src_channels,
+			 unsigned _dest_channels) noexcept;
+
+	/**
+	 * Construct the matrix which is used by
+	 * #PcmChannelsConverter.  Upmixing copies mono to all
+	 * channels and stereo to the front channels; downmixing
+	 * follows ITU-R BS.775 (center and surround channels are
+	 * attenuated by 3 dB, LFE is dropped), and each output
+	 * channel is normalized so it cannot clip.
+	 */
+	gcc_pure
+	static PcmChannelMatrix Default(unsigned src_channels,
+					unsigned dest_channels) noexcept;
+
+	unsigned GetSourceChannels() const noexcept {
+		return src_channels;
+	}
+
+	unsigned GetDestChannels() const noexcept {
+		return dest_channels;
+	}
+
+	float Get(unsigned dest, unsigned src) const noexcept {
+		return coefficients[dest][src];
+	}
+
+	void Set(unsigned dest, unsigned src, float value) noexcept {
+		coefficients[dest][src] = value;
+	}
+
+	/**
+	 * Scale down each output channel whose coefficients add up
+	 * to more than 1, so full-scale input cannot clip.
+	 */
+	void Normalize() noexcept;
+};
+
+/**
+ * Apply a mixing matrix to 16 bit PCM data.
+ *
+ * @param buffer the destination pcm_buffer object
+ * @param matrix the mixing matrix
+ * @param src the source PCM buffer
+ * @return the destination buffer
+ */
+ConstBuffer<int16_t>
+pcm_channel_matrix_16(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		      ConstBuffer<int16_t> src) noexcept;
+
+/**
+ * Apply a mixing matrix to 24 bit PCM data (aligned at 32 bit
+ * boundaries).
+ *
+ * @param buffer the destination pcm_buffer object
+ * @param matrix the mixing matrix
+ * @param src the source PCM buffer
+ * @return the destination buffer
+ */
+ConstBuffer<int32_t>
+pcm_channel_matrix_24(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		      ConstBuffer<int32_t> src) noexcept;
+
+/**
+ * Apply a mixing matrix to 32 bit PCM data.
+ *
+ * @param buffer the destination pcm_buffer object
+ * @param matrix the mixing matrix
+ * @param src the source PCM buffer
+ * @return the destination buffer
+ */
+ConstBuffer<int32_t>
+pcm_channel_matrix_32(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		      ConstBuffer<int32_t> src) noexcept;
+
+/**
+ * Apply a mixing matrix to 32 bit float PCM data.
+ *
+ * @param buffer the destination pcm_buffer object
+ * @param matrix the mixing matrix
+ * @param src the source PCM buffer
+ * @return the destination buffer
+ */
+ConstBuffer<float>
+pcm_channel_matrix_float(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+			 ConstBuffer<float> src) noexcept;
+
+/**
+ * Apply a mixing matrix to PCM data in the given sample format.
+ *
+ * @return the destination buffer or nullptr if the sample format is
+ * not supported
+ */
+ConstBuffer<void>
+pcm_channel_matrix(PcmBuffer &buffer, const PcmChannelMatrix &matrix,
+		   SampleFormat format, ConstBuffer<void> src) noexcept;
+
+#endif
@@ -19,11 +19,17 @@
 
 #include "ChannelsConverter.hxx"
 #include "PcmChannels.hxx"
+#include "ChannelMatrix.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/RuntimeError.hxx"
 
 #include <assert.h>
 
+PcmChannelsConverter::~PcmChannelsConverter() noexcept
+{
+	assert(format == SampleFormat::UNDEFINED);
+}
+
 void
 PcmChannelsConverter::Open(SampleFormat _format,
 			   unsigned _src_channels, unsigned _dest_channels)
@@ -42,6 +48,9 @@ PcmChannelsConverter::Open(SampleFormat _format,
 					 sample_format_to_string(_format));
 	}
 
+	matrix = std::make_unique<PcmChannelMatrix>(PcmChannelMatrix::Default(_src_channels,
+									      _dest_channels));
+
 	format = _format;
 	src_channels = _src_channels;
 	dest_channels = _dest_channels;
@@ -50,6 +59,8 @@ PcmChannelsConverter::Open(SampleFormat _format,
 void
 PcmChannelsConverter::Close() noexcept
 {
+	matrix.reset();
+
 #ifndef NDEBUG
 	format = SampleFormat::UNDEFINED;
 #endif
@@ -68,22 +79,26 @@ PcmChannelsConverter::Convert(ConstBuffer<void> src) noexcept
 	case SampleFormat::S16:
 		return pcm_convert_channels_16(buffer, dest_channels,
 					       src_channels,
-					       ConstBuffer<int16_t>::FromVoid(src)).ToVoid();
+					       ConstBuffer<int16_t>::FromVoid(src),
+					       matrix.get()).ToVoid();
 
 	case SampleFormat::S24_P32:
 		return pcm_convert_channels_24(buffer, dest_channels,
 					       src_channels,
-					       ConstBuffer<int32_t>::FromVoid(src)).ToVoid();
+					       ConstBuffer<int32_t>::FromVoid(src),
+					       matrix.get()).ToVoid();
 
 	case SampleFormat::S32:
 		return pcm_convert_channels_32(buffer, dest_channels,
 					       src_channels,
-					       ConstBuffer<int32_t>::FromVoid(src)).ToVoid();
+					       ConstBuffer<int32_t>::FromVoid(src),
+					       matrix.get()).ToVoid();
 
 	case SampleFormat::FLOAT:
 		return pcm_convert_channels_float(buffer, dest_channels,
 						  src_channels,
-						  ConstBuffer<float>::FromVoid(src)).ToVoid();
+						  ConstBuffer<float>::FromVoid(src),
+						  matrix.get()).ToVoid();
 	}
 
 	assert(false);
@@ -23,10 +23,13 @@
 #include "SampleFormat.hxx"
 #include "Buffer.hxx"
 
+#include <memory>
+
 #ifndef NDEBUG
 #include <assert.h>
 #endif
 
+class PcmChannelMatrix;
 template<typename T> struct ConstBuffer;
 
 /**
@@ -36,18 +39,22 @@ class PcmChannelsConverter {
 	SampleFormat format;
 	unsigned src_channels, dest_channels;
 
+	/**
+	 * The mixing matrix for this conversion (see
+	 * PcmChannelMatrix::Default()); it is built once by Open().
+	 */
+	std::unique_ptr<PcmChannelMatrix> matrix;
+
 	PcmBuffer buffer;
 
 public:
 #ifndef NDEBUG
 	PcmChannelsConverter() noexcept
 		:format(SampleFormat::UNDEFINED) {}
-
-	~PcmChannelsConverter() noexcept {
-		assert(format == SampleFormat::UNDEFINED);
-	}
 #endif
 
+	~PcmChannelsConverter() noexcept;
+
 	/**
 	 * Opens the object, prepare for Convert().
 	 *
@@ -21,12 +21,14 @@
 #include "Prng.hxx"
 #include "Traits.hxx"
 
+#include <algorithm>
+
 template<typename T, T MIN, T MAX, unsigned scale_bits>
 inline T
-PcmDither::Dither(T sample) noexcept
+PcmDither::Dither(T sample, T noise) noexcept
 {
-	constexpr T round = 1 << (scale_bits - 1);
-	constexpr T mask = (1 << scale_bits) - 1;
+	constexpr T round = T(1) << (scale_bits - 1);
+	constexpr T mask = (T(1) << scale_bits) - 1;
 
 	sample += error[0] - error[1] + error[2];
 
@@ -34,12 +36,7 @@ PcmDither::Dither(T sample) noexcept
 	error[1] = error[0] / 2;
 
 	/* round */
-	T output = sample + round;
-
-	const T rnd = pcm_prng(random);
-	output += (rnd & mask) - (random & mask);
-
-	random = rnd;
+	T output = sample + round + noise;
 
 	/* clip */
 	if (output > MAX) {
@@ -61,6 +58,19 @@ PcmDither::Dither(T sample) noexcept
 	return output >> scale_bits;
 }
 
+template<typename T, T MIN, T MAX, unsigned scale_bits>
+inline T
+PcmDither::Dither(T sample) noexcept
+{
+	constexpr T mask = (T(1) << scale_bits) - 1;
+
+	const uint32_t rnd = prng.Next();
+	const T noise = T(rnd & mask) - T(random & mask);
+	random = rnd;
+
+	return Dither<T, MIN, MAX, scale_bits>(sample, noise);
+}
+
 template<typename ST, unsigned SBITS, unsigned DBITS>
 inline ST
 PcmDither::DitherShift(ST sample) noexcept
@@ -74,27 +84,47 @@ PcmDither::DitherShift(ST sample) noexcept
 	return Dither<ST, MIN, MAX, SBITS - DBITS>(sample);
 }
 
-template<typename ST, typename DT>
-inline typename DT::value_type
-PcmDither::DitherConvert(typename ST::value_type sample) noexcept
-{
-	static_assert(ST::BITS > DT::BITS,
-		      "Sample formats cannot be dithered");
-
-	constexpr unsigned scale_bits = ST::BITS - DT::BITS;
-
-	return Dither<typename ST::sum_type, ST::MIN, ST::MAX,
-		      scale_bits>(sample);
-}
-
 template<typename ST, typename DT>
 inline void
 PcmDither::DitherConvert(typename DT::pointer_type dest,
 			 typename ST::const_pointer_type src,
 			 typename ST::const_pointer_type src_end) noexcept
 {
-	while (src < src_end)
-		*dest++ = DitherConvert<ST, DT>(*src++);
+	static_assert(ST::BITS > DT::BITS,
+		      "Sample formats cannot be dithered");
+
+	typedef typename ST::sum_type T;
+	constexpr unsigned scale_bits = ST::BITS - DT::BITS;
+	constexpr T mask = (T(1) << scale_bits) - 1;
+
+	/* the first element is the last random value of the
+	   previous block */
+	uint32_t rnd[BLOCK_SIZE + 1];
+	int32_t noise[BLOCK_SIZE];
+
+	while (src < src_end) {
+		const size_t n = std::min<size_t>(src_end - src, BLOCK_SIZE);
+
+		/* generate the noise for the whole block at once;
+		   these loops have a constant trip count and no
+		   dependencies between iterations, which allows the
+		   compiler to vectorise them */
+		rnd[0] = random;
+		prng.Fill(rnd + 1, BLOCK_SIZE);
+		random = rnd[n];
+
+		for (size_t i = 0; i < BLOCK_SIZE; ++i)
+			noise[i] = int32_t(rnd[i + 1] & mask) -
+				int32_t(rnd[i] & mask);
+
+		/* the error feedback is a serial dependency */
+		for (size_t i = 0; i < n; ++i)
+			dest[i] = Dither<T, ST::MIN, ST::MAX,
+					 scale_bits>(src[i], noise[i]);
+
+		src += n;
+		dest += n;
+	}
 }
 
 inline void
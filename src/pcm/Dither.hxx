@@ -20,13 +20,31 @@
 #ifndef MPD_PCM_DITHER_HXX
 #define MPD_PCM_DITHER_HXX
 
+#include "Prng.hxx"
+
+#include <stddef.h>
 #include <stdint.h>
 
 enum class SampleFormat : uint8_t;
 
 class PcmDither {
+	/**
+	 * The number of samples which are dithered at a time by the
+	 * buffer-oriented methods.
+	 */
+	static constexpr size_t BLOCK_SIZE = 256;
+	static_assert(BLOCK_SIZE % PcmPrng::LANES == 0,
+		      "PcmPrng::Fill() needs a multiple of LANES");
+
 	int32_t error[3];
-	int32_t random;
+
+	/**
+	 * The previous random value; the difference between two
+	 * consecutive values is high-passed triangular noise.
+	 */
+	uint32_t random;
+
+	PcmPrng prng;
 
 public:
 	constexpr PcmDither() noexcept
@@ -65,16 +83,20 @@ private:
 	T Dither(T sample) noexcept;
 
 	/**
-	 * Convert the given sample from one sample format to another,
-	 * discarding bits.
+	 * Like Dither(T), but with a caller-provided noise value
+	 * (difference of two random values masked to #scale_bits).
+	 */
+	template<typename T, T MIN, T MAX, unsigned scale_bits>
+	T Dither(T sample, T noise) noexcept;
+
+	/**
+	 * Convert a buffer from one sample format to another,
+	 * discarding bits.  The noise is generated #BLOCK_SIZE
+	 * samples at a time.
 	 *
 	 * @param ST the input #SampleTraits class
-	 * @param ST the output #SampleTraits class
-	 * @param sample the input sample value
+	 * @param DT the output #SampleTraits class
 	 */
-	template<typename ST, typename DT>
-	typename DT::value_type DitherConvert(typename ST::value_type sample) noexcept;
-
 	template<typename ST, typename DT>
 	void DitherConvert(typename DT::pointer_type dest,
 			   typename ST::const_pointer_type src,
@@ -21,6 +21,7 @@
 #include "Order.hxx"
 #include "Pack.hxx"
 #include "Silence.hxx"
+#include "util/ByteOrder.hxx"
 #include "util/ByteReverse.hxx"
 #include "util/ConstBuffer.hxx"
 #include "util/WritableBuffer.hxx"
@@ -264,6 +265,21 @@ PcmExport::Params::CalcInputSampleRate(unsigned sample_rate) const noexcept
 	return sample_rate;
 }
 
+/**
+ * Shift padded 24 bit samples to the most significant bits (#shift8),
+ * optionally swapping the byte order in the same pass.
+ */
+template<bool reverse_endian>
+static void
+ShiftS24_P32(uint32_t *gcc_restrict dest, const int32_t *gcc_restrict src,
+	     size_t n) noexcept
+{
+	for (size_t i = 0; i < n; ++i) {
+		const uint32_t x = uint32_t(src[i]) << 8;
+		dest[i] = reverse_endian ? ByteSwap32(x) : x;
+	}
+}
+
 ConstBuffer<void>
 PcmExport::Export(ConstBuffer<void> data) noexcept
 {
@@ -293,6 +309,10 @@ PcmExport::Export(ConstBuffer<void> data) noexcept
 	}
 #endif
 
+	/* packing and shifting are fused with the byte swap, so
+	   S24_3BE and S24_P32 with reverse endianess need only one
+	   pass over the data */
+
 	if (pack24) {
 		const auto src = ConstBuffer<int32_t>::FromVoid(data);
 		const size_t num_samples = src.size;
@@ -300,18 +320,28 @@ PcmExport::Export(ConstBuffer<void> data) noexcept
 		uint8_t *dest = (uint8_t *)pack_buffer.Get(dest_size);
 		assert(dest != nullptr);
 
-		pcm_pack_24(dest, src.begin(), src.end());
+		if (reverse_endian == 0)
+			pcm_pack_24(dest, src.begin(), src.end());
+		else if (IsBigEndian())
+			pcm_pack_24le(dest, src.begin(), src.end());
+		else
+			pcm_pack_24be(dest, src.begin(), src.end());
 
 		data.data = dest;
 		data.size = dest_size;
+		return data;
 	} else if (shift8) {
 		const auto src = ConstBuffer<int32_t>::FromVoid(data);
 
 		uint32_t *dest = (uint32_t *)pack_buffer.Get(data.size);
 		data.data = dest;
 
-		for (auto i : src)
-			*dest++ = i << 8;
+		if (reverse_endian == 0)
+			ShiftS24_P32<false>(dest, src.data, src.size);
+		else
+			ShiftS24_P32<true>(dest, src.data, src.size);
+
+		return data;
 	}
 
 	if (reverse_endian > 0) {
@@ -20,29 +20,84 @@
 #include "Pack.hxx"
 #include "util/ByteOrder.hxx"
 
-static void
-pack_sample(uint8_t *dest, const int32_t *src0) noexcept
+#include <string.h>
+
+/**
+ * Pack four padded 24 bit samples into three 32 bit words, which,
+ * when stored in the given byte order, are twelve bytes of packed
+ * little-endian or big-endian 24 bit samples.  Doing four samples at
+ * a time replaces twelve byte stores with three word stores, which
+ * also allows the compiler to vectorize the loop.
+ */
+template<bool big_endian>
+static inline void
+PackQuad(uint8_t *dest, const int32_t *src) noexcept
 {
-	const uint8_t *src = (const uint8_t *)src0;
+	const uint32_t a = src[0], b = src[1], c = src[2], d = src[3];
 
-	if (IsBigEndian())
-		++src;
+	uint32_t w[3];
+	if (big_endian) {
+		w[0] = ToBE32((a << 8) | ((b >> 16) & 0xff));
+		w[1] = ToBE32((b << 16) | ((c >> 8) & 0xffff));
+		w[2] = ToBE32((c << 24) | (d & 0xffffff));
+	} else {
+		w[0] = ToLE32((a & 0xffffff) | (b << 24));
+		w[1] = ToLE32(((b >> 8) & 0xffff) | (c << 16));
+		w[2] = ToLE32(((c >> 16) & 0xff) | (d << 8));
+	}
 
-	*dest++ = *src++;
-	*dest++ = *src++;
-	*dest++ = *src++;
+	/* all four source samples have been loaded already, which
+	   makes in-place conversion safe */
+	memcpy(dest, w, sizeof(w));
+}
+
+template<bool big_endian>
+static inline void
+PackSample(uint8_t *dest, int32_t src) noexcept
+{
+	if (big_endian) {
+		dest[0] = src >> 16;
+		dest[1] = src >> 8;
+		dest[2] = src;
+	} else {
+		dest[0] = src;
+		dest[1] = src >> 8;
+		dest[2] = src >> 16;
+	}
+}
+
+template<bool big_endian>
+static void
+PackS24(uint8_t *dest, const int32_t *src, const int32_t *src_end) noexcept
+{
+	for (; src_end - src >= 4; src += 4, dest += 12)
+		PackQuad<big_endian>(dest, src);
+
+	for (; src < src_end; ++src, dest += 3)
+		PackSample<big_endian>(dest, *src);
 }
 
 void
 pcm_pack_24(uint8_t *dest, const int32_t *src, const int32_t *src_end) noexcept
 {
-	/* duplicate loop to help the compiler's optimizer (constant
-	   parameter to the pack_sample() inline function) */
+	if (IsBigEndian())
+		PackS24<true>(dest, src, src_end);
+	else
+		PackS24<false>(dest, src, src_end);
+}
 
-	while (src < src_end) {
-		pack_sample(dest, src++);
-		dest += 3;
-	}
+void
+pcm_pack_24le(uint8_t *dest,
+	      const int32_t *src, const int32_t *src_end) noexcept
+{
+	PackS24<false>(dest, src, src_end);
+}
+
+void
+pcm_pack_24be(uint8_t *dest,
+	      const int32_t *src, const int32_t *src_end) noexcept
+{
+	PackS24<true>(dest, src, src_end);
 }
 
 /**
@@ -40,6 +40,22 @@ void
 pcm_pack_24(uint8_t *dest,
 	    const int32_t *src, const int32_t *src_end) noexcept;
 
+/**
+ * Like pcm_pack_24(), but the destination byte order is always
+ * little-endian.
+ */
+void
+pcm_pack_24le(uint8_t *dest,
+	      const int32_t *src, const int32_t *src_end) noexcept;
+
+/**
+ * Like pcm_pack_24(), but the destination byte order is always
+ * big-endian.
+ */
+void
+pcm_pack_24be(uint8_t *dest,
+	      const int32_t *src, const int32_t *src_end) noexcept;
+
 /**
  * Converts packed 24 bit samples (3 bytes per sample) to padded 24
  * bit samples (4 bytes per sample).
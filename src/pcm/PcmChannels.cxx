@@ -19,6 +19,7 @@
 
 #include "PcmChannels.hxx"
 #include "ChannelDefs.hxx"
+#include "ChannelMatrix.hxx"
 #include "Buffer.hxx"
 #include "Silence.hxx"
 #include "Traits.hxx"
@@ -70,30 +71,6 @@ StereoToMono(typename Traits::pointer_type dest,
 	return dest;
 }
 
-template<SampleFormat F, class Traits=SampleTraits<F>>
-static typename Traits::pointer_type
-NToStereo(typename Traits::pointer_type dest,
-	  unsigned src_channels,
-	  typename Traits::const_pointer_type src,
-	  typename Traits::const_pointer_type end) noexcept
-{
-	assert((end - src) % src_channels == 0);
-
-	while (src != end) {
-		typename Traits::sum_type sum = *src++;
-		for (unsigned c = 1; c < src_channels; ++c)
-			sum += *src++;
-
-		typename Traits::value_type value(sum / int(src_channels));
-
-		/* TODO: this is actually only mono ... */
-		*dest++ = value;
-		*dest++ = value;
-	}
-
-	return dest;
-}
-
 /**
  * Convert stereo to N channels (where N > 2).  Left and right map to
  * the first two channels (front left and front right), and the
@@ -126,29 +103,15 @@ StereoToN(typename Traits::pointer_type dest,
 	return dest;
 }
 
-template<SampleFormat F, class Traits=SampleTraits<F>>
-static typename Traits::pointer_type
-NToM(typename Traits::pointer_type dest,
-     unsigned dest_channels,
-     unsigned src_channels,
-     typename Traits::const_pointer_type src,
-     typename Traits::const_pointer_type end) noexcept
+/**
+ * Is there a special implementation for this conversion which is
+ * faster than applying PcmChannelMatrix::Default()?
+ */
+static constexpr bool
+HasShortcut(unsigned src_channels, unsigned dest_channels) noexcept
 {
-	assert((end - src) % src_channels == 0);
-
-	while (src != end) {
-		typename Traits::sum_type sum = *src++;
-		for (unsigned c = 1; c < src_channels; ++c)
-			sum += *src++;
-
-		typename Traits::value_type value(sum / int(src_channels));
-
-		/* TODO: this is actually only mono ... */
-		for (unsigned c = 0; c < dest_channels; ++c)
-			*dest++ = value;
-	}
-
-	return dest;
+	return (src_channels == 1 && dest_channels == 2) ||
+		(src_channels == 2 && dest_channels != 2);
 }
 
 template<SampleFormat F, class Traits=SampleTraits<F>>
@@ -156,10 +119,28 @@ static ConstBuffer<typename Traits::value_type>
 ConvertChannels(PcmBuffer &buffer,
 		unsigned dest_channels,
 		unsigned src_channels,
-		ConstBuffer<typename Traits::value_type> src) noexcept
+		ConstBuffer<typename Traits::value_type> src,
+		const PcmChannelMatrix *matrix) noexcept
 {
 	assert(src.size % src_channels == 0);
 
+	if (!HasShortcut(src_channels, dest_channels)) {
+		if (matrix == nullptr) {
+			const auto m = PcmChannelMatrix::Default(src_channels,
+								 dest_channels);
+			return ConvertChannels<F, Traits>(buffer, dest_channels,
+							  src_channels, src,
+							  &m);
+		}
+
+		assert(matrix->GetSourceChannels() == src_channels);
+		assert(matrix->GetDestChannels() == dest_channels);
+
+		const auto dest = pcm_channel_matrix(buffer, *matrix, F,
+						     src.ToVoid());
+		return ConstBuffer<typename Traits::value_type>::FromVoid(dest);
+	}
+
 	const size_t dest_size = src.size / src_channels * dest_channels;
 	auto dest = buffer.GetT<typename Traits::value_type>(dest_size);
 
@@ -167,14 +148,9 @@ ConvertChannels(PcmBuffer &buffer,
 		MonoToStereo(dest, src.begin(), src.end());
 	else if (src_channels == 2 && dest_channels == 1)
 		StereoToMono<F>(dest, src.begin(), src.end());
-	else if (dest_channels == 2)
-		NToStereo<F>(dest, src_channels, src.begin(), src.end());
-	else if (src_channels == 2 && dest_channels > 2)
+	else
 		StereoToN<F, Traits>(dest, dest_channels,
 				     src.begin(), src.end());
-	else
-		NToM<F>(dest, dest_channels,
-			src_channels, src.begin(), src.end());
 
 	return { dest, dest_size };
 }
@@ -183,38 +159,46 @@ ConstBuffer<int16_t>
 pcm_convert_channels_16(PcmBuffer &buffer,
 			unsigned dest_channels,
 			unsigned src_channels,
-			ConstBuffer<int16_t> src) noexcept
+			ConstBuffer<int16_t> src,
+			const PcmChannelMatrix *matrix) noexcept
 {
 	return ConvertChannels<SampleFormat::S16>(buffer, dest_channels,
-						  src_channels, src);
+						  src_channels, src,
+						  matrix);
 }
 
 ConstBuffer<int32_t>
 pcm_convert_channels_24(PcmBuffer &buffer,
 			unsigned dest_channels,
 			unsigned src_channels,
-			ConstBuffer<int32_t> src) noexcept
+			ConstBuffer<int32_t> src,
+			const PcmChannelMatrix *matrix) noexcept
 {
 	return ConvertChannels<SampleFormat::S24_P32>(buffer, dest_channels,
-						      src_channels, src);
+						      src_channels, src,
+						      matrix);
 }
 
 ConstBuffer<int32_t>
 pcm_convert_channels_32(PcmBuffer &buffer,
 			unsigned dest_channels,
 			unsigned src_channels,
-			ConstBuffer<int32_t> src) noexcept
+			ConstBuffer<int32_t> src,
+			const PcmChannelMatrix *matrix) noexcept
 {
 	return ConvertChannels<SampleFormat::S32>(buffer, dest_channels,
-						  src_channels, src);
+						  src_channels, src,
+						  matrix);
 }
 
 ConstBuffer<float>
 pcm_convert_channels_float(PcmBuffer &buffer,
 			   unsigned dest_channels,
 			   unsigned src_channels,
-			   ConstBuffer<float> src) noexcept
+			   ConstBuffer<float> src,
+			   const PcmChannelMatrix *matrix) noexcept
 {
 	return ConvertChannels<SampleFormat::FLOAT>(buffer, dest_channels,
-						    src_channels, src);
+						    src_channels, src,
+						    matrix);
 }
@@ -23,6 +23,7 @@
 #include <stdint.h>
 
 class PcmBuffer;
+class PcmChannelMatrix;
 template<typename T> struct ConstBuffer;
 
 /**
@@ -32,13 +33,17 @@ template<typename T> struct ConstBuffer;
  * @param dest_channels the number of channels requested
  * @param src_channels the number of channels in the source buffer
  * @param src the source PCM buffer
+ * @param matrix the result of PcmChannelMatrix::Default() for these
+ * channel counts (used if there is no faster special
+ * implementation), or nullptr to build it on each call
  * @return the destination buffer
  */
 ConstBuffer<int16_t>
 pcm_convert_channels_16(PcmBuffer &buffer,
 			unsigned dest_channels,
 			unsigned src_channels,
-			ConstBuffer<int16_t> src) noexcept;
+			ConstBuffer<int16_t> src,
+			const PcmChannelMatrix *matrix=nullptr) noexcept;
 
 /**
  * Changes the number of channels in 24 bit PCM data (aligned at 32
@@ -48,13 +53,17 @@ pcm_convert_channels_16(PcmBuffer &buffer,
  * @param dest_channels the number of channels requested
  * @param src_channels the number of channels in the source buffer
  * @param src the source PCM buffer
+ * @param matrix the result of PcmChannelMatrix::Default() for these
+ * channel counts (used if there is no faster special
+ * implementation), or nullptr to build it on each call
  * @return the destination buffer
  */
 ConstBuffer<int32_t>
 pcm_convert_channels_24(PcmBuffer &buffer,
 			unsigned dest_channels,
 			unsigned src_channels,
-			ConstBuffer<int32_t> src) noexcept;
+			ConstBuffer<int32_t> src,
+			const PcmChannelMatrix *matrix=nullptr) noexcept;
 
 /**
  * Changes the number of channels in 32 bit PCM data.
@@ -63,13 +72,17 @@ pcm_convert_channels_24(PcmBuffer &buffer,
  * @param dest_channels the number of channels requested
  * @param src_channels the number of channels in the source buffer
  * @param src the source PCM buffer
+ * @param matrix the result of PcmChannelMatrix::Default() for these
+ * channel counts (used if there is no faster special
+ * implementation), or nullptr to build it on each call
  * @return the destination buffer
  */
 ConstBuffer<int32_t>
 pcm_convert_channels_32(PcmBuffer &buffer,
 			unsigned dest_channels,
 			unsigned src_channels,
-			ConstBuffer<int32_t> src) noexcept;
+			ConstBuffer<int32_t> src,
+			const PcmChannelMatrix *matrix=nullptr) noexcept;
 
 /**
  * Changes the number of channels in 32 bit float PCM data.
@@ -78,12 +91,16 @@ pcm_convert_channels_32(PcmBuffer &buffer,
  * @param dest_channels the number of channels requested
  * @param src_channels the number of channels in the source buffer
  * @param src the source PCM buffer
+ * @param matrix the result of PcmChannelMatrix::Default() for these
+ * channel counts (used if there is no faster special
+ * implementation), or nullptr to build it on each call
  * @return the destination buffer
  */
 ConstBuffer<float>
 pcm_convert_channels_float(PcmBuffer &buffer,
 			   unsigned dest_channels,
 			   unsigned src_channels,
-			   ConstBuffer<float> src) noexcept;
+			   ConstBuffer<float> src,
+			   const PcmChannelMatrix *matrix=nullptr) noexcept;
 
 #endif
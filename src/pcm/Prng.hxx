@@ -20,14 +20,64 @@
 #ifndef MPD_PCM_PRNG_HXX
 #define MPD_PCM_PRNG_HXX
 
+#include <algorithm>
+
+#include <stddef.h>
+#include <stdint.h>
+
 /**
- * A very simple linear congruential PRNG.  It's good enough for PCM
- * dithering.
+ * One step of Marsaglia's 32 bit xorshift generator.  The state must
+ * not be zero.
  */
-constexpr static inline unsigned long
-pcm_prng(unsigned long state) noexcept
+constexpr static inline uint32_t
+pcm_xorshift(uint32_t state) noexcept
 {
-	return (state * 0x0019660dL + 0x3c6ef35fL) & 0xffffffffL;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
 }
 
+/**
+ * Eight interleaved xorshift generators.  It's good enough for PCM
+ * dithering.  The lanes do not depend on each other, which allows the
+ * compiler to vectorise Fill() and to overlap the latencies of the
+ * lanes.
+ */
+class PcmPrng {
+public:
+	static constexpr size_t LANES = 8;
+
+private:
+	uint32_t state[LANES];
+
+public:
+	constexpr PcmPrng() noexcept
+		:state{0x2545f491, 0x9e3779b9, 0x6c078965, 0x3c6ef35f,
+		       0x19660d01, 0x7f4a7c15, 0x5851f42d, 0x14057b7f} {}
+
+	/**
+	 * Generate one value.  This advances only the first lane; it
+	 * is meant for code which dithers single samples.
+	 */
+	uint32_t Next() noexcept {
+		return state[0] = pcm_xorshift(state[0]);
+	}
+
+	/**
+	 * Fill the given buffer with random values.
+	 *
+	 * @param n the number of values; must be a multiple of
+	 * #LANES
+	 */
+	void Fill(uint32_t *dest, size_t n) noexcept {
+		for (size_t i = 0; i < n; i += LANES) {
+			for (size_t j = 0; j < LANES; ++j)
+				state[j] = pcm_xorshift(state[j]);
+
+			std::copy_n(state, LANES, dest + i);
+		}
+	}
+};
+
 #endif
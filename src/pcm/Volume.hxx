@@ -95,6 +95,13 @@ public:
 		volume = _volume;
 	}
 
+	/**
+	 * Would Apply() return its input unmodified?
+	 */
+	bool IsPassthrough() const noexcept {
+		return volume == PCM_VOLUME_1 && !convert;
+	}
+
 	/**
 	 * Opens the object, prepare for Apply().
 	 *
@@ -20,6 +20,8 @@
 #include "Control.hxx"
 #include "Outputs.hxx"
 #include "Idle.hxx"
+#include "MusicBuffer.hxx"
+#include "decoder/Control.hxx"
 #include "song/DetachedSong.hxx"
 
 #include <algorithm>
@@ -29,13 +31,17 @@
 PlayerControl::PlayerControl(PlayerListener &_listener,
 			     PlayerOutputs &_outputs,
 			     InputCacheManager *_input_cache,
+			     DecoderCacheManager *_decoder_cache,
 			     unsigned _buffer_chunks,
 			     AudioFormat _configured_audio_format,
-			     const ReplayGainConfig &_replay_gain_config) noexcept
+			     const ReplayGainConfig &_replay_gain_config,
+			     bool _predecode) noexcept
 	:listener(_listener), outputs(_outputs),
 	 input_cache(_input_cache),
+	 decoder_cache(_decoder_cache),
 	 buffer_chunks(_buffer_chunks),
 	 configured_audio_format(_configured_audio_format),
+	 predecode(_predecode),
 	 thread(BIND_THIS_METHOD(RunThread)),
 	 replay_gain_config(_replay_gain_config)
 {
@@ -186,6 +192,25 @@ PlayerControl::LockGetStatus() noexcept
 	return status;
 }
 
+PlayerMetrics
+PlayerControl::LockGetMetrics() const noexcept
+{
+	PlayerMetrics metrics;
+
+	const std::lock_guard<Mutex> protect(mutex);
+
+	for (const auto *dc : metrics_decoders)
+		if (dc != nullptr)
+			metrics.decoded_time += dc->decoded_time;
+
+	if (metrics_buffer != nullptr) {
+		metrics.buffer_chunks_used = metrics_buffer->GetAllocated();
+		metrics.buffer_chunks_total = metrics_buffer->GetSize();
+	}
+
+	return metrics;
+}
+
 void
 PlayerControl::SetError(PlayerError type, std::exception_ptr &&_error) noexcept
 {
@@ -40,6 +40,9 @@ struct Tag;
 class PlayerListener;
 class PlayerOutputs;
 class InputCacheManager;
+class DecoderCacheManager;
+class DecoderControl;
+class MusicBuffer;
 class DetachedSong;
 
 enum class PlayerState : uint8_t {
@@ -110,6 +113,18 @@ struct PlayerStatus {
 	SongTime elapsed_time;
 };
 
+/**
+ * Statistics for the metrics exporter.
+ */
+struct PlayerMetrics {
+	/**
+	 * The total duration of audio decoded so far.
+	 */
+	FloatDuration decoded_time = FloatDuration::zero();
+
+	unsigned buffer_chunks_used = 0, buffer_chunks_total = 0;
+};
+
 class PlayerControl final : public AudioOutputClient {
 	friend class Player;
 
@@ -119,6 +134,8 @@ class PlayerControl final : public AudioOutputClient {
 
 	InputCacheManager *const input_cache;
 
+	DecoderCacheManager *const decoder_cache;
+
 	const unsigned buffer_chunks;
 
 	/**
@@ -126,6 +143,12 @@ class PlayerControl final : public AudioOutputClient {
 	 */
 	const AudioFormat configured_audio_format;
 
+	/**
+	 * The "predecode_next_song" setting: decode the beginning of
+	 * the next song in a second decoder thread?
+	 */
+	const bool predecode;
+
 	/**
 	 * The handle of the player thread.
 	 */
@@ -234,13 +257,22 @@ class PlayerControl final : public AudioOutputClient {
 
 	FloatDuration total_play_time = FloatDuration::zero();
 
+	/**
+	 * The decoders and the buffer owned by RunThread(), to be
+	 * inspected by LockGetMetrics().  Protected by #mutex.
+	 */
+	const DecoderControl *metrics_decoders[2] = {nullptr, nullptr};
+	const MusicBuffer *metrics_buffer = nullptr;
+
 public:
 	PlayerControl(PlayerListener &_listener,
 		      PlayerOutputs &_outputs,
 		      InputCacheManager *_input_cache,
+		      DecoderCacheManager *_decoder_cache,
 		      unsigned buffer_chunks,
 		      AudioFormat _configured_audio_format,
-		      const ReplayGainConfig &_replay_gain_config) noexcept;
+		      const ReplayGainConfig &_replay_gain_config,
+		      bool _predecode) noexcept;
 	~PlayerControl() noexcept;
 
 	void Kill() noexcept;
@@ -349,6 +381,9 @@ public:
 		return total_play_time;
 	}
 
+	gcc_pure
+	PlayerMetrics LockGetMetrics() const noexcept;
+
 private:
 	/**
 	 * Signals the object.  The object should be locked prior to
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Predecoder.hxx"
+#include "decoder/Control.hxx"
+#include "MusicPipe.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicChunk.hxx"
+#include "song/DetachedSong.hxx"
+#include "AudioFormat.hxx"
+
+#include <algorithm>
+
+#include <assert.h>
+
+/**
+ * The amount of audio which is decoded in advance by the
+ * pre-decoder while the current song is still being decoded.
+ */
+static constexpr auto predecode_duration = std::chrono::seconds(2);
+
+bool
+Predecoder::IsBusy() const noexcept
+{
+	return decoder != nullptr && decoder->pipe != nullptr;
+}
+
+unsigned
+Predecoder::CalcPipeLimit(AudioFormat audio_format,
+			  unsigned buffer_size) noexcept
+{
+	const size_t limit_size = audio_format.TimeToSize(predecode_duration);
+	const unsigned limit =
+		(limit_size + sizeof(MusicChunk::data) - 1)
+		/ sizeof(MusicChunk::data);
+	return std::max(std::min(limit, buffer_size / 4), 1U);
+}
+
+void
+Predecoder::Start(std::unique_lock<Mutex> &lock,
+		  std::unique_ptr<DetachedSong> song,
+		  SongTime start_time, SongTime end_time,
+		  ReplayGainMode replay_gain_mode,
+		  MusicBuffer &buffer, AudioFormat audio_format) noexcept
+{
+	assert(IsEnabled());
+	assert(!IsBusy());
+	assert(decoder->IsIdle());
+
+	/* decode only the beginning of the next song, and leave the
+	   rest of the MusicBuffer to the current song */
+	decoder->pipe_limit = CalcPipeLimit(audio_format, buffer.GetSize());
+
+	decoder->replay_gain_mode = replay_gain_mode;
+	decoder->Start(lock, std::move(song), start_time, end_time,
+		       buffer, std::make_shared<MusicPipe>());
+}
+
+void
+Predecoder::Stop(std::unique_lock<Mutex> &lock) noexcept
+{
+	if (!IsBusy())
+		return;
+
+	decoder->Stop(lock);
+
+	decoder->pipe->Clear();
+	decoder->pipe.reset();
+	decoder->pipe_limit = 0;
+}
+
+void
+Predecoder::SwitchTo(DecoderControl *&dc) noexcept
+{
+	assert(IsBusy());
+	assert(dc->IsIdle());
+
+	/* the old decoder's pipe is the player's current pipe,
+	   which still contains the end of the current song; just
+	   detach it */
+	dc->pipe.reset();
+
+	decoder->TakePrevious(*dc);
+	std::swap(dc, decoder);
+
+	/* lift the limit and let it decode the rest of the song */
+	dc->pipe_limit = 0;
+	dc->Signal();
+}
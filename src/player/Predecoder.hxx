@@ -0,0 +1,122 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PLAYER_PREDECODER_HXX
+#define MPD_PLAYER_PREDECODER_HXX
+
+#include "Chrono.hxx"
+#include "thread/Mutex.hxx"
+#include "ReplayGainMode.hxx"
+#include "util/Compiler.h"
+
+#include <memory>
+
+struct AudioFormat;
+class DecoderControl;
+class DetachedSong;
+class MusicBuffer;
+
+/**
+ * The decoder which decodes the beginning of the next song while
+ * the main decoder is still busy with the current one
+ * ("predecode_next_song").  When the main decoder has finished,
+ * the two are swapped.
+ *
+ * All methods must be called from the player thread.
+ */
+class Predecoder {
+	/**
+	 * The second decoder; nullptr if pre-decoding is disabled.
+	 * This pointer gets swapped with the main decoder by
+	 * SwitchTo().
+	 */
+	DecoderControl *decoder;
+
+public:
+	explicit Predecoder(DecoderControl *_decoder) noexcept
+		:decoder(_decoder) {}
+
+	Predecoder(const Predecoder &) = delete;
+	Predecoder &operator=(const Predecoder &) = delete;
+
+	bool IsEnabled() const noexcept {
+		return decoder != nullptr;
+	}
+
+	/**
+	 * Is the decoder busy with the next song?
+	 *
+	 * Caller must lock the mutex.
+	 */
+	gcc_pure
+	bool IsBusy() const noexcept;
+
+	/**
+	 * Calculate the number of chunks to be pre-decoded:
+	 * #predecode_duration, but no more than a quarter of the
+	 * #MusicBuffer, which is needed by the current song.
+	 */
+	gcc_const
+	static unsigned CalcPipeLimit(AudioFormat audio_format,
+				      unsigned buffer_size) noexcept;
+
+	/**
+	 * Start decoding the beginning of the given song into a new
+	 * pipe.  The decoder pauses after CalcPipeLimit() chunks.
+	 *
+	 * Caller must lock the mutex.  Must not be called while
+	 * IsBusy() or if !IsEnabled().
+	 *
+	 * @param audio_format the format currently being played,
+	 * used to calculate the pipe limit
+	 */
+	void Start(std::unique_lock<Mutex> &lock,
+		   std::unique_ptr<DetachedSong> song,
+		   SongTime start_time, SongTime end_time,
+		   ReplayGainMode replay_gain_mode,
+		   MusicBuffer &buffer, AudioFormat audio_format) noexcept;
+
+	/**
+	 * Stop the decoder and clear (and free) its music pipe.  This
+	 * is a no-op if !IsBusy().
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void Stop(std::unique_lock<Mutex> &lock) noexcept;
+
+	/**
+	 * The main decoder has finished the current song: make this
+	 * decoder the main decoder and let it decode the rest of the
+	 * next song; the old main decoder becomes the idle
+	 * pre-decoder.
+	 *
+	 * The old main decoder's pipe (which still contains the end
+	 * of the current song and is owned by the caller) is
+	 * detached.
+	 *
+	 * Caller must lock the mutex.  Must only be called while
+	 * IsBusy().
+	 *
+	 * @param dc the main decoder; it is replaced with the
+	 * pre-decoder
+	 */
+	void SwitchTo(DecoderControl *&dc) noexcept;
+};
+
+#endif
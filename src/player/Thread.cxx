@@ -44,12 +44,16 @@
 #include "MusicChunk.hxx"
 #include "song/DetachedSong.hxx"
 #include "CrossFade.hxx"
+#include "Predecoder.hxx"
 #include "tag/Tag.hxx"
 #include "Idle.hxx"
 #include "util/Domain.hxx"
 #include "thread/Name.hxx"
+#include "config/ThreadConfig.hxx"
+#include "trace/PipelineTrace.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
 #include <exception>
 #include <memory>
 
@@ -66,7 +70,21 @@ static constexpr auto buffer_before_play_duration = std::chrono::seconds(1);
 class Player {
 	PlayerControl &pc;
 
-	DecoderControl &dc;
+	/**
+	 * The decoder which feeds the current song (or the next song
+	 * after the current one has been decoded completely).  This
+	 * pointer gets swapped with the #predecoder when the player
+	 * switches to the pre-decoded song.
+	 */
+	DecoderControl *dc;
+
+	/**
+	 * An optional second decoder which decodes the beginning of
+	 * the next song while #dc is still busy with the current
+	 * one.  It is disabled if "predecode_next_song" is
+	 * disabled.
+	 */
+	Predecoder predecoder;
 
 	MusicBuffer &buffer;
 
@@ -196,8 +214,9 @@ class Player {
 
 public:
 	Player(PlayerControl &_pc, DecoderControl &_dc,
+	       DecoderControl *_predecoder,
 	       MusicBuffer &_buffer) noexcept
-		:pc(_pc), dc(_dc), buffer(_buffer),
+		:pc(_pc), dc(&_dc), predecoder(_predecoder), buffer(_buffer),
 		 decoder_wakeup_threshold(buffer.GetSize() * 3 / 4)
 	{
 	}
@@ -225,6 +244,38 @@ private:
 	void StartDecoder(std::unique_lock<Mutex> &lock,
 			  std::shared_ptr<MusicPipe> pipe) noexcept;
 
+	/**
+	 * Is the #predecoder busy with the next song?
+	 */
+	gcc_pure
+	bool IsPredecoding() const noexcept {
+		return predecoder.IsBusy();
+	}
+
+	/**
+	 * Start decoding the queued song in the #predecoder if it
+	 * is enabled and #dc is still busy with the current song.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void StartPredecoder(std::unique_lock<Mutex> &lock) noexcept;
+
+	/**
+	 * Stop the #predecoder and clear (and free) its music pipe.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void StopPredecoder(std::unique_lock<Mutex> &lock) noexcept;
+
+	/**
+	 * #dc has finished the current song: make the #predecoder
+	 * the main decoder and let it decode the rest of the next
+	 * song.
+	 *
+	 * Caller must lock the mutex.
+	 */
+	void SwitchToPredecoder() noexcept;
+
 	/**
 	 * The decoder has acknowledged the "START" command (see
 	 * ActivateDecoder()).  This function checks if the decoder
@@ -255,7 +306,7 @@ private:
 	bool IsDecoderAtCurrentSong() const noexcept {
 		assert(pipe != nullptr);
 
-		return dc.pipe == pipe;
+		return dc->pipe == pipe;
 	}
 
 	/**
@@ -265,7 +316,7 @@ private:
 	 */
 	gcc_pure
 	bool IsDecoderAtNextSong() const noexcept {
-		return dc.pipe != nullptr && !IsDecoderAtCurrentSong();
+		return dc->pipe != nullptr && !IsDecoderAtCurrentSong();
 	}
 
 	/**
@@ -372,13 +423,48 @@ Player::StartDecoder(std::unique_lock<Mutex> &lock,
 	assert(pc.next_song != nullptr);
 
 	/* copy ReplayGain parameters to the decoder */
-	dc.replay_gain_mode = pc.replay_gain_mode;
+	dc->replay_gain_mode = pc.replay_gain_mode;
 
 	SongTime start_time = pc.next_song->GetStartTime() + pc.seek_time;
 
-	dc.Start(lock, std::make_unique<DetachedSong>(*pc.next_song),
-		 start_time, pc.next_song->GetEndTime(),
-		 buffer, std::move(_pipe));
+	dc->Start(lock, std::make_unique<DetachedSong>(*pc.next_song),
+		  start_time, pc.next_song->GetEndTime(),
+		  buffer, std::move(_pipe));
+}
+
+void
+Player::StartPredecoder(std::unique_lock<Mutex> &lock) noexcept
+{
+	if (!predecoder.IsEnabled() || IsPredecoding() ||
+	    !queued || pc.next_song == nullptr ||
+	    decoder_starting || dc->IsIdle() ||
+	    !IsDecoderAtCurrentSong() ||
+	    !play_audio_format.IsDefined())
+		return;
+
+	predecoder.Start(lock, std::make_unique<DetachedSong>(*pc.next_song),
+			 pc.next_song->GetStartTime() + pc.seek_time,
+			 pc.next_song->GetEndTime(),
+			 pc.replay_gain_mode,
+			 buffer, play_audio_format);
+}
+
+void
+Player::StopPredecoder(std::unique_lock<Mutex> &lock) noexcept
+{
+	if (!IsPredecoding())
+		return;
+
+	const PlayerControl::ScopeOccupied occupied(pc);
+
+	predecoder.Stop(lock);
+}
+
+inline void
+Player::SwitchToPredecoder() noexcept
+{
+	predecoder.SwitchTo(dc);
+	decoder_woken = false;
 }
 
 void
@@ -386,13 +472,13 @@ Player::StopDecoder(std::unique_lock<Mutex> &lock) noexcept
 {
 	const PlayerControl::ScopeOccupied occupied(pc);
 
-	dc.Stop(lock);
+	dc->Stop(lock);
 
-	if (dc.pipe != nullptr) {
+	if (dc->pipe != nullptr) {
 		/* clear and free the decoder pipe */
 
-		dc.pipe->Clear();
-		dc.pipe.reset();
+		dc->pipe->Clear();
+		dc->pipe.reset();
 
 		/* just in case we've been cross-fading: cancel it
 		   now, because we just deleted the new song's decoder
@@ -405,7 +491,7 @@ bool
 Player::ForwardDecoderError() noexcept
 {
 	try {
-		dc.CheckRethrowError();
+		dc->CheckRethrowError();
 	} catch (...) {
 		pc.SetError(PlayerError::DECODER, std::current_exception());
 		return false;
@@ -511,7 +597,7 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 	if (!ForwardDecoderError()) {
 		/* the decoder failed */
 		return false;
-	} else if (!dc.IsStarting()) {
+	} else if (!dc->IsStarting()) {
 		/* the decoder is ready and ok */
 
 		if (output_open &&
@@ -520,10 +606,10 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 			   all chunks yet - wait for that */
 			return true;
 
-		pc.total_time = real_song_duration(*dc.song,
-						   dc.total_time);
-		pc.audio_format = dc.in_audio_format;
-		play_audio_format = dc.out_audio_format;
+		pc.total_time = real_song_duration(*dc->song,
+						   dc->total_time);
+		pc.audio_format = dc->in_audio_format;
+		play_audio_format = dc->out_audio_format;
 		decoder_starting = false;
 
 		const size_t buffer_before_play_size =
@@ -557,7 +643,7 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 			FormatError(player_domain,
 				    "problems opening audio device "
 				    "while playing \"%s\"",
-				    dc.song->GetURI());
+				    dc->song->GetURI());
 			return true;
 		}
 
@@ -565,7 +651,7 @@ Player::CheckDecoderStartup(std::unique_lock<Mutex> &lock) noexcept
 	} else {
 		/* the decoder is not yet ready; wait
 		   some more */
-		dc.WaitForDecoder(lock);
+		dc->WaitForDecoder(lock);
 
 		return true;
 	}
@@ -586,7 +672,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock, SongTime seek_time) noexcept
 	try {
 		const PlayerControl::ScopeOccupied occupied(pc);
 
-		dc.Seek(lock, song->GetStartTime() + seek_time);
+		dc->Seek(lock, song->GetStartTime() + seek_time);
 	} catch (...) {
 		/* decoder failure */
 		pc.SetError(PlayerError::DECODER, std::current_exception());
@@ -602,8 +688,11 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 {
 	assert(pc.next_song != nullptr);
 
+	/* the pre-decoded song (if any) will not be played next */
+	StopPredecoder(lock);
+
 	if (pc.seek_time > SongTime::zero() && // TODO: allow this only if the song duration is known
-	    dc.IsUnseekableCurrentSong(*pc.next_song)) {
+	    dc->IsUnseekableCurrentSong(*pc.next_song)) {
 		/* seeking into the current song; but we already know
 		   it's not seekable, so let's fail early */
 		/* note the seek_time>0 check: if seeking to the
@@ -624,7 +713,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 
 	idle_add(IDLE_PLAYER);
 
-	if (!dc.IsSeekableCurrentSong(*pc.next_song)) {
+	if (!dc->IsSeekableCurrentSong(*pc.next_song)) {
 		/* the decoder is already decoding the "next" song -
 		   stop it and start the previous song again */
 
@@ -648,7 +737,7 @@ Player::SeekDecoder(std::unique_lock<Mutex> &lock) noexcept
 		if (!IsDecoderAtCurrentSong()) {
 			/* the decoder is already decoding the "next" song,
 			   but it is the same song file; exchange the pipe */
-			ReplacePipe(dc.pipe);
+			ReplacePipe(dc->pipe);
 		}
 
 		pc.next_song.reset();
@@ -712,8 +801,10 @@ Player::ProcessCommand(std::unique_lock<Mutex> &lock) noexcept
 		queued = true;
 		pc.CommandFinished();
 
-		if (dc.IsIdle())
+		if (dc->IsIdle())
 			StartDecoder(lock, std::make_shared<MusicPipe>());
+		else
+			StartPredecoder(lock);
 
 		break;
 
@@ -750,6 +841,8 @@ Player::ProcessCommand(std::unique_lock<Mutex> &lock) noexcept
 			   stop it and reset the position */
 			StopDecoder(lock);
 
+		StopPredecoder(lock);
+
 		pc.next_song.reset();
 		queued = false;
 		pc.CommandFinished();
@@ -847,7 +940,7 @@ Player::PlayNextChunk() noexcept
 		unsigned cross_fade_position = pipe->GetSize();
 		assert(cross_fade_position <= cross_fade_chunks);
 
-		auto other_chunk = dc.pipe->Shift();
+		auto other_chunk = dc->pipe->Shift();
 		if (other_chunk != nullptr) {
 			chunk = pipe->Shift();
 			assert(chunk != nullptr);
@@ -883,14 +976,14 @@ Player::PlayNextChunk() noexcept
 
 			std::unique_lock<Mutex> lock(pc.mutex);
 
-			if (dc.IsIdle()) {
+			if (dc->IsIdle()) {
 				/* the decoder isn't running, abort
 				   cross fading */
 				xfade_state = CrossFadeState::DISABLED;
 			} else {
 				/* wait for the decoder */
-				dc.Signal();
-				dc.WaitForDecoder(lock);
+				dc->Signal();
+				dc->WaitForDecoder(lock);
 
 				return true;
 			}
@@ -915,6 +1008,10 @@ Player::PlayNextChunk() noexcept
 	try {
 		pc.PlayChunk(*song, std::move(chunk),
 			     play_audio_format);
+
+		if (PipelineTrace::IsEnabled())
+			PipelineTrace::Record(PipelineTraceEvent::CHUNK_CONSUMED,
+					      nullptr, pipe->GetSize());
 	} catch (...) {
 		LogError(std::current_exception());
 
@@ -936,10 +1033,10 @@ Player::PlayNextChunk() noexcept
 	/* this formula should prevent that the decoder gets woken up
 	   with each chunk; it is more efficient to make it decode a
 	   larger block at a time */
-	if (!dc.IsIdle() && dc.pipe->GetSize() <= decoder_wakeup_threshold) {
+	if (!dc->IsIdle() && dc->pipe->GetSize() <= decoder_wakeup_threshold) {
 		if (!decoder_woken) {
 			decoder_woken = true;
-			dc.Signal();
+			dc->Signal();
 		}
 	} else
 		decoder_woken = false;
@@ -955,7 +1052,7 @@ Player::SongBorder() noexcept
 
 		FormatDefault(player_domain, "played \"%s\"", song->GetURI());
 
-		ReplacePipe(dc.pipe);
+		ReplacePipe(dc->pipe);
 
 		pc.outputs.SongBorder();
 	}
@@ -1001,10 +1098,10 @@ Player::Run() noexcept
 			   prevent stuttering on slow machines */
 
 			if (pipe->GetSize() < buffer_before_play &&
-			    !dc.IsIdle() && !buffer.IsFull()) {
+			    !dc->IsIdle() && !buffer.IsFull()) {
 				/* not enough decoded buffer space yet */
 
-				dc.WaitForDecoder(lock);
+				dc->WaitForDecoder(lock);
 				continue;
 			} else {
 				/* buffering is complete */
@@ -1012,31 +1109,35 @@ Player::Run() noexcept
 			}
 		}
 
-		if (dc.IsIdle() && queued && IsDecoderAtCurrentSong()) {
+		if (dc->IsIdle() && queued && IsDecoderAtCurrentSong()) {
 			/* the decoder has finished the current song;
 			   make it decode the next song */
 
-			assert(dc.pipe == nullptr || dc.pipe == pipe);
+			assert(dc->pipe == nullptr || dc->pipe == pipe);
 
-			StartDecoder(lock, std::make_shared<MusicPipe>());
-		}
+			if (IsPredecoding())
+				SwitchToPredecoder();
+			else
+				StartDecoder(lock, std::make_shared<MusicPipe>());
+		} else
+			StartPredecoder(lock);
 
 		if (/* no cross-fading if MPD is going to pause at the
 		       end of the current song */
 		    !pc.border_pause &&
 		    IsDecoderAtNextSong() &&
 		    xfade_state == CrossFadeState::UNKNOWN &&
-		    !dc.IsStarting()) {
+		    !dc->IsStarting()) {
 			/* enable cross fading in this song?  if yes,
 			   calculate how many chunks will be required
 			   for it */
 			cross_fade_chunks =
-				pc.cross_fade.Calculate(dc.total_time,
-							dc.replay_gain_db,
-							dc.replay_gain_prev_db,
-							dc.GetMixRampStart(),
-							dc.GetMixRampPreviousEnd(),
-							dc.out_audio_format,
+				pc.cross_fade.Calculate(dc->total_time,
+							dc->replay_gain_db,
+							dc->replay_gain_prev_db,
+							dc->GetMixRampStart(),
+							dc->GetMixRampPreviousEnd(),
+							dc->out_audio_format,
 							play_audio_format,
 							buffer.GetSize() -
 							buffer_before_play);
@@ -1066,14 +1167,14 @@ Player::Run() noexcept
 			   waiting for space in the MusicBuffer) and
 			   wait for it */
 			// TODO: eliminate this kludge
-			dc.Signal();
+			dc->Signal();
 
-			dc.WaitForDecoder(lock);
+			dc->WaitForDecoder(lock);
 		} else if (IsDecoderAtNextSong()) {
 			/* at the beginning of a new song */
 
 			SongBorder();
-		} else if (dc.IsIdle()) {
+		} else if (dc->IsIdle()) {
 			if (queued)
 				/* the decoder has just stopped,
 				   between the two IsIdle() checks,
@@ -1103,14 +1204,17 @@ Player::Run() noexcept
 			   waiting for space in the MusicBuffer) and
 			   wait for it */
 			// TODO: eliminate this kludge
-			dc.Signal();
+			dc->Signal();
 
-			dc.WaitForDecoder(lock);
+			PipelineTrace::Emit(PipelineTraceEvent::PLAYER_WAIT_BEGIN);
+			dc->WaitForDecoder(lock);
+			PipelineTrace::Emit(PipelineTraceEvent::PLAYER_WAIT_END);
 		}
 	}
 
 	CancelPendingSeek();
 	StopDecoder(lock);
+	StopPredecoder(lock);
 
 	pipe.reset();
 
@@ -1132,10 +1236,10 @@ Player::Run() noexcept
 }
 
 static void
-do_play(PlayerControl &pc, DecoderControl &dc,
+do_play(PlayerControl &pc, DecoderControl &dc, DecoderControl *predecoder,
 	MusicBuffer &buffer) noexcept
 {
-	Player player(pc, dc, buffer);
+	Player player(pc, dc, predecoder, buffer);
 	player.Run();
 }
 
@@ -1143,17 +1247,32 @@ void
 PlayerControl::RunThread() noexcept
 try {
 	SetThreadName("player");
+	ApplyThreadConfig(ThreadKind::PLAYER);
 
 	DecoderControl dc(mutex, cond,
-			  input_cache,
+			  input_cache, decoder_cache,
 			  configured_audio_format,
 			  replay_gain_config);
 	dc.StartThread();
 
+	std::unique_ptr<DecoderControl> predecoder;
+	if (predecode) {
+		predecoder = std::make_unique<DecoderControl>(mutex, cond,
+							      input_cache,
+							      decoder_cache,
+							      configured_audio_format,
+							      replay_gain_config);
+		predecoder->StartThread();
+	}
+
 	MusicBuffer buffer(buffer_chunks);
 
 	std::unique_lock<Mutex> lock(mutex);
 
+	metrics_decoders[0] = &dc;
+	metrics_decoders[1] = predecoder.get();
+	metrics_buffer = &buffer;
+
 	while (1) {
 		switch (command) {
 		case PlayerCommand::SEEK:
@@ -1162,7 +1281,7 @@ try {
 
 			{
 				const ScopeUnlock unlock(mutex);
-				do_play(*this, dc, buffer);
+				do_play(*this, dc, predecoder.get(), buffer);
 				listener.OnPlayerSync();
 			}
 
@@ -1207,9 +1326,14 @@ try {
 			{
 				const ScopeUnlock unlock(mutex);
 				dc.Quit();
+				if (predecoder)
+					predecoder->Quit();
 				outputs.Close();
 			}
 
+			metrics_decoders[0] = metrics_decoders[1] = nullptr;
+			metrics_buffer = nullptr;
+
 			CommandFinished();
 			return;
 
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_EXPAT_SONG_ENUMERATOR_HXX
+#define MPD_EXPAT_SONG_ENUMERATOR_HXX
+
+#include "SongEnumerator.hxx"
+#include "song/DetachedSong.hxx"
+#include "input/InputStream.hxx"
+#include "input/Ptr.hxx"
+#include "lib/expat/ExpatParser.hxx"
+
+#include <exception>
+#include <list>
+#include <utility>
+
+/**
+ * A #SongEnumerator which parses an XML playlist incrementally.
+ * More input is fed into the parser only when all songs parsed so
+ * far have been consumed, so the first song is available long before
+ * the whole document has been received, and memory usage does not
+ * grow with the size of the playlist.
+ *
+ * Parser and I/O errors are thrown by NextSong() after all songs
+ * parsed before the error have been returned.
+ *
+ * @param P the parser state object; its expat callbacks append songs
+ * to its attribute "songs" (a std::list<DetachedSong>)
+ */
+template<typename P>
+class ExpatSongEnumerator final : public SongEnumerator {
+	InputStreamPtr is;
+
+	P state;
+
+	ExpatParser expat;
+
+	bool eof = false;
+
+	/**
+	 * An error which will be rethrown after all pending songs
+	 * have been returned.
+	 */
+	std::exception_ptr error;
+
+public:
+	ExpatSongEnumerator(InputStreamPtr &&_is,
+			    XML_StartElementHandler start,
+			    XML_EndElementHandler end,
+			    XML_CharacterDataHandler char_data)
+		:is(std::move(_is)), expat(&state) {
+		expat.SetElementHandler(start, end);
+		expat.SetCharacterDataHandler(char_data);
+	}
+
+	std::unique_ptr<DetachedSong> NextSong() override {
+		while (state.songs.empty()) {
+			if (error)
+				std::rethrow_exception(std::exchange(error,
+								     nullptr));
+
+			if (eof)
+				return nullptr;
+
+			try {
+				Feed();
+			} catch (...) {
+				error = std::current_exception();
+				eof = true;
+			}
+		}
+
+		auto result = std::make_unique<DetachedSong>(std::move(state.songs.front()));
+		state.songs.pop_front();
+		return result;
+	}
+
+private:
+	void Feed() {
+		assert(is->IsReady());
+
+		char buffer[4096];
+		size_t nbytes = is->LockRead(buffer, sizeof(buffer));
+		if (nbytes == 0) {
+			eof = true;
+			expat.CompleteParse();
+		} else
+			expat.Parse(buffer, nbytes);
+	}
+};
+
+#endif
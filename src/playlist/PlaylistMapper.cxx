@@ -20,6 +20,7 @@
 #include "PlaylistMapper.hxx"
 #include "PlaylistFile.hxx"
 #include "PlaylistStream.hxx"
+#include "SplSongCache.hxx"
 #include "SongEnumerator.hxx"
 #include "Mapper.hxx"
 #include "fs/AllocatedPath.hxx"
@@ -40,7 +41,7 @@ playlist_open_in_playlist_dir(const char *uri, Mutex &mutex)
 	if (path_fs.IsNull())
 		return nullptr;
 
-	return playlist_open_path(path_fs, mutex);
+	return spl_song_cache_open(uri, path_fs, mutex);
 }
 
 #ifdef ENABLE_DATABASE
@@ -21,13 +21,12 @@
 #include "LocateUri.hxx"
 #include "PlaylistQueue.hxx"
 #include "PlaylistAny.hxx"
-#include "PlaylistSong.hxx"
+#include "PlaylistSongResolver.hxx"
 #include "PlaylistError.hxx"
 #include "queue/Playlist.hxx"
 #include "SongEnumerator.hxx"
 #include "song/DetachedSong.hxx"
 #include "thread/Mutex.hxx"
-#include "fs/Traits.hxx"
 
 #ifdef ENABLE_DATABASE
 #include "SongLoader.hxx"
@@ -41,23 +40,20 @@ playlist_load_into_queue(const char *uri, SongEnumerator &e,
 			 playlist &dest, PlayerControl &pc,
 			 const SongLoader &loader)
 {
-	const std::string base_uri = uri != nullptr
-		? PathTraitsUTF8::GetParent(uri)
-		: std::string(".");
+	/* skip songs before the start index without resolving
+	   them */
+	unsigned i = 0;
+	for (; i < start_index && i < end_index; ++i)
+		if (e.NextSong() == nullptr)
+			return;
 
-	std::unique_ptr<DetachedSong> song;
-	for (unsigned i = 0;
-	     i < end_index && (song = e.NextSong()) != nullptr;
-	     ++i) {
-		if (i < start_index) {
-			/* skip songs before the start index */
-			continue;
-		}
+	PlaylistSongResolver resolver(e, uri, loader, end_index - i);
 
-		if (!playlist_check_translate_song(*song, base_uri.c_str(),
-						   loader)) {
+	std::unique_ptr<DetachedSong> song;
+	bool ok;
+	while ((song = resolver.Next(ok)) != nullptr) {
+		if (!ok)
 			continue;
-		}
 
 		dest.AppendSong(pc, std::move(*song));
 	}
@@ -37,6 +37,9 @@ class PlayerControl;
  * URIs
  * @param start_index the index of the first song
  * @param end_index the index of the last song (excluding)
+ *
+ * Throws on error; songs which have been parsed before the error
+ * remain in the queue.
  */
 void
 playlist_load_into_queue(const char *uri, SongEnumerator &e,
@@ -47,6 +50,8 @@ playlist_load_into_queue(const char *uri, SongEnumerator &e,
 /**
  * Opens a playlist with a playlist plugin and append to the specified
  * play queue.
+ *
+ * Throws on error.
  */
 void
 playlist_open_into_queue(const LocatedUri &uri,
@@ -42,7 +42,7 @@ merge_song_metadata(DetachedSong &add, const DetachedSong &base) noexcept
 	add.SetLastModified(base.GetLastModified());
 }
 
-static bool
+bool
 playlist_check_load_song(DetachedSong &song, const SongLoader &loader) noexcept
 try {
 	DetachedSong tmp = loader.LoadSong(song.GetURI());
@@ -57,9 +57,8 @@ try {
 	return false;
 }
 
-bool
-playlist_check_translate_song(DetachedSong &song, const char *base_uri,
-			      const SongLoader &loader) noexcept
+void
+playlist_translate_uri(DetachedSong &song, const char *base_uri) noexcept
 {
 	if (base_uri != nullptr && strcmp(base_uri, ".") == 0)
 		/* PathTraitsUTF8::GetParent() returns "." when there
@@ -88,6 +87,12 @@ playlist_check_translate_song(DetachedSong &song, const char *base_uri,
 	if (base_uri != nullptr && !uri_has_scheme(uri) &&
 	    !PathTraitsUTF8::IsAbsolute(uri))
 		song.SetURI(PathTraitsUTF8::Build(base_uri, uri));
+}
 
+bool
+playlist_check_translate_song(DetachedSong &song, const char *base_uri,
+			      const SongLoader &loader) noexcept
+{
+	playlist_translate_uri(song, base_uri);
 	return playlist_check_load_song(song, loader);
 }
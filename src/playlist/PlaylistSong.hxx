@@ -23,6 +23,23 @@
 class SongLoader;
 class DetachedSong;
 
+/**
+ * The first step of playlist_check_translate_song(): make a relative
+ * URI absolute by applying the playlist's base URI.
+ */
+void
+playlist_translate_uri(DetachedSong &song, const char *base_uri) noexcept;
+
+/**
+ * The second step of playlist_check_translate_song(): verify the
+ * song and load it with the #SongLoader, merging the metadata.
+ *
+ * @return true on success, false if the song should not be used
+ */
+bool
+playlist_check_load_song(DetachedSong &song,
+			 const SongLoader &loader) noexcept;
+
 /**
  * Verifies the song, returns false if it is unsafe.  Translate the
  * song to a song within the database, if it is a local file.
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "PlaylistSongResolver.hxx"
+#include "PlaylistSong.hxx"
+#include "SongEnumerator.hxx"
+#include "SongLoader.hxx"
+#include "song/DetachedSong.hxx"
+#include "thread/Name.hxx"
+#include "fs/Traits.hxx"
+
+#include <algorithm>
+#include <utility>
+#include <thread>
+
+/**
+ * The number of songs read from the #SongEnumerator at a time.
+ */
+static constexpr std::size_t BATCH_SIZE = 256;
+
+/**
+ * The maximum number of worker threads.
+ */
+static constexpr unsigned MAX_WORKERS = 4;
+
+PlaylistSongResolver::PlaylistSongResolver(SongEnumerator &_e,
+					   const char *uri,
+					   const SongLoader &_loader,
+					   unsigned max_songs) noexcept
+	:e(_e),
+	 base_uri(uri != nullptr
+		  ? PathTraitsUTF8::GetParent(uri)
+		  : std::string(".")),
+	 loader(_loader),
+	 remaining(max_songs),
+	 next_item(0), next_job(0)
+{
+}
+
+PlaylistSongResolver::~PlaylistSongResolver() noexcept
+{
+	{
+		const std::lock_guard<Mutex> protect(mutex);
+		quit = true;
+		cond.notify_all();
+	}
+
+	for (auto &i : workers)
+		i.Join();
+}
+
+bool
+PlaylistSongResolver::StartWorkers(std::size_t n_jobs) noexcept
+{
+	unsigned max_workers = std::min(MAX_WORKERS,
+					std::thread::hardware_concurrency());
+	if (n_jobs < max_workers)
+		max_workers = n_jobs;
+
+	while (workers.size() < max_workers) {
+		workers.emplace_back(BIND_THIS_METHOD(RunWorker));
+		try {
+			workers.back().Start();
+		} catch (...) {
+			workers.pop_back();
+			break;
+		}
+	}
+
+	return !workers.empty();
+}
+
+void
+PlaylistSongResolver::RunWorker() noexcept
+{
+	SetThreadName("playlist");
+
+	std::unique_lock<Mutex> lock(mutex);
+
+	while (true) {
+		cond.wait(lock, [this]{
+			return quit || next_job < jobs.size();
+		});
+
+		if (quit)
+			break;
+
+		auto &item = batch[jobs[next_job++]];
+
+		{
+			const ScopeUnlock unlock(mutex);
+			item.ok = playlist_check_load_song(*item.song, loader);
+		}
+
+		item.done = true;
+		cond.notify_all();
+	}
+}
+
+void
+PlaylistSongResolver::Fill()
+{
+	/* all items of the previous batch have been consumed, so no
+	   worker is accessing the vector now */
+	{
+		const std::lock_guard<Mutex> protect(mutex);
+		jobs.clear();
+		next_job = 0;
+	}
+
+	batch.clear();
+	next_item = 0;
+
+	try {
+		std::unique_ptr<DetachedSong> song;
+		while (remaining > 0 && batch.size() < BATCH_SIZE &&
+		       (song = e.NextSong()) != nullptr) {
+			--remaining;
+			playlist_translate_uri(*song, base_uri.c_str());
+			batch.push_back({std::move(song), false, false});
+		}
+	} catch (...) {
+		/* resolve and return the songs read so far, and
+		   rethrow after them */
+		error = std::current_exception();
+		remaining = 0;
+	}
+
+	/* local files need an expensive tag scan; hand them to the
+	   workers */
+	std::vector<std::size_t> new_jobs;
+	for (std::size_t i = 0; i < batch.size(); ++i)
+		if (loader.IsLocalFile(batch[i].song->GetURI()))
+			new_jobs.push_back(i);
+
+	if (!new_jobs.empty() && StartWorkers(new_jobs.size())) {
+		const std::lock_guard<Mutex> protect(mutex);
+		jobs = std::move(new_jobs);
+		cond.notify_all();
+	}
+
+	/* meanwhile, resolve all other songs (database lookups and
+	   remote URIs) in this thread, because the database is not
+	   thread-safe; each database entry is a separate GetSong()
+	   call */
+	for (std::size_t i = 0, j = 0; i < batch.size(); ++i) {
+		if (j < jobs.size() && jobs[j] == i) {
+			++j;
+			continue;
+		}
+
+		auto &item = batch[i];
+		item.ok = playlist_check_load_song(*item.song, loader);
+
+		const std::lock_guard<Mutex> protect(mutex);
+		item.done = true;
+	}
+}
+
+std::unique_ptr<DetachedSong>
+PlaylistSongResolver::Next(bool &ok)
+{
+	if (next_item >= batch.size()) {
+		if (!error)
+			Fill();
+
+		if (next_item >= batch.size()) {
+			if (error)
+				std::rethrow_exception(std::exchange(error,
+								     nullptr));
+
+			return nullptr;
+		}
+	}
+
+	auto &item = batch[next_item++];
+
+	{
+		std::unique_lock<Mutex> lock(mutex);
+		cond.wait(lock, [&item]{ return item.done; });
+	}
+
+	ok = item.ok;
+	return std::move(item.song);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PLAYLIST_SONG_RESOLVER_HXX
+#define MPD_PLAYLIST_SONG_RESOLVER_HXX
+
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <exception>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SongEnumerator;
+class SongLoader;
+class DetachedSong;
+
+/**
+ * Reads songs from a #SongEnumerator and resolves them like
+ * playlist_check_translate_song().  Songs whose tags need to be
+ * scanned from a local file are resolved by worker threads; all
+ * others (remote URIs and database lookups) are resolved by the
+ * calling thread.  The results are returned in playlist order.
+ *
+ * Database entries are still looked up one at a time with
+ * SongLoader::LoadSong(), i.e. one Database::GetSong() call per
+ * entry.  The #Database interface has no bulk lookup by URI, and
+ * visiting the whole database for each batch would be more
+ * expensive than these lookups for all but huge playlists.
+ */
+class PlaylistSongResolver {
+	struct Item {
+		std::unique_ptr<DetachedSong> song;
+
+		/**
+		 * The result of playlist_check_load_song().
+		 */
+		bool ok;
+
+		/**
+		 * Has this item been resolved?  Protected by #mutex.
+		 */
+		bool done;
+	};
+
+	SongEnumerator &e;
+
+	const std::string base_uri;
+
+	const SongLoader &loader;
+
+	/**
+	 * The number of songs which may still be read from the
+	 * #SongEnumerator.
+	 */
+	unsigned remaining;
+
+	/**
+	 * Protects #Item::done, #jobs, #next_job and #quit.
+	 */
+	Mutex mutex;
+
+	/**
+	 * Signalled when a job is added, when an item is done and
+	 * when the workers shall quit.
+	 */
+	Cond cond;
+
+	/**
+	 * The current batch of songs.  This vector is only modified
+	 * by the calling thread while no job is pending.
+	 */
+	std::vector<Item> batch;
+
+	/**
+	 * The index of the next #batch item to be returned by Next().
+	 */
+	std::size_t next_item;
+
+	/**
+	 * Indexes of #batch items which shall be resolved by a worker.
+	 */
+	std::vector<std::size_t> jobs;
+
+	/**
+	 * The index of the next item in #jobs to be picked up by a
+	 * worker.
+	 */
+	std::size_t next_job;
+
+	bool quit = false;
+
+	/**
+	 * An error thrown by the #SongEnumerator while filling the
+	 * current batch.  It is rethrown by Next() after all songs
+	 * read before the error have been returned.
+	 */
+	std::exception_ptr error;
+
+	std::list<Thread> workers;
+
+public:
+	/**
+	 * @param uri the URI of the playlist (used to resolve
+	 * relative song URIs) or nullptr
+	 * @param max_songs read no more than this number of songs
+	 * from the #SongEnumerator
+	 */
+	PlaylistSongResolver(SongEnumerator &_e, const char *uri,
+			     const SongLoader &_loader,
+			     unsigned max_songs) noexcept;
+
+	~PlaylistSongResolver() noexcept;
+
+	PlaylistSongResolver(const PlaylistSongResolver &) = delete;
+	PlaylistSongResolver &operator=(const PlaylistSongResolver &) = delete;
+
+	/**
+	 * Returns the next song or nullptr at the end of the
+	 * playlist.
+	 *
+	 * Throws if the #SongEnumerator fails.
+	 *
+	 * @param ok set to false if the song should not be used (see
+	 * playlist_check_translate_song()); it is returned
+	 * nonetheless, as it is, e.g. for printing its URI
+	 */
+	std::unique_ptr<DetachedSong> Next(bool &ok);
+
+private:
+	/**
+	 * Read the next batch of songs and resolve them (or hand them
+	 * to the workers).
+	 */
+	void Fill();
+
+	/**
+	 * Start worker threads for the given number of jobs.
+	 *
+	 * @return false if no worker is available
+	 */
+	bool StartWorkers(std::size_t n_jobs) noexcept;
+
+	void RunWorker() noexcept;
+};
+
+#endif
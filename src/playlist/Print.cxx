@@ -21,30 +21,28 @@
 #include "LocateUri.hxx"
 #include "Print.hxx"
 #include "PlaylistAny.hxx"
-#include "PlaylistSong.hxx"
+#include "PlaylistSongResolver.hxx"
 #include "SongEnumerator.hxx"
 #include "SongPrint.hxx"
 #include "song/DetachedSong.hxx"
-#include "fs/Traits.hxx"
 #include "thread/Mutex.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 
+#include <climits>
+
 static void
 playlist_provider_print(Response &r,
 			const SongLoader &loader,
 			const char *uri,
-			SongEnumerator &e, bool detail) noexcept
+			SongEnumerator &e, bool detail)
 {
-	const std::string base_uri = uri != nullptr
-		? PathTraitsUTF8::GetParent(uri)
-		: std::string(".");
+	PlaylistSongResolver resolver(e, uri, loader, UINT_MAX);
 
 	std::unique_ptr<DetachedSong> song;
-	while ((song = e.NextSong()) != nullptr) {
-		if (playlist_check_translate_song(*song, base_uri.c_str(),
-						  loader) &&
-		    detail)
+	bool ok;
+	while ((song = resolver.Next(ok)) != nullptr) {
+		if (ok && detail)
 			song_print_info(r, *song);
 		else
 			/* fallback if no detail was requested or no
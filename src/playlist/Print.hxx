@@ -27,6 +27,10 @@ struct Partition;
 /**
  * Send the playlist file to the client.
  *
+ * Throws on error (e.g. if the playlist file is malformed); songs
+ * which have been parsed before the error may have been sent
+ * already.
+ *
  * @param uri the URI of the playlist file in UTF-8 encoding
  * @param detail true if all details should be printed
  * @return true on success, false if the playlist does not exist
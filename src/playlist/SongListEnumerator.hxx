@@ -0,0 +1,52 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SONG_LIST_ENUMERATOR_HXX
+#define MPD_SONG_LIST_ENUMERATOR_HXX
+
+#include "SongEnumerator.hxx"
+#include "song/DetachedSong.hxx"
+
+#include <memory>
+#include <vector>
+
+using SongList = std::vector<DetachedSong>;
+
+/**
+ * A #SongEnumerator which returns copies of the songs in a shared
+ * (usually cached) #SongList.
+ */
+class SongListEnumerator final : public SongEnumerator {
+	const std::shared_ptr<const SongList> songs;
+
+	SongList::const_iterator next;
+
+public:
+	explicit SongListEnumerator(std::shared_ptr<const SongList> &&_songs) noexcept
+		:songs(std::move(_songs)), next(songs->begin()) {}
+
+	std::unique_ptr<DetachedSong> NextSong() override {
+		if (next == songs->end())
+			return nullptr;
+
+		return std::make_unique<DetachedSong>(*next++);
+	}
+};
+
+#endif
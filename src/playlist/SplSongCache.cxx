@@ -0,0 +1,142 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SplSongCache.hxx"
+#include "SongListEnumerator.hxx"
+#include "PlaylistStream.hxx"
+#include "fs/Path.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/FileSystem.hxx"
+#include "util/LruCache.hxx"
+
+#include <string>
+
+/**
+ * The maximum number of stored playlists in #spl_song_cache.
+ */
+static constexpr std::size_t SPL_SONG_CACHE_SIZE = 16;
+
+/**
+ * The songs of a stored playlist.  They are considered up to date as
+ * long as the file's attributes are unchanged.
+ */
+struct SplSongCacheItem {
+	std::chrono::system_clock::time_point mtime;
+	uint64_t size;
+#ifndef _WIN32
+	ino_t inode;
+#endif
+
+	std::shared_ptr<const SongList> songs;
+
+	SplSongCacheItem(const FileInfo &fi,
+			 std::shared_ptr<const SongList> &&_songs) noexcept
+		:mtime(fi.GetModificationTime()), size(fi.GetSize()),
+#ifndef _WIN32
+		 inode(fi.GetInode()),
+#endif
+		 songs(std::move(_songs)) {}
+
+	gcc_pure
+	bool IsValid(const FileInfo &fi) const noexcept {
+		return fi.GetModificationTime() == mtime &&
+			fi.GetSize() == size
+#ifndef _WIN32
+			&& fi.GetInode() == inode
+#endif
+			;
+	}
+};
+
+/**
+ * Recently listed or loaded stored playlists, indexed by their name.
+ * Stored playlists are only accessed by the main thread, therefore
+ * no locking is necessary.
+ */
+static LruCache<std::string, SplSongCacheItem,
+		SPL_SONG_CACHE_SIZE> spl_song_cache;
+
+/**
+ * A #SongEnumerator which forwards all songs of a playlist plugin
+ * and stores them in the cache when the end has been reached.
+ */
+class SplSongCacheRecorder final : public SongEnumerator {
+	std::unique_ptr<SongEnumerator> parser;
+
+	const std::string name;
+	const FileInfo fi;
+
+	SongList songs;
+
+public:
+	/**
+	 * @param fi the attributes of the file before it was read
+	 */
+	SplSongCacheRecorder(std::unique_ptr<SongEnumerator> &&_parser,
+			     const char *_name, const FileInfo &_fi)
+		:parser(std::move(_parser)), name(_name), fi(_fi) {}
+
+	std::unique_ptr<DetachedSong> NextSong() override {
+		if (parser == nullptr)
+			return nullptr;
+
+		auto song = parser->NextSong();
+		if (song != nullptr) {
+			songs.push_back(*song);
+			return song;
+		}
+
+		/* the whole file has been parsed successfully: store
+		   it in the cache */
+		parser.reset();
+		spl_song_cache.Put(name,
+				   SplSongCacheItem(fi,
+						    std::make_shared<const SongList>(std::move(songs))));
+		return nullptr;
+	}
+};
+
+std::unique_ptr<SongEnumerator>
+spl_song_cache_open(const char *name, Path path_fs, Mutex &mutex)
+{
+	FileInfo fi;
+	if (!GetFileInfo(path_fs, fi) || !fi.IsRegular())
+		return nullptr;
+
+	auto *item = spl_song_cache.Get(name);
+	if (item != nullptr) {
+		if (item->IsValid(fi))
+			return std::make_unique<SongListEnumerator>(std::shared_ptr<const SongList>(item->songs));
+
+		spl_song_cache.Remove(name);
+	}
+
+	auto playlist = playlist_open_path(path_fs, mutex);
+	if (playlist == nullptr)
+		return nullptr;
+
+	return std::make_unique<SplSongCacheRecorder>(std::move(playlist),
+						      name, fi);
+}
+
+void
+spl_song_cache_erase(const char *name) noexcept
+{
+	spl_song_cache.Remove(name);
+}
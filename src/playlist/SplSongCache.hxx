@@ -0,0 +1,55 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SPL_SONG_CACHE_HXX
+#define MPD_SPL_SONG_CACHE_HXX
+
+#include "thread/Mutex.hxx"
+
+#include <memory>
+
+class Path;
+class SongEnumerator;
+
+/**
+ * Open a stored playlist with the playlist plugins (like
+ * playlist_open_path()).  The songs (including the tags parsed by
+ * the plugin, e.g. from #EXTINF lines) of recently used stored
+ * playlists are kept in a cache, which is validated with the file's
+ * attributes.
+ *
+ * This function must be called from the main thread.
+ *
+ * @param name the name of the stored playlist
+ * @param path_fs the path of the stored playlist file
+ * @return a #SongEnumerator or nullptr if the file cannot be opened
+ */
+std::unique_ptr<SongEnumerator>
+spl_song_cache_open(const char *name, Path path_fs, Mutex &mutex);
+
+/**
+ * Remove a stored playlist from the cache.  This must be called
+ * after MPD has modified the file.
+ *
+ * This function must be called from the main thread.
+ */
+void
+spl_song_cache_erase(const char *name) noexcept;
+
+#endif
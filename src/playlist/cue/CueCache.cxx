@@ -0,0 +1,156 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "CueCache.hxx"
+#include "thread/Mutex.hxx"
+#include "util/LruCache.hxx"
+
+/**
+ * The attributes of a file.  A cache item is considered up to date
+ * as long as they are unchanged.
+ */
+struct CueFileAttributes {
+	std::chrono::system_clock::time_point mtime;
+	uint64_t size;
+#ifndef _WIN32
+	ino_t inode;
+#endif
+
+	explicit CueFileAttributes(const FileInfo &fi) noexcept
+		:mtime(fi.GetModificationTime()), size(fi.GetSize())
+#ifndef _WIN32
+		, inode(fi.GetInode())
+#endif
+	{
+	}
+
+	gcc_pure
+	bool IsValid(const FileInfo &fi) const noexcept {
+		return fi.GetModificationTime() == mtime &&
+			fi.GetSize() == size
+#ifndef _WIN32
+			&& fi.GetInode() == inode
+#endif
+			;
+	}
+};
+
+/**
+ * A parsed cue sheet.
+ */
+struct CueCacheItem {
+	CueFileAttributes attributes;
+
+	std::shared_ptr<const CueTrackList> tracks;
+
+	CueCacheItem(const FileInfo &fi,
+		     std::shared_ptr<const CueTrackList> &&_tracks) noexcept
+		:attributes(fi), tracks(std::move(_tracks)) {}
+};
+
+/**
+ * Recently used cue sheets, indexed by their file system path.
+ * This avoids reading the cue sheet again (and scanning the tags of
+ * the music file containing it) each time a cue sheet album is
+ * listed or loaded.
+ */
+static LruCache<PathTraitsFS::string, CueCacheItem,
+		CUE_CACHE_SIZE> cue_cache;
+
+/**
+ * Recently checked music files which have no embedded cue sheet.
+ * These are kept apart from #cue_cache, because a database update
+ * checks every file, and these would otherwise evict the real cue
+ * sheets.
+ */
+static LruCache<PathTraitsFS::string, CueFileAttributes,
+		CUE_NEGATIVE_CACHE_SIZE> cue_negative_cache;
+
+/**
+ * Playlists may be opened by the update thread, therefore both
+ * caches are protected by this mutex.
+ */
+static Mutex cue_cache_mutex;
+
+bool
+cue_cache_get(Path path, const FileInfo &fi,
+	      std::shared_ptr<const CueTrackList> &tracks) noexcept
+{
+	const std::lock_guard<Mutex> protect(cue_cache_mutex);
+
+	auto *item = cue_cache.Get(path.c_str());
+	if (item != nullptr) {
+		if (item->attributes.IsValid(fi)) {
+			tracks = item->tracks;
+			return true;
+		}
+
+		cue_cache.Remove(path.c_str());
+	}
+
+	auto *attributes = cue_negative_cache.Get(path.c_str());
+	if (attributes != nullptr) {
+		if (attributes->IsValid(fi)) {
+			tracks = nullptr;
+			return true;
+		}
+
+		cue_negative_cache.Remove(path.c_str());
+	}
+
+	return false;
+}
+
+void
+cue_cache_put(Path path, const FileInfo &fi,
+	      std::shared_ptr<const CueTrackList> tracks) noexcept
+try {
+	const std::lock_guard<Mutex> protect(cue_cache_mutex);
+
+	if (tracks != nullptr) {
+		cue_negative_cache.Remove(path.c_str());
+		cue_cache.Put(path.c_str(),
+			      CueCacheItem(fi, std::move(tracks)));
+	} else {
+		cue_cache.Remove(path.c_str());
+		cue_negative_cache.Put(path.c_str(), CueFileAttributes(fi));
+	}
+} catch (...) {
+	/* out of memory: don't cache this file */
+}
+
+std::unique_ptr<DetachedSong>
+CueCacheRecorder::NextSong()
+{
+	if (parser == nullptr)
+		return nullptr;
+
+	auto song = parser->NextSong();
+	if (song != nullptr) {
+		tracks.push_back(*song);
+		return song;
+	}
+
+	/* the whole cue sheet has been parsed successfully: store it
+	   in the cache */
+	parser.reset();
+	cue_cache_put(path, fi,
+		      std::make_shared<const CueTrackList>(std::move(tracks)));
+	return nullptr;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_CUE_CACHE_HXX
+#define MPD_CUE_CACHE_HXX
+
+#include "../SongListEnumerator.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+
+#include <memory>
+#include <vector>
+
+class Path;
+
+using CueTrackList = SongList;
+
+/**
+ * The maximum number of parsed cue sheets in the cache.
+ */
+static constexpr std::size_t CUE_CACHE_SIZE = 256;
+
+/**
+ * The maximum number of files in the cache which are known to have
+ * no cue sheet.
+ */
+static constexpr std::size_t CUE_NEGATIVE_CACHE_SIZE = 1024;
+
+/**
+ * Look up the parsed cue sheet of a local file in the cache.  This
+ * may be a ".cue" file or a music file with an embedded cue sheet.
+ *
+ * This function is thread-safe.
+ *
+ * @param fi the current attributes of the file; the cache item is
+ * only used if they have not changed
+ * @param tracks on success, this is set to the cached songs or
+ * nullptr if the file is known to have no cue sheet
+ * @return true if an up-to-date cache item was found
+ */
+bool
+cue_cache_get(Path path, const FileInfo &fi,
+	      std::shared_ptr<const CueTrackList> &tracks) noexcept;
+
+/**
+ * Store the parsed cue sheet of a local file in the cache.
+ *
+ * This function is thread-safe.  When the cache is full, the least
+ * recently used item is evicted.  Files without a cue sheet are
+ * remembered separately, so they never evict parsed cue sheets.
+ *
+ * @param tracks the songs or nullptr if the file has no cue sheet
+ */
+void
+cue_cache_put(Path path, const FileInfo &fi,
+	      std::shared_ptr<const CueTrackList> tracks) noexcept;
+
+/**
+ * A #SongEnumerator which forwards all songs of a cue sheet parser
+ * and stores them in the cache when the end has been reached.
+ */
+class CueCacheRecorder final : public SongEnumerator {
+	std::unique_ptr<SongEnumerator> parser;
+
+	const AllocatedPath path;
+	const FileInfo fi;
+
+	CueTrackList tracks;
+
+public:
+	/**
+	 * @param fi the attributes of the file before it was read
+	 */
+	CueCacheRecorder(std::unique_ptr<SongEnumerator> &&_parser,
+			 Path _path, const FileInfo &_fi) noexcept
+		:parser(std::move(_parser)), path(_path), fi(_fi) {}
+
+	std::unique_ptr<DetachedSong> NextSong() override;
+};
+
+#endif
@@ -21,7 +21,12 @@
 #include "../PlaylistPlugin.hxx"
 #include "../SongEnumerator.hxx"
 #include "../cue/CueParser.hxx"
+#include "../cue/CueCache.hxx"
 #include "input/TextInputStream.hxx"
+#include "input/InputStream.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/Traits.hxx"
 
 class CuePlaylist final : public SongEnumerator {
 	TextInputStream tis;
@@ -38,7 +43,28 @@ class CuePlaylist final : public SongEnumerator {
 static std::unique_ptr<SongEnumerator>
 cue_playlist_open_stream(InputStreamPtr &&is)
 {
-	return std::make_unique<CuePlaylist>(std::move(is));
+	/* local files are cached; their input stream URI is the
+	   absolute path */
+	AllocatedPath path = nullptr;
+	FileInfo fi;
+	if (PathTraitsUTF8::IsAbsolute(is->GetURI())) {
+		path = AllocatedPath::FromUTF8(is->GetURI());
+		if (!path.IsNull() && !GetFileInfo(path, fi))
+			path.SetNull();
+	}
+
+	if (!path.IsNull()) {
+		std::shared_ptr<const CueTrackList> tracks;
+		if (cue_cache_get(path, fi, tracks) && tracks != nullptr)
+			return std::make_unique<SongListEnumerator>(std::move(tracks));
+	}
+
+	auto playlist = std::make_unique<CuePlaylist>(std::move(is));
+	if (!path.IsNull())
+		return std::make_unique<CueCacheRecorder>(std::move(playlist),
+							  path, fi);
+
+	return playlist;
 }
 
 std::unique_ptr<DetachedSong>
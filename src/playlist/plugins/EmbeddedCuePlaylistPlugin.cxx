@@ -27,12 +27,14 @@
 #include "../PlaylistPlugin.hxx"
 #include "../SongEnumerator.hxx"
 #include "../cue/CueParser.hxx"
+#include "../cue/CueCache.hxx"
 #include "tag/Handler.hxx"
 #include "tag/Generic.hxx"
 #include "song/DetachedSong.hxx"
 #include "TagFile.hxx"
 #include "fs/Traits.hxx"
 #include "fs/AllocatedPath.hxx"
+#include "fs/FileInfo.hxx"
 #include "util/StringView.hxx"
 
 #include <memory>
@@ -90,14 +92,30 @@ embcue_playlist_open_uri(const char *uri,
 
 	const auto path_fs = AllocatedPath::FromUTF8Throw(uri);
 
+	FileInfo fi;
+	const bool cacheable = GetFileInfo(path_fs, fi);
+	if (cacheable) {
+		std::shared_ptr<const CueTrackList> tracks;
+		if (cue_cache_get(path_fs, fi, tracks)) {
+			if (tracks == nullptr)
+				/* no "CUESHEET" tag (cached) */
+				return nullptr;
+
+			return std::make_unique<SongListEnumerator>(std::move(tracks));
+		}
+	}
+
 	ExtractCuesheetTagHandler extract_cuesheet;
 	ScanFileTagsNoGeneric(path_fs, extract_cuesheet);
 	if (extract_cuesheet.cuesheet.empty())
 		ScanGenericTags(path_fs, extract_cuesheet);
 
-	if (extract_cuesheet.cuesheet.empty())
+	if (extract_cuesheet.cuesheet.empty()) {
 		/* no "CUESHEET" tag found */
+		if (cacheable)
+			cue_cache_put(path_fs, fi, nullptr);
 		return nullptr;
+	}
 
 	auto playlist = std::make_unique<EmbeddedCuePlaylist>();
 
@@ -108,6 +126,10 @@ embcue_playlist_open_uri(const char *uri,
 	playlist->next = &playlist->cuesheet[0];
 	playlist->parser = std::make_unique<CueParser>();
 
+	if (cacheable)
+		return std::make_unique<CueCacheRecorder>(std::move(playlist),
+							  path_fs, fi);
+
 	return playlist;
 }
 
@@ -19,7 +19,7 @@
 
 #include "PlsPlaylistPlugin.hxx"
 #include "../PlaylistPlugin.hxx"
-#include "../MemorySongEnumerator.hxx"
+#include "../SongEnumerator.hxx"
 #include "input/TextInputStream.hxx"
 #include "input/InputStream.hxx"
 #include "song/DetachedSong.hxx"
@@ -28,104 +28,243 @@
 #include "util/StringStrip.hxx"
 #include "util/DivideString.hxx"
 
+#include <map>
 #include <string>
 
 #include <stdlib.h>
 
-static bool
-FindPlaylistSection(TextInputStream &is)
-{
-	char *line;
-	while ((line = is.ReadLine()) != nullptr) {
-		line = Strip(line);
-		if (StringEqualsCaseASCII(line, "[playlist]"))
-			return true;
-	}
+/**
+ * Parses a PLS file incrementally.
+ *
+ * Most PLS files list the keys of each entry together
+ * ("File1", "Title1", "Length1", "File2", ...); once this layout has
+ * been detected, each entry is returned as soon as the next one
+ * begins.  Other files (e.g. all "File" keys before all "Title" keys)
+ * are buffered until the end of the section.
+ *
+ * If a file turns out to violate the grouped layout after it has been
+ * detected (e.g. "Length1" after "File2"), the keys of entries which
+ * have already been returned are ignored, and the rest of the section
+ * is buffered.
+ */
+class PlsPlaylist final : public SongEnumerator {
+	struct Entry {
+		std::string file, title;
+		int length = -1;
+	};
 
-	return false;
-}
+	static constexpr unsigned MAX_ENTRIES = 65536;
 
-static bool
-ParsePls(TextInputStream &is, std::forward_list<DetachedSong> &songs)
-{
-	assert(songs.empty());
+	TextInputStream tis;
 
-	if (!FindPlaylistSection(is))
-		return false;
+	/**
+	 * Entries which have not yet been returned, indexed by their
+	 * (1-based) number.
+	 */
+	std::map<unsigned, Entry> entries;
 
+	/**
+	 * The value of "NumberOfEntries" or 0 if it has not been
+	 * seen yet.
+	 */
 	unsigned n_entries = 0;
 
-	struct Entry {
-		std::string file, title;
-		int length;
+	/**
+	 * The number of the entry addressed by the most recent key.
+	 */
+	unsigned current = 0;
+
+	/**
+	 * Has a key other than "File" been seen for entry #current?
+	 */
+	bool current_has_details = false;
+
+	/**
+	 * Entries with a number below this one have already been
+	 * returned.
+	 */
+	unsigned next = 1;
+
+	enum class Layout {
+		/**
+		 * Not yet known; buffer all entries.
+		 */
+		UNKNOWN,
+
+		/**
+		 * The keys of each entry are listed together.
+		 */
+		GROUPED,
+
+		/**
+		 * The keys of different entries are mixed.
+		 */
+		MIXED,
+	} layout = Layout::UNKNOWN;
+
+	bool eof = false;
+
+public:
+	explicit PlsPlaylist(InputStreamPtr &&is)
+		:tis(std::move(is)) {}
+
+	bool FindPlaylistSection() {
+		char *line;
+		while ((line = tis.ReadLine()) != nullptr) {
+			line = Strip(line);
+			if (StringEqualsCaseASCII(line, "[playlist]"))
+				return true;
+		}
 
-		Entry():length(-1) {}
-	};
+		return false;
+	}
 
-	static constexpr unsigned MAX_ENTRIES = 65536;
+	InputStreamPtr &&StealInputStream() noexcept {
+		return tis.StealInputStream();
+	}
 
-	std::vector<Entry> entries;
+	std::unique_ptr<DetachedSong> NextSong() override;
+
+private:
+	/**
+	 * Is the first pending entry complete, i.e. will it not be
+	 * modified by subsequent lines?
+	 */
+	gcc_pure
+	bool IsFirstEntryComplete() const noexcept {
+		return !entries.empty() &&
+			(eof || (layout == Layout::GROUPED &&
+				 entries.begin()->first < current));
+	}
 
-	char *line;
-	while ((line = is.ReadLine()) != nullptr) {
-		line = Strip(line);
+	/**
+	 * Look up the entry with the given number for modification.
+	 *
+	 * @param details true for keys other than "File"
+	 * @return the entry or nullptr if the number is out of range
+	 * or if the entry has already been returned
+	 */
+	Entry *GetEntry(unsigned i, bool details) noexcept;
+
+	/**
+	 * Read and parse the next line.
+	 */
+	void ReadLine();
+};
 
-		if (*line == 0 || *line == ';')
-			continue;
+PlsPlaylist::Entry *
+PlsPlaylist::GetEntry(unsigned i, bool details) noexcept
+{
+	if (i < 1 || i > (n_entries > 0 ? n_entries : MAX_ENTRIES))
+		return nullptr;
 
-		if (*line == '[')
-			/* another section starts; we only want
-			   [Playlist], so stop here */
-			break;
+	if (i != current) {
+		if (layout != Layout::MIXED && i < current)
+			/* going back to a previous entry: this is
+			   either not the common layout at all, or the
+			   GROUPED detection was wrong; buffer the
+			   rest to lose no more keys */
+			layout = Layout::MIXED;
+		else if (layout == Layout::UNKNOWN && current > 0 &&
+			 current_has_details)
+			/* the previous entry had more than just a
+			   "File" key, and a new one begins: this is
+			   the common layout */
+			layout = Layout::GROUPED;
+
+		current = i;
+		current_has_details = false;
+	}
 
-		const DivideString ds(line, '=', true);
-		if (!ds.IsDefined())
-			continue;
+	if (details)
+		current_has_details = true;
 
-		const char *const name = ds.GetFirst();
-		const char *const value = ds.GetSecond();
+	if (i < next)
+		/* this entry has already been returned; the key
+		   is dropped */
+		return nullptr;
 
-		if (StringEqualsCaseASCII(name, "NumberOfEntries")) {
-			n_entries = strtoul(value, nullptr, 10);
-			if (n_entries == 0)
-				/* empty file - nothing remains to be
-				   done */
-				return true;
+	return &entries[i];
+}
+
+void
+PlsPlaylist::ReadLine()
+{
+	char *line = tis.ReadLine();
+	if (line == nullptr) {
+		eof = true;
+		return;
+	}
+
+	line = Strip(line);
 
-			if (n_entries > MAX_ENTRIES)
-				n_entries = MAX_ENTRIES;
-			entries.resize(n_entries);
-		} else if (StringEqualsCaseASCII(name, "File", 4)) {
-			unsigned i = strtoul(name + 4, nullptr, 10);
-			if (i >= 1 && i <= (n_entries > 0 ? n_entries : MAX_ENTRIES)) {
-				if (entries.size() < i)
-					entries.resize(i);
-				entries[i - 1].file = value;
-			}
-		} else if (StringEqualsCaseASCII(name, "Title", 5)) {
-			unsigned i = strtoul(name + 5, nullptr, 10);
-			if (i >= 1 && i <= (n_entries > 0 ? n_entries : MAX_ENTRIES)) {
-				if (entries.size() < i)
-					entries.resize(i);
-				entries[i - 1].title = value;
-			}
-		} else if (StringEqualsCaseASCII(name, "Length", 6)) {
-			unsigned i = strtoul(name + 6, nullptr, 10);
-			if (i >= 1 && i <= (n_entries > 0 ? n_entries : MAX_ENTRIES)) {
-				if (entries.size() < i)
-					entries.resize(i);
-				entries[i - 1].length = atoi(value);
-			}
+	if (*line == 0 || *line == ';')
+		return;
+
+	if (*line == '[') {
+		/* another section starts; we only want [Playlist],
+		   so stop here */
+		eof = true;
+		return;
+	}
+
+	const DivideString ds(line, '=', true);
+	if (!ds.IsDefined())
+		return;
+
+	const char *const name = ds.GetFirst();
+	const char *const value = ds.GetSecond();
+
+	if (StringEqualsCaseASCII(name, "NumberOfEntries")) {
+		n_entries = strtoul(value, nullptr, 10);
+		if (n_entries == 0) {
+			/* empty file - nothing remains to be done */
+			entries.clear();
+			eof = true;
+			return;
 		}
+
+		if (n_entries > MAX_ENTRIES)
+			n_entries = MAX_ENTRIES;
+
+		entries.erase(entries.upper_bound(n_entries), entries.end());
+	} else if (StringEqualsCaseASCII(name, "File", 4)) {
+		auto *entry = GetEntry(strtoul(name + 4, nullptr, 10),
+				       false);
+		if (entry != nullptr)
+			entry->file = value;
+	} else if (StringEqualsCaseASCII(name, "Title", 5)) {
+		auto *entry = GetEntry(strtoul(name + 5, nullptr, 10),
+				       true);
+		if (entry != nullptr)
+			entry->title = value;
+	} else if (StringEqualsCaseASCII(name, "Length", 6)) {
+		auto *entry = GetEntry(strtoul(name + 6, nullptr, 10),
+				       true);
+		if (entry != nullptr)
+			entry->length = atoi(value);
 	}
+}
 
-	if (n_entries == 0)
-		/* no "NumberOfEntries" found */
-		return false;
+std::unique_ptr<DetachedSong>
+PlsPlaylist::NextSong()
+{
+	while (true) {
+		while (!IsFirstEntryComplete()) {
+			if (eof)
+				return nullptr;
+
+			ReadLine();
+		}
 
-	auto i = songs.before_begin();
-	for (const auto &entry : entries) {
-		const char *uri = entry.file.c_str();
+		const auto i = entries.begin();
+		next = i->first + 1;
+		Entry entry = std::move(i->second);
+		entries.erase(i);
+
+		if (entry.file.empty())
+			/* no "File" key for this entry */
+			continue;
 
 		TagBuilder tag;
 		if (!entry.title.empty())
@@ -134,32 +273,21 @@ ParsePls(TextInputStream &is, std::forward_list<DetachedSong> &songs)
 		if (entry.length > 0)
 			tag.SetDuration(SignedSongTime::FromS(entry.length));
 
-		i = songs.emplace_after(i, uri, tag.Commit());
-	}
-
-	return true;
-}
-
-static bool
-ParsePls(InputStreamPtr &&is, std::forward_list<DetachedSong> &songs)
-{
-	TextInputStream tis(std::move(is));
-	if (!ParsePls(tis, songs)) {
-		is = tis.StealInputStream();
-		return false;
+		return std::make_unique<DetachedSong>(std::move(entry.file),
+						      tag.Commit());
 	}
-
-	return true;
 }
 
 static std::unique_ptr<SongEnumerator>
 pls_open_stream(InputStreamPtr &&is)
 {
-	std::forward_list<DetachedSong> songs;
-	if (!ParsePls(std::move(is), songs))
+	auto playlist = std::make_unique<PlsPlaylist>(std::move(is));
+	if (!playlist->FindPlaylistSection()) {
+		is = playlist->StealInputStream();
 		return nullptr;
+	}
 
-	return std::make_unique<MemorySongEnumerator>(std::move(songs));
+	return playlist;
 }
 
 static const char *const pls_suffixes[] = {
@@ -19,7 +19,7 @@
 
 #include "XspfPlaylistPlugin.hxx"
 #include "../PlaylistPlugin.hxx"
-#include "../MemorySongEnumerator.hxx"
+#include "../ExpatSongEnumerator.hxx"
 #include "song/DetachedSong.hxx"
 #include "input/InputStream.hxx"
 #include "tag/Builder.hxx"
@@ -33,10 +33,10 @@
  */
 struct XspfParser {
 	/**
-	 * The list of songs (in reverse order because that's faster
-	 * while adding).
+	 * Songs which have been parsed, but not yet consumed by
+	 * ExpatSongEnumerator::NextSong().
 	 */
-	std::forward_list<DetachedSong> songs;
+	std::list<DetachedSong> songs;
 
 	/**
 	 * The current position in the XML file.
@@ -93,9 +93,10 @@ xspf_start_element(void *user_data, const XML_Char *element_name,
 		break;
 
 	case XspfParser::TRACK:
-		if (strcmp(element_name, "location") == 0)
+		if (strcmp(element_name, "location") == 0) {
 			parser->state = XspfParser::LOCATION;
-		else if (strcmp(element_name, "title") == 0)
+			parser->location.clear();
+		} else if (strcmp(element_name, "title") == 0)
 			parser->tag_type = TAG_TITLE;
 		else if (strcmp(element_name, "creator") == 0)
 			/* TAG_COMPOSER would be more correct
@@ -139,8 +140,8 @@ xspf_end_element(void *user_data, const XML_Char *element_name)
 	case XspfParser::TRACK:
 		if (strcmp(element_name, "track") == 0) {
 			if (!parser->location.empty())
-				parser->songs.emplace_front(std::move(parser->location),
-							    parser->tag_builder.Commit());
+				parser->songs.emplace_back(std::move(parser->location),
+							   parser->tag_builder.Commit());
 
 			parser->state = XspfParser::TRACKLIST;
 		} else
@@ -174,7 +175,8 @@ xspf_char_data(void *user_data, const XML_Char *s, int len)
 		break;
 
 	case XspfParser::LOCATION:
-		parser->location.assign(s, len);
+		/* expat may split the text into several chunks */
+		parser->location.append(s, len);
 
 		break;
 	}
@@ -188,17 +190,11 @@ xspf_char_data(void *user_data, const XML_Char *s, int len)
 static std::unique_ptr<SongEnumerator>
 xspf_open_stream(InputStreamPtr &&is)
 {
-	XspfParser parser;
-
-	{
-		ExpatParser expat(&parser);
-		expat.SetElementHandler(xspf_start_element, xspf_end_element);
-		expat.SetCharacterDataHandler(xspf_char_data);
-		expat.Parse(*is);
-	}
-
-	parser.songs.reverse();
-	return std::make_unique<MemorySongEnumerator>(std::move(parser.songs));
+	using Enumerator = ExpatSongEnumerator<XspfParser>;
+	return std::make_unique<Enumerator>(std::move(is),
+					    xspf_start_element,
+					    xspf_end_element,
+					    xspf_char_data);
 }
 
 static const char *const xspf_suffixes[] = {
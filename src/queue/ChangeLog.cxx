@@ -0,0 +1,108 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ChangeLog.hxx"
+
+#include <algorithm>
+
+#include <assert.h>
+
+void
+QueueChangeLog::Add(uint32_t version, unsigned start, unsigned end) noexcept
+{
+	assert(start <= end);
+
+	if (start == end)
+		return;
+
+	if (n_entries > 0) {
+		/* merge with the previous entry if it belongs to the
+		   same version and the ranges touch each other */
+		Entry &last = Last();
+		if (last.version == version &&
+		    start <= last.end && end >= last.start) {
+			last.start = std::min(last.start, start);
+			last.end = std::max(last.end, end);
+			return;
+		}
+	}
+
+	if (n_entries == CAPACITY) {
+		/* discard the oldest entry */
+		const Entry &oldest = entries[head];
+		complete_since = std::max(complete_since, oldest.version + 1);
+		head = (head + 1) % CAPACITY;
+		--n_entries;
+	}
+
+	++n_entries;
+	Last() = {version, start, end};
+}
+
+void
+QueueChangeLog::Reset(uint32_t version) noexcept
+{
+	head = 0;
+	n_entries = 0;
+	complete_since = version;
+	stale_end = 0;
+}
+
+void
+QueueChangeLog::Restart(uint32_t version, unsigned length) noexcept
+{
+	Reset(version);
+	stale_end = length;
+}
+
+bool
+QueueChangeLog::Collect(uint32_t version, std::vector<Range> &ranges) const
+{
+	if (version < complete_since)
+		return false;
+
+	ranges.clear();
+
+	if (stale_end > 0)
+		ranges.emplace_back(0, stale_end);
+
+	for (unsigned i = 0; i < n_entries; ++i) {
+		const Entry &e = entries[(head + i) % CAPACITY];
+		if (e.version >= version)
+			ranges.emplace_back(e.start, e.end);
+	}
+
+	if (ranges.empty())
+		return true;
+
+	/* sort and merge overlapping ranges */
+
+	std::sort(ranges.begin(), ranges.end());
+
+	auto dest = ranges.begin();
+	for (auto i = std::next(ranges.begin()); i != ranges.end(); ++i) {
+		if (i->first <= dest->second)
+			dest->second = std::max(dest->second, i->second);
+		else
+			*++dest = *i;
+	}
+
+	ranges.erase(std::next(dest), ranges.end());
+	return true;
+}
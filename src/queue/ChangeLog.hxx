@@ -0,0 +1,134 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_QUEUE_CHANGE_LOG_HXX
+#define MPD_QUEUE_CHANGE_LOG_HXX
+
+#include "util/Compiler.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+/**
+ * A bounded log of position ranges in the #Queue which were modified,
+ * together with the queue version of each modification.  It allows
+ * "plchanges" to visit only the modified ranges instead of scanning
+ * the whole queue.
+ *
+ * When a modification shifts songs to other positions (e.g. a
+ * deletion or a move), the whole range of shifted positions is
+ * logged, which means that the union of all ranges logged since a
+ * given version is a superset of the positions which have changed
+ * since then, even though older ranges are not adjusted.
+ *
+ * When the queue version wraps around, the stamps of all items are
+ * reset to 0, which means they are considered modified in every
+ * version.  Such items never move (moving an item stamps it with
+ * the current version), so the log restarts and reports the
+ * positions which were occupied at that time as "stale" until they
+ * are all gone.
+ */
+class QueueChangeLog {
+	struct Entry {
+		uint32_t version;
+		unsigned start, end;
+	};
+
+	static constexpr unsigned CAPACITY = 256;
+
+	std::array<Entry, CAPACITY> entries;
+
+	/**
+	 * The index of the oldest entry in the ring buffer.
+	 */
+	unsigned head = 0;
+
+	/**
+	 * The number of entries in the ring buffer.
+	 */
+	unsigned n_entries = 0;
+
+	/**
+	 * All modifications with this version or newer are in the
+	 * log.  Older entries have been discarded.
+	 */
+	uint32_t complete_since = 1;
+
+	/**
+	 * Positions below this one may hold items whose stamp has
+	 * been reset to 0 by a version wrap-around; they are
+	 * reported by every Collect() call.
+	 */
+	unsigned stale_end = 0;
+
+public:
+	/**
+	 * A half-open range of positions.
+	 */
+	typedef std::pair<unsigned, unsigned> Range;
+
+	/**
+	 * Record a modification of the position range [start, end).
+	 */
+	void Add(uint32_t version, unsigned start, unsigned end) noexcept;
+
+	/**
+	 * Discard all entries; all modifications from the given
+	 * version on will be logged.
+	 */
+	void Reset(uint32_t version) noexcept;
+
+	/**
+	 * The queue's version numbers have wrapped around, and the
+	 * stamps of all items have been reset to 0.  Discard all
+	 * entries and restart the log with the given (new) version;
+	 * the positions below the given queue length are reported
+	 * as modified until DiscardStale() or Reset() is called.
+	 */
+	void Restart(uint32_t version, unsigned length) noexcept;
+
+	/**
+	 * There are no items with a stamp of 0 anymore (e.g. because
+	 * the queue has been cleared).
+	 */
+	void DiscardStale() noexcept {
+		stale_end = 0;
+	}
+
+	/**
+	 * Determine which positions have been modified since the
+	 * given version.
+	 *
+	 * @param ranges a list which receives the sorted and
+	 * non-overlapping position ranges
+	 * @return false if the log does not cover the given version
+	 * (the caller must then scan the whole queue)
+	 */
+	bool Collect(uint32_t version, std::vector<Range> &ranges) const;
+
+private:
+	Entry &Last() noexcept {
+		return entries[(head + n_entries - 1) % CAPACITY];
+	}
+};
+
+#endif
@@ -27,19 +27,20 @@
 #include <assert.h>
 
 /**
- * A table that maps id numbers to position numbers.
+ * A table that maps id numbers to objects.
  */
+template<typename T>
 class IdTable {
 	unsigned size;
 
 	unsigned next;
 
-	int *const data;
+	T **const data;
 
 public:
 	IdTable(unsigned _size) noexcept
-		:size(_size), next(1), data(new int[size]) {
-		std::fill_n(data, size, -1);
+		:size(_size), next(1), data(new T *[size]) {
+		std::fill_n(data, size, nullptr);
 	}
 
 	~IdTable() noexcept {
@@ -49,10 +50,13 @@ public:
 	IdTable(const IdTable &) = delete;
 	IdTable &operator=(const IdTable &) = delete;
 
-	int IdToPosition(unsigned id) const noexcept {
+	/**
+	 * @return the object with the given id or nullptr
+	 */
+	T *Lookup(unsigned id) const noexcept {
 		return id < size
 			? data[id]
-			: -1;
+			: nullptr;
 	}
 
 	unsigned GenerateId() noexcept {
@@ -66,29 +70,22 @@ public:
 			if (next == size)
 				next = 1;
 
-			if (data[id] < 0)
+			if (data[id] == nullptr)
 				return id;
 		}
 	}
 
-	unsigned Insert(unsigned position) noexcept {
+	unsigned Insert(T &t) noexcept {
 		unsigned id = GenerateId();
-		data[id] = position;
+		data[id] = &t;
 		return id;
 	}
 
-	void Move(unsigned id, unsigned position) noexcept {
-		assert(id < size);
-		assert(data[id] >= 0);
-
-		data[id] = position;
-	}
-
 	void Erase(unsigned id) noexcept {
 		assert(id < size);
-		assert(data[id] >= 0);
+		assert(data[id] != nullptr);
 
-		data[id] = -1;
+		data[id] = nullptr;
 	}
 };
 
@@ -48,13 +48,16 @@ playlist::TagModified(const char *uri, const Tag &tag) noexcept
 {
 	bool modified = false;
 
-	for (unsigned i = 0; i < queue.length; ++i) {
-		auto &song = *queue.items[i].song;
+	unsigned position = 0;
+	for (auto &item : queue.items) {
+		auto &song = *item.song;
 		if (song.IsURI(uri)) {
 			song.SetTag(tag);
-			queue.ModifyAtPosition(i);
+			queue.ModifyAtPosition(position);
 			modified = true;
 		}
+
+		++position;
 	}
 
 	if (modified)
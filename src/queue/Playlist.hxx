@@ -24,6 +24,8 @@
 #include "queue/Queue.hxx"
 #include "config.h"
 
+#include <vector>
+
 enum TagType : uint8_t;
 struct Tag;
 class PlayerControl;
@@ -212,6 +214,17 @@ public:
 	 */
 	unsigned AppendSong(PlayerControl &pc, DetachedSong &&song);
 
+	/**
+	 * Append many songs at once.  This is cheaper than calling
+	 * AppendSong() for each of them, because the queue is
+	 * committed only once.  The songs are moved out of the
+	 * vector.
+	 *
+	 * Throws PlaylistError if the queue would be too large; the
+	 * songs which fit are appended nonetheless.
+	 */
+	void AppendSongs(PlayerControl &pc, std::vector<DetachedSong> &songs);
+
 	/**
 	 * Throws #std::runtime_error on error.
 	 *
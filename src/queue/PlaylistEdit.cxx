@@ -118,6 +118,43 @@ playlist::AppendSong(PlayerControl &pc, DetachedSong &&song)
 	return id;
 }
 
+void
+playlist::AppendSongs(PlayerControl &pc, std::vector<DetachedSong> &songs)
+{
+	if (songs.empty())
+		return;
+
+	const DetachedSong *const queued_song = GetQueuedSong();
+
+	/* the position after which new songs are shuffled into the
+	   list of remaining songs to play */
+	const unsigned shuffle_start = queued >= 0
+		? queued + 1
+		: current + 1;
+
+	bool too_large = false;
+
+	for (auto &song : songs) {
+		if (queue.IsFull()) {
+			too_large = true;
+			break;
+		}
+
+		queue.Append(std::move(song), 0);
+
+		if (queue.random && shuffle_start < queue.GetLength())
+			queue.ShuffleOrderLastWithPriority(shuffle_start,
+							   queue.GetLength());
+	}
+
+	UpdateQueuedSong(pc, queued_song);
+	OnModified();
+
+	if (too_large)
+		throw PlaylistError(PlaylistResult::TOO_LARGE,
+				    "Playlist is too large");
+}
+
 unsigned
 playlist::AppendURI(PlayerControl &pc, const SongLoader &loader,
 		    const char *uri)
@@ -20,10 +20,10 @@
 #include "Queue.hxx"
 #include "song/DetachedSong.hxx"
 
+#include <algorithm>
+
 Queue::Queue(unsigned _max_length) noexcept
 	:max_length(_max_length),
-	 items(new Item[max_length]),
-	 order(new unsigned[max_length]),
 	 id_table(max_length * HASH_MULT)
 {
 }
@@ -31,9 +31,6 @@ Queue::Queue(unsigned _max_length) noexcept
 Queue::~Queue() noexcept
 {
 	Clear();
-
-	delete[] items;
-	delete[] order;
 }
 
 int
@@ -61,10 +58,13 @@ Queue::IncrementVersion() noexcept
 	version++;
 
 	if (version >= max) {
-		for (unsigned i = 0; i < length; i++)
-			items[i].version = 0;
+		items.ResetStamps();
 
 		version = 1;
+
+		/* all items have version 0 now; restart the log
+		   and let it report them until they are gone */
+		changes.Restart(version, length);
 	}
 }
 
@@ -73,8 +73,7 @@ Queue::ModifyAtOrder(unsigned _order) noexcept
 {
 	assert(_order < length);
 
-	unsigned position = order[_order];
-	ModifyAtPosition(position);
+	ModifyAtPosition(OrderToPosition(_order));
 }
 
 unsigned
@@ -82,112 +81,59 @@ Queue::Append(DetachedSong &&song, uint8_t priority) noexcept
 {
 	assert(!IsFull());
 
-	const unsigned position = length++;
-	const unsigned id = id_table.Insert(position);
+	++length;
 
-	auto &item = items[position];
-	item.song = new DetachedSong(std::move(song));
-	item.id = id;
-	item.version = version;
-	item.priority = priority;
+	auto *item = new Item();
+	item->song = new DetachedSong(std::move(song));
+	item->id = id_table.Insert(*item);
+	item->priority = priority;
+
+	items.push_back(*item);
+	order.push_back(*item);
+	order.SetKey(*item, priority);
 
-	order[position] = position;
+	ModifyAtPosition(length - 1);
 
-	return id;
+	return item->id;
 }
 
 void
 Queue::SwapPositions(unsigned position1, unsigned position2) noexcept
 {
-	unsigned id1 = items[position1].id;
-	unsigned id2 = items[position2].id;
+	auto &item1 = items[position1];
+	auto &item2 = items[position2];
 
-	std::swap(items[position1], items[position2]);
+	items.Swap(item1, item2);
 
-	items[position1].version = version;
-	items[position2].version = version;
+	/* the "order" list refers to positions, not to songs */
+	order.Swap(item1, item2);
 
-	id_table.Move(id1, position2);
-	id_table.Move(id2, position1);
+	ModifyAtPosition(position1);
+	ModifyAtPosition(position2);
 }
 
 void
 Queue::MovePostion(unsigned from, unsigned to) noexcept
 {
-	const Item tmp = items[from];
-
-	/* move songs to one less in from->to */
-
-	for (unsigned i = from; i < to; i++)
-		MoveItemTo(i + 1, i);
-
-	/* move songs to one more in to->from */
-
-	for (unsigned i = from; i > to; i--)
-		MoveItemTo(i - 1, i);
-
-	/* put song at _to_ */
-
-	id_table.Move(tmp.id, to);
-	items[to] = tmp;
-	items[to].version = version;
-
-	/* now deal with order */
-
-	if (random) {
-		for (unsigned i = 0; i < length; i++) {
-			if (order[i] > from && order[i] <= to)
-				order[i]--;
-			else if (order[i] < from &&
-				 order[i] >= to)
-				order[i]++;
-			else if (from == order[i])
-				order[i] = to;
-		}
-	}
+	MoveRange(from, from + 1, to);
 }
 
 void
 Queue::MoveRange(unsigned start, unsigned end, unsigned to) noexcept
 {
-	const auto tmp = std::make_unique<Item[]>(end - start);
-
-	// Copy the original block [start,end-1]
-	for (unsigned i = start; i < end; i++)
-		tmp[i - start] = items[i];
-
-	// If to > start, we need to move to-start items to start, starting from end
-	for (unsigned i = end; i < end + to - start; i++)
-		MoveItemTo(i, start + i - end);
-
-	// If to < start, we need to move start-to items to newend (= end + to - start), starting from to
-	// This is the same as moving items from start-1 to to (decreasing), with start-1 going to end-1
-	// We have to iterate in this order to avoid writing over something we haven't yet moved
-	for (int i = start - 1; i >= int(to); i--)
-		MoveItemTo(i, i + end - start);
-
-	// Copy the original block back in, starting at to.
-	for (unsigned i = start; i< end; i++)
-	{
-		id_table.Move(tmp[i - start].id, to + i - start);
-		items[to + i - start] = tmp[i-start];
-		items[to + i - start].version = version;
-	}
+	assert(start <= end);
+	assert(end <= length);
+	assert(to + (end - start) <= length);
 
-	if (random) {
-		// Update the positions in the queue.
-		// Note that the ranges for these cases are the same as the ranges of
-		// the loops above.
-		for (unsigned i = 0; i < length; i++) {
-			if (order[i] >= end && order[i] < to + end - start)
-				order[i] -= end - start;
-			else if (order[i] < start &&
-				 order[i] >= to)
-				order[i] += end - start;
-			else if (start <= order[i] && order[i] < end)
-				order[i] += to - start;
-		}
-	}
+	items.Move(start, end, to);
+
+	/* in random mode, the "order" list follows the songs;
+	   otherwise it equals the position list */
+	if (!random)
+		order.Move(start, end, to);
+
+	ModifyPositionRange(std::min(start, to),
+			    std::max(end, to + end - start));
 }
 
 unsigned
@@ -196,17 +142,7 @@ Queue::MoveOrder(unsigned from_order, unsigned to_order) noexcept
 	assert(from_order < length);
 	assert(to_order <= length);
 
-	const unsigned from_position = OrderToPosition(from_order);
-
-	if (from_order < to_order) {
-		for (unsigned i = from_order; i < to_order; ++i)
-			order[i] = order[i + 1];
-	} else {
-		for (unsigned i = from_order; i > to_order; --i)
-			order[i] = order[i - 1];
-	}
-
-	order[to_order] = from_position;
+	order.Move(from_order, from_order + 1, to_order);
 	return to_order;
 }
 
@@ -233,46 +169,50 @@ Queue::DeletePosition(unsigned position) noexcept
 {
 	assert(position < length);
 
-	delete items[position].song;
-
-	const unsigned id = PositionToId(position);
-	const unsigned _order = PositionToOrder(position);
-
-	--length;
+	auto &item = items[position];
 
 	/* release the song id */
 
-	id_table.Erase(id);
-
-	/* delete song from songs array */
+	id_table.Erase(item.id);
 
-	for (unsigned i = position; i < length; i++)
-		MoveItemTo(i + 1, i);
+	items.erase(item);
+	order.erase(item);
 
-	/* delete the entry from the order array */
+	--length;
 
-	for (unsigned i = _order; i < length; i++)
-		order[i] = order[i + 1];
+	/* all songs after the deleted one have moved */
 
-	/* readjust values in the order array */
+	ModifyPositionRange(position, length);
 
-	for (unsigned i = 0; i < length; i++)
-		if (order[i] > position)
-			--order[i];
+	delete item.song;
+	delete &item;
 }
 
 void
 Queue::Clear() noexcept
 {
-	for (unsigned i = 0; i < length; i++) {
-		Item *item = &items[i];
-
+	order.clear();
+	items.clear_and_dispose([this](Item *item){
 		delete item->song;
 
 		id_table.Erase(item->id);
-	}
+
+		delete item;
+	});
 
 	length = 0;
+
+	/* there are no items with version 0 anymore */
+	changes.DiscardStale();
+}
+
+void
+Queue::RestoreOrder() noexcept
+{
+	order.clear();
+
+	for (auto &item : items)
+		order.push_back(item);
 }
 
 static void
@@ -284,14 +224,13 @@ queue_sort_order_by_priority(Queue *queue,
 	assert(start <= end);
 	assert(end <= queue->length);
 
-	auto cmp = [queue](unsigned a_pos, unsigned b_pos){
-		const Queue::Item &a = queue->items[a_pos];
-		const Queue::Item &b = queue->items[b_pos];
-
-		return a.priority > b.priority;
+	auto cmp = [](const Queue::Item *a, const Queue::Item *b){
+		return a->priority > b->priority;
 	};
 
-	std::stable_sort(queue->order + start, queue->order + end, cmp);
+	queue->order.Permute(start, end, [&cmp](auto &v){
+		std::stable_sort(v.begin(), v.end(), cmp);
+	});
 }
 
 void
@@ -302,7 +241,9 @@ Queue::ShuffleOrderRange(unsigned start, unsigned end) noexcept
 	assert(end <= length);
 
 	rand.AutoCreate();
-	std::shuffle(order + start, order + end, rand);
+	order.Permute(start, end, [this](auto &v){
+		std::shuffle(v.begin(), v.end(), rand);
+	});
 }
 
 /**
@@ -367,11 +308,11 @@ Queue::ShuffleOrderLastWithPriority(unsigned start, unsigned end) noexcept
 	/* skip all items at the start which have a higher priority,
 	   because the last item shall only be shuffled within its
 	   priority group */
-	const auto last_priority = items[OrderToPosition(end - 1)].priority;
-	while (items[OrderToPosition(start)].priority != last_priority) {
-		++start;
-		assert(start < end);
-	}
+	const auto last_priority = GetOrderPriority(end - 1);
+	start = order.FindKey(start, [last_priority](uint8_t min, uint8_t max){
+		return min <= last_priority && last_priority <= max;
+	});
+	assert(start < end);
 
 	rand.AutoCreate();
 
@@ -402,14 +343,15 @@ Queue::FindPriorityOrder(unsigned start_order, uint8_t priority,
 	assert(random);
 	assert(start_order <= length);
 
-	for (unsigned i = start_order; i < length; ++i) {
-		const unsigned position = OrderToPosition(i);
-		const Item *item = &items[position];
-		if (item->priority <= priority && i != exclude_order)
-			return i;
-	}
+	const auto p = [priority](uint8_t min, uint8_t){
+		return min <= priority;
+	};
 
-	return length;
+	unsigned i = order.FindKey(start_order, p);
+	if (i == exclude_order)
+		i = order.FindKey(i + 1, p);
+
+	return i;
 }
 
 unsigned
@@ -418,14 +360,12 @@ Queue::CountSamePriority(unsigned start_order, uint8_t priority) const noexcept
 	assert(random);
 	assert(start_order <= length);
 
-	for (unsigned i = start_order; i < length; ++i) {
-		const unsigned position = OrderToPosition(i);
-		const Item *item = &items[position];
-		if (item->priority != priority)
-			return i - start_order;
-	}
+	const unsigned end = order.FindKey(start_order,
+					   [priority](uint8_t min, uint8_t max){
+		return min != priority || max != priority;
+	});
 
-	return length - start_order;
+	return end - start_order;
 }
 
 bool
@@ -439,8 +379,9 @@ Queue::SetPriority(unsigned position, uint8_t priority, int after_order,
 	if (old_priority == priority)
 		return false;
 
-	item->version = version;
+	ModifyAtPosition(position);
 	item->priority = priority;
+	order.SetKey(*item, priority);
 
 	if (!random || !reorder)
 		/* don't reorder if not in random mode */
@@ -458,10 +399,8 @@ Queue::SetPriority(unsigned position, uint8_t priority, int after_order,
 			   increased and is now bigger than the
 			   current one's */
 
-			const unsigned after_position =
-				OrderToPosition(after_order);
 			const Item *after_item =
-				&items[after_position];
+				&GetOrderItem(after_order);
 			if (priority <= old_priority ||
 			    priority <= after_item->priority)
 				/* priority hasn't become bigger */
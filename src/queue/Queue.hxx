@@ -22,8 +22,10 @@
 
 #include "util/Compiler.h"
 #include "IdTable.hxx"
+#include "ChangeLog.hxx"
 #include "SingleMode.hxx"
 #include "util/LazyRandomEngine.hxx"
+#include "util/RankTree.hxx"
 
 #include <utility>
 
@@ -41,6 +43,10 @@ class DetachedSong;
  * - the position in the queue
  * - the unique id (which stays the same, regardless of moves)
  * - the order number (which only differs from "position" in random mode)
+ *
+ * The items are linked into two #RankTree instances (one in
+ * "position" order and one in "order" order), which makes all
+ * lookups and edits O(log n), even for very large queues.
  */
 struct Queue {
 	/**
@@ -54,14 +60,14 @@ struct Queue {
 	 * information attached.
 	 */
 	struct Item {
+		RankTreeHook position_hook;
+		RankTreeHook order_hook;
+
 		DetachedSong *song;
 
 		/** the unique id of this item in the queue */
 		unsigned id;
 
-		/** when was this item last changed? */
-		uint32_t version;
-
 		/**
 		 * The priority of this item, between 0 and 255.  High
 		 * priority value means that this song gets played first in
@@ -79,14 +85,23 @@ struct Queue {
 	/** the current version number */
 	uint32_t version = 1;
 
-	/** all songs in "position" order */
-	Item *const items;
+	/**
+	 * All songs in "position" order.  The stamp of each item is
+	 * the version when it was last changed.
+	 */
+	RankTree<Item, &Item::position_hook> items;
+
+	/**
+	 * All songs in "order" order.  Outside of random mode, this
+	 * is the same as #items.
+	 */
+	RankTree<Item, &Item::order_hook> order;
 
-	/** map order numbers to positions */
-	unsigned *const order;
+	/** map song ids to items */
+	IdTable<Item> id_table;
 
-	/** map song ids to positions */
-	IdTable id_table;
+	/** which positions were modified in which version? */
+	QueueChangeLog changes;
 
 	/** repeat playback when the end of the queue has been
 	    reached? */
@@ -146,10 +161,15 @@ struct Queue {
 		return _order < length;
 	}
 
+	gcc_pure
 	int IdToPosition(unsigned id) const noexcept {
-		return id_table.IdToPosition(id);
+		const Item *item = id_table.Lookup(id);
+		return item != nullptr
+			? int(items.IndexOf(*item))
+			: -1;
 	}
 
+	gcc_pure
 	int PositionToId(unsigned position) const noexcept {
 		assert(position < length);
 
@@ -160,19 +180,14 @@ struct Queue {
 	unsigned OrderToPosition(unsigned _order) const noexcept {
 		assert(_order < length);
 
-		return order[_order];
+		return items.IndexOf(order[_order]);
 	}
 
 	gcc_pure
 	unsigned PositionToOrder(unsigned position) const noexcept {
 		assert(position < length);
 
-		for (unsigned i = 0;; ++i) {
-			assert(i < length);
-
-			if (order[i] == position)
-				return i;
-		}
+		return order.IndexOf(items[position]);
 	}
 
 	gcc_pure
@@ -182,10 +197,11 @@ struct Queue {
 		return items[position].priority;
 	}
 
+	gcc_pure
 	const Item &GetOrderItem(unsigned i) const noexcept {
 		assert(IsValidOrder(i));
 
-		return items[OrderToPosition(i)];
+		return order[i];
 	}
 
 	uint8_t GetOrderPriority(unsigned i) const noexcept {
@@ -195,6 +211,7 @@ struct Queue {
 	/**
 	 * Returns the song at the specified position.
 	 */
+	gcc_pure
 	DetachedSong &Get(unsigned position) const noexcept {
 		assert(position < length);
 
@@ -204,21 +221,37 @@ struct Queue {
 	/**
 	 * Returns the song at the specified order number.
 	 */
+	gcc_pure
 	DetachedSong &GetOrder(unsigned _order) const noexcept {
-		return Get(OrderToPosition(_order));
+		return *GetOrderItem(_order).song;
 	}
 
 	/**
 	 * Is the song at the specified position newer than the specified
 	 * version?
 	 */
+	gcc_pure
 	bool IsNewerAtPosition(unsigned position,
 			       uint32_t _version) const noexcept {
 		assert(position < length);
 
+		const uint32_t item_version = items.GetStamp(items[position]);
 		return _version > version ||
-			items[position].version >= _version ||
-			items[position].version == 0;
+			item_version >= _version ||
+			item_version == 0;
+	}
+
+	/**
+	 * Determine which positions may have been modified since the
+	 * given version; the result is a superset which needs to be
+	 * filtered with IsNewerAtPosition().
+	 *
+	 * @return false if that is unknown, and the whole queue must
+	 * be scanned
+	 */
+	bool CollectChanges(uint32_t _version,
+			    std::vector<QueueChangeLog::Range> &ranges) const {
+		return _version <= version && changes.Collect(_version, ranges);
 	}
 
 	/**
@@ -244,7 +277,8 @@ struct Queue {
 	void ModifyAtPosition(unsigned position) noexcept {
 		assert(position < length);
 
-		items[position].version = version;
+		items.RaiseStamp(items[position], version);
+		changes.Add(version, position, position + 1);
 	}
 
 	/**
@@ -275,7 +309,7 @@ struct Queue {
 	 * Swaps two songs, addressed by their order number.
 	 */
 	void SwapOrders(unsigned order1, unsigned order2) noexcept {
-		std::swap(order[order1], order[order2]);
+		order.Swap(order[order1], order[order2]);
 	}
 
 	/**
@@ -324,12 +358,9 @@ struct Queue {
 	void Clear() noexcept;
 
 	/**
-	 * Initializes the "order" array, and restores "normal" order.
+	 * Initializes the "order" list, and restores "normal" order.
 	 */
-	void RestoreOrder() noexcept {
-		for (unsigned i = 0; i < length; ++i)
-			order[i] = i;
-	}
+	void RestoreOrder() noexcept;
 
 	/**
 	 * Shuffle the order of items in the specified range, ignoring
@@ -373,12 +404,13 @@ struct Queue {
 			      uint8_t priority, int after_order) noexcept;
 
 private:
-	void MoveItemTo(unsigned from, unsigned to) noexcept {
-		unsigned from_id = items[from].id;
-
-		items[to] = items[from];
-		items[to].version = version;
-		id_table.Move(from_id, to);
+	/**
+	 * Mark all items in the specified position range as
+	 * modified, because their position has changed.
+	 */
+	void ModifyPositionRange(unsigned start, unsigned end) noexcept {
+		items.RaiseStampRange(start, end, version);
+		changes.Add(version, start, end);
 	}
 
 	/**
@@ -25,6 +25,8 @@
 #include "song/LightSong.hxx"
 #include "client/Response.hxx"
 
+#include <algorithm>
+
 /**
  * Send detailed information about a range of songs in the queue to a
  * client.
@@ -70,10 +72,16 @@ queue_print_uris(Response &r, const Queue &queue,
 	}
 }
 
-void
-queue_print_changes_info(Response &r, const Queue &queue,
-			 uint32_t version,
-			 unsigned start, unsigned end)
+/**
+ * Invoke a function for each position in the given range which has
+ * been modified since the given version.  This consults the queue's
+ * change log and falls back to scanning the whole range if the log
+ * does not reach back far enough.
+ */
+template<typename F>
+static void
+queue_visit_changes(const Queue &queue, uint32_t version,
+		    unsigned start, unsigned end, F &&f)
 {
 	assert(start <= end);
 
@@ -83,9 +91,28 @@ queue_print_changes_info(Response &r, const Queue &queue,
 	if (end > queue.GetLength())
 		end = queue.GetLength();
 
-	for (unsigned i = start; i < end; i++)
-		if (queue.IsNewerAtPosition(i, version))
-			queue_print_song_info(r, queue, i);
+	std::vector<QueueChangeLog::Range> ranges;
+	if (!queue.CollectChanges(version, ranges))
+		ranges = {{start, end}};
+
+	for (const auto &range : ranges) {
+		const unsigned range_start = std::max(range.first, start);
+		const unsigned range_end = std::min(range.second, end);
+
+		for (unsigned i = range_start; i < range_end; i++)
+			if (queue.IsNewerAtPosition(i, version))
+				f(i);
+	}
+}
+
+void
+queue_print_changes_info(Response &r, const Queue &queue,
+			 uint32_t version,
+			 unsigned start, unsigned end)
+{
+	queue_visit_changes(queue, version, start, end, [&](unsigned i){
+		queue_print_song_info(r, queue, i);
+	});
 }
 
 void
@@ -93,18 +120,10 @@ queue_print_changes_position(Response &r, const Queue &queue,
 			     uint32_t version,
 			     unsigned start, unsigned end)
 {
-	assert(start <= end);
-
-	if (start >= queue.GetLength())
-		return;
-
-	if (end > queue.GetLength())
-		end = queue.GetLength();
-
-	for (unsigned i = start; i < end; i++)
-		if (queue.IsNewerAtPosition(i, version))
-			r.Format("cpos: %i\nId: %i\n",
-				 i, queue.PositionToId(i));
+	queue_visit_changes(queue, version, start, end, [&](unsigned i){
+		r.Format("cpos: %i\nId: %i\n",
+			 i, queue.PositionToId(i));
+	});
 }
 
 void
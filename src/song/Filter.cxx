@@ -25,6 +25,7 @@
 #include "TagSongFilter.hxx"
 #include "ModifiedSinceSongFilter.hxx"
 #include "AudioFormatSongFilter.hxx"
+#include "StickerSongFilter.hxx"
 #include "AudioParser.hxx"
 #include "tag/ParseName.hxx"
 #include "time/ISO8601.hxx"
@@ -240,6 +241,62 @@ ParseStringFilter(const char *&s, bool fold_case)
 			    fold_case, false, negated);
 }
 
+#ifdef ENABLE_SQLITE
+
+static constexpr bool
+IsStickerNameChar(char ch) noexcept
+{
+	return !IsWhitespaceOrNull(ch) &&
+		ch != '=' && ch != '<' && ch != '>' && ch != ')';
+}
+
+/**
+ * Parse the remainder of a "(sticker:NAME OP 'VALUE')" expression
+ * after the "sticker:" prefix, up to the closing parenthesis.
+ *
+ * Throws on error.
+ */
+static std::shared_ptr<StickerSongFilter::Predicate>
+ParseStickerPredicate(const char *&s)
+{
+	const char *begin = s;
+	while (IsStickerNameChar(*s))
+		++s;
+
+	if (s == begin)
+		throw std::runtime_error("Sticker name expected");
+
+	std::string name(begin, s);
+	s = StripLeft(s);
+
+	if (*s == ')')
+		return std::make_shared<StickerSongFilter::Predicate>(std::move(name),
+								      StickerOperator::EXISTS,
+								      std::string());
+
+	StickerOperator op;
+	if (s[0] == '=' && s[1] == '=') {
+		op = StickerOperator::EQUALS;
+		s += 2;
+	} else if (s[0] == '<') {
+		op = StickerOperator::LESS_THAN;
+		++s;
+	} else if (s[0] == '>') {
+		op = StickerOperator::GREATER_THAN;
+		++s;
+	} else
+		throw std::runtime_error("'==', '<' or '>' expected");
+
+	s = StripLeft(s);
+	auto value = ExpectQuoted(s);
+
+	return std::make_shared<StickerSongFilter::Predicate>(std::move(name),
+							      op,
+							      std::move(value));
+}
+
+#endif
+
 ISongFilterPtr
 SongFilter::ParseExpression(const char *&s, bool fold_case)
 {
@@ -287,6 +344,19 @@ SongFilter::ParseExpression(const char *&s, bool fold_case)
 		return std::make_unique<NotSongFilter>(std::move(inner));
 	}
 
+#ifdef ENABLE_SQLITE
+	if (auto after_sticker = StringAfterPrefix(s, "sticker:")) {
+		s = after_sticker;
+		auto predicate = ParseStickerPredicate(s);
+		if (*s != ')')
+			throw std::runtime_error("')' expected");
+		s = StripLeft(s + 1);
+
+		stickers.push_back(predicate);
+		return std::make_unique<StickerSongFilter>(std::move(predicate));
+	}
+#endif
+
 	auto type = ExpectFilterType(s);
 
 	if (type == LOCATE_TAG_MODIFIED_SINCE) {
@@ -467,6 +537,7 @@ SongFilter::WithoutBasePrefix(const char *_prefix) const noexcept
 {
 	const StringView prefix(_prefix);
 	SongFilter result;
+	result.stickers = stickers;
 
 	for (const auto &i : and_filter.GetItems()) {
 		const auto *f = dynamic_cast<const BaseSongFilter *>(i.get());
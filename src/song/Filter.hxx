@@ -21,9 +21,11 @@
 #define MPD_SONG_FILTER_HXX
 
 #include "AndSongFilter.hxx"
+#include "StickerSongFilter.hxx"
 #include "util/Compiler.h"
 
 #include <string>
+#include <vector>
 
 #include <stdint.h>
 
@@ -39,6 +41,11 @@ struct LightSong;
 class SongFilter {
 	AndSongFilter and_filter;
 
+	/**
+	 * All sticker predicates found in #and_filter.
+	 */
+	std::vector<std::shared_ptr<StickerSongFilter::Predicate>> stickers;
+
 public:
 	SongFilter() = default;
 
@@ -57,7 +64,7 @@ public:
 	std::string ToExpression() const noexcept;
 
 private:
-	static ISongFilterPtr ParseExpression(const char *&s, bool fold_case=false);
+	ISongFilterPtr ParseExpression(const char *&s, bool fold_case=false);
 
 	gcc_nonnull(2,3)
 	void Parse(const char *tag, const char *value, bool fold_case=false);
@@ -88,6 +95,15 @@ public:
 	gcc_pure
 	bool HasFoldCase() const noexcept;
 
+	/**
+	 * Returns the sticker predicates of this filter.  Their
+	 * matching songs must be loaded before Match() is called (see
+	 * sticker_song_load_filter()).
+	 */
+	const auto &GetStickerPredicates() const noexcept {
+		return stickers;
+	}
+
 	/**
 	 * Does this filter contain constraints other than "base"?
 	 */
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "StickerSongFilter.hxx"
+#include "Escape.hxx"
+#include "LightSong.hxx"
+
+std::string
+StickerSongFilter::ToExpression() const noexcept
+{
+	std::string result = "(sticker:" + predicate->name;
+
+	switch (predicate->op) {
+	case StickerOperator::EXISTS:
+		return result + ")";
+
+	case StickerOperator::EQUALS:
+		result += " == ";
+		break;
+
+	case StickerOperator::LESS_THAN:
+		result += " < ";
+		break;
+
+	case StickerOperator::GREATER_THAN:
+		result += " > ";
+		break;
+	}
+
+	return result + "\"" + EscapeFilterString(predicate->value) + "\")";
+}
+
+bool
+StickerSongFilter::Match(const LightSong &song) const noexcept
+{
+	return predicate->uris.find(song.GetURI()) != predicate->uris.end();
+}
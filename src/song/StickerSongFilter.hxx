@@ -0,0 +1,74 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_STICKER_SONG_FILTER_HXX
+#define MPD_STICKER_SONG_FILTER_HXX
+
+#include "ISongFilter.hxx"
+#include "sticker/Match.hxx"
+
+#include <string>
+#include <unordered_set>
+
+/**
+ * Match songs by the value of a sticker.  This class does not access
+ * the sticker database; the URIs of all matching songs need to be
+ * loaded before Match() is called (see sticker_song_load_filter()).
+ */
+class StickerSongFilter final : public ISongFilter {
+public:
+	/**
+	 * The sticker predicate and the songs which match it.  It is
+	 * shared by all clones of the filter, which allows loading it
+	 * after the #SongFilter has been optimized.
+	 */
+	struct Predicate {
+		std::string name;
+
+		StickerOperator op;
+
+		std::string value;
+
+		/**
+		 * The URIs of all songs whose sticker matches.
+		 */
+		std::unordered_set<std::string> uris;
+
+		Predicate(std::string &&_name, StickerOperator _op,
+			  std::string &&_value) noexcept
+			:name(std::move(_name)), op(_op),
+			 value(std::move(_value)) {}
+	};
+
+private:
+	std::shared_ptr<Predicate> predicate;
+
+public:
+	explicit StickerSongFilter(std::shared_ptr<Predicate> _predicate) noexcept
+		:predicate(std::move(_predicate)) {}
+
+	ISongFilterPtr Clone() const noexcept override {
+		return std::make_unique<StickerSongFilter>(*this);
+	}
+
+	std::string ToExpression() const noexcept override;
+	bool Match(const LightSong &song) const noexcept override;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include "lib/sqlite/Util.hxx"
 #include "fs/Path.hxx"
 #include "Idle.hxx"
+#include "Log.hxx"
 #include "util/StringCompare.hxx"
 #include "util/ScopeExit.hxx"
 
@@ -42,6 +43,8 @@ enum sticker_sql {
 	STICKER_SQL_FIND_VALUE,
 	STICKER_SQL_FIND_LT,
 	STICKER_SQL_FIND_GT,
+	STICKER_SQL_BEGIN,
+	STICKER_SQL_COMMIT,
 	STICKER_SQL_COUNT
 };
 
@@ -59,18 +62,57 @@ static const char *const sticker_sql[] = {
 	//[STICKER_SQL_DELETE_VALUE] =
 	"DELETE FROM sticker WHERE type=? AND uri=? AND name=?",
 	//[STICKER_SQL_FIND] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=?",
 
 	//[STICKER_SQL_FIND_VALUE] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=? AND value=?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=? AND value=?",
 
 	//[STICKER_SQL_FIND_LT] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=? AND value<?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=? AND value<?",
 
 	//[STICKER_SQL_FIND_GT] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=? AND value>?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=? AND value>?",
+
+	//[STICKER_SQL_BEGIN] =
+	"BEGIN",
+
+	//[STICKER_SQL_COMMIT] =
+	"COMMIT",
 };
 
+/**
+ * Commit a write transaction after this duration.
+ */
+static constexpr std::chrono::steady_clock::duration COMMIT_DELAY =
+	std::chrono::seconds(1);
+
+/**
+ * Commit a write transaction after this number of modifications.
+ */
+static constexpr unsigned COMMIT_THRESHOLD = 16384;
+
+/**
+ * Flush the #StickerDatabase::cache when it has grown to this number
+ * of entries.
+ */
+static constexpr std::size_t MAX_CACHE_SIZE = 65536;
+
+/**
+ * Execute a statement without parameters which returns no rows and
+ * reset it.
+ *
+ * Throws #SqliteError on error.
+ */
+static void
+ExecuteSimple(sqlite3_stmt *s)
+{
+	AtScopeExit(s) {
+		sqlite3_reset(s);
+	};
+
+	ExecuteCommand(s);
+}
+
 static const char sticker_sql_create[] =
 	"CREATE TABLE IF NOT EXISTS sticker("
 	"  type VARCHAR NOT NULL, "
@@ -82,13 +124,29 @@ static const char sticker_sql_create[] =
 	" sticker_value ON sticker(type, uri, name);"
 	"";
 
-StickerDatabase::StickerDatabase(Path path)
-	:db(path.c_str())
+/**
+ * Write-ahead logging makes commits much cheaper; with it, the
+ * database stays consistent with synchronous=NORMAL, and only the
+ * last transactions may be lost on power failure.
+ */
+static const char sticker_sql_journal[] =
+	"PRAGMA journal_mode=WAL;"
+	"PRAGMA synchronous=NORMAL;";
+
+StickerDatabase::StickerDatabase(EventLoop &event_loop, Path path)
+	:db(path.c_str()),
+	 commit_timer(event_loop, BIND_THIS_METHOD(OnCommitTimer))
 {
 	assert(!path.IsNull());
 
 	int ret;
 
+	ret = sqlite3_exec(db, sticker_sql_journal,
+			   nullptr, nullptr, nullptr);
+	if (ret != SQLITE_OK)
+		throw SqliteError(db, ret,
+				  "Failed to enable the sticker journal");
+
 	/* create the table and index */
 
 	ret = sqlite3_exec(db, sticker_sql_create,
@@ -110,6 +168,13 @@ StickerDatabase::~StickerDatabase() noexcept
 {
 	assert(db != nullptr);
 
+	try {
+		Commit();
+	} catch (...) {
+		LogError(std::current_exception(),
+			 "Failed to commit sticker database");
+	}
+
 	for (unsigned i = 0; i < std::size(stmt); ++i) {
 		assert(stmt[i] != nullptr);
 
@@ -117,6 +182,66 @@ StickerDatabase::~StickerDatabase() noexcept
 	}
 }
 
+void
+StickerDatabase::Commit()
+{
+	if (!in_transaction)
+		return;
+
+	commit_timer.Cancel();
+
+	ExecuteSimple(stmt[STICKER_SQL_COMMIT]);
+	in_transaction = false;
+	pending_writes = 0;
+}
+
+void
+StickerDatabase::BeginWrite()
+{
+	if (in_transaction)
+		return;
+
+	ExecuteSimple(stmt[STICKER_SQL_BEGIN]);
+	in_transaction = true;
+
+	commit_timer.Schedule(COMMIT_DELAY);
+}
+
+void
+StickerDatabase::EndWrite()
+{
+	assert(in_transaction);
+
+	if (++pending_writes >= COMMIT_THRESHOLD)
+		Commit();
+}
+
+void
+StickerDatabase::OnCommitTimer() noexcept
+{
+	try {
+		Commit();
+	} catch (...) {
+		LogError(std::current_exception(),
+			 "Failed to commit sticker database");
+
+		/* try again later */
+		commit_timer.Schedule(COMMIT_DELAY);
+	}
+}
+
+std::string
+StickerDatabase::MakeCacheKey(const char *type, const char *uri,
+			      const char *name) noexcept
+{
+	std::string key(type);
+	key.push_back('\0');
+	key.append(uri);
+	key.push_back('\0');
+	key.append(name);
+	return key;
+}
+
 std::string
 StickerDatabase::LoadValue(const char *type, const char *uri, const char *name)
 {
@@ -129,6 +254,11 @@ StickerDatabase::LoadValue(const char *type, const char *uri, const char *name)
 	if (StringIsEmpty(name))
 		return std::string();
 
+	auto key = MakeCacheKey(type, uri, name);
+	auto i = cache.find(key);
+	if (i != cache.end())
+		return i->second;
+
 	BindAll(s, type, uri, name);
 
 	AtScopeExit(s) {
@@ -140,6 +270,10 @@ StickerDatabase::LoadValue(const char *type, const char *uri, const char *name)
 	if (ExecuteRow(s))
 		value = (const char*)sqlite3_column_text(s, 0);
 
+	if (cache.size() >= MAX_CACHE_SIZE)
+		cache.clear();
+
+	cache.emplace(std::move(key), value);
 	return value;
 }
 
@@ -185,7 +319,9 @@ StickerDatabase::UpdateValue(const char *type, const char *uri,
 		sqlite3_clear_bindings(s);
 	};
 
+	BeginWrite();
 	bool modified = ExecuteModified(s);
+	EndWrite();
 
 	if (modified)
 		idle_add(IDLE_STICKER);
@@ -211,7 +347,10 @@ StickerDatabase::InsertValue(const char *type, const char *uri,
 		sqlite3_clear_bindings(s);
 	};
 
+	BeginWrite();
 	ExecuteCommand(s);
+	EndWrite();
+
 	idle_add(IDLE_STICKER);
 }
 
@@ -229,6 +368,10 @@ StickerDatabase::StoreValue(const char *type, const char *uri,
 
 	if (!UpdateValue(type, uri, name, value))
 		InsertValue(type, uri, name, value);
+
+	auto i = cache.find(MakeCacheKey(type, uri, name));
+	if (i != cache.end())
+		i->second = value;
 }
 
 bool
@@ -246,7 +389,17 @@ StickerDatabase::Delete(const char *type, const char *uri)
 		sqlite3_clear_bindings(s);
 	};
 
+	BeginWrite();
 	bool modified = ExecuteModified(s);
+	EndWrite();
+
+	/* forget all cached values of this object */
+	const auto prefix = MakeCacheKey(type, uri, "");
+	auto i = cache.lower_bound(prefix);
+	while (i != cache.end() &&
+	       i->first.compare(0, prefix.length(), prefix) == 0)
+		i = cache.erase(i);
+
 	if (modified)
 		idle_add(IDLE_STICKER);
 	return modified;
@@ -268,7 +421,14 @@ StickerDatabase::DeleteValue(const char *type, const char *uri,
 		sqlite3_clear_bindings(s);
 	};
 
+	BeginWrite();
 	bool modified = ExecuteModified(s);
+	EndWrite();
+
+	auto i = cache.find(MakeCacheKey(type, uri, name));
+	if (i != cache.end())
+		i->second.clear();
+
 	if (modified)
 		idle_add(IDLE_STICKER);
 	return modified;
@@ -284,6 +444,47 @@ StickerDatabase::Load(const char *type, const char *uri)
 	return s;
 }
 
+/**
+ * Calculate the smallest string which is larger than all strings
+ * starting with the given prefix.  Returns false if there is no
+ * such string (i.e. the prefix is empty or consists only of 0xff
+ * bytes).
+ */
+static bool
+PrefixEnd(std::string &end)
+{
+	while (!end.empty() && (unsigned char)end.back() == 0xff)
+		end.pop_back();
+
+	if (end.empty())
+		return false;
+
+	++end.back();
+	return true;
+}
+
+static sqlite3_stmt *
+BindFindRange(sqlite3_stmt *s, const char *type, const char *base_uri)
+{
+	std::string end(base_uri);
+	const bool bounded = PrefixEnd(end);
+
+	/* the end is parameter 3; SQLITE_TRANSIENT because the
+	   std::string goes out of scope */
+	const int result = bounded
+		? sqlite3_bind_text(s, 3, end.data(), end.length(),
+				    SQLITE_TRANSIENT)
+		/* any BLOB compares larger than all TEXT values,
+		   which makes the range unbounded */
+		: sqlite3_bind_zeroblob(s, 3, 0);
+	if (result != SQLITE_OK)
+		throw SqliteError(s, result, "sqlite3_bind() failed");
+
+	Bind(s, 1, type);
+	Bind(s, 2, base_uri);
+	return s;
+}
+
 sqlite3_stmt *
 StickerDatabase::BindFind(const char *type, const char *base_uri,
 			  const char *name,
@@ -295,25 +496,35 @@ StickerDatabase::BindFind(const char *type, const char *base_uri,
 	if (base_uri == nullptr)
 		base_uri = "";
 
+	/* instead of "uri LIKE (? || '%')", which cannot use the
+	   index, the prefix is looked up as a range */
+
+	sqlite3_stmt *s;
+
 	switch (op) {
 	case StickerOperator::EXISTS:
-		BindAll(stmt[STICKER_SQL_FIND], type, base_uri, name);
-		return stmt[STICKER_SQL_FIND];
+		s = BindFindRange(stmt[STICKER_SQL_FIND], type, base_uri);
+		Bind(s, 4, name);
+		return s;
 
 	case StickerOperator::EQUALS:
-		BindAll(stmt[STICKER_SQL_FIND_VALUE],
-			type, base_uri, name, value);
-		return stmt[STICKER_SQL_FIND_VALUE];
+		s = BindFindRange(stmt[STICKER_SQL_FIND_VALUE],
+				  type, base_uri);
+		Bind(s, 4, name);
+		Bind(s, 5, value);
+		return s;
 
 	case StickerOperator::LESS_THAN:
-		BindAll(stmt[STICKER_SQL_FIND_LT],
-			type, base_uri, name, value);
-		return stmt[STICKER_SQL_FIND_LT];
+		s = BindFindRange(stmt[STICKER_SQL_FIND_LT], type, base_uri);
+		Bind(s, 4, name);
+		Bind(s, 5, value);
+		return s;
 
 	case StickerOperator::GREATER_THAN:
-		BindAll(stmt[STICKER_SQL_FIND_GT],
-			type, base_uri, name, value);
-		return stmt[STICKER_SQL_FIND_GT];
+		s = BindFindRange(stmt[STICKER_SQL_FIND_GT], type, base_uri);
+		Bind(s, 4, name);
+		Bind(s, 5, value);
+		return s;
 	}
 
 	assert(false);
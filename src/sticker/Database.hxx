@@ -44,6 +44,7 @@
 
 #include "Match.hxx"
 #include "lib/sqlite/Database.hxx"
+#include "event/TimerEvent.hxx"
 
 #include <sqlite3.h>
 
@@ -51,6 +52,7 @@
 #include <string>
 
 class Path;
+class EventLoop;
 struct Sticker;
 
 class StickerDatabase {
@@ -65,6 +67,8 @@ class StickerDatabase {
 		  SQL_FIND_VALUE,
 		  SQL_FIND_LT,
 		  SQL_FIND_GT,
+		  SQL_BEGIN,
+		  SQL_COMMIT,
 
 		  SQL_COUNT
 	};
@@ -72,13 +76,44 @@ class StickerDatabase {
 	Sqlite::Database db;
 	sqlite3_stmt *stmt[SQL_COUNT];
 
+	/**
+	 * Commits the pending write transaction (see #in_transaction)
+	 * shortly after the first modification.
+	 */
+	TimerEvent commit_timer;
+
+	/**
+	 * Is a write transaction open?  Modifications are collected
+	 * in one transaction which is committed by #commit_timer or
+	 * after a number of writes, because committing each of them
+	 * separately is very expensive.  Reads on this connection see
+	 * the uncommitted modifications.
+	 */
+	bool in_transaction = false;
+
+	/**
+	 * The number of modifications in the current transaction.
+	 */
+	unsigned pending_writes = 0;
+
+	/**
+	 * Cached results of LoadValue().  The key is built by
+	 * MakeCacheKey(); a missing value is cached as an empty
+	 * string, just like LoadValue() returns it.
+	 */
+	std::map<std::string, std::string> cache;
+
 public:
 	/**
 	 * Opens the sticker database.
 	 *
 	 * Throws on error.
 	 */
-	StickerDatabase(Path path);
+	StickerDatabase(EventLoop &event_loop, Path path);
+
+	/**
+	 * Commits pending modifications and closes the database.
+	 */
 	~StickerDatabase() noexcept;
 
 	/**
@@ -142,7 +177,34 @@ public:
 			       void *user_data),
 		  void *user_data);
 
+	/**
+	 * Commit the pending write transaction now.
+	 *
+	 * Throws #SqliteError on error.
+	 */
+	void Commit();
+
 private:
+	/**
+	 * Open a write transaction unless one is already open.
+	 *
+	 * Throws #SqliteError on error.
+	 */
+	void BeginWrite();
+
+	/**
+	 * Account for a modification; commit the transaction if it
+	 * has become too large.
+	 *
+	 * Throws #SqliteError on error.
+	 */
+	void EndWrite();
+
+	void OnCommitTimer() noexcept;
+
+	static std::string MakeCacheKey(const char *type, const char *uri,
+					 const char *name) noexcept;
+
 	void ListValues(std::map<std::string, std::string> &table,
 			const char *type, const char *uri);
 
@@ -22,6 +22,7 @@
 #include "Database.hxx"
 #include "song/LightSong.hxx"
 #include "db/Interface.hxx"
+#include "song/Filter.hxx"
 #include "util/Alloc.hxx"
 #include "util/ScopeExit.hxx"
 
@@ -133,3 +134,25 @@ sticker_song_find(StickerDatabase &sticker_database, const Database &db,
 	sticker_database.Find("song", data.base_uri, name, op, value,
 			      sticker_song_find_cb, &data);
 }
+
+static void
+sticker_song_load_filter_cb(const char *uri, gcc_unused const char *value,
+			    void *user_data)
+{
+	auto &uris = *(std::unordered_set<std::string> *)user_data;
+	uris.emplace(uri);
+}
+
+void
+sticker_song_load_filter(StickerDatabase &sticker_database,
+			 const SongFilter &filter)
+{
+	for (const auto &i : filter.GetStickerPredicates()) {
+		i->uris.clear();
+		sticker_database.Find("song", nullptr, i->name.c_str(), i->op,
+				      i->op == StickerOperator::EXISTS
+				      ? nullptr
+				      : i->value.c_str(),
+				      sticker_song_load_filter_cb, &i->uris);
+	}
+}
@@ -28,6 +28,7 @@ struct LightSong;
 struct Sticker;
 class Database;
 class StickerDatabase;
+class SongFilter;
 
 /**
  * Returns one value from a song's sticker record.
@@ -100,4 +101,14 @@ sticker_song_find(StickerDatabase &sticker_database, const Database &db,
 			       void *user_data),
 		  void *user_data);
 
+/**
+ * Load the songs matching all sticker predicates of the given
+ * filter, so it can be evaluated during a database visit.
+ *
+ * Throws #SqliteError on error.
+ */
+void
+sticker_song_load_filter(StickerDatabase &sticker_database,
+			 const SongFilter &filter);
+
 #endif
@@ -30,8 +30,11 @@
 #include "Util.hxx"
 #include "system/Error.hxx"
 
+#include <stdexcept>
+
 #ifdef __linux__
 #include <sched.h>
+#include <sys/resource.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 #elif defined(_WIN32)
@@ -100,15 +103,88 @@ void
 SetThreadRealtime()
 {
 #ifdef __linux__
+	SetThreadScheduler(ThreadScheduler::FIFO, 50);
+#endif	// __linux__
+};
+
+#ifdef __linux__
+
+static int
+ToLinuxPolicy(ThreadScheduler scheduler)
+{
+	switch (scheduler) {
+	case ThreadScheduler::OTHER:
+		return SCHED_OTHER;
+
+	case ThreadScheduler::BATCH:
+#ifdef SCHED_BATCH
+		return SCHED_BATCH;
+#else
+		break;
+#endif
+
+	case ThreadScheduler::IDLE:
+#ifdef SCHED_IDLE
+		return SCHED_IDLE;
+#else
+		break;
+#endif
+
+	case ThreadScheduler::FIFO:
+		return SCHED_FIFO;
+
+	case ThreadScheduler::RR:
+		return SCHED_RR;
+	}
+
+	throw std::invalid_argument("Scheduling policy not supported");
+}
+
+#endif
+
+void
+SetThreadScheduler(ThreadScheduler scheduler, int priority)
+{
+#ifdef __linux__
+	const bool realtime = scheduler == ThreadScheduler::FIFO ||
+		scheduler == ThreadScheduler::RR;
+
 	struct sched_param sched_param;
-	sched_param.sched_priority = 50;
+	sched_param.sched_priority = realtime ? priority : 0;
 
-	int policy = SCHED_FIFO;
+	int policy = ToLinuxPolicy(scheduler);
 #ifdef SCHED_RESET_ON_FORK
-	policy |= SCHED_RESET_ON_FORK;
+	if (realtime)
+		policy |= SCHED_RESET_ON_FORK;
 #endif
 
 	if (linux_sched_setscheduler(0, policy, &sched_param) < 0)
 		throw MakeErrno("sched_setscheduler failed");
-#endif	// __linux__
-};
+
+	/* on Linux, the "nice" value is a per-thread attribute */
+	if (!realtime && setpriority(PRIO_PROCESS, 0, priority) < 0)
+		throw MakeErrno("setpriority failed");
+#else
+	(void)scheduler;
+	(void)priority;
+	throw std::runtime_error("Thread scheduling not supported on this platform");
+#endif
+}
+
+void
+SetThreadAffinity(uint64_t cpu_mask)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (unsigned i = 0; i < 64; ++i)
+		if (cpu_mask & (uint64_t(1) << i))
+			CPU_SET(i, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set) < 0)
+		throw MakeErrno("sched_setaffinity failed");
+#else
+	(void)cpu_mask;
+	throw std::runtime_error("CPU affinity not supported on this platform");
+#endif
+}
@@ -30,6 +30,16 @@
 #ifndef THREAD_UTIL_HXX
 #define THREAD_UTIL_HXX
 
+#include <stdint.h>
+
+enum class ThreadScheduler {
+	OTHER,
+	BATCH,
+	IDLE,
+	FIFO,
+	RR,
+};
+
 /**
  * Lower the current thread's priority to "idle" (very low).
  */
@@ -44,4 +54,24 @@ SetThreadIdlePriority() noexcept;
 void
 SetThreadRealtime();
 
+/**
+ * Set the current thread's scheduling policy.  For the real-time
+ * policies (#ThreadScheduler::FIFO and #ThreadScheduler::RR),
+ * #priority is the static priority (1..99); for all others, it is
+ * the "nice" value (-20..19).
+ *
+ * Throws std::system_error on error.
+ */
+void
+SetThreadScheduler(ThreadScheduler scheduler, int priority);
+
+/**
+ * Restrict the current thread to the given CPUs.  Bit N of the
+ * mask enables CPU N.
+ *
+ * Throws std::system_error on error.
+ */
+void
+SetThreadAffinity(uint64_t cpu_mask);
+
 #endif
@@ -0,0 +1,394 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "PipelineTrace.hxx"
+#include "fs/io/FileOutputStream.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Thread.hxx"
+#include "thread/Name.hxx"
+#include "Log.hxx"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+
+#ifdef HAVE_PRCTL
+#include <sys/prctl.h>
+#endif
+
+namespace PipelineTrace {
+
+std::atomic_bool enabled{false};
+
+namespace {
+
+/**
+ * One slot in the ring buffer.  All fields are atomic so a
+ * concurrent Dump() never reads torn values; #sequence works like a
+ * seqlock: it is zero while the slot is being written, and the
+ * (1-based) event number after that.
+ */
+struct Entry {
+	std::atomic<uint64_t> sequence{0};
+	std::atomic<uint64_t> time{0};
+	std::atomic<const char *> name{nullptr};
+	std::atomic<uint32_t> value{0};
+	std::atomic<uint16_t> tid{0};
+	std::atomic<PipelineTraceEvent> event{PipelineTraceEvent::XRUN};
+};
+
+static std::array<Entry, CAPACITY> ring;
+
+static std::atomic<uint64_t> head{0};
+
+/**
+ * The names of the threads which have recorded events, indexed by
+ * their trace thread id.
+ */
+struct ThreadInfo {
+	std::atomic_bool valid{false};
+	char name[16];
+};
+
+static constexpr unsigned MAX_THREADS = 64;
+
+static std::array<ThreadInfo, MAX_THREADS> threads;
+
+static std::atomic_uint next_tid{0};
+
+static thread_local uint16_t current_tid = 0;
+
+/**
+ * A copy of everything which is written by Dump().
+ */
+struct DumpData {
+	/**
+	 * The names of all known threads, indexed by the trace
+	 * thread id.
+	 */
+	std::vector<std::pair<unsigned, std::string>> threads;
+
+	std::vector<Event> events;
+};
+
+/**
+ * Protects #dump_path, #dump_running, #pending_path and
+ * #pending_dump.
+ */
+static Mutex dump_mutex;
+
+static AllocatedPath dump_path = nullptr;
+
+/**
+ * Is #dump_thread currently writing #pending_dump to
+ * #pending_path?  While this is true, only #dump_thread accesses
+ * these two.
+ */
+static bool dump_running = false;
+
+static AllocatedPath pending_path = nullptr;
+static DumpData pending_dump;
+
+} // namespace
+
+static void
+DumpThreadFunction() noexcept;
+
+static Thread dump_thread(BIND_FUNCTION(DumpThreadFunction));
+
+static uint16_t
+RegisterThread() noexcept
+{
+	const unsigned tid = ++next_tid;
+	if (tid < MAX_THREADS) {
+		auto &info = threads[tid];
+		info.name[0] = 0;
+#if defined(HAVE_PRCTL) && defined(PR_GET_NAME)
+		prctl(PR_GET_NAME, (unsigned long)info.name, 0, 0, 0);
+		info.name[sizeof(info.name) - 1] = 0;
+#endif
+		info.valid.store(true, std::memory_order_release);
+	}
+
+	return uint16_t(tid);
+}
+
+static uint64_t
+Now() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+SetEnabled(bool _enabled) noexcept
+{
+	enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+void
+Record(PipelineTraceEvent event, const char *name, unsigned value) noexcept
+{
+	if (current_tid == 0)
+		current_tid = RegisterThread();
+
+	const uint64_t n = head.fetch_add(1, std::memory_order_relaxed);
+	auto &e = ring[n % CAPACITY];
+
+	e.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	e.time.store(Now(), std::memory_order_relaxed);
+	e.name.store(name, std::memory_order_relaxed);
+	e.value.store(value, std::memory_order_relaxed);
+	e.tid.store(current_tid, std::memory_order_relaxed);
+	e.event.store(event, std::memory_order_relaxed);
+
+	e.sequence.store(n + 1, std::memory_order_release);
+}
+
+static void
+WriteJsonString(BufferedOutputStream &os, const char *s)
+{
+	os.Write('"');
+
+	for (; *s != 0; ++s) {
+		const unsigned char ch = *s;
+		if (ch == '"' || ch == '\\') {
+			os.Write('\\');
+			os.Write(*s);
+		} else if (ch < 0x20)
+			os.Format("\\u%04x", ch);
+		else
+			os.Write(*s);
+	}
+
+	os.Write('"');
+}
+
+static bool
+ReadEntry(uint64_t n, Event &s) noexcept
+{
+	const auto &e = ring[n % CAPACITY];
+
+	if (e.sequence.load(std::memory_order_acquire) != n + 1)
+		return false;
+
+	s.time = e.time.load(std::memory_order_relaxed);
+	s.name = e.name.load(std::memory_order_relaxed);
+	s.value = e.value.load(std::memory_order_relaxed);
+	s.tid = e.tid.load(std::memory_order_relaxed);
+	s.event = e.event.load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return e.sequence.load(std::memory_order_relaxed) == n + 1;
+}
+
+static void
+WriteEvent(BufferedOutputStream &os, const Event &s, uint64_t start)
+{
+	const double ts = int64_t(s.time - start) / 1000.;
+
+	switch (s.event) {
+	case PipelineTraceEvent::CHUNK_PRODUCED:
+	case PipelineTraceEvent::CHUNK_CONSUMED:
+		os.Format("{\"name\":\"pipe\",\"ph\":\"C\",\"ts\":%.3f,"
+			  "\"pid\":1,\"tid\":%u,\"args\":{\"chunks\":%u}}",
+			  ts, s.tid, s.value);
+		break;
+
+	case PipelineTraceEvent::PLAYER_WAIT_BEGIN:
+	case PipelineTraceEvent::PLAYER_WAIT_END:
+		os.Format("{\"name\":\"wait for decoder\",\"ph\":\"%c\","
+			  "\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+			  s.event == PipelineTraceEvent::PLAYER_WAIT_BEGIN
+			  ? 'B' : 'E',
+			  ts, s.tid);
+		break;
+
+	case PipelineTraceEvent::OUTPUT_WAIT_BEGIN:
+	case PipelineTraceEvent::OUTPUT_WAIT_END:
+		os.Format("{\"name\":\"wait for chunk\",\"ph\":\"%c\","
+			  "\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+			  s.event == PipelineTraceEvent::OUTPUT_WAIT_BEGIN
+			  ? 'B' : 'E',
+			  ts, s.tid);
+		break;
+
+	case PipelineTraceEvent::XRUN:
+		os.Format("{\"name\":\"xrun\",\"ph\":\"i\",\"s\":\"g\","
+			  "\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"device\":",
+			  ts, s.tid);
+		WriteJsonString(os, s.name != nullptr ? s.name : "");
+		os.Write("}}");
+		break;
+	}
+}
+
+std::vector<Event>
+Collect()
+{
+	const uint64_t end = head.load(std::memory_order_acquire);
+	const uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+	std::vector<Event> events;
+	events.reserve(end - begin);
+
+	for (uint64_t n = begin; n < end; ++n) {
+		Event e;
+		if (ReadEntry(n, e))
+			events.push_back(e);
+		/* else: being overwritten right now */
+	}
+
+	return events;
+}
+
+static DumpData
+CollectDumpData()
+{
+	DumpData data;
+
+	const unsigned n_threads = std::min(next_tid.load(),
+					    MAX_THREADS - 1);
+	for (unsigned tid = 1; tid <= n_threads; ++tid) {
+		const auto &info = threads[tid];
+		if (info.valid.load(std::memory_order_acquire))
+			data.threads.emplace_back(tid, info.name);
+	}
+
+	data.events = Collect();
+	return data;
+}
+
+static void
+WriteJson(BufferedOutputStream &os, const DumpData &data)
+{
+	os.Write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	bool first = true;
+
+	/* thread names */
+	for (const auto &i : data.threads) {
+		if (!first)
+			os.Write(",\n");
+		first = false;
+
+		os.Format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+			  "\"tid\":%u,\"args\":{\"name\":", i.first);
+		WriteJsonString(os, i.second.c_str());
+		os.Write("}}");
+	}
+
+	const uint64_t start = data.events.empty()
+		? 0
+		: data.events.front().time;
+
+	for (const auto &e : data.events) {
+		if (!first)
+			os.Write(",\n");
+		first = false;
+
+		WriteEvent(os, e, start);
+	}
+
+	os.Write("\n]}\n");
+}
+
+static void
+WriteFile(Path path, const DumpData &data)
+{
+	FileOutputStream fos(path);
+	BufferedOutputStream bos(fos);
+	WriteJson(bos, data);
+	bos.Flush();
+	fos.Commit();
+}
+
+void
+Dump(Path path)
+{
+	WriteFile(path, CollectDumpData());
+}
+
+void
+SetDumpPath(AllocatedPath &&path) noexcept
+{
+	const std::lock_guard<Mutex> lock(dump_mutex);
+	dump_path = std::move(path);
+}
+
+static void
+DumpThreadFunction() noexcept
+{
+	SetThreadName("trace");
+
+	std::unique_lock<Mutex> lock(dump_mutex);
+
+	try {
+		const ScopeUnlock unlock(dump_mutex);
+		WriteFile(pending_path, pending_dump);
+	} catch (...) {
+		LogError(std::current_exception());
+	}
+
+	pending_path = nullptr;
+	pending_dump = {};
+	dump_running = false;
+}
+
+void
+DumpDefault()
+{
+	const std::lock_guard<Mutex> lock(dump_mutex);
+	if (dump_path.IsNull())
+		throw std::runtime_error("No pipeline_trace_file configured");
+
+	if (dump_running)
+		throw std::runtime_error("Pipeline trace dump already in progress");
+
+	if (dump_thread.IsDefined())
+		/* the previous dump has finished; clean up */
+		dump_thread.Join();
+
+	pending_path = dump_path;
+	pending_dump = CollectDumpData();
+
+	dump_running = true;
+	try {
+		dump_thread.Start();
+	} catch (...) {
+		dump_running = false;
+		pending_path = nullptr;
+		pending_dump = {};
+		throw;
+	}
+}
+
+void
+Deinit() noexcept
+{
+	if (dump_thread.IsDefined())
+		dump_thread.Join();
+}
+
+} // namespace PipelineTrace
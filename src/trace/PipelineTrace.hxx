@@ -0,0 +1,183 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PIPELINE_TRACE_HXX
+#define MPD_PIPELINE_TRACE_HXX
+
+#include "util/Compiler.h"
+
+#include <atomic>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Path;
+class AllocatedPath;
+
+enum class PipelineTraceEvent : uint8_t {
+	/**
+	 * The decoder has pushed a chunk to the #MusicPipe; the value
+	 * is the new pipe size.
+	 */
+	CHUNK_PRODUCED,
+
+	/**
+	 * The player has submitted a chunk to the outputs; the value
+	 * is the remaining pipe size.
+	 */
+	CHUNK_CONSUMED,
+
+	/**
+	 * The player is waiting for the decoder because the pipe is
+	 * empty.
+	 */
+	PLAYER_WAIT_BEGIN,
+	PLAYER_WAIT_END,
+
+	/**
+	 * An output thread is waiting for the next chunk; the output
+	 * is identified by the thread name.
+	 */
+	OUTPUT_WAIT_BEGIN,
+	OUTPUT_WAIT_END,
+
+	/**
+	 * An audio device reported a buffer underrun; the name
+	 * identifies the device.
+	 */
+	XRUN,
+};
+
+/**
+ * A lock-free ring buffer of timestamped events in the playback
+ * pipeline (decoder, #MusicPipe, player and outputs), which can be
+ * dumped as a Chrome "trace event" JSON file to find out which stage
+ * starved when a dropout occurred.
+ *
+ * When disabled, recording costs only one relaxed atomic load.
+ */
+namespace PipelineTrace {
+
+/**
+ * The number of events kept in the ring buffer; older ones are
+ * overwritten.
+ */
+static constexpr size_t CAPACITY = 32768;
+
+/**
+ * A copy of one recorded event.
+ */
+struct Event {
+	/**
+	 * The std::chrono::steady_clock time in nanoseconds.
+	 */
+	uint64_t time;
+
+	const char *name;
+	uint32_t value;
+
+	/**
+	 * The trace thread id (1-based).
+	 */
+	uint16_t tid;
+
+	PipelineTraceEvent event;
+};
+
+extern std::atomic_bool enabled;
+
+gcc_pure
+static inline bool
+IsEnabled() noexcept
+{
+	return gcc_unlikely(enabled.load(std::memory_order_relaxed));
+}
+
+void
+SetEnabled(bool _enabled) noexcept;
+
+/**
+ * Record an event unconditionally; use Emit() unless the caller has
+ * already checked IsEnabled().
+ *
+ * This function is thread-safe and does not block.
+ *
+ * @param name a string which must remain valid until the process
+ * exits (or nullptr)
+ */
+void
+Record(PipelineTraceEvent event, const char *name,
+       unsigned value) noexcept;
+
+static inline void
+Emit(PipelineTraceEvent event, const char *name=nullptr,
+     unsigned value=0) noexcept
+{
+	if (IsEnabled())
+		Record(event, name, value);
+}
+
+/**
+ * Copy all events which are currently in the ring buffer, oldest
+ * first.  Events which are being overwritten concurrently are
+ * skipped, and so are the rare events which were overwritten by a
+ * writer that had fallen one lap behind.
+ *
+ * This function is thread-safe and does not block the threads which
+ * record events.
+ */
+std::vector<Event>
+Collect();
+
+/**
+ * Write all recorded events to a file in the Chrome trace event
+ * JSON format.
+ *
+ * Throws on error.
+ */
+void
+Dump(Path path);
+
+/**
+ * Set the file which is written by DumpDefault().
+ */
+void
+SetDumpPath(AllocatedPath &&path) noexcept;
+
+/**
+ * Copy all recorded events and write them to the file configured
+ * with SetDumpPath() in a new thread, which logs errors.  This
+ * avoids blocking the caller (i.e. the main thread) with file I/O.
+ *
+ * Throws if no file is configured, if a dump is already in
+ * progress or if the thread cannot be started.
+ */
+void
+DumpDefault();
+
+/**
+ * Wait for the thread started by DumpDefault() to finish.
+ */
+void
+Deinit() noexcept;
+
+} // namespace PipelineTrace
+
+#endif
@@ -25,6 +25,7 @@
 #include "Log.hxx"
 #include "LogInit.hxx"
 #include "event/Loop.hxx"
+#include "trace/PipelineTrace.hxx"
 #include "system/Error.hxx"
 #include "util/Domain.hxx"
 
@@ -53,6 +54,18 @@ handle_reload_event(void *) noexcept
 	cycle_log_files();
 }
 
+static void
+HandleDumpTraceSignal(void *) noexcept
+{
+	LogDebug(signal_handlers_domain, "got SIGUSR2, dumping pipeline trace");
+
+	try {
+		PipelineTrace::DumpDefault();
+	} catch (...) {
+		LogError(std::current_exception());
+	}
+}
+
 #endif
 
 void
@@ -72,6 +85,7 @@ SignalHandlersInit(EventLoop &loop)
 	SignalMonitorRegister(SIGTERM, {&loop, HandleShutdownSignal});
 
 	SignalMonitorRegister(SIGHUP, {nullptr, handle_reload_event});
+	SignalMonitorRegister(SIGUSR2, {nullptr, HandleDumpTraceSignal});
 #endif
 }
 
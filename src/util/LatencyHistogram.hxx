@@ -0,0 +1,118 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_LATENCY_HISTOGRAM_HXX
+#define MPD_LATENCY_HISTOGRAM_HXX
+
+#include <chrono>
+#include <array>
+
+#include <stdint.h>
+
+/**
+ * A histogram of durations with logarithmic buckets: bucket 0 counts
+ * durations below one microsecond, bucket i (i>0) counts durations
+ * in the range [2^(i-1), 2^i) microseconds.  Percentiles are
+ * therefore approximations; they are rounded up to the upper bound
+ * of their bucket, but never exceed the maximum.
+ *
+ * This class is not thread-safe.
+ */
+class LatencyHistogram {
+public:
+	typedef std::chrono::steady_clock::duration Duration;
+
+private:
+	static constexpr unsigned N_BUCKETS = 40;
+
+	std::array<uint64_t, N_BUCKETS> buckets{};
+
+	uint64_t count = 0;
+
+	Duration sum = Duration::zero(), max = Duration::zero();
+
+public:
+	void Add(Duration d) noexcept {
+		if (d < Duration::zero())
+			d = Duration::zero();
+
+		++buckets[BucketOf(d)];
+		++count;
+		sum += d;
+		if (d > max)
+			max = d;
+	}
+
+	uint64_t GetCount() const noexcept {
+		return count;
+	}
+
+	Duration GetSum() const noexcept {
+		return sum;
+	}
+
+	Duration GetMax() const noexcept {
+		return max;
+	}
+
+	/**
+	 * Returns an upper bound for the given percentile (0..100)
+	 * of all durations added so far.
+	 */
+	Duration GetPercentile(double percentile) const noexcept {
+		if (count == 0)
+			return Duration::zero();
+
+		/* the rank of the requested sample, 1-based */
+		uint64_t rank = uint64_t(count * percentile / 100. + .5);
+		if (rank < 1)
+			rank = 1;
+		else if (rank > count)
+			rank = count;
+
+		uint64_t seen = 0;
+		for (unsigned i = 0; i < N_BUCKETS; ++i) {
+			seen += buckets[i];
+			if (seen >= rank) {
+				const Duration upper = UpperBoundOf(i);
+				return upper < max ? upper : max;
+			}
+		}
+
+		return max;
+	}
+
+private:
+	static unsigned BucketOf(Duration d) noexcept {
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+		unsigned i = 0;
+		while (us > 0 && i < N_BUCKETS - 1) {
+			us >>= 1;
+			++i;
+		}
+
+		return i;
+	}
+
+	static constexpr Duration UpperBoundOf(unsigned i) noexcept {
+		return std::chrono::microseconds(uint64_t(1) << i);
+	}
+};
+
+#endif
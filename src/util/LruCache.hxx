@@ -0,0 +1,157 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_LRU_CACHE_HXX
+#define MPD_LRU_CACHE_HXX
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <utility>
+
+/**
+ * A small key/value cache which evicts the least recently used item
+ * when it is full.  Lookups take O(log n) in a std::map; the usage
+ * order is kept in a std::list.
+ *
+ * This class is not thread-safe.
+ *
+ * @param capacity the maximum number of items
+ */
+template<typename K, typename V, std::size_t capacity>
+class LruCache {
+	static_assert(capacity > 0, "Capacity must not be zero");
+
+	struct Item {
+		K key;
+		V value;
+
+		template<typename KK, typename VV>
+		Item(KK &&_key, VV &&_value)
+			:key(std::forward<KK>(_key)),
+			 value(std::forward<VV>(_value)) {}
+	};
+
+	using ItemList = std::list<Item>;
+
+	/**
+	 * All items, the most recently used first.
+	 */
+	ItemList items;
+
+	/**
+	 * Indexes #items by key.  The transparent comparison allows
+	 * looking up a std::string key with a C string.
+	 */
+	std::map<K, typename ItemList::iterator, std::less<>> map;
+
+public:
+	std::size_t size() const noexcept {
+		return items.size();
+	}
+
+	bool empty() const noexcept {
+		return items.empty();
+	}
+
+	/**
+	 * Look up an item and mark it as the most recently used one.
+	 *
+	 * @return a pointer to the value or nullptr if there is no
+	 * such item
+	 */
+	template<typename KK>
+	V *Get(const KK &key) noexcept {
+		auto i = map.find(key);
+		if (i == map.end())
+			return nullptr;
+
+		items.splice(items.begin(), items, i->second);
+		return &i->second->value;
+	}
+
+	/**
+	 * Add an item or replace the value of an existing one, and
+	 * mark it as the most recently used one.  If the cache is
+	 * full, the least recently used item is evicted.
+	 *
+	 * @return a reference to the value
+	 */
+	template<typename KK, typename VV>
+	V &Put(KK &&key, VV &&value) {
+		auto i = map.find(key);
+		if (i != map.end()) {
+			items.splice(items.begin(), items, i->second);
+			i->second->value = std::forward<VV>(value);
+			return i->second->value;
+		}
+
+		if (items.size() >= capacity) {
+			map.erase(items.back().key);
+			items.pop_back();
+		}
+
+		items.emplace_front(key, std::forward<VV>(value));
+
+		try {
+			map.emplace(std::forward<KK>(key), items.begin());
+		} catch (...) {
+			items.pop_front();
+			throw;
+		}
+
+		return items.front().value;
+	}
+
+	/**
+	 * Remove the item with the given key (if it exists).
+	 */
+	template<typename KK>
+	void Remove(const KK &key) noexcept {
+		auto i = map.find(key);
+		if (i == map.end())
+			return;
+
+		items.erase(i->second);
+		map.erase(i);
+	}
+
+	/**
+	 * Remove all items matching the given predicate, which is
+	 * invoked with the key and the value.
+	 */
+	template<typename P>
+	void RemoveIf(P &&p) noexcept {
+		for (auto i = items.begin(); i != items.end();) {
+			if (p(i->key, i->value)) {
+				map.erase(i->key);
+				i = items.erase(i);
+			} else
+				++i;
+		}
+	}
+
+	void Clear() noexcept {
+		map.clear();
+		items.clear();
+	}
+};
+
+#endif
@@ -0,0 +1,644 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_RANK_TREE_HXX
+#define MPD_RANK_TREE_HXX
+
+#include "Cast.hxx"
+#include "Compiler.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+/**
+ * The hook which links an object into a #RankTree.  One object may
+ * contain several hooks to be a member of several trees.
+ */
+struct RankTreeHook {
+	RankTreeHook *parent, *left, *right;
+
+	/**
+	 * The number of nodes in the subtree rooted at this node.
+	 */
+	unsigned size;
+
+	/**
+	 * The random treap priority; a node's weight is never smaller
+	 * than its children's.
+	 */
+	uint32_t weight;
+
+	/**
+	 * The element's stamp (see RankTree::GetStamp()).  It must be
+	 * initialized before the element is inserted for the first
+	 * time; it is preserved when the element is moved.
+	 */
+	uint32_t stamp;
+
+	/**
+	 * A pending stamp for the whole subtree which has not yet been
+	 * applied to the nodes below.
+	 */
+	uint32_t subtree_stamp;
+
+	/**
+	 * The element's key (see RankTree::SetKey()).  Like the
+	 * stamp, it is preserved when the element is moved.
+	 */
+	uint8_t key;
+
+	/**
+	 * The smallest and the largest key in the subtree rooted at
+	 * this node.
+	 */
+	uint8_t min_key, max_key;
+};
+
+/**
+ * An intrusive sequence container which is implemented as an
+ * implicit treap (a randomized binary search tree keyed on the
+ * element's index).  Random access by index, looking up the index
+ * of an element, insertion, removal and moving ranges are O(log n)
+ * (expected).
+ *
+ * Each element carries a "stamp", a number which can be raised for
+ * a whole range of elements in O(log n); this can be used to mark
+ * ranges as modified.
+ *
+ * Each element also carries a small "key".  The tree keeps track of
+ * the key range of each subtree, which allows finding the first
+ * element with a matching key quickly (see FindKey()).
+ *
+ * The container does not own its elements.
+ */
+template<typename T, RankTreeHook T::*hook_member>
+class RankTree {
+	RankTreeHook *root = nullptr;
+
+	/**
+	 * State of the xorshift generator for treap weights.
+	 */
+	uint32_t seed = 2463534242;
+
+public:
+	RankTree() = default;
+
+	RankTree(const RankTree &) = delete;
+	RankTree &operator=(const RankTree &) = delete;
+
+	bool empty() const noexcept {
+		return root == nullptr;
+	}
+
+	unsigned size() const noexcept {
+		return Size(root);
+	}
+
+	/**
+	 * Forget all elements.  They are not disposed.
+	 */
+	void clear() noexcept {
+		root = nullptr;
+	}
+
+	/**
+	 * Remove all elements and invoke the given disposer on each
+	 * one of them (in no particular order).
+	 */
+	template<typename D>
+	void clear_and_dispose(D &&disposer) noexcept {
+		Dispose(root, disposer);
+		root = nullptr;
+	}
+
+	gcc_pure
+	T &operator[](unsigned i) const noexcept {
+		assert(i < size());
+
+		RankTreeHook *h = root;
+		while (true) {
+			const unsigned left_size = Size(h->left);
+			if (i < left_size)
+				h = h->left;
+			else if (i == left_size)
+				return Cast(*h);
+			else {
+				i -= left_size + 1;
+				h = h->right;
+			}
+		}
+	}
+
+	/**
+	 * Determine the index of the given element, which must be a
+	 * member of this tree.
+	 */
+	gcc_pure
+	unsigned IndexOf(const T &t) const noexcept {
+		const RankTreeHook *h = &(t.*hook_member);
+		unsigned i = Size(h->left);
+
+		for (const RankTreeHook *p = h->parent; p != nullptr;
+		     h = p, p = p->parent)
+			if (h == p->right)
+				i += Size(p->left) + 1;
+
+		return i;
+	}
+
+	/**
+	 * Insert an element before the given index.
+	 */
+	void insert(unsigned i, T &t) noexcept {
+		assert(i <= size());
+
+		RankTreeHook *h = InitHook(t);
+		auto s = Split(root, i);
+		SetRoot(Merge(Merge(s.first, h), s.second));
+	}
+
+	void push_back(T &t) noexcept {
+		SetRoot(Merge(root, InitHook(t)));
+	}
+
+	/**
+	 * Remove the given element, which must be a member of this
+	 * tree.
+	 */
+	void erase(T &t) noexcept {
+		RankTreeHook *h = &(t.*hook_member);
+		const uint32_t stamp = GetStamp(t);
+		PushDown(h);
+		h->stamp = stamp;
+
+		RankTreeHook *p = h->parent;
+		RankTreeHook *m = Merge(h->left, h->right);
+
+		if (p == nullptr) {
+			SetRoot(m);
+			return;
+		}
+
+		if (p->left == h)
+			p->left = m;
+		else
+			p->right = m;
+
+		if (m != nullptr)
+			m->parent = p;
+
+		for (; p != nullptr; p = p->parent) {
+			p->size = 1 + Size(p->left) + Size(p->right);
+			UpdateKeys(p);
+		}
+	}
+
+	/**
+	 * Move the range [start, end) so its first element ends up at
+	 * index "to".
+	 */
+	void Move(unsigned start, unsigned end, unsigned to) noexcept {
+		assert(start <= end);
+		assert(end <= size());
+		assert(to + (end - start) <= size());
+
+		auto a = Split(root, start);
+		auto b = Split(a.second, end - start);
+		auto c = Split(Merge(a.first, b.second), to);
+		SetRoot(Merge(Merge(c.first, b.first), c.second));
+	}
+
+	/**
+	 * Returns the stamp of the given element, i.e. the largest
+	 * value passed to RaiseStamp() or RaiseStampRange() which
+	 * covered it.
+	 */
+	gcc_pure
+	uint32_t GetStamp(const T &t) const noexcept {
+		const RankTreeHook *h = &(t.*hook_member);
+		uint32_t result = std::max(h->stamp, h->subtree_stamp);
+
+		for (h = h->parent; h != nullptr; h = h->parent)
+			result = std::max(result, h->subtree_stamp);
+
+		return result;
+	}
+
+	void RaiseStamp(T &t, uint32_t value) noexcept {
+		RankTreeHook &h = t.*hook_member;
+		h.stamp = std::max(h.stamp, value);
+	}
+
+	/**
+	 * Raise the stamp of all elements in the range [start, end)
+	 * to at least the given value.
+	 */
+	void RaiseStampRange(unsigned start, unsigned end,
+			     uint32_t value) noexcept {
+		assert(start <= end);
+		assert(end <= size());
+
+		if (start == end)
+			return;
+
+		auto a = Split(root, start);
+		auto b = Split(a.second, end - start);
+		b.first->subtree_stamp = std::max(b.first->subtree_stamp,
+						  value);
+		SetRoot(Merge(Merge(a.first, b.first), b.second));
+	}
+
+	/**
+	 * Reset the stamps of all elements to zero.
+	 */
+	void ResetStamps() noexcept {
+		ResetStamps(root);
+	}
+
+	gcc_pure
+	static uint8_t GetKey(const T &t) noexcept {
+		return (t.*hook_member).key;
+	}
+
+	/**
+	 * Change the key of the given element, which must be a member
+	 * of this tree.  This costs O(log n).
+	 */
+	void SetKey(T &t, uint8_t key) noexcept {
+		RankTreeHook *h = &(t.*hook_member);
+		h->key = key;
+
+		for (; h != nullptr; h = h->parent)
+			UpdateKeys(h);
+	}
+
+	/**
+	 * Find the first element at or after the given index whose key
+	 * matches.  The predicate receives a key range (min, max) and
+	 * returns whether it may contain a matching key; for a single
+	 * element, min and max are both its key.  This is O(log n) if
+	 * the matching keys form a contiguous range of the sequence,
+	 * e.g. when looking for the first key not larger than a value
+	 * in a sequence sorted by key.
+	 *
+	 * @return the index of the element or size() if there is none
+	 */
+	template<typename P>
+	gcc_pure
+	unsigned FindKey(unsigned start, P &&p) const noexcept {
+		return FindKey(root, 0, start, p);
+	}
+
+	/**
+	 * Exchange the indexes of two elements.
+	 */
+	void Swap(T &a, T &b) noexcept {
+		if (&a == &b)
+			return;
+
+		unsigned i = IndexOf(a), j = IndexOf(b);
+		T *x = &a, *y = &b;
+		if (i > j) {
+			std::swap(i, j);
+			std::swap(x, y);
+		}
+
+		erase(*y);
+		erase(*x);
+		insert(i, *y);
+		insert(j, *x);
+	}
+
+	/**
+	 * Rearrange the elements in the range [start, end).  The
+	 * function receives a std::vector<T *> of these elements and
+	 * may permute it.  This costs O(k log k) for a range of k
+	 * elements.
+	 */
+	template<typename F>
+	void Permute(unsigned start, unsigned end, F &&f) {
+		assert(start <= end);
+		assert(end <= size());
+
+		auto a = Split(root, start);
+		auto b = Split(a.second, end - start);
+		if (b.first != nullptr)
+			b.first->parent = nullptr;
+
+		/* the subtree will be rebuilt; apply all pending
+		   stamps before that */
+		PushDownAll(b.first);
+
+		std::vector<T *> v;
+		v.reserve(end - start);
+		for (RankTreeHook *h = First(b.first); h != nullptr;
+		     h = Next(h))
+			v.push_back(&Cast(*h));
+
+		f(v);
+		assert(v.size() == end - start);
+
+		RankTreeHook *middle = nullptr;
+		for (T *t : v)
+			middle = Merge(middle, InitHook(*t));
+
+		SetRoot(Merge(Merge(a.first, middle), b.second));
+	}
+
+	class const_iterator {
+		friend class RankTree;
+
+		const RankTreeHook *cursor;
+
+		constexpr const_iterator(const RankTreeHook *_cursor) noexcept
+			:cursor(_cursor) {}
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef T *pointer;
+		typedef T &reference;
+		typedef std::ptrdiff_t difference_type;
+
+		bool operator==(const const_iterator &other) const noexcept {
+			return cursor == other.cursor;
+		}
+
+		bool operator!=(const const_iterator &other) const noexcept {
+			return cursor != other.cursor;
+		}
+
+		T &operator*() const noexcept {
+			return Cast(const_cast<RankTreeHook &>(*cursor));
+		}
+
+		T *operator->() const noexcept {
+			return &**this;
+		}
+
+		const_iterator &operator++() noexcept {
+			cursor = Next(cursor);
+			return *this;
+		}
+	};
+
+	const_iterator begin() const noexcept {
+		return First(root);
+	}
+
+	const_iterator end() const noexcept {
+		return nullptr;
+	}
+
+	/**
+	 * Returns an iterator pointing to the element at the given
+	 * index (or end()).
+	 */
+	gcc_pure
+	const_iterator IteratorAt(unsigned i) const noexcept {
+		return i < size()
+			? &((*this)[i].*hook_member)
+			: nullptr;
+	}
+
+private:
+	static T &Cast(RankTreeHook &h) noexcept {
+		return ContainerCast(h, hook_member);
+	}
+
+	static constexpr unsigned Size(const RankTreeHook *h) noexcept {
+		return h != nullptr ? h->size : 0;
+	}
+
+	uint32_t NextWeight() noexcept {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+	RankTreeHook *InitHook(T &t) noexcept {
+		RankTreeHook &h = t.*hook_member;
+		h.parent = h.left = h.right = nullptr;
+		h.size = 1;
+		h.weight = NextWeight();
+		h.subtree_stamp = 0;
+		h.min_key = h.max_key = h.key;
+		return &h;
+	}
+
+	/**
+	 * Apply the pending subtree stamp to this node and pass it on
+	 * to its children.  This must be done before the children of
+	 * a node are modified.
+	 */
+	static void PushDown(RankTreeHook *h) noexcept {
+		const uint32_t value = h->subtree_stamp;
+		if (value == 0)
+			return;
+
+		h->stamp = std::max(h->stamp, value);
+		h->subtree_stamp = 0;
+
+		if (h->left != nullptr)
+			h->left->subtree_stamp =
+				std::max(h->left->subtree_stamp, value);
+		if (h->right != nullptr)
+			h->right->subtree_stamp =
+				std::max(h->right->subtree_stamp, value);
+	}
+
+	static void PushDownAll(RankTreeHook *h) noexcept {
+		if (h == nullptr)
+			return;
+
+		PushDown(h);
+		PushDownAll(h->left);
+		PushDownAll(h->right);
+	}
+
+	static void ResetStamps(RankTreeHook *h) noexcept {
+		if (h == nullptr)
+			return;
+
+		h->stamp = h->subtree_stamp = 0;
+		ResetStamps(h->left);
+		ResetStamps(h->right);
+	}
+
+	void SetRoot(RankTreeHook *h) noexcept {
+		root = h;
+		if (h != nullptr)
+			h->parent = nullptr;
+	}
+
+	/**
+	 * Recalculate the key range of a node from its own key and its
+	 * children's key ranges.
+	 */
+	static void UpdateKeys(RankTreeHook *h) noexcept {
+		h->min_key = h->max_key = h->key;
+
+		if (h->left != nullptr) {
+			h->min_key = std::min(h->min_key, h->left->min_key);
+			h->max_key = std::max(h->max_key, h->left->max_key);
+		}
+
+		if (h->right != nullptr) {
+			h->min_key = std::min(h->min_key, h->right->min_key);
+			h->max_key = std::max(h->max_key, h->right->max_key);
+		}
+	}
+
+	/**
+	 * Recalculate the size and the key range of a node after its
+	 * children have been modified and let the children point to
+	 * it.
+	 */
+	static void Update(RankTreeHook *h) noexcept {
+		h->size = 1 + Size(h->left) + Size(h->right);
+		UpdateKeys(h);
+
+		if (h->left != nullptr)
+			h->left->parent = h;
+		if (h->right != nullptr)
+			h->right->parent = h;
+	}
+
+	/**
+	 * Concatenate two trees.
+	 */
+	static RankTreeHook *Merge(RankTreeHook *a, RankTreeHook *b) noexcept {
+		if (a == nullptr)
+			return b;
+		if (b == nullptr)
+			return a;
+
+		if (a->weight > b->weight) {
+			PushDown(a);
+			a->right = Merge(a->right, b);
+			Update(a);
+			return a;
+		} else {
+			PushDown(b);
+			b->left = Merge(a, b->left);
+			Update(b);
+			return b;
+		}
+	}
+
+	/**
+	 * Split a tree into the first "n" elements and the rest.
+	 */
+	static std::pair<RankTreeHook *, RankTreeHook *>
+	Split(RankTreeHook *h, unsigned n) noexcept {
+		if (h == nullptr)
+			return {nullptr, nullptr};
+
+		PushDown(h);
+
+		const unsigned left_size = Size(h->left);
+		if (n <= left_size) {
+			auto s = Split(h->left, n);
+			h->left = s.second;
+			Update(h);
+			return {s.first, h};
+		} else {
+			auto s = Split(h->right, n - left_size - 1);
+			h->right = s.first;
+			Update(h);
+			return {h, s.second};
+		}
+	}
+
+	/**
+	 * Recursive implementation of FindKey().
+	 *
+	 * @param offset the index of the first element in this subtree
+	 * @return the index of the element or the end of this subtree
+	 * if there is none
+	 */
+	template<typename P>
+	static unsigned FindKey(const RankTreeHook *h, unsigned offset,
+				unsigned start, P &p) noexcept {
+		if (h == nullptr)
+			return offset;
+
+		const unsigned end = offset + h->size;
+		if (end <= start || !p(h->min_key, h->max_key))
+			return end;
+
+		const unsigned left_end = offset + Size(h->left);
+		const unsigned i = FindKey(h->left, offset, start, p);
+		if (i < left_end)
+			return i;
+
+		if (left_end >= start && p(h->key, h->key))
+			return left_end;
+
+		return FindKey(h->right, left_end + 1, start, p);
+	}
+
+	template<typename D>
+	static void Dispose(RankTreeHook *h, D &disposer) noexcept {
+		if (h == nullptr)
+			return;
+
+		Dispose(h->left, disposer);
+		Dispose(h->right, disposer);
+		disposer(&Cast(*h));
+	}
+
+	static const RankTreeHook *First(const RankTreeHook *h) noexcept {
+		if (h != nullptr)
+			while (h->left != nullptr)
+				h = h->left;
+		return h;
+	}
+
+	static RankTreeHook *First(RankTreeHook *h) noexcept {
+		return const_cast<RankTreeHook *>(First((const RankTreeHook *)h));
+	}
+
+	/**
+	 * Find the in-order successor of the given node.  Note that
+	 * this follows the parent pointers; the node must be part of
+	 * a tree whose root's parent is nullptr.
+	 */
+	static const RankTreeHook *Next(const RankTreeHook *h) noexcept {
+		if (h->right != nullptr)
+			return First(h->right);
+
+		while (h->parent != nullptr && h == h->parent->right)
+			h = h->parent;
+
+		return h->parent;
+	}
+
+	static RankTreeHook *Next(RankTreeHook *h) noexcept {
+		return const_cast<RankTreeHook *>(Next((const RankTreeHook *)h));
+	}
+};
+
+#endif
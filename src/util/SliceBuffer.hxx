@@ -79,6 +79,10 @@ public:
 		return buffer.size();
 	}
 
+	unsigned GetAllocated() const noexcept {
+		return n_allocated;
+	}
+
 	bool empty() const noexcept {
 		return n_allocated == 0;
 	}
@@ -27,17 +27,19 @@
 #include <stdio.h>
 
 void
-DumpDecoderClient::Ready(const AudioFormat audio_format,
+DumpDecoderClient::Ready(const AudioFormat _audio_format,
 			 gcc_unused bool seekable,
 			 SignedSongTime duration) noexcept
 {
 	assert(!initialized);
-	assert(audio_format.IsValid());
+	assert(_audio_format.IsValid());
 
-	fprintf(stderr, "audio_format=%s duration=%f\n",
-		ToString(audio_format).c_str(),
-		duration.ToDoubleS());
+	if (!quiet)
+		fprintf(stderr, "audio_format=%s duration=%f\n",
+			ToString(_audio_format).c_str(),
+			duration.ToDoubleS());
 
+	audio_format = _audio_format;
 	initialized = true;
 }
 
@@ -95,6 +97,11 @@ DumpDecoderClient::SubmitData(gcc_unused InputStream *is,
 			      const void *data, size_t datalen,
 			      gcc_unused uint16_t kbit_rate) noexcept
 {
+	n_bytes += datalen;
+
+	if (quiet)
+		return DecoderCommand::NONE;
+
 	if (kbit_rate != prev_kbit_rate) {
 		prev_kbit_rate = kbit_rate;
 		fprintf(stderr, "%u kbit/s\n", kbit_rate);
@@ -108,6 +115,9 @@ DecoderCommand
 DumpDecoderClient::SubmitTag(gcc_unused InputStream *is,
 			     Tag &&tag) noexcept
 {
+	if (quiet)
+		return DecoderCommand::NONE;
+
 	fprintf(stderr, "TAG: duration=%f\n", tag.duration.ToDoubleS());
 
 	for (const auto &i : tag)
@@ -134,13 +144,16 @@ DumpReplayGainInfo(const ReplayGainInfo &info) noexcept
 void
 DumpDecoderClient::SubmitReplayGain(const ReplayGainInfo *rgi) noexcept
 {
-	if (rgi != nullptr)
+	if (rgi != nullptr && !quiet)
 		DumpReplayGainInfo(*rgi);
 }
 
 void
 DumpDecoderClient::SubmitMixRamp(gcc_unused MixRampInfo &&mix_ramp) noexcept
 {
+	if (quiet)
+		return;
+
 	fprintf(stderr, "MixRamp: start='%s' end='%s'\n",
 		mix_ramp.GetStart(), mix_ramp.GetEnd());
 }
@@ -22,23 +22,48 @@
 
 #include "decoder/Client.hxx"
 #include "thread/Mutex.hxx"
+#include "AudioFormat.hxx"
 
 /**
  * A #DecoderClient implementation which dumps metadata to stderr and
  * decoded data to stdout.
  */
 class DumpDecoderClient final : public DecoderClient {
+	/**
+	 * If true, then nothing is dumped; the decoded data is only
+	 * counted.
+	 */
+	const bool quiet;
+
 	bool initialized = false;
 
 	uint16_t prev_kbit_rate = 0;
 
+	AudioFormat audio_format = AudioFormat::Undefined();
+
+	uint64_t n_bytes = 0;
+
 public:
 	Mutex mutex;
 
+	explicit DumpDecoderClient(bool _quiet=false) noexcept
+		:quiet(_quiet) {}
+
 	bool IsInitialized() const noexcept {
 		return initialized;
 	}
 
+	const AudioFormat &GetAudioFormat() const noexcept {
+		return audio_format;
+	}
+
+	/**
+	 * Returns the number of PCM bytes submitted by the decoder.
+	 */
+	uint64_t GetDecodedBytes() const noexcept {
+		return n_bytes;
+	}
+
 	/* virtual methods from DecoderClient */
 	void Ready(AudioFormat audio_format,
 		   bool seekable, SignedSongTime duration) noexcept override;
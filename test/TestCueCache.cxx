@@ -0,0 +1,150 @@
+/*
+ * Unit tests for the cue sheet cache.
+ */
+
+#include "config.h"
+#include "playlist/cue/CueCache.hxx"
+#include "fs/Path.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/FileSystem.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+class CueCacheTest : public ::testing::Test {
+protected:
+	char path[32];
+	FileInfo fi;
+
+	void SetUp() override {
+		strcpy(path, "/tmp/TestCueCache.XXXXXX");
+		int fd = mkstemp(path);
+		ASSERT_GE(fd, 0);
+		close(fd);
+
+		Write("foo");
+	}
+
+	void TearDown() override {
+		unlink(path);
+	}
+
+	void Write(const char *data) {
+		FILE *file = fopen(path, "w");
+		ASSERT_NE(file, nullptr);
+		fputs(data, file);
+		fclose(file);
+
+		ASSERT_TRUE(GetFileInfo(Path::FromFS(path), fi));
+	}
+
+	/**
+	 * Generate the path of a fake file which does not need to
+	 * exist, because the cache never accesses it.
+	 */
+	static std::string FakePath(const char *prefix, unsigned i) {
+		return std::string("/nonexistent/") + prefix + std::to_string(i);
+	}
+
+	static std::shared_ptr<const CueTrackList> MakeTracks(const char *uri) {
+		auto tracks = std::make_shared<CueTrackList>();
+		tracks->emplace_back(uri);
+		return tracks;
+	}
+
+	bool Lookup(const std::string &p,
+		    std::shared_ptr<const CueTrackList> &tracks) {
+		return cue_cache_get(Path::FromFS(p.c_str()), fi, tracks);
+	}
+};
+
+TEST_F(CueCacheTest, Hit)
+{
+	std::shared_ptr<const CueTrackList> tracks;
+	EXPECT_FALSE(cue_cache_get(Path::FromFS(path), fi, tracks));
+
+	cue_cache_put(Path::FromFS(path), fi, MakeTracks("foo.flac"));
+	ASSERT_TRUE(cue_cache_get(Path::FromFS(path), fi, tracks));
+	ASSERT_NE(tracks, nullptr);
+	ASSERT_EQ(tracks->size(), 1u);
+	EXPECT_STREQ(tracks->front().GetURI(), "foo.flac");
+
+	/* negative item */
+	cue_cache_put(Path::FromFS(path), fi, nullptr);
+	ASSERT_TRUE(cue_cache_get(Path::FromFS(path), fi, tracks));
+	EXPECT_EQ(tracks, nullptr);
+
+	/* and back */
+	cue_cache_put(Path::FromFS(path), fi, MakeTracks("bar.flac"));
+	ASSERT_TRUE(cue_cache_get(Path::FromFS(path), fi, tracks));
+	ASSERT_NE(tracks, nullptr);
+	EXPECT_STREQ(tracks->front().GetURI(), "bar.flac");
+}
+
+TEST_F(CueCacheTest, Invalidate)
+{
+	std::shared_ptr<const CueTrackList> tracks;
+
+	cue_cache_put(Path::FromFS(path), fi, MakeTracks("foo.flac"));
+	ASSERT_TRUE(cue_cache_get(Path::FromFS(path), fi, tracks));
+
+	/* modify the file: the size changes */
+	Write("foobar");
+	EXPECT_FALSE(cue_cache_get(Path::FromFS(path), fi, tracks));
+
+	cue_cache_put(Path::FromFS(path), fi, nullptr);
+	ASSERT_TRUE(cue_cache_get(Path::FromFS(path), fi, tracks));
+	EXPECT_EQ(tracks, nullptr);
+
+	Write("foo");
+	EXPECT_FALSE(cue_cache_get(Path::FromFS(path), fi, tracks));
+}
+
+TEST_F(CueCacheTest, Evict)
+{
+	std::shared_ptr<const CueTrackList> tracks;
+
+	for (unsigned i = 0; i < CUE_CACHE_SIZE; ++i)
+		cue_cache_put(Path::FromFS(FakePath("a", i).c_str()), fi,
+			      MakeTracks("x.flac"));
+
+	/* use the first one, which makes the second one the least
+	   recently used item */
+	EXPECT_TRUE(Lookup(FakePath("a", 0), tracks));
+
+	cue_cache_put(Path::FromFS(FakePath("b", 0).c_str()), fi,
+		      MakeTracks("x.flac"));
+
+	EXPECT_TRUE(Lookup(FakePath("a", 0), tracks));
+	EXPECT_FALSE(Lookup(FakePath("a", 1), tracks));
+	EXPECT_TRUE(Lookup(FakePath("a", 2), tracks));
+	EXPECT_TRUE(Lookup(FakePath("b", 0), tracks));
+}
+
+TEST_F(CueCacheTest, NegativeDoesNotEvict)
+{
+	std::shared_ptr<const CueTrackList> tracks;
+
+	cue_cache_put(Path::FromFS(path), fi, MakeTracks("foo.flac"));
+
+	/* a database update checks many files without a cue sheet */
+	for (unsigned i = 0; i < 2 * CUE_NEGATIVE_CACHE_SIZE; ++i)
+		cue_cache_put(Path::FromFS(FakePath("n", i).c_str()), fi,
+			      nullptr);
+
+	ASSERT_TRUE(cue_cache_get(Path::FromFS(path), fi, tracks));
+	ASSERT_NE(tracks, nullptr);
+	EXPECT_STREQ(tracks->front().GetURI(), "foo.flac");
+
+	/* the negative cache is bounded, too */
+	EXPECT_FALSE(Lookup(FakePath("n", 0), tracks));
+	EXPECT_TRUE(Lookup(FakePath("n", 2 * CUE_NEGATIVE_CACHE_SIZE - 1),
+			   tracks));
+	EXPECT_EQ(tracks, nullptr);
+}
@@ -0,0 +1,45 @@
+/*
+ * Unit tests for src/util/
+ */
+
+#include "util/LatencyHistogram.hxx"
+
+#include <gtest/gtest.h>
+
+using std::chrono::microseconds;
+
+TEST(LatencyHistogram, Empty)
+{
+	const LatencyHistogram h;
+	EXPECT_EQ(0u, h.GetCount());
+	EXPECT_EQ(LatencyHistogram::Duration::zero(), h.GetMax());
+	EXPECT_EQ(LatencyHistogram::Duration::zero(), h.GetPercentile(50));
+}
+
+TEST(LatencyHistogram, Basic)
+{
+	LatencyHistogram h;
+	for (unsigned i = 0; i < 99; ++i)
+		h.Add(microseconds(10));
+	h.Add(microseconds(5000));
+
+	EXPECT_EQ(100u, h.GetCount());
+	EXPECT_EQ(microseconds(5000), h.GetMax());
+	EXPECT_EQ(microseconds(99 * 10 + 5000), h.GetSum());
+
+	/* 10us is in the bucket [8us, 16us) */
+	EXPECT_EQ(microseconds(16), h.GetPercentile(50));
+	EXPECT_EQ(microseconds(16), h.GetPercentile(99));
+
+	/* the result is capped at the maximum */
+	EXPECT_EQ(microseconds(5000), h.GetPercentile(100));
+}
+
+TEST(LatencyHistogram, Negative)
+{
+	LatencyHistogram h;
+	h.Add(microseconds(-3));
+	EXPECT_EQ(1u, h.GetCount());
+	EXPECT_EQ(LatencyHistogram::Duration::zero(), h.GetMax());
+	EXPECT_EQ(LatencyHistogram::Duration::zero(), h.GetPercentile(99));
+}
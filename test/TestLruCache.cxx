@@ -0,0 +1,82 @@
+/*
+ * Unit tests for class LruCache.
+ */
+
+#include "util/LruCache.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(LruCache, Basic)
+{
+	LruCache<std::string, int, 4> cache;
+	EXPECT_TRUE(cache.empty());
+	EXPECT_EQ(cache.Get("foo"), nullptr);
+
+	cache.Put("foo", 1);
+	cache.Put(std::string("bar"), 2);
+	EXPECT_EQ(cache.size(), 2u);
+
+	ASSERT_NE(cache.Get("foo"), nullptr);
+	EXPECT_EQ(*cache.Get("foo"), 1);
+	EXPECT_EQ(*cache.Get(std::string("bar")), 2);
+
+	/* replace */
+	cache.Put("foo", 3);
+	EXPECT_EQ(cache.size(), 2u);
+	EXPECT_EQ(*cache.Get("foo"), 3);
+
+	cache.Remove("foo");
+	EXPECT_EQ(cache.Get("foo"), nullptr);
+	EXPECT_EQ(cache.size(), 1u);
+
+	cache.Clear();
+	EXPECT_TRUE(cache.empty());
+	EXPECT_EQ(cache.Get("bar"), nullptr);
+}
+
+TEST(LruCache, Evict)
+{
+	LruCache<std::string, int, 3> cache;
+	cache.Put("a", 1);
+	cache.Put("b", 2);
+	cache.Put("c", 3);
+
+	/* "a" becomes the most recently used item, so "b" is
+	   evicted */
+	EXPECT_NE(cache.Get("a"), nullptr);
+	cache.Put("d", 4);
+
+	EXPECT_EQ(cache.size(), 3u);
+	EXPECT_EQ(cache.Get("b"), nullptr);
+	EXPECT_NE(cache.Get("a"), nullptr);
+	EXPECT_NE(cache.Get("c"), nullptr);
+	EXPECT_NE(cache.Get("d"), nullptr);
+
+	/* replacing refreshes, too: now "a" is the oldest one */
+	cache.Put("c", 5);
+	cache.Put("e", 6);
+	EXPECT_EQ(cache.Get("a"), nullptr);
+	EXPECT_EQ(*cache.Get("c"), 5);
+}
+
+TEST(LruCache, RemoveIf)
+{
+	LruCache<std::string, int, 8> cache;
+	for (int i = 0; i < 8; ++i)
+		cache.Put(std::to_string(i), i);
+
+	cache.RemoveIf([](const std::string &, int value){
+		return value % 2 == 0;
+	});
+
+	EXPECT_EQ(cache.size(), 4u);
+	EXPECT_EQ(cache.Get("2"), nullptr);
+	EXPECT_EQ(*cache.Get("3"), 3);
+
+	/* the index is still consistent */
+	for (int i = 8; i < 16; ++i)
+		cache.Put(std::to_string(i), i);
+	EXPECT_EQ(cache.size(), 8u);
+}
@@ -0,0 +1,56 @@
+/*
+ * Unit tests for class MetricsWriter.
+ */
+
+#include "metrics/Writer.hxx"
+#include "util/LatencyHistogram.hxx"
+
+#include <gtest/gtest.h>
+
+using std::chrono::microseconds;
+
+TEST(MetricsWriter, Empty)
+{
+	MetricsWriter w;
+	EXPECT_EQ(w.Finish(), "# EOF\n");
+}
+
+TEST(MetricsWriter, Samples)
+{
+	MetricsWriter w;
+	w.Family("mpd_foo", "counter", "Number of foos");
+	w.Sample("mpd_foo_total", {}, uint64_t(42));
+	w.Sample("mpd_foo_total", {{"a", "b"}, {"c", "d"}}, 0.5);
+	w.Sample("mpd_foo_total", {{"a", "x\"y\\z\nw"}},
+		 std::chrono::milliseconds(1500));
+
+	EXPECT_EQ(w.Finish(),
+		  "# TYPE mpd_foo counter\n"
+		  "# HELP mpd_foo Number of foos\n"
+		  "mpd_foo_total 42\n"
+		  "mpd_foo_total{a=\"b\",c=\"d\"} 0.5\n"
+		  "mpd_foo_total{a=\"x\\\"y\\\\z\\nw\"} 1.5\n"
+		  "# EOF\n");
+}
+
+TEST(MetricsWriter, Summary)
+{
+	LatencyHistogram h;
+	for (unsigned i = 0; i < 99; ++i)
+		h.Add(microseconds(10));
+	h.Add(microseconds(5000));
+
+	MetricsWriter w;
+	w.Family("mpd_bar_seconds", "summary", "Bar duration");
+	w.Summary("mpd_bar_seconds", {{"command", "status"}}, h);
+
+	/* 10us is in the bucket [8us, 16us) */
+	EXPECT_EQ(w.Finish(),
+		  "# TYPE mpd_bar_seconds summary\n"
+		  "# HELP mpd_bar_seconds Bar duration\n"
+		  "mpd_bar_seconds{command=\"status\",quantile=\"0.5\"} 1.6e-05\n"
+		  "mpd_bar_seconds{command=\"status\",quantile=\"0.99\"} 1.6e-05\n"
+		  "mpd_bar_seconds_sum{command=\"status\"} 0.00599\n"
+		  "mpd_bar_seconds_count{command=\"status\"} 100\n"
+		  "# EOF\n");
+}
@@ -0,0 +1,127 @@
+/*
+ * Unit tests for the pipeline trace ring buffer.
+ */
+
+#include "trace/PipelineTrace.hxx"
+#include "fs/AllocatedPath.hxx"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+TEST(PipelineTrace, Wrap)
+{
+	/* overwrite the whole ring buffer, plus 100 more */
+	static constexpr unsigned N = PipelineTrace::CAPACITY + 100;
+	for (unsigned i = 0; i < N; ++i)
+		PipelineTrace::Record(PipelineTraceEvent::CHUNK_PRODUCED,
+				      nullptr, i);
+
+	const auto events = PipelineTrace::Collect();
+	ASSERT_EQ(events.size(), PipelineTrace::CAPACITY);
+
+	/* the oldest 100 events have been overwritten, and the
+	   remaining ones are returned oldest first */
+	EXPECT_EQ(events.front().value, 100u);
+	EXPECT_EQ(events.back().value, N - 1);
+
+	for (size_t i = 1; i < events.size(); ++i) {
+		ASSERT_EQ(events[i].value, events[i - 1].value + 1);
+		ASSERT_GE(events[i].time, events[i - 1].time);
+	}
+}
+
+TEST(PipelineTrace, ConcurrentCollect)
+{
+	/* each writer thread records events whose attributes all
+	   depend on the writer number; a torn read would mix
+	   them up */
+	static constexpr unsigned N_WRITERS = 4;
+	static const char *const names[N_WRITERS] = {
+		"a", "b", "c", "d",
+	};
+	static constexpr PipelineTraceEvent types[N_WRITERS] = {
+		PipelineTraceEvent::CHUNK_PRODUCED,
+		PipelineTraceEvent::CHUNK_CONSUMED,
+		PipelineTraceEvent::OUTPUT_WAIT_BEGIN,
+		PipelineTraceEvent::XRUN,
+	};
+
+	std::atomic_bool quit{false};
+
+	std::thread writers[N_WRITERS];
+	for (unsigned k = 0; k < N_WRITERS; ++k)
+		writers[k] = std::thread([k, &quit](){
+			for (unsigned i = 0; !quit.load(std::memory_order_relaxed); ++i)
+				PipelineTrace::Record(types[k], names[k],
+						      (k << 24) | (i & 0xffffff));
+		});
+
+	for (unsigned round = 0; round < 50; ++round) {
+		const auto events = PipelineTrace::Collect();
+		EXPECT_LE(events.size(), PipelineTrace::CAPACITY);
+
+		for (const auto &e : events) {
+			const unsigned k = e.value >> 24;
+			if (e.name == nullptr)
+				/* recorded by another test */
+				continue;
+
+			ASSERT_LT(k, N_WRITERS);
+			ASSERT_EQ(e.name, names[k]);
+			ASSERT_EQ(e.event, types[k]);
+		}
+	}
+
+	quit = true;
+	for (auto &i : writers)
+		i.join();
+
+	/* after all writers have finished, nearly all slots contain
+	   a complete event; a writer which was preempted one lap
+	   behind the others may have overwritten a newer event,
+	   which is then skipped */
+	const auto events = PipelineTrace::Collect();
+	EXPECT_LE(events.size(), PipelineTrace::CAPACITY);
+	EXPECT_GT(events.size(), PipelineTrace::CAPACITY - N_WRITERS);
+}
+
+TEST(PipelineTrace, DumpDefault)
+{
+	char path[] = "/tmp/TestPipelineTrace.XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	close(fd);
+
+	PipelineTrace::Record(PipelineTraceEvent::XRUN, "hw:0", 0);
+
+	PipelineTrace::SetDumpPath(AllocatedPath::FromFS(path));
+	PipelineTrace::DumpDefault();
+
+	/* wait for the dump thread */
+	PipelineTrace::Deinit();
+
+	FILE *file = fopen(path, "r");
+	ASSERT_NE(file, nullptr);
+
+	char buffer[64];
+	ASSERT_NE(fgets(buffer, sizeof(buffer), file), nullptr);
+	EXPECT_STREQ(buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fclose(file);
+
+	/* another dump may be started after the previous one has
+	   finished */
+	PipelineTrace::DumpDefault();
+	PipelineTrace::Deinit();
+
+	PipelineTrace::SetDumpPath(nullptr);
+	EXPECT_THROW(PipelineTrace::DumpDefault(), std::runtime_error);
+
+	unlink(path);
+}
@@ -0,0 +1,211 @@
+/*
+ * Unit tests for the incremental PLS playlist parser.
+ */
+
+#include "playlist/PlaylistPlugin.hxx"
+#include "playlist/SongEnumerator.hxx"
+#include "playlist/plugins/PlsPlaylistPlugin.hxx"
+#include "input/InputStream.hxx"
+#include "song/DetachedSong.hxx"
+#include "tag/Tag.hxx"
+#include "thread/Mutex.hxx"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+/**
+ * Returns the given string in small chunks, to exercise the
+ * incremental parser.
+ */
+class StringInputStream final : public InputStream {
+	const char *data;
+	size_t remaining;
+
+public:
+	StringInputStream(Mutex &_mutex, const char *_data)
+		:InputStream("test://", _mutex),
+		 data(_data), remaining(strlen(data)) {
+		SetReady();
+	}
+
+	size_t GetRemaining() const noexcept {
+		return remaining;
+	}
+
+	/* virtual methods from InputStream */
+	bool IsEOF() const noexcept override {
+		return remaining == 0;
+	}
+
+	size_t Read(std::unique_lock<Mutex> &,
+		    void *ptr, size_t read_size) override {
+		size_t nbytes = std::min({remaining, read_size, size_t(7)});
+		memcpy(ptr, data, nbytes);
+		data += nbytes;
+		remaining -= nbytes;
+		offset += nbytes;
+		return nbytes;
+	}
+};
+
+class PlsPlaylistTest : public ::testing::Test {
+protected:
+	Mutex mutex;
+
+	/**
+	 * The stream passed to the plugin; it is owned by the
+	 * #SongEnumerator.
+	 */
+	StringInputStream *is;
+
+	std::unique_ptr<SongEnumerator> Open(const char *data) {
+		auto s = std::make_unique<StringInputStream>(mutex, data);
+		is = s.get();
+		auto e = pls_playlist_plugin.open_stream(std::move(s));
+		EXPECT_NE(e, nullptr);
+		return e;
+	}
+
+	static void Expect(SongEnumerator &e, const char *uri,
+			   const char *title, int length) {
+		auto song = e.NextSong();
+		ASSERT_NE(song, nullptr);
+		EXPECT_STREQ(song->GetURI(), uri);
+
+		const auto &tag = song->GetTag();
+		if (title != nullptr)
+			EXPECT_STREQ(tag.GetValue(TAG_TITLE), title);
+		else
+			EXPECT_EQ(tag.GetValue(TAG_TITLE), nullptr);
+
+		if (length > 0)
+			EXPECT_EQ(tag.duration.ToS(), length);
+		else
+			EXPECT_TRUE(tag.duration.IsNegative());
+	}
+};
+
+TEST_F(PlsPlaylistTest, Grouped)
+{
+	auto e = Open("[playlist]\n"
+		      "NumberOfEntries=3\n"
+		      "File1=http://example.com/a\n"
+		      "Title1=A\n"
+		      "Length1=10\n"
+		      "File2=http://example.com/b\n"
+		      "Title2=B\n"
+		      "File3=http://example.com/c\n"
+		      "Length3=-1\n"
+		      "Version=2\n");
+
+	Expect(*e, "http://example.com/a", "A", 10);
+
+	/* the first entry is returned as soon as the second one
+	   begins, without reading the whole file */
+	EXPECT_GT(is->GetRemaining(), 0u);
+
+	Expect(*e, "http://example.com/b", "B", -1);
+	Expect(*e, "http://example.com/c", nullptr, -1);
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, Mixed)
+{
+	auto e = Open("[playlist]\n"
+		      "File1=http://example.com/a\n"
+		      "File2=http://example.com/b\n"
+		      "File3=http://example.com/c\n"
+		      "Title1=A\n"
+		      "Title2=B\n"
+		      "Title3=C\n"
+		      "Length2=20\n");
+
+	Expect(*e, "http://example.com/a", "A", -1);
+	Expect(*e, "http://example.com/b", "B", 20);
+	Expect(*e, "http://example.com/c", "C", -1);
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, TrailingNumberOfEntries)
+{
+	auto e = Open("[playlist]\n"
+		      "File1=http://example.com/a\n"
+		      "File2=http://example.com/b\n"
+		      "File3=http://example.com/c\n"
+		      "NumberOfEntries=2\n"
+		      "Version=2\n");
+
+	Expect(*e, "http://example.com/a", nullptr, -1);
+	Expect(*e, "http://example.com/b", nullptr, -1);
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, NoNumberOfEntries)
+{
+	auto e = Open("[playlist]\n"
+		      "File1=http://example.com/a\n"
+		      "Title1=A\n"
+		      "File2=http://example.com/b\n"
+		      "Title2=B\n");
+
+	Expect(*e, "http://example.com/a", "A", -1);
+	Expect(*e, "http://example.com/b", "B", -1);
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, MissingFile)
+{
+	auto e = Open("[playlist]\n"
+		      "File1=http://example.com/a\n"
+		      "Title1=A\n"
+		      "Title2=B\n"
+		      "Length2=20\n"
+		      "File3=http://example.com/c\n"
+		      "Title3=C\n"
+		      "NumberOfEntries=3\n");
+
+	/* entry 2 has no "File" key and is skipped */
+	Expect(*e, "http://example.com/a", "A", -1);
+	Expect(*e, "http://example.com/c", "C", -1);
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, LateKey)
+{
+	auto e = Open("[playlist]\n"
+		      "File1=http://example.com/a\n"
+		      "Title1=A\n"
+		      "File2=http://example.com/b\n"
+		      "Length1=10\n"
+		      "Title2=B\n"
+		      "File3=http://example.com/c\n"
+		      "Length2=20\n");
+
+	/* the first entry has already been returned when
+	   "Length1" arrives; that key is dropped */
+	Expect(*e, "http://example.com/a", "A", -1);
+
+	/* the rest is buffered, so "Length2" after "File3" is not
+	   lost */
+	Expect(*e, "http://example.com/b", "B", 20);
+	Expect(*e, "http://example.com/c", nullptr, -1);
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, Empty)
+{
+	auto e = Open("[playlist]\n"
+		      "NumberOfEntries=0\n"
+		      "File1=http://example.com/a\n");
+
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST_F(PlsPlaylistTest, NoPlaylistSection)
+{
+	auto s = std::make_unique<StringInputStream>(mutex, "hello\n");
+	EXPECT_EQ(pls_playlist_plugin.open_stream(std::move(s)), nullptr);
+}
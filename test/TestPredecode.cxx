@@ -0,0 +1,519 @@
+/*
+ * Unit tests for the DecoderControl features used by the player to
+ * pre-decode the next song in a second decoder ("predecode_next_song"),
+ * and for the player's #Predecoder.
+ */
+
+#include "player/Predecoder.hxx"
+#include "decoder/Control.hxx"
+#include "MusicBuffer.hxx"
+#include "MusicPipe.hxx"
+#include "MusicChunk.hxx"
+#include "ReplayGainConfig.hxx"
+#include "song/DetachedSong.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/* the decoder thread is not started by these tests; this stub
+   avoids linking the decoder plugins */
+void
+DecoderControl::RunThread() noexcept
+{
+}
+
+namespace {
+
+/**
+ * Allocate a chunk containing one frame of audio data.
+ */
+static MusicChunkPtr
+MakeChunk(MusicBuffer &buffer) noexcept
+{
+	auto chunk = buffer.Allocate();
+	chunk->audio_format = AudioFormat(44100, SampleFormat::S16, 2);
+	chunk->length = 4;
+	return chunk;
+}
+
+/**
+ * Simulates the decoder thread's DecoderBridge::GetChunk(): it
+ * honours the pipe limit and pushes chunks to the pipe.
+ */
+class FakeDecoder {
+	DecoderControl &dc;
+	MusicBuffer &buffer;
+
+public:
+	std::atomic_uint pushed{0};
+	DecoderCommand result = DecoderCommand::NONE;
+
+private:
+	/* declared last, because the thread accesses all other
+	   attributes as soon as it is started */
+	std::thread thread;
+
+public:
+	FakeDecoder(DecoderControl &_dc, MusicBuffer &_buffer,
+		    unsigned n_chunks)
+		:dc(_dc), buffer(_buffer),
+		 thread([this, n_chunks](){ Run(n_chunks); }) {}
+
+	void Join() {
+		thread.join();
+	}
+
+private:
+	void Run(unsigned n_chunks) noexcept {
+		for (unsigned i = 0; i < n_chunks; ++i) {
+			result = dc.LockWaitPipeLimit();
+			if (result != DecoderCommand::NONE)
+				return;
+
+			auto chunk = MakeChunk(buffer);
+
+			const std::lock_guard<Mutex> protect(dc.mutex);
+			dc.pipe->Push(std::move(chunk));
+			++pushed;
+		}
+	}
+};
+
+class PredecodeTest : public ::testing::Test {
+protected:
+	Mutex mutex;
+	Cond client_cond;
+	const ReplayGainConfig replay_gain_config;
+
+	MusicBuffer buffer{16};
+
+	DecoderControl dc{mutex, client_cond, nullptr, nullptr,
+			  AudioFormat::Undefined(), replay_gain_config};
+	DecoderControl predecoder{mutex, client_cond, nullptr, nullptr,
+				  AudioFormat::Undefined(),
+				  replay_gain_config};
+
+	void SetUp() override {
+		dc.pipe = std::make_shared<MusicPipe>();
+		predecoder.pipe = std::make_shared<MusicPipe>();
+	}
+
+	void TearDown() override {
+		dc.pipe->Clear();
+		predecoder.pipe->Clear();
+	}
+
+	/**
+	 * Wait until the #FakeDecoder has pushed the given number
+	 * of chunks, and then a little bit longer to see that it
+	 * does not push more.
+	 */
+	static void WaitPushed(const FakeDecoder &d, unsigned n) {
+		while (d.pushed < n)
+			std::this_thread::yield();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+};
+
+/**
+ * Simulates the decoder thread's main loop (see decoder/Thread.cxx):
+ * it executes the START and STOP commands sent by the player, and
+ * "decodes" a fixed number of chunks per song, honouring the pipe
+ * limit.  The number of each chunk is stored in
+ * MusicChunk::bit_rate.
+ */
+class FakeDecoderThread {
+	DecoderControl &dc;
+	const unsigned n_chunks;
+
+	/**
+	 * Protected by DecoderControl::mutex.
+	 */
+	bool quit = false;
+
+	/* declared last, because the thread accesses all other
+	   attributes as soon as it is started */
+	std::thread thread;
+
+public:
+	FakeDecoderThread(DecoderControl &_dc, unsigned _n_chunks)
+		:dc(_dc), n_chunks(_n_chunks),
+		 thread([this](){ Run(); }) {}
+
+	~FakeDecoderThread() noexcept {
+		{
+			const std::lock_guard<Mutex> protect(dc.mutex);
+			quit = true;
+			dc.Signal();
+		}
+
+		thread.join();
+	}
+
+private:
+	void Run() noexcept {
+		std::unique_lock<Mutex> lock(dc.mutex);
+
+		while (!quit) {
+			switch (dc.command) {
+			case DecoderCommand::NONE:
+				dc.Wait(lock);
+				break;
+
+			case DecoderCommand::START:
+				dc.state = DecoderState::START;
+				dc.CommandFinishedLocked();
+				dc.SetReady(AudioFormat(44100,
+							SampleFormat::S16, 2),
+					    true, SignedSongTime::FromS(60));
+				Decode(lock);
+				dc.state = DecoderState::STOP;
+				dc.client_cond.notify_one();
+				break;
+
+			case DecoderCommand::STOP:
+			case DecoderCommand::SEEK:
+				dc.state = DecoderState::STOP;
+				dc.CommandFinishedLocked();
+				break;
+			}
+		}
+	}
+
+	void Decode(std::unique_lock<Mutex> &lock) noexcept {
+		for (unsigned i = 0; i < n_chunks; ++i) {
+			while (dc.command == DecoderCommand::NONE &&
+			       dc.IsPipeLimitReached())
+				dc.Wait(lock);
+
+			if (dc.command != DecoderCommand::NONE)
+				/* let Run() handle the command */
+				return;
+
+			auto chunk = MakeChunk(*dc.buffer);
+			chunk->bit_rate = i;
+			dc.pipe->Push(std::move(chunk));
+			dc.client_cond.notify_one();
+		}
+	}
+};
+
+/**
+ * Drives the real #Predecoder with two simulated decoder threads,
+ * like the player thread does.
+ */
+class PlayerPredecodeTest : public ::testing::Test {
+protected:
+	static constexpr unsigned BUFFER_SIZE = 64;
+	static constexpr unsigned MAIN_CHUNKS = 3;
+	static constexpr unsigned NEXT_CHUNKS = 40;
+
+	Mutex mutex;
+	Cond client_cond;
+	const ReplayGainConfig replay_gain_config;
+
+	const AudioFormat audio_format{44100, SampleFormat::S16, 2};
+
+	MusicBuffer buffer{BUFFER_SIZE};
+
+	DecoderControl dc{mutex, client_cond, nullptr, nullptr,
+			  AudioFormat::Undefined(), replay_gain_config};
+	DecoderControl second{mutex, client_cond, nullptr, nullptr,
+			      AudioFormat::Undefined(), replay_gain_config};
+
+	/* declared after the #DecoderControl instances, because
+	   they must be stopped before those are destructed */
+	FakeDecoderThread dc_thread{dc, MAIN_CHUNKS};
+	FakeDecoderThread second_thread{second, NEXT_CHUNKS};
+
+	Predecoder predecoder{&second};
+
+	/**
+	 * The main decoder, as seen by the player; this gets swapped
+	 * by Predecoder::SwitchTo().
+	 */
+	DecoderControl *current = &dc;
+
+	/**
+	 * The pipe of the current song, owned by the "player".
+	 */
+	std::shared_ptr<MusicPipe> pipe;
+
+	void TearDown() override {
+		std::unique_lock<Mutex> lock(mutex);
+		predecoder.Stop(lock);
+		current->Stop(lock);
+
+		if (pipe != nullptr)
+			pipe->Clear();
+		if (current->pipe != nullptr && current->pipe != pipe)
+			current->pipe->Clear();
+	}
+
+	/**
+	 * Start the main decoder, like Player::StartDecoder().
+	 */
+	void StartMain(std::unique_lock<Mutex> &lock, const char *uri) {
+		pipe = std::make_shared<MusicPipe>();
+		current->Start(lock, std::make_unique<DetachedSong>(uri),
+			       SongTime::zero(), SongTime::zero(),
+			       buffer, pipe);
+	}
+
+	void StartPredecoder(std::unique_lock<Mutex> &lock,
+			     const char *uri) {
+		predecoder.Start(lock, std::make_unique<DetachedSong>(uri),
+				 SongTime::zero(), SongTime::zero(),
+				 ReplayGainMode::TRACK,
+				 buffer, audio_format);
+	}
+
+	/**
+	 * Wait until the given decoder has finished (or paused at
+	 * its pipe limit).
+	 */
+	void WaitDecoder(std::unique_lock<Mutex> &lock,
+			 DecoderControl &d) {
+		while (!d.IsIdle() &&
+		       !(d.pipe != nullptr && d.IsPipeLimitReached()))
+			client_cond.wait(lock);
+	}
+
+	/**
+	 * Check that the pipe contains chunks numbered 0..n-1 and
+	 * remove them.
+	 */
+	static void CheckChunks(MusicPipe &p, unsigned n) {
+		EXPECT_EQ(p.GetSize(), n);
+
+		unsigned i = 0;
+		while (auto chunk = p.Shift()) {
+			EXPECT_EQ(chunk->bit_rate, i);
+			++i;
+		}
+
+		EXPECT_EQ(i, n);
+	}
+};
+
+} // namespace
+
+TEST_F(PredecodeTest, PipeLimit)
+{
+	EXPECT_FALSE(predecoder.IsPipeLimitReached());
+
+	predecoder.pipe_limit = 2;
+	EXPECT_FALSE(predecoder.IsPipeLimitReached());
+
+	predecoder.pipe->Push(MakeChunk(buffer));
+	EXPECT_FALSE(predecoder.IsPipeLimitReached());
+
+	predecoder.pipe->Push(MakeChunk(buffer));
+	EXPECT_TRUE(predecoder.IsPipeLimitReached());
+
+	/* 0 means "no limit" */
+	predecoder.pipe_limit = 0;
+	EXPECT_FALSE(predecoder.IsPipeLimitReached());
+}
+
+TEST_F(PredecodeTest, Handoff)
+{
+	MixRampInfo mix_ramp;
+	mix_ramp.SetEnd("1.0;2.0");
+	dc.SetMixRamp(std::move(mix_ramp));
+	dc.replay_gain_db = -3.5;
+
+	predecoder.pipe_limit = 2;
+
+	FakeDecoder d(predecoder, buffer, 5);
+	WaitPushed(d, 2);
+
+	{
+		/* the pre-decoder must stop at the limit, leaving
+		   the rest of the buffer to the current song */
+		const std::lock_guard<Mutex> protect(mutex);
+		EXPECT_EQ(predecoder.pipe->GetSize(), 2u);
+	}
+
+	EXPECT_EQ(d.pushed, 2u);
+
+	{
+		/* this is what Player::SwitchToPredecoder() does
+		   after the main decoder has finished */
+		const std::lock_guard<Mutex> protect(mutex);
+		predecoder.TakePrevious(dc);
+		predecoder.pipe_limit = 0;
+		predecoder.Signal();
+	}
+
+	d.Join();
+
+	EXPECT_EQ(d.result, DecoderCommand::NONE);
+	EXPECT_EQ(d.pushed, 5u);
+	EXPECT_EQ(predecoder.pipe->GetSize(), 5u);
+
+	/* the chunks were pushed in order and are all there */
+	unsigned n = 0;
+	while (auto chunk = predecoder.pipe->Shift()) {
+		EXPECT_EQ(chunk->length, 4u);
+		++n;
+	}
+
+	EXPECT_EQ(n, 5u);
+
+	EXPECT_STREQ(predecoder.GetMixRampPreviousEnd(), "1.0;2.0");
+	EXPECT_FLOAT_EQ(predecoder.replay_gain_prev_db, -3.5);
+}
+
+TEST_F(PredecodeTest, StopAtLimit)
+{
+	predecoder.pipe_limit = 1;
+
+	FakeDecoder d(predecoder, buffer, 5);
+	WaitPushed(d, 1);
+
+	{
+		/* Player::StopPredecoder() sends STOP while the
+		   pre-decoder waits at the limit */
+		const std::lock_guard<Mutex> protect(mutex);
+		predecoder.command = DecoderCommand::STOP;
+		predecoder.Signal();
+	}
+
+	d.Join();
+
+	EXPECT_EQ(d.result, DecoderCommand::STOP);
+	EXPECT_EQ(d.pushed, 1u);
+	EXPECT_EQ(predecoder.pipe->GetSize(), 1u);
+
+	predecoder.command = DecoderCommand::NONE;
+}
+
+TEST(Predecoder, CalcPipeLimit)
+{
+	const AudioFormat audio_format(44100, SampleFormat::S16, 2);
+	const size_t chunk_size = sizeof(MusicChunk::data);
+	const unsigned two_seconds =
+		(audio_format.TimeToSize(std::chrono::seconds(2))
+		 + chunk_size - 1) / chunk_size;
+
+	/* two seconds if the buffer is large enough */
+	EXPECT_EQ(Predecoder::CalcPipeLimit(audio_format, 4096),
+		  two_seconds);
+
+	/* never more than a quarter of the buffer */
+	EXPECT_EQ(Predecoder::CalcPipeLimit(audio_format, 64), 16u);
+
+	/* but at least one chunk */
+	EXPECT_EQ(Predecoder::CalcPipeLimit(audio_format, 2), 1u);
+}
+
+TEST_F(PlayerPredecodeTest, Switch)
+{
+	std::unique_lock<Mutex> lock(mutex);
+
+	EXPECT_TRUE(predecoder.IsEnabled());
+	EXPECT_FALSE(predecoder.IsBusy());
+
+	StartMain(lock, "a");
+	StartPredecoder(lock, "b");
+	EXPECT_TRUE(predecoder.IsBusy());
+	EXPECT_EQ(second.replay_gain_mode, ReplayGainMode::TRACK);
+
+	const unsigned limit =
+		Predecoder::CalcPipeLimit(audio_format, BUFFER_SIZE);
+	EXPECT_EQ(second.pipe_limit, limit);
+
+	/* the pre-decoder stops at the limit, leaving the rest of
+	   the buffer to the current song */
+	WaitDecoder(lock, second);
+	EXPECT_FALSE(second.IsIdle());
+	EXPECT_EQ(second.pipe->GetSize(), limit);
+
+	/* the main decoder finishes the current song */
+	WaitDecoder(lock, dc);
+	EXPECT_TRUE(dc.IsIdle());
+
+	MixRampInfo mix_ramp;
+	mix_ramp.SetEnd("1.0;2.0");
+	dc.SetMixRamp(std::move(mix_ramp));
+	dc.replay_gain_db = -3.5;
+
+	predecoder.SwitchTo(current);
+
+	/* the decoders have been swapped */
+	EXPECT_EQ(current, &second);
+	EXPECT_STREQ(current->song->GetURI(), "b");
+	EXPECT_EQ(current->pipe_limit, 0u);
+	EXPECT_STREQ(current->GetMixRampPreviousEnd(), "1.0;2.0");
+	EXPECT_FLOAT_EQ(current->replay_gain_prev_db, -3.5);
+
+	/* the old decoder has been detached from the player's pipe,
+	   which still contains the end of the current song; it is
+	   now the (idle) pre-decoder */
+	EXPECT_EQ(dc.pipe, nullptr);
+	EXPECT_FALSE(predecoder.IsBusy());
+	CheckChunks(*pipe, MAIN_CHUNKS);
+
+	/* with the limit lifted, the rest of the next song is
+	   decoded; the player continues with its pipe */
+	pipe = current->pipe;
+	WaitDecoder(lock, *current);
+	EXPECT_TRUE(current->IsIdle());
+	CheckChunks(*pipe, NEXT_CHUNKS);
+
+	/* the old main decoder can now pre-decode the song after
+	   that */
+	StartPredecoder(lock, "c");
+	EXPECT_TRUE(predecoder.IsBusy());
+	EXPECT_STREQ(dc.song->GetURI(), "c");
+	EXPECT_EQ(dc.pipe_limit, limit);
+}
+
+TEST_F(PlayerPredecodeTest, Cancel)
+{
+	std::unique_lock<Mutex> lock(mutex);
+
+	StartMain(lock, "a");
+	StartPredecoder(lock, "b");
+	WaitDecoder(lock, second);
+	EXPECT_GT(second.pipe->GetSize(), 0u);
+
+	/* e.g. the queue has been modified: the pre-decoded song
+	   is not the next one anymore */
+	predecoder.Stop(lock);
+
+	EXPECT_FALSE(predecoder.IsBusy());
+	EXPECT_TRUE(second.IsIdle());
+	EXPECT_EQ(second.pipe, nullptr);
+	EXPECT_EQ(second.pipe_limit, 0u);
+
+	/* all of its chunks have been returned to the buffer */
+	WaitDecoder(lock, dc);
+	{
+		const ScopeUnlock unlock(mutex);
+		EXPECT_EQ(buffer.GetAllocated(), MAIN_CHUNKS);
+	}
+
+	/* the pre-decoder can be started again */
+	StartPredecoder(lock, "c");
+	EXPECT_TRUE(predecoder.IsBusy());
+	EXPECT_STREQ(second.song->GetURI(), "c");
+}
+
+TEST_F(PlayerPredecodeTest, Disabled)
+{
+	Predecoder disabled(nullptr);
+	EXPECT_FALSE(disabled.IsEnabled());
+	EXPECT_FALSE(disabled.IsBusy());
+
+	/* stopping a disabled pre-decoder is a no-op */
+	std::unique_lock<Mutex> lock(mutex);
+	disabled.Stop(lock);
+}
@@ -0,0 +1,241 @@
+/*
+ * Unit tests for the queue's change log, which must yield the same
+ * result as scanning the whole queue with IsNewerAtPosition().
+ */
+
+#include "queue/Queue.hxx"
+#include "song/DetachedSong.hxx"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+
+void Tag::Clear() noexcept {}
+
+static std::set<unsigned>
+ScanChanges(const Queue &queue, uint32_t version)
+{
+	std::set<unsigned> result;
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		if (queue.IsNewerAtPosition(i, version))
+			result.insert(i);
+	return result;
+}
+
+static std::set<unsigned>
+LogChanges(const Queue &queue, uint32_t version)
+{
+	std::vector<QueueChangeLog::Range> ranges;
+	EXPECT_TRUE(queue.CollectChanges(version, ranges));
+
+	std::set<unsigned> result;
+	for (const auto &range : ranges)
+		for (unsigned i = range.first;
+		     i < range.second && i < queue.GetLength(); ++i)
+			if (queue.IsNewerAtPosition(i, version))
+				result.insert(i);
+	return result;
+}
+
+TEST(QueueChanges, Basic)
+{
+	Queue queue(64);
+
+	for (unsigned i = 0; i < 8; ++i)
+		queue.Append(DetachedSong("foo.ogg"), 0);
+	queue.IncrementVersion();
+
+	const uint32_t v = queue.version;
+
+	queue.ModifyAtPosition(5);
+	queue.IncrementVersion();
+
+	std::vector<QueueChangeLog::Range> ranges;
+	ASSERT_TRUE(queue.CollectChanges(v, ranges));
+	ASSERT_EQ(1u, ranges.size());
+	EXPECT_EQ(5u, ranges.front().first);
+	EXPECT_EQ(6u, ranges.front().second);
+
+	/* deleting a song shifts all following songs */
+	queue.DeletePosition(2);
+	queue.IncrementVersion();
+
+	ASSERT_TRUE(queue.CollectChanges(v, ranges));
+	ASSERT_EQ(1u, ranges.size());
+	EXPECT_EQ(2u, ranges.front().first);
+	EXPECT_EQ(7u, ranges.front().second);
+
+	/* a version from the future requires a full scan */
+	EXPECT_FALSE(queue.CollectChanges(queue.version + 1, ranges));
+}
+
+/**
+ * Apply a random modification to the queue.  In random mode, the
+ * "order" list is modified as well.
+ */
+template<typename R>
+static void
+RandomStep(Queue &queue, R &rnd)
+{
+	const unsigned length = queue.GetLength();
+
+	const unsigned n_ops = queue.random ? 11 : 6;
+	switch (length < 4 ? 0 : rnd() % n_ops) {
+	case 0:
+		if (!queue.IsFull())
+			queue.Append(DetachedSong("foo.ogg"), 0);
+		break;
+
+	case 1:
+		queue.DeletePosition(rnd() % length);
+		break;
+
+	case 2:
+		queue.MovePostion(rnd() % length, rnd() % length);
+		break;
+
+	case 3:
+		queue.SwapPositions(rnd() % length, rnd() % length);
+		break;
+
+	case 4:
+		queue.ModifyAtPosition(rnd() % length);
+		break;
+
+	case 5:
+		queue.SetPriority(rnd() % length, rnd() % 4, -1);
+		break;
+
+	/* the following operations are only used in random mode */
+
+	case 6:
+		/* reorders the "order" list, too */
+		queue.SetPriority(rnd() % length, rnd() % 4,
+				  int(rnd() % length) - 1);
+		break;
+
+	case 7:
+		queue.ModifyAtOrder(rnd() % length);
+		break;
+
+	case 8:
+		queue.MoveOrder(rnd() % length, rnd() % length);
+		break;
+
+	case 9:
+		queue.SwapOrders(rnd() % length, rnd() % length);
+		break;
+
+	case 10:
+		queue.ShuffleOrder();
+		break;
+	}
+
+	queue.IncrementVersion();
+}
+
+/**
+ * Compare the change log with a full scan for some versions which
+ * are recent enough to be covered by the log.
+ */
+template<typename R>
+static void
+CheckRecentVersions(const Queue &queue,
+		    const std::vector<uint32_t> &versions, R &rnd)
+{
+	for (unsigned i = 0; i < 4; ++i) {
+		const unsigned back = rnd() % std::min<size_t>(versions.size(), 64);
+		const uint32_t v = versions[versions.size() - 1 - back];
+		EXPECT_EQ(ScanChanges(queue, v), LogChanges(queue, v));
+	}
+}
+
+TEST(QueueChanges, Random)
+{
+	Queue queue(256);
+	std::minstd_rand rnd;
+
+	std::vector<uint32_t> versions;
+
+	for (unsigned step = 0; step < 2000; ++step) {
+		RandomStep(queue, rnd);
+		versions.push_back(queue.version);
+		CheckRecentVersions(queue, versions, rnd);
+	}
+}
+
+TEST(QueueChanges, RandomMode)
+{
+	Queue queue(256);
+	std::minstd_rand rnd;
+
+	std::vector<uint32_t> versions;
+
+	for (unsigned i = 0; i < 16; ++i)
+		queue.Append(DetachedSong("foo.ogg"), 0);
+
+	queue.random = true;
+	queue.ShuffleOrder();
+	queue.IncrementVersion();
+
+	for (unsigned step = 0; step < 2000; ++step) {
+		RandomStep(queue, rnd);
+		versions.push_back(queue.version);
+		CheckRecentVersions(queue, versions, rnd);
+
+		/* the "order" list still refers to all items */
+		for (unsigned i = 0; i < queue.GetLength(); ++i)
+			EXPECT_EQ(queue.PositionToOrder(queue.OrderToPosition(i)),
+				  i);
+	}
+}
+
+TEST(QueueChanges, WrapAround)
+{
+	Queue queue(256);
+	std::minstd_rand rnd;
+
+	for (unsigned i = 0; i < 8; ++i)
+		queue.Append(DetachedSong("foo.ogg"), 0);
+	queue.IncrementVersion();
+
+	/* let the version wrap around; all items get version 0 */
+	queue.version = (uint32_t(1) << 31) - 2;
+	queue.ModifyAtPosition(3);
+	queue.IncrementVersion();
+	ASSERT_EQ(queue.version, 1u);
+
+	/* the log restarts right away and reports the items with
+	   version 0 */
+	std::vector<QueueChangeLog::Range> ranges;
+	ASSERT_TRUE(queue.CollectChanges(queue.version, ranges));
+	ASSERT_EQ(1u, ranges.size());
+	EXPECT_EQ(0u, ranges.front().first);
+	EXPECT_EQ(8u, ranges.front().second);
+
+	std::vector<uint32_t> versions{queue.version};
+
+	for (unsigned step = 0; step < 2000; ++step) {
+		RandomStep(queue, rnd);
+		versions.push_back(queue.version);
+		CheckRecentVersions(queue, versions, rnd);
+	}
+
+	/* after the queue has been cleared, there are no items with
+	   version 0 anymore */
+	queue.Clear();
+	queue.IncrementVersion();
+	const uint32_t v = queue.version;
+	queue.Append(DetachedSong("foo.ogg"), 0);
+	queue.Append(DetachedSong("foo.ogg"), 0);
+	queue.IncrementVersion();
+	queue.ModifyAtPosition(1);
+	queue.IncrementVersion();
+
+	ASSERT_TRUE(queue.CollectChanges(queue.version - 1, ranges));
+	ASSERT_EQ(1u, ranges.size());
+	EXPECT_EQ(1u, ranges.front().first);
+	EXPECT_EQ(2u, ranges.front().second);
+	EXPECT_EQ(ScanChanges(queue, v), LogChanges(queue, v));
+}
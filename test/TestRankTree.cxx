@@ -0,0 +1,237 @@
+/*
+ * Unit tests for class RankTree.
+ */
+
+#include "util/RankTree.hxx"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Node {
+	RankTreeHook hook;
+	unsigned value;
+
+	explicit Node(unsigned _value) noexcept:value(_value) {}
+};
+
+typedef RankTree<Node, &Node::hook> Tree;
+
+}
+
+static void
+Check(const Tree &tree, const std::vector<Node *> &expected)
+{
+	ASSERT_EQ(expected.size(), size_t(tree.size()));
+
+	unsigned i = 0;
+	for (const auto &node : tree) {
+		ASSERT_LT(i, expected.size());
+		EXPECT_EQ(expected[i], &node);
+		EXPECT_EQ(expected[i], &tree[i]);
+		EXPECT_EQ(i, tree.IndexOf(node));
+		++i;
+	}
+
+	EXPECT_EQ(expected.size(), size_t(i));
+}
+
+TEST(RankTree, Basic)
+{
+	std::vector<std::unique_ptr<Node>> nodes;
+	for (unsigned i = 0; i < 8; ++i)
+		nodes.emplace_back(std::make_unique<Node>(i));
+
+	Tree tree;
+	EXPECT_TRUE(tree.empty());
+	EXPECT_EQ(0u, tree.size());
+	EXPECT_TRUE(tree.begin() == tree.end());
+
+	std::vector<Node *> expected;
+	for (auto &i : nodes) {
+		tree.push_back(*i);
+		expected.push_back(i.get());
+	}
+
+	EXPECT_FALSE(tree.empty());
+	Check(tree, expected);
+
+	/* erase the first, the last and one in the middle */
+	tree.erase(*nodes[0]);
+	tree.erase(*nodes[7]);
+	tree.erase(*nodes[4]);
+	expected = {nodes[1].get(), nodes[2].get(), nodes[3].get(),
+		    nodes[5].get(), nodes[6].get()};
+	Check(tree, expected);
+
+	/* insert them at other places */
+	tree.insert(0, *nodes[7]);
+	tree.insert(3, *nodes[0]);
+	tree.insert(7, *nodes[4]);
+	expected = {nodes[7].get(), nodes[1].get(), nodes[2].get(),
+		    nodes[0].get(), nodes[3].get(), nodes[5].get(),
+		    nodes[6].get(), nodes[4].get()};
+	Check(tree, expected);
+
+	tree.Swap(*nodes[7], *nodes[4]);
+	std::swap(expected.front(), expected.back());
+	Check(tree, expected);
+
+	tree.Swap(*nodes[0], *nodes[2]);
+	std::swap(expected[2], expected[3]);
+	Check(tree, expected);
+
+	EXPECT_EQ(nodes[5].get(), &*tree.IteratorAt(5));
+	EXPECT_TRUE(tree.IteratorAt(8) == tree.end());
+
+	tree.clear();
+	EXPECT_TRUE(tree.empty());
+}
+
+/**
+ * Compare random operations with a std::vector.
+ */
+TEST(RankTree, Random)
+{
+	constexpr unsigned N = 1000;
+
+	std::vector<std::unique_ptr<Node>> nodes;
+	for (unsigned i = 0; i < N; ++i)
+		nodes.emplace_back(std::make_unique<Node>(i));
+
+	Tree tree;
+	std::vector<Node *> expected;
+	for (auto &i : nodes) {
+		tree.push_back(*i);
+		expected.push_back(i.get());
+	}
+
+	std::minstd_rand rnd;
+
+	for (unsigned i = 0; i < 200; ++i) {
+		/* move a range */
+		unsigned start = rnd() % N, end = rnd() % N;
+		if (start > end)
+			std::swap(start, end);
+		const unsigned to = rnd() % (N - (end - start) + 1);
+
+		tree.Move(start, end, to);
+
+		std::vector<Node *> range(expected.begin() + start,
+					  expected.begin() + end);
+		expected.erase(expected.begin() + start,
+			       expected.begin() + end);
+		expected.insert(expected.begin() + to,
+				range.begin(), range.end());
+
+		/* remove and re-insert one element */
+		Node &node = *expected[rnd() % N];
+		const unsigned index = rnd() % N;
+		tree.erase(node);
+		tree.insert(index, node);
+		expected.erase(std::find(expected.begin(), expected.end(),
+					 &node));
+		expected.insert(expected.begin() + index, &node);
+	}
+
+	Check(tree, expected);
+
+	/* reverse a range */
+	tree.Permute(100, 900, [](std::vector<Node *> &v){
+		std::reverse(v.begin(), v.end());
+	});
+	std::reverse(expected.begin() + 100, expected.begin() + 900);
+
+	Check(tree, expected);
+}
+
+TEST(RankTree, Stamp)
+{
+	std::vector<std::unique_ptr<Node>> nodes;
+	for (unsigned i = 0; i < 100; ++i)
+		nodes.emplace_back(std::make_unique<Node>(i));
+
+	Tree tree;
+	for (auto &i : nodes) {
+		i->hook.stamp = 0;
+		tree.push_back(*i);
+	}
+
+	tree.RaiseStampRange(10, 20, 1);
+	tree.RaiseStampRange(15, 30, 2);
+	tree.RaiseStamp(*nodes[50], 3);
+
+	const auto expected_stamp = [](unsigned value) -> uint32_t {
+		if (value == 50)
+			return 3;
+		if (value >= 15 && value < 30)
+			return 2;
+		if (value >= 10 && value < 15)
+			return 1;
+		return 0;
+	};
+
+	/* stamps must follow the elements when they are moved */
+	tree.Move(0, 40, 60);
+	tree.Swap(*nodes[12], *nodes[90]);
+	tree.erase(*nodes[25]);
+	tree.insert(0, *nodes[25]);
+	tree.Permute(0, 100, [](std::vector<Node *> &v){
+		std::reverse(v.begin(), v.end());
+	});
+
+	for (const auto &i : nodes)
+		EXPECT_EQ(expected_stamp(i->value), tree.GetStamp(*i));
+
+	tree.ResetStamps();
+	for (const auto &i : nodes)
+		EXPECT_EQ(0u, tree.GetStamp(*i));
+}
+
+TEST(RankTree, Key)
+{
+	constexpr unsigned N = 500;
+
+	std::vector<std::unique_ptr<Node>> nodes;
+	for (unsigned i = 0; i < N; ++i)
+		nodes.emplace_back(std::make_unique<Node>(i));
+
+	Tree tree;
+	for (auto &i : nodes) {
+		i->hook.key = 0;
+		tree.push_back(*i);
+	}
+
+	std::minstd_rand rnd;
+
+	for (unsigned i = 0; i < 300; ++i) {
+		tree.SetKey(*nodes[rnd() % N], rnd() % 4);
+
+		const unsigned start = rnd() % N, end = rnd() % N;
+		tree.Move(std::min(start, end), std::max(start, end),
+			  rnd() % (N - (std::max(start, end) -
+					std::min(start, end)) + 1));
+
+		Node &node = *nodes[rnd() % N];
+		tree.erase(node);
+		tree.insert(rnd() % N, node);
+
+		/* compare with a linear search */
+		const unsigned from = rnd() % (N + 1);
+		const uint8_t key = rnd() % 4;
+
+		unsigned expected = from;
+		while (expected < N && Tree::GetKey(tree[expected]) != key)
+			++expected;
+
+		EXPECT_EQ(expected,
+			  tree.FindKey(from, [key](uint8_t min, uint8_t max){
+				  return min <= key && key <= max;
+			  }));
+	}
+}
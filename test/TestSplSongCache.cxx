@@ -0,0 +1,154 @@
+/*
+ * Unit tests for the stored playlist song cache.
+ */
+
+#include "config.h"
+#include "playlist/SplSongCache.hxx"
+#include "playlist/SongListEnumerator.hxx"
+#include "playlist/PlaylistRegistry.hxx"
+#include "song/DetachedSong.hxx"
+#include "tag/Tag.hxx"
+#include "config/Data.hxx"
+#include "fs/Path.hxx"
+#include "thread/Mutex.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <typeinfo>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static constexpr char extm3u[] =
+	"#EXTM3U\n"
+	"#EXTINF:123,Artist - Title\n"
+	"http://example.com/a.mp3\n"
+	"#EXTINF:45,Second\n"
+	"http://example.com/b.mp3\n";
+
+class SplSongCacheTest : public ::testing::Test {
+protected:
+	char path[40];
+
+	Mutex mutex;
+
+	static void SetUpTestCase() {
+		playlist_list_global_init(ConfigData());
+	}
+
+	static void TearDownTestCase() {
+		playlist_list_global_finish();
+	}
+
+	void SetUp() override {
+		strcpy(path, "/tmp/TestSplSongCache.XXXXXX.m3u");
+		int fd = mkstemps(path, 4);
+		ASSERT_GE(fd, 0);
+		close(fd);
+	}
+
+	void TearDown() override {
+		spl_song_cache_erase("test");
+		unlink(path);
+	}
+
+	void Write(const char *data) {
+		FILE *file = fopen(path, "w");
+		ASSERT_NE(file, nullptr);
+		fputs(data, file);
+		fclose(file);
+	}
+
+	std::unique_ptr<SongEnumerator> Open() {
+		return spl_song_cache_open("test", Path::FromFS(path), mutex);
+	}
+
+	static void CheckExtM3u(SongEnumerator &e) {
+		auto song = e.NextSong();
+		ASSERT_NE(song, nullptr);
+		EXPECT_STREQ(song->GetURI(), "http://example.com/a.mp3");
+		EXPECT_STREQ(song->GetTag().GetValue(TAG_NAME),
+			     "Artist - Title");
+		EXPECT_EQ(song->GetTag().duration.ToS(), 123);
+
+		song = e.NextSong();
+		ASSERT_NE(song, nullptr);
+		EXPECT_STREQ(song->GetURI(), "http://example.com/b.mp3");
+		EXPECT_STREQ(song->GetTag().GetValue(TAG_NAME), "Second");
+		EXPECT_EQ(song->GetTag().duration.ToS(), 45);
+
+		EXPECT_EQ(e.NextSong(), nullptr);
+	}
+};
+
+TEST_F(SplSongCacheTest, ExtM3u)
+{
+	Write(extm3u);
+
+	/* the first time, the file is parsed by the extm3u plugin */
+	auto e = Open();
+	ASSERT_NE(e, nullptr);
+	EXPECT_NE(typeid(*e), typeid(SongListEnumerator));
+	CheckExtM3u(*e);
+
+	/* the second time, the songs come from the cache, with all
+	   the tags parsed from the #EXTINF lines */
+	e = Open();
+	ASSERT_NE(e, nullptr);
+	EXPECT_EQ(typeid(*e), typeid(SongListEnumerator));
+	CheckExtM3u(*e);
+}
+
+TEST_F(SplSongCacheTest, Incomplete)
+{
+	Write(extm3u);
+
+	/* stop after the first song: nothing is cached */
+	auto e = Open();
+	ASSERT_NE(e, nullptr);
+	EXPECT_NE(e->NextSong(), nullptr);
+
+	e = Open();
+	ASSERT_NE(e, nullptr);
+	EXPECT_NE(typeid(*e), typeid(SongListEnumerator));
+	CheckExtM3u(*e);
+}
+
+TEST_F(SplSongCacheTest, Invalidate)
+{
+	Write(extm3u);
+
+	auto e = Open();
+	ASSERT_NE(e, nullptr);
+	CheckExtM3u(*e);
+
+	/* the file size changes */
+	Write("#EXTM3U\n"
+	      "#EXTINF:7,Other\n"
+	      "http://example.com/c.mp3\n");
+
+	e = Open();
+	ASSERT_NE(e, nullptr);
+	EXPECT_NE(typeid(*e), typeid(SongListEnumerator));
+
+	auto song = e->NextSong();
+	ASSERT_NE(song, nullptr);
+	EXPECT_STREQ(song->GetURI(), "http://example.com/c.mp3");
+	EXPECT_STREQ(song->GetTag().GetValue(TAG_NAME), "Other");
+	EXPECT_EQ(e->NextSong(), nullptr);
+
+	/* after an explicit erase, the file is parsed again */
+	spl_song_cache_erase("test");
+	e = Open();
+	ASSERT_NE(e, nullptr);
+	EXPECT_NE(typeid(*e), typeid(SongListEnumerator));
+}
+
+TEST_F(SplSongCacheTest, NoSuchFile)
+{
+	unlink(path);
+	EXPECT_EQ(Open(), nullptr);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "song/StickerSongFilter.hxx"
+#include "song/Filter.hxx"
+#include "song/LightSong.hxx"
+#include "tag/Tag.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+static bool
+InvokeFilter(const ISongFilter &f, const char *uri) noexcept
+{
+	return f.Match(LightSong(uri, Tag()));
+}
+
+TEST(StickerSongFilter, Basic)
+{
+	auto predicate = std::make_shared<StickerSongFilter::Predicate>("rating",
+									StickerOperator::GREATER_THAN,
+									"3");
+	const StickerSongFilter f(predicate);
+	EXPECT_EQ(f.ToExpression(), "(sticker:rating > \"3\")");
+
+	/* nothing loaded yet */
+	EXPECT_FALSE(InvokeFilter(f, "a.ogg"));
+
+	predicate->uris.emplace("a.ogg");
+	predicate->uris.emplace("dir/b.ogg");
+
+	EXPECT_TRUE(InvokeFilter(f, "a.ogg"));
+	EXPECT_TRUE(InvokeFilter(f, "dir/b.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "b.ogg"));
+
+	/* clones share the loaded songs */
+	const auto clone = f.Clone();
+	predicate->uris.emplace("c.ogg");
+	EXPECT_TRUE(InvokeFilter(*clone, "c.ogg"));
+}
+
+#ifdef ENABLE_SQLITE
+
+TEST(StickerSongFilter, Parse)
+{
+	const char *args[] = {
+		"((sticker:rating > \"3\") AND (!(sticker:skip)))",
+	};
+
+	SongFilter filter;
+	filter.Parse({args, 1});
+	filter.Optimize();
+
+	const auto &predicates = filter.GetStickerPredicates();
+	ASSERT_EQ(predicates.size(), 2u);
+	EXPECT_EQ(predicates[0]->name, "rating");
+	EXPECT_EQ(predicates[0]->op, StickerOperator::GREATER_THAN);
+	EXPECT_EQ(predicates[0]->value, "3");
+	EXPECT_EQ(predicates[1]->name, "skip");
+	EXPECT_EQ(predicates[1]->op, StickerOperator::EXISTS);
+
+	EXPECT_EQ(filter.ToExpression(),
+		  "((sticker:rating > \"3\") AND (!(sticker:skip)))");
+
+	predicates[0]->uris.emplace("a.ogg");
+	predicates[0]->uris.emplace("b.ogg");
+	predicates[1]->uris.emplace("b.ogg");
+
+	EXPECT_TRUE(filter.Match(LightSong("a.ogg", Tag())));
+	EXPECT_FALSE(filter.Match(LightSong("b.ogg", Tag())));
+	EXPECT_FALSE(filter.Match(LightSong("c.ogg", Tag())));
+
+	const char *bad[] = {
+		"(sticker:rating ~ \"3\")",
+	};
+
+	SongFilter filter2;
+	EXPECT_THROW(filter2.Parse({bad, 1}), std::runtime_error);
+}
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Unit tests for the incremental XML playlist parsers.
+ */
+
+#include "playlist/PlaylistPlugin.hxx"
+#include "playlist/SongEnumerator.hxx"
+#include "playlist/plugins/AsxPlaylistPlugin.hxx"
+#include "playlist/plugins/XspfPlaylistPlugin.hxx"
+#include "input/InputStream.hxx"
+#include "song/DetachedSong.hxx"
+#include "tag/Tag.hxx"
+#include "thread/Mutex.hxx"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+/**
+ * Returns the given string in small chunks, to exercise the
+ * incremental parser.
+ */
+class StringInputStream final : public InputStream {
+	const char *data;
+	size_t remaining;
+
+public:
+	StringInputStream(Mutex &_mutex, const char *_data)
+		:InputStream("test://", _mutex),
+		 data(_data), remaining(strlen(data)) {
+		SetReady();
+	}
+
+	/* virtual methods from InputStream */
+	bool IsEOF() const noexcept override {
+		return remaining == 0;
+	}
+
+	size_t Read(std::unique_lock<Mutex> &,
+		    void *ptr, size_t read_size) override {
+		size_t nbytes = std::min({remaining, read_size, size_t(7)});
+		memcpy(ptr, data, nbytes);
+		data += nbytes;
+		remaining -= nbytes;
+		offset += nbytes;
+		return nbytes;
+	}
+};
+
+static std::unique_ptr<SongEnumerator>
+Open(const playlist_plugin &plugin, Mutex &mutex, const char *data)
+{
+	auto e = plugin.open_stream(std::make_unique<StringInputStream>(mutex,
+									data));
+	EXPECT_NE(e, nullptr);
+	return e;
+}
+
+TEST(XmlPlaylist, Xspf)
+{
+	Mutex mutex;
+	auto e = Open(xspf_playlist_plugin, mutex,
+		      "<?xml version=\"1.0\"?>"
+		      "<playlist><trackList>"
+		      "<track><location>http://example.com/a</location>"
+		      "<title>A</title></track>"
+		      "<track><location>http://example.com/b</location></track>"
+		      "</trackList></playlist>");
+
+	auto song = e->NextSong();
+	ASSERT_NE(song, nullptr);
+	EXPECT_STREQ(song->GetURI(), "http://example.com/a");
+	EXPECT_STREQ(song->GetTag().GetValue(TAG_TITLE), "A");
+
+	song = e->NextSong();
+	ASSERT_NE(song, nullptr);
+	EXPECT_STREQ(song->GetURI(), "http://example.com/b");
+
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST(XmlPlaylist, XspfMalformed)
+{
+	Mutex mutex;
+	auto e = Open(xspf_playlist_plugin, mutex,
+		      "<playlist><trackList>"
+		      "<track><location>http://example.com/a</location></track>"
+		      "<track></foo>");
+
+	/* the song before the error is returned */
+	auto song = e->NextSong();
+	ASSERT_NE(song, nullptr);
+	EXPECT_STREQ(song->GetURI(), "http://example.com/a");
+
+	EXPECT_ANY_THROW(e->NextSong());
+	EXPECT_EQ(e->NextSong(), nullptr);
+}
+
+TEST(XmlPlaylist, AsxTruncated)
+{
+	Mutex mutex;
+	auto e = Open(asx_playlist_plugin, mutex,
+		      "<asx version=\"3.0\">"
+		      "<entry><ref href=\"http://example.com/a\"/></entry>"
+		      "<entry><ref href=\"http://example.com/b\"/>");
+
+	auto song = e->NextSong();
+	ASSERT_NE(song, nullptr);
+	EXPECT_STREQ(song->GetURI(), "http://example.com/a");
+
+	/* the document ends inside the second entry */
+	EXPECT_ANY_THROW(e->NextSong());
+}
+
+TEST(XmlPlaylist, NotXml)
+{
+	Mutex mutex;
+	auto e = Open(asx_playlist_plugin, mutex, "this is not XML");
+	EXPECT_ANY_THROW(e->NextSong());
+}
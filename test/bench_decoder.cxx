@@ -0,0 +1,349 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of MPD's decoder plugins.  It
+ * decodes each file given on the command line with every enabled
+ * decoder plugin which supports its suffix (or only with the one
+ * selected with --decoder), discards the PCM data and prints one
+ * line per plugin and file.
+ *
+ */
+
+#include "ConfigGlue.hxx"
+#include "event/Thread.hxx"
+#include "decoder/DecoderList.hxx"
+#include "decoder/DecoderPlugin.hxx"
+#include "decoder/DecoderAPI.hxx" /* for class StopDecoder */
+#include "DumpDecoderClient.hxx"
+#include "input/Init.hxx"
+#include "input/InputStream.hxx"
+#include "fs/Path.hxx"
+#include "AudioFormat.hxx"
+#include "util/OptionDef.hxx"
+#include "util/OptionParser.hxx"
+#include "util/PrintException.hxx"
+#include "util/StringBuffer.hxx"
+#include "Log.hxx"
+#include "LogBackend.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdexcept>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+/**
+ * The number of allocations with operator new.  Memory allocated by
+ * C libraries with malloc() is not counted.
+ */
+static std::atomic<uint64_t> n_allocations{0};
+
+void *
+operator new(std::size_t size)
+{
+	++n_allocations;
+
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void
+operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+	free(p);
+}
+
+struct CommandLine {
+	const char *decoder = nullptr;
+
+	ConstBuffer<const char *> files = nullptr;
+
+	Path config_path = nullptr;
+
+	unsigned repeat = 3;
+
+	bool verbose = false;
+};
+
+enum Option {
+	OPTION_CONFIG,
+	OPTION_DECODER,
+	OPTION_REPEAT,
+	OPTION_VERBOSE,
+};
+
+static constexpr OptionDef option_defs[] = {
+	{"config", 0, true, "Load a MPD configuration file"},
+	{"decoder", 'd', true, "Use only this decoder plugin"},
+	{"repeat", 'r', true, "Decode each file this many times (default 3)"},
+	{"verbose", 'v', false, "Verbose logging"},
+};
+
+static CommandLine
+ParseCommandLine(int argc, char **argv)
+{
+	CommandLine c;
+
+	OptionParser option_parser(option_defs, argc, argv);
+	while (auto o = option_parser.Next()) {
+		switch (Option(o.index)) {
+		case OPTION_CONFIG:
+			c.config_path = Path::FromFS(o.value);
+			break;
+
+		case OPTION_DECODER:
+			c.decoder = o.value;
+			break;
+
+		case OPTION_REPEAT:
+			c.repeat = strtoul(o.value, nullptr, 10);
+			if (c.repeat == 0)
+				throw std::runtime_error("Invalid --repeat value");
+			break;
+
+		case OPTION_VERBOSE:
+			c.verbose = true;
+			break;
+		}
+	}
+
+	c.files = option_parser.GetRemaining();
+	if (c.files.empty())
+		throw std::runtime_error("Usage: bench_decoder [--verbose] [--config=FILE] [--decoder=PLUGIN] [--repeat=N] FILE...");
+
+	return c;
+}
+
+class GlobalInit {
+	const ConfigData config;
+	EventThread io_thread;
+	const ScopeInputPluginsInit input_plugins_init;
+	const ScopeDecoderPluginsInit decoder_plugins_init;
+
+public:
+	explicit GlobalInit(Path config_path)
+		:config(AutoLoadConfigFile(config_path)),
+		 input_plugins_init(config, io_thread.GetEventLoop()),
+		 decoder_plugins_init(config)
+	{
+		io_thread.Start();
+	}
+};
+
+/**
+ * Reset the peak resident set size of this process, so
+ * GetPeakRss() reports the peak of the following run only.  This
+ * is only implemented on Linux; elsewhere, the peak since the
+ * process was started is reported.
+ */
+static void
+ResetPeakRss() noexcept
+{
+#ifdef __linux__
+	int fd = open("/proc/self/clear_refs", O_WRONLY|O_CLOEXEC);
+	if (fd >= 0) {
+		[[maybe_unused]] ssize_t nbytes = write(fd, "5", 1);
+		close(fd);
+	}
+#endif
+}
+
+/**
+ * @return the peak resident set size in kB
+ */
+static long
+GetPeakRss() noexcept
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+		return 0;
+
+	return usage.ru_maxrss;
+}
+
+struct RunResult {
+	AudioFormat audio_format;
+	std::chrono::duration<double> elapsed;
+	uint64_t decoded_bytes;
+	uint64_t allocations;
+	long peak_rss;
+};
+
+static RunResult
+DecodeOnce(const DecoderPlugin &plugin, const char *uri)
+{
+	DumpDecoderClient client(true);
+
+	ResetPeakRss();
+	const uint64_t allocations_before = n_allocations;
+	const auto start = std::chrono::steady_clock::now();
+
+	if (plugin.file_decode != nullptr) {
+		try {
+			plugin.FileDecode(client, Path::FromFS(uri));
+		} catch (StopDecoder) {
+		}
+	} else {
+		assert(plugin.stream_decode != nullptr);
+
+		auto is = InputStream::OpenReady(uri, client.mutex);
+		try {
+			plugin.StreamDecode(client, *is);
+		} catch (StopDecoder) {
+		}
+	}
+
+	RunResult result;
+	result.elapsed = std::chrono::steady_clock::now() - start;
+	result.allocations = n_allocations - allocations_before;
+	result.peak_rss = GetPeakRss();
+
+	if (!client.IsInitialized())
+		throw std::runtime_error("Decoding failed");
+
+	result.audio_format = client.GetAudioFormat();
+	result.decoded_bytes = client.GetDecodedBytes();
+	return result;
+}
+
+static void
+PrintHeader() noexcept
+{
+	printf("%-12s %-16s %10s %10s %10s %12s %10s  %s\n",
+	       "plugin", "format", "seconds", "realtime", "MB/s",
+	       "allocs", "rss_kB", "file");
+}
+
+/**
+ * Decode the file #repeat times and print the fastest run.
+ */
+static void
+Bench(const DecoderPlugin &plugin, const char *uri, unsigned repeat)
+{
+	RunResult best;
+	long peak_rss = 0;
+
+	for (unsigned i = 0; i < repeat; ++i) {
+		const auto result = DecodeOnce(plugin, uri);
+		if (i == 0 || result.elapsed < best.elapsed)
+			best = result;
+		peak_rss = std::max(peak_rss, result.peak_rss);
+	}
+
+	const double elapsed = std::max(best.elapsed.count(), 1e-9);
+	const double song_duration =
+		best.audio_format.SizeToTime<std::chrono::duration<double>>(best.decoded_bytes).count();
+
+	printf("%-12s %-16s %10.3f %9.1fx %10.1f %12llu %10ld  %s\n",
+	       plugin.name, ToString(best.audio_format).c_str(),
+	       elapsed, song_duration / elapsed,
+	       best.decoded_bytes / elapsed / (1024 * 1024),
+	       (unsigned long long)best.allocations, peak_rss,
+	       uri);
+}
+
+gcc_pure
+static bool
+IsUsable(const DecoderPlugin &plugin, Path path) noexcept
+{
+	if (plugin.file_decode == nullptr && plugin.stream_decode == nullptr)
+		return false;
+
+	const auto suffix = path.GetSuffix();
+	return suffix != nullptr && plugin.SupportsSuffix(suffix);
+}
+
+int main(int argc, char **argv)
+try {
+	const auto c = ParseCommandLine(argc, argv);
+
+	SetLogThreshold(c.verbose ? LogLevel::DEBUG : LogLevel::INFO);
+	const GlobalInit init(c.config_path);
+
+	const DecoderPlugin *selected = nullptr;
+	if (c.decoder != nullptr) {
+		selected = decoder_plugin_from_name(c.decoder);
+		if (selected == nullptr) {
+			fprintf(stderr, "No such decoder: %s\n", c.decoder);
+			return EXIT_FAILURE;
+		}
+
+		if (selected->file_decode == nullptr &&
+		    selected->stream_decode == nullptr) {
+			fprintf(stderr, "Decoder plugin is not usable\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	PrintHeader();
+
+	int status = EXIT_SUCCESS;
+
+	for (const char *uri : c.files) {
+		bool found = false;
+
+		auto try_plugin = [&](const DecoderPlugin &plugin){
+			if (selected == nullptr &&
+			    !IsUsable(plugin, Path::FromFS(uri)))
+				return;
+
+			found = true;
+
+			try {
+				Bench(plugin, uri, c.repeat);
+			} catch (...) {
+				fprintf(stderr, "%s: %s: ", plugin.name, uri);
+				PrintException(std::current_exception());
+				status = EXIT_FAILURE;
+			}
+		};
+
+		if (selected != nullptr)
+			try_plugin(*selected);
+		else
+			decoder_plugins_for_each_enabled(try_plugin);
+
+		if (!found) {
+			fprintf(stderr, "No decoder for %s\n", uri);
+			status = EXIT_FAILURE;
+		}
+	}
+
+	return status;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
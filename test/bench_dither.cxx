@@ -0,0 +1,86 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of MPD's dithering code
+ * (pcm/Dither.cxx).
+ *
+ */
+
+#include "pcm/Dither.cxx" // including the .cxx file to get inlined templates
+
+#include <chrono>
+#include <random>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr size_t N = 16384;
+static constexpr unsigned ITERATIONS = 2000;
+
+static int32_t src[N];
+static int16_t dest[N];
+
+template<typename F>
+static void
+Run(const char *name, F &&f)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < ITERATIONS; ++i)
+		f();
+
+	const std::chrono::duration<double> duration =
+		std::chrono::steady_clock::now() - start;
+	const double samples = double(N) * ITERATIONS;
+
+	printf("%-16s %8.3f ns/sample %10.1f Msamples/s\n", name,
+	       duration.count() * 1e9 / samples,
+	       samples / duration.count() / 1e6);
+}
+
+int
+main(int, char **)
+{
+	std::minstd_rand engine;
+	for (auto &i : src)
+		i = int32_t(engine());
+
+	PcmDither dither;
+
+	Run("Dither32To16", [&]{
+		dither.Dither32To16(dest, src, src + N);
+	});
+
+	for (auto &i : src)
+		i >>= 8;
+
+	Run("Dither24To16", [&]{
+		dither.Dither24To16(dest, src, src + N);
+	});
+
+	/* print something derived from the output so the compiler
+	   cannot discard the work */
+	long sum = 0;
+	for (auto i : dest)
+		sum += i;
+	fprintf(stderr, "checksum: %ld\n", sum);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the speed of bulk edits on large play
+ * queues.
+ *
+ */
+
+#include "queue/Queue.hxx"
+#include "song/DetachedSong.hxx"
+
+#include <chrono>
+#include <random>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr unsigned ITERATIONS = 1000;
+
+template<typename F>
+static void
+Run(unsigned length, const char *name, unsigned n, F &&f)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < n; ++i)
+		f();
+
+	const std::chrono::duration<double> duration =
+		std::chrono::steady_clock::now() - start;
+
+	printf("%8u %-24s %10.3f us/op\n", length, name,
+	       duration.count() * 1e6 / n);
+}
+
+static void
+Bench(unsigned length)
+{
+	Queue queue(length);
+	std::minstd_rand engine;
+
+	Run(length, "append", length, [&]{
+		queue.Append(DetachedSong("foo/bar.ogg"), 0);
+	});
+
+	Run(length, "delete first", ITERATIONS, [&]{
+		queue.DeletePosition(0);
+	});
+
+	while (!queue.IsFull())
+		queue.Append(DetachedSong("foo/bar.ogg"), 0);
+
+	Run(length, "delete random", ITERATIONS, [&]{
+		queue.DeletePosition(engine() % queue.GetLength());
+		queue.Append(DetachedSong("foo/bar.ogg"), 0);
+	});
+
+	Run(length, "move", ITERATIONS, [&]{
+		queue.MovePostion(engine() % length, engine() % length);
+	});
+
+	Run(length, "move range", ITERATIONS, [&]{
+		unsigned start = engine() % length, end = engine() % length;
+		if (start > end)
+			std::swap(start, end);
+
+		queue.MoveRange(start, end,
+				engine() % (length - (end - start) + 1));
+	});
+
+	Run(length, "swap", ITERATIONS, [&]{
+		queue.SwapPositions(engine() % length, engine() % length);
+	});
+
+	Run(length, "id to position", ITERATIONS, [&]{
+		const unsigned id = queue.PositionToId(engine() % length);
+		if (queue.IdToPosition(id) < 0)
+			abort();
+	});
+
+	queue.random = true;
+	queue.ShuffleOrder();
+
+	Run(length, "position to order", ITERATIONS, [&]{
+		const unsigned position = engine() % length;
+		if (queue.OrderToPosition(queue.PositionToOrder(position)) != position)
+			abort();
+	});
+
+	Run(length, "move order", ITERATIONS, [&]{
+		queue.MoveOrder(engine() % length, engine() % length);
+	});
+
+	Run(length, "priority", ITERATIONS, [&]{
+		queue.SetPriority(engine() % length, engine() % 4,
+				  engine() % length);
+	});
+
+	Run(length, "clear", 1, [&]{
+		queue.Clear();
+	});
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 1) {
+		for (int i = 1; i < argc; ++i)
+			Bench(strtoul(argv[i], nullptr, 10));
+	} else {
+		Bench(10000);
+		Bench(100000);
+		Bench(1000000);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2003-2019 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program converts raw 24 bit or 32 bit PCM data from stdin to
+ * 16 bit with MPD's dithering code (pcm/Dither.cxx), e.g. to produce
+ * files for an ABX comparison.
+ *
+ */
+
+#include "pcm/Dither.cxx" // including the .cxx file to get inlined templates
+#include "AudioParser.hxx"
+#include "AudioFormat.hxx"
+#include "util/PrintException.hxx"
+#include "util/Compiler.h"
+
+#include <stdexcept>
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int
+main(int argc, char **argv)
+try {
+	static int32_t buffer[4096];
+	static int16_t dest[4096];
+	ssize_t nbytes;
+
+	if (argc > 2) {
+		fprintf(stderr, "Usage: run_dither [FORMAT] <IN >OUT\n");
+		return EXIT_FAILURE;
+	}
+
+	AudioFormat audio_format(48000, SampleFormat::S24_P32, 2);
+	if (argc > 1)
+		audio_format = ParseAudioFormat(argv[1], false);
+
+	if (audio_format.format != SampleFormat::S24_P32 &&
+	    audio_format.format != SampleFormat::S32)
+		throw std::runtime_error("Sample format must be 24 or 32 bit");
+
+	PcmDither dither;
+
+	while ((nbytes = read(0, buffer, sizeof(buffer))) > 0) {
+		const size_t n = size_t(nbytes) / sizeof(buffer[0]);
+
+		if (audio_format.format == SampleFormat::S24_P32)
+			dither.Dither24To16(dest, buffer, buffer + n);
+		else
+			dither.Dither32To16(dest, buffer, buffer + n);
+
+		gcc_unused ssize_t ignored = write(1, dest, n * sizeof(dest[0]));
+	}
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
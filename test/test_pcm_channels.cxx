@@ -19,11 +19,15 @@
 
 #include "test_pcm_util.hxx"
 #include "pcm/PcmChannels.hxx"
+#include "pcm/ChannelMatrix.hxx"
+#include "pcm/ChannelsConverter.hxx"
 #include "pcm/Buffer.hxx"
 #include "util/ConstBuffer.hxx"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 TEST(PcmTest, Channels16)
 {
 	constexpr size_t N = 509;
@@ -107,3 +111,113 @@ TEST(PcmTest, Channels32)
 		EXPECT_EQ(silence, dest[i * 6 + 5]);
 	}
 }
+
+TEST(PcmTest, Channels51ToStereo)
+{
+	constexpr size_t N = 509;
+	const auto src = TestDataBuffer<int16_t, N * 6>();
+
+	PcmBuffer buffer;
+
+	auto dest = pcm_convert_channels_16(buffer, 2, 6, { src, N * 6 });
+	EXPECT_FALSE(dest.IsNull());
+	EXPECT_EQ(N * 2, dest.size);
+
+	/* ITU-R BS.775: center and surround at -3 dB, no LFE,
+	   normalized */
+	constexpr float c = 0.70710678f;
+	constexpr float sum = 1 + c + c;
+	for (unsigned i = 0; i < N; ++i) {
+		const int16_t *s = &src[i * 6];
+		const float l = (s[0] + c * s[2] + c * s[4]) / sum;
+		const float r = (s[1] + c * s[2] + c * s[5]) / sum;
+		EXPECT_NEAR(l, dest[i * 2], 1);
+		EXPECT_NEAR(r, dest[i * 2 + 1], 1);
+	}
+}
+
+TEST(PcmTest, ChannelMatrixFloat)
+{
+	constexpr size_t N = 509;
+	const auto src = TestDataBuffer<float, N * 3>(RandomFloat());
+
+	/* swap left and right, mix the third channel into both at
+	   half volume */
+	PcmChannelMatrix matrix(3, 2);
+	matrix.Set(0, 1, 1);
+	matrix.Set(0, 2, 0.5);
+	matrix.Set(1, 0, 1);
+	matrix.Set(1, 2, 0.5);
+
+	PcmBuffer buffer;
+	auto dest = pcm_channel_matrix_float(buffer, matrix, { src, N * 3 });
+	EXPECT_FALSE(dest.IsNull());
+	EXPECT_EQ(N * 2, dest.size);
+
+	for (unsigned i = 0; i < N; ++i) {
+		EXPECT_FLOAT_EQ(src[i * 3 + 1] + 0.5f * src[i * 3 + 2],
+				dest[i * 2]);
+		EXPECT_FLOAT_EQ(src[i * 3] + 0.5f * src[i * 3 + 2],
+				dest[i * 2 + 1]);
+	}
+}
+
+TEST(PcmTest, ChannelMatrixClip)
+{
+	const int16_t src[] = { 30000, 30000, -30000, -30000 };
+
+	PcmChannelMatrix matrix(2, 1);
+	matrix.Set(0, 0, 1);
+	matrix.Set(0, 1, 1);
+
+	PcmBuffer buffer;
+	auto dest = pcm_channel_matrix_16(buffer, matrix, { src, 4 });
+	EXPECT_EQ(2u, dest.size);
+	EXPECT_EQ(INT16_MAX, dest[0]);
+	EXPECT_EQ(INT16_MIN, dest[1]);
+}
+
+TEST(PcmTest, ChannelMatrixRound)
+{
+	const int16_t src[] = { 3, 0, -3, 0, 1, 0, 2, 0, 32767, 0 };
+
+	PcmChannelMatrix matrix(2, 1);
+	matrix.Set(0, 0, 0.5);
+
+	/* the result is rounded to the nearest integer, not
+	   truncated toward zero */
+	PcmBuffer buffer;
+	auto dest = pcm_channel_matrix_16(buffer, matrix, { src, 10 });
+	ASSERT_EQ(5u, dest.size);
+	EXPECT_EQ(2, dest[0]);
+	EXPECT_EQ(-2, dest[1]);
+	EXPECT_EQ(1, dest[2]);
+	EXPECT_EQ(1, dest[3]);
+	EXPECT_EQ(16384, dest[4]);
+}
+
+TEST(PcmTest, ChannelsConverter)
+{
+	constexpr size_t N = 509;
+	const auto src = TestDataBuffer<int16_t, N * 6>();
+
+	/* the matrix built by Open() gives the same result as
+	   pcm_convert_channels_16() */
+	PcmBuffer buffer;
+	const auto expected = pcm_convert_channels_16(buffer, 2, 6,
+						      { src, N * 6 });
+
+	PcmChannelsConverter converter;
+	converter.Open(SampleFormat::S16, 6, 2);
+
+	const ConstBuffer<int16_t> src_buffer(src, N * 6);
+
+	for (unsigned i = 0; i < 2; ++i) {
+		const auto dest = ConstBuffer<int16_t>::FromVoid(converter.Convert(src_buffer.ToVoid()));
+		ASSERT_EQ(expected.size, dest.size);
+		EXPECT_TRUE(std::equal(dest.begin(), dest.end(),
+				       expected.begin()));
+	}
+
+	converter.Close();
+}
@@ -51,3 +51,25 @@ TEST(PcmTest, Dither32)
 		EXPECT_LT(dest[i], (src[i] >> 16) + 8);
 	}
 }
+
+TEST(PcmTest, Dither32Clip)
+{
+	constexpr unsigned N = 509;
+	int32_t src[N];
+	for (unsigned i = 0; i < N; ++i)
+		src[i] = i % 2 ? INT32_MAX : INT32_MIN;
+
+	int16_t dest[N];
+	PcmDither dither;
+	dither.Dither32To16(dest, src, src + N);
+
+	/* the noise and the error feedback may move the values
+	   by a few steps towards zero, but nothing must wrap
+	   around */
+	for (unsigned i = 0; i < N; ++i) {
+		if (i % 2)
+			EXPECT_GE(dest[i], INT16_MAX - 8);
+		else
+			EXPECT_LE(dest[i], INT16_MIN + 8);
+	}
+}
@@ -18,6 +18,7 @@
  */
 
 #include "config.h"
+#include "test_pcm_util.hxx"
 #include "pcm/Export.hxx"
 #include "pcm/Traits.hxx"
 #include "util/ByteOrder.hxx"
@@ -57,6 +58,46 @@ TEST(PcmTest, ExportShift8)
 			 sizeof(expected_silence)), 0);
 }
 
+TEST(PcmTest, ExportShift8ReverseEndian)
+{
+	static constexpr int32_t src[] = { 0x0, 0x1, 0x100, 0x10000, 0xffffff, -1 };
+	static constexpr uint8_t expected_be[] = {
+		0, 0, 0, 0,
+		0, 0, 0x1, 0,
+		0, 0x1, 0, 0,
+		0x1, 0, 0, 0,
+		0xff, 0xff, 0xff, 0,
+		0xff, 0xff, 0xff, 0,
+	};
+
+	static constexpr uint8_t expected_le[] = {
+		0, 0, 0, 0,
+		0, 0x1, 0, 0,
+		0, 0, 0x1, 0,
+		0, 0, 0, 0x1,
+		0, 0xff, 0xff, 0xff,
+		0, 0xff, 0xff, 0xff,
+	};
+
+	/* the output byte order is the opposite of the host's */
+	static const uint8_t *const expected = IsBigEndian()
+		? expected_le : expected_be;
+
+	PcmExport::Params params;
+	params.shift8 = true;
+	params.reverse_endian = true;
+
+	PcmExport e;
+	e.Open(SampleFormat::S24_P32, 2, params);
+
+	EXPECT_EQ(e.GetInputFrameSize(), 8u);
+	EXPECT_EQ(e.GetOutputFrameSize(), 8u);
+
+	auto dest = e.Export({src, sizeof(src)});
+	EXPECT_EQ(sizeof(expected_be), dest.size);
+	EXPECT_TRUE(memcmp(dest.data, expected, dest.size) == 0);
+}
+
 TEST(PcmTest, ExportPack24)
 {
 	static constexpr int32_t src[] = { 0x0, 0x1, 0x100, 0x10000, 0xffffff };
@@ -106,6 +147,98 @@ TEST(PcmTest, ExportPack24)
 			 sizeof(expected_silence)), 0);
 }
 
+TEST(PcmTest, ExportPack24ReverseEndian)
+{
+	static constexpr int32_t src[] = { 0x0, 0x1, 0x100, 0x10000, 0xffffff };
+
+	static constexpr uint8_t expected_be[] = {
+		0, 0, 0x0,
+		0, 0, 0x1,
+		0, 0x1, 0x00,
+		0x1, 0x00, 0x00,
+		0xff, 0xff, 0xff,
+	};
+
+	static constexpr uint8_t expected_le[] = {
+		0, 0, 0x0,
+		0x1, 0, 0,
+		0x00, 0x1, 0,
+		0, 0x00, 0x01,
+		0xff, 0xff, 0xff,
+	};
+
+	/* the output byte order is the opposite of the host's */
+	static const uint8_t *const expected = IsBigEndian()
+		? expected_le : expected_be;
+
+	PcmExport::Params params;
+	params.pack24 = true;
+	params.reverse_endian = true;
+
+	PcmExport e;
+	e.Open(SampleFormat::S24_P32, 2, params);
+
+	EXPECT_EQ(e.GetInputFrameSize(), 8u);
+	EXPECT_EQ(e.GetOutputFrameSize(), 6u);
+
+	auto dest = e.Export({src, sizeof(src)});
+	EXPECT_EQ(sizeof(expected_be), dest.size);
+	EXPECT_TRUE(memcmp(dest.data, expected, dest.size) == 0);
+}
+
+/**
+ * Compare the fused pack/shift/byte-swap kernels with a byte-wise
+ * reference implementation on random data whose length is not a
+ * multiple of the kernels' block size.
+ */
+static void
+TestExportS24(bool pack24, bool shift8, bool reverse_endian)
+{
+	constexpr size_t N = 509 * 2;
+	const auto src = TestDataBuffer<int32_t, N>(RandomInt24());
+
+	const bool big_endian = IsBigEndian() != reverse_endian;
+	const size_t sample_size = pack24 ? 3 : 4;
+
+	uint8_t expected[N * 4];
+	for (size_t i = 0; i < N; ++i) {
+		uint32_t x = src[i];
+		if (shift8)
+			x <<= 8;
+
+		uint8_t bytes[4];
+		for (size_t j = 0; j < 4; ++j)
+			bytes[j] = x >> (8 * j);
+
+		uint8_t *d = expected + i * sample_size;
+		for (size_t j = 0; j < sample_size; ++j)
+			d[j] = big_endian
+				? bytes[sample_size - 1 - j]
+				: bytes[j];
+	}
+
+	PcmExport::Params params;
+	params.pack24 = pack24;
+	params.shift8 = shift8;
+	params.reverse_endian = reverse_endian;
+
+	PcmExport e;
+	e.Open(SampleFormat::S24_P32, 2, params);
+
+	auto dest = e.Export({src.begin(), sizeof(src)});
+	ASSERT_EQ(N * sample_size, dest.size);
+	EXPECT_EQ(memcmp(dest.data, expected, dest.size), 0);
+}
+
+TEST(PcmTest, ExportS24BitExact)
+{
+	for (bool reverse_endian : {false, true}) {
+		TestExportS24(false, false, reverse_endian);
+		TestExportS24(true, false, reverse_endian);
+		TestExportS24(false, true, reverse_endian);
+	}
+}
+
 TEST(PcmTest, ExportReverseEndian)
 {
 	static constexpr uint8_t src[] = {
@@ -23,6 +23,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
+#include <string.h>
+
 TEST(PcmTest, Pack24)
 {
 	constexpr unsigned N = 509;
@@ -87,3 +91,54 @@ TEST(PcmTest, Unpack24BE)
 		EXPECT_EQ(s, dest[i]);
 	}
 }
+
+TEST(PcmTest, Pack24LE)
+{
+	constexpr unsigned N = 509;
+	const auto src = TestDataBuffer<int32_t, N>(RandomInt24());
+
+	uint8_t dest[N * 3];
+	pcm_pack_24le(dest, src.begin(), src.end());
+
+	for (unsigned i = 0; i < N; ++i) {
+		int32_t d = (dest[i * 3 + 2] << 16) | (dest[i * 3 + 1] << 8)
+			| dest[i * 3];
+		if (d & 0x800000)
+			d |= 0xff000000;
+
+		EXPECT_EQ(d, src[i]);
+	}
+}
+
+TEST(PcmTest, Pack24BE)
+{
+	constexpr unsigned N = 509;
+	const auto src = TestDataBuffer<int32_t, N>(RandomInt24());
+
+	uint8_t dest[N * 3];
+	pcm_pack_24be(dest, src.begin(), src.end());
+
+	for (unsigned i = 0; i < N; ++i) {
+		int32_t d = (dest[i * 3] << 16) | (dest[i * 3 + 1] << 8)
+			| dest[i * 3 + 2];
+		if (d & 0x800000)
+			d |= 0xff000000;
+
+		EXPECT_EQ(d, src[i]);
+	}
+}
+
+TEST(PcmTest, Pack24InPlace)
+{
+	constexpr unsigned N = 509;
+	const auto src = TestDataBuffer<int32_t, N>(RandomInt24());
+
+	uint8_t expected[N * 3];
+	pcm_pack_24(expected, src.begin(), src.end());
+
+	int32_t buffer[N];
+	std::copy(src.begin(), src.end(), buffer);
+	pcm_pack_24((uint8_t *)buffer, buffer, buffer + N);
+
+	EXPECT_EQ(memcmp(buffer, expected, sizeof(expected)), 0);
+}
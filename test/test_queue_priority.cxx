@@ -17,7 +17,7 @@ check_descending_priority(const Queue *queue,
 	uint8_t last_priority = 0xff;
 	for (unsigned order = start_order; order < queue->GetLength(); ++order) {
 		unsigned position = queue->OrderToPosition(order);
-		uint8_t priority = queue->items[position].priority;
+		uint8_t priority = queue->GetPriorityAtPosition(position);
 		assert(priority <= last_priority);
 		(void)last_priority;
 		last_priority = priority;
@@ -123,7 +123,7 @@ TEST(QueuePriority, Priority)
 
 	unsigned a_order = 3;
 	unsigned a_position = queue.OrderToPosition(a_order);
-	EXPECT_EQ(10u, unsigned(queue.items[a_position].priority));
+	EXPECT_EQ(10u, unsigned(queue.GetPriorityAtPosition(a_position)));
 	queue.SetPriority(a_position, 20, current_order);
 
 	current_order = queue.PositionToOrder(current_position);
@@ -140,7 +140,7 @@ TEST(QueuePriority, Priority)
 
 	unsigned b_order = 10;
 	unsigned b_position = queue.OrderToPosition(b_order);
-	EXPECT_EQ(0u, unsigned(queue.items[b_position].priority));
+	EXPECT_EQ(0u, unsigned(queue.GetPriorityAtPosition(b_position)));
 	queue.SetPriority(b_position, 70, current_order);
 
 	current_order = queue.PositionToOrder(current_position);
@@ -155,7 +155,7 @@ TEST(QueuePriority, Priority)
 
 	a_order = queue.PositionToOrder(a_position);
 	EXPECT_EQ(5u, a_order);
-	EXPECT_EQ(20u, unsigned(queue.items[a_position].priority));
+	EXPECT_EQ(20u, unsigned(queue.GetPriorityAtPosition(a_position)));
 	queue.SetPriority(a_position, 5, current_order);
 
 	current_order = queue.PositionToOrder(current_position);